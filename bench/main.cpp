@@ -0,0 +1,664 @@
+#include <armajitto/armajitto.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+using namespace armajitto;
+
+// Headless benchmark runner with synthetic guest workloads.
+//
+// Each workload runs in a fresh recompiler for a fixed amount of wall-clock time. Instructions take one cycle each, so
+// the number of cycles executed approximates the number of guest instructions executed. With the timing table (-tt),
+// cycles include memory access timings instead.
+//
+// Usage: armajitto-bench [options] [workload...]; run with -h for the list of options and workloads
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Memory map
+//
+// 00000000..00003FFF  Exception vectors (mirrored at FFFF0000 for CPUs with high vectors)
+// 02000000..023FFFFF  RAM; code is loaded at 02000000
+// 04000000..04000007  MMIO registers, handled by the system callbacks
+//                     04000000: status; bit 0 is set on every 16th read
+//                     04000004: IRQ acknowledge; any write lowers the IRQ line
+
+constexpr uint32_t kCodeBase = 0x02000000;
+constexpr uint32_t kStackTop = 0x02300000;
+constexpr uint32_t kMMIOBase = 0x04000000;
+
+class BenchSystem : public ISystem {
+public:
+    BenchSystem(HugePageMode hugePages)
+        : ISystem(hugePages) {
+        using MemArea = MemoryArea;
+        using MemAttr = MemoryAttributes;
+
+        vectors.fill(0);
+        ram.fill(0);
+
+        m_memMap.Map(MemArea::All, 0, 0x00000000, vectors.size(), MemAttr::RWX, vectors.data(), vectors.size());
+        m_memMap.Map(MemArea::All, 0, 0xFFFF0000, vectors.size(), MemAttr::RWX, vectors.data(), vectors.size());
+        m_memMap.Map(MemArea::All, 0, 0x02000000, ram.size(), MemAttr::RWX, ram.data(), ram.size());
+    }
+
+    void WriteARM(uint32_t address, std::initializer_list<uint32_t> code) {
+        for (uint32_t instr : code) {
+            Write(address, &instr, sizeof(instr));
+            address += sizeof(instr);
+        }
+    }
+
+    void WriteThumb(uint32_t address, std::initializer_list<uint16_t> code) {
+        for (uint16_t instr : code) {
+            Write(address, &instr, sizeof(instr));
+            address += sizeof(instr);
+        }
+    }
+
+    uint8_t MemReadByte(uint32_t address) final {
+        return MMIORead(address);
+    }
+
+    uint16_t MemReadHalf(uint32_t address) final {
+        return MMIORead(address);
+    }
+
+    uint32_t MemReadWord(uint32_t address) final {
+        return MMIORead(address);
+    }
+
+    void MemWriteByte(uint32_t address, uint8_t /*value*/) final {
+        MMIOWrite(address);
+    }
+
+    void MemWriteHalf(uint32_t address, uint16_t /*value*/) final {
+        MMIOWrite(address);
+    }
+
+    void MemWriteWord(uint32_t address, uint32_t /*value*/) final {
+        MMIOWrite(address);
+    }
+
+    std::array<uint8_t, 0x4000> vectors;
+    std::array<uint8_t, 0x400000> ram;
+
+    arm::State *armState = nullptr;
+    uint32_t statusReads = 0;
+
+private:
+    void Write(uint32_t address, const void *data, size_t size) {
+        if (address < vectors.size()) {
+            std::memcpy(&vectors[address], data, size);
+        } else {
+            std::memcpy(&ram[address - 0x02000000], data, size);
+        }
+    }
+
+    uint32_t MMIORead(uint32_t address) {
+        if ((address & ~3) == kMMIOBase) {
+            return (++statusReads % 16 == 0) ? 1 : 0;
+        }
+        return 0;
+    }
+
+    void MMIOWrite(uint32_t address) {
+        if ((address & ~3) == kMMIOBase + 4 && armState != nullptr) {
+            armState->IRQLine() = false;
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Workloads
+
+struct Workload {
+    const char *name;
+    const char *description;
+    bool thumb;
+
+    // Writes the code and sets up the initial state
+    std::function<void(BenchSystem &sys, arm::State &state)> setup;
+
+    // Number of cycles to run per call to Recompiler::Run
+    uint64_t sliceCycles = 100000;
+
+    // Raises the IRQ line before every slice
+    bool irqStorm = false;
+};
+
+static const std::vector<Workload> kWorkloads = {
+    {
+        .name = "alu-arm",
+        .description = "ARM ALU loop",
+        .thumb = false,
+        .setup =
+            [](BenchSystem &sys, arm::State &state) {
+                sys.WriteARM(kCodeBase, {
+                                            0xE0800001, // loop: add r0, r0, r1
+                                            0xE02221E0, //       eor r2, r2, r0, ror #3
+                                            0xE2533001, //       subs r3, r3, #1
+                                            0x1AFFFFFB, //       bne loop
+                                            0xE3A03801, //       mov r3, #0x10000
+                                            0xEAFFFFF9, //       b loop
+                                        });
+                state.GPR(arm::GPR::R1) = 0x12345678;
+                state.GPR(arm::GPR::R3) = 0x10000;
+            },
+    },
+    {
+        .name = "alu-thumb",
+        .description = "Thumb ALU loop",
+        .thumb = true,
+        .setup =
+            [](BenchSystem &sys, arm::State &state) {
+                sys.WriteThumb(kCodeBase, {
+                                              0x1840, // loop: adds r0, r0, r1
+                                              0x4042, //       eors r2, r0
+                                              0x00D4, //       lsls r4, r2, #3
+                                              0x3B01, //       subs r3, #1
+                                              0xD1FA, //       bne loop
+                                              0x23FF, //       movs r3, #0xFF
+                                              0xE7F8, //       b loop
+                                          });
+                state.GPR(arm::GPR::R1) = 0x12345678;
+                state.GPR(arm::GPR::R3) = 0xFF;
+            },
+    },
+    {
+        .name = "memcpy",
+        .description = "LDMIA/STMIA copy of 16 KiB",
+        .thumb = false,
+        .setup =
+            [](BenchSystem &sys, arm::State & /*state*/) {
+                sys.WriteARM(kCodeBase, {
+                                            0xE3A00622, // outer: mov r0, #0x02200000
+                                            0xE3A01621, //        mov r1, #0x02100000
+                                            0xE3A02901, //        mov r2, #0x4000
+                                            0xE8B100F0, // copy:  ldmia r1!, {r4-r7}
+                                            0xE8A000F0, //        stmia r0!, {r4-r7}
+                                            0xE2522010, //        subs r2, r2, #16
+                                            0xCAFFFFFB, //        bgt copy
+                                            0xEAFFFFF7, //        b outer
+                                        });
+            },
+    },
+    {
+        .name = "calls-arm",
+        .description = "ARM BL/BX LR calls",
+        .thumb = false,
+        .setup =
+            [](BenchSystem &sys, arm::State & /*state*/) {
+                sys.WriteARM(kCodeBase, {
+                                            0xEB000002, // main: bl func
+                                            0xEB000001, //       bl func
+                                            0xEAFFFFFC, //       b main
+                                            0xE1A00000, //       nop
+                                            0xE2800001, // func: add r0, r0, #1
+                                            0xE12FFF1E, //       bx lr
+                                        });
+            },
+    },
+    {
+        .name = "calls-thumb",
+        .description = "Thumb BL with PUSH/POP",
+        .thumb = true,
+        .setup =
+            [](BenchSystem &sys, arm::State & /*state*/) {
+                sys.WriteThumb(kCodeBase, {
+                                              0xF000, // main: bl func
+                                              0xF802, //
+                                              0xE7FC, //       b main
+                                              0x46C0, //       nop
+                                              0xB510, // func: push {r4, lr}
+                                              0x3401, //       adds r4, #1
+                                              0xBD10, //       pop {r4, pc}
+                                          });
+            },
+    },
+    {
+        .name = "mmio-poll",
+        .description = "Polling an MMIO status register",
+        .thumb = false,
+        .setup =
+            [](BenchSystem &sys, arm::State &state) {
+                sys.WriteARM(kCodeBase, {
+                                            0xE5901000, // loop: ldr r1, [r0]
+                                            0xE3110001, //       tst r1, #1
+                                            0x0AFFFFFC, //       beq loop
+                                            0xE2822001, //       add r2, r2, #1
+                                            0xEAFFFFFA, //       b loop
+                                        });
+                state.GPR(arm::GPR::R0) = kMMIOBase;
+            },
+    },
+    {
+        .name = "smc",
+        .description = "Self-modifying code",
+        .thumb = false,
+        .setup =
+            [](BenchSystem &sys, arm::State &state) {
+                sys.WriteARM(kCodeBase, {
+                                            0xE2800001, // loop: add r0, r0, #1
+                                            0xE5843000, //       str r3, [r4]
+                                            0xEAFFFFFC, //       b loop
+                                        });
+                state.GPR(arm::GPR::R3) = 0xE2800001; // add r0, r0, #1
+                state.GPR(arm::GPR::R4) = kCodeBase;
+            },
+    },
+    {
+        .name = "irq-storm",
+        .description = "ARM ALU loop interrupted every 100 cycles",
+        .thumb = false,
+        .setup =
+            [](BenchSystem &sys, arm::State &state) {
+                sys.WriteARM(kCodeBase, {
+                                            0xE0800001, // loop: add r0, r0, r1
+                                            0xE02221E0, //       eor r2, r2, r0, ror #3
+                                            0xE2533001, //       subs r3, r3, #1
+                                            0x1AFFFFFB, //       bne loop
+                                            0xE3A03801, //       mov r3, #0x10000
+                                            0xEAFFFFF9, //       b loop
+                                        });
+                sys.WriteARM(0x00000018, {
+                                             0xE58CC004, // irq: str r12, [r12, #4]
+                                             0xE25EF004, //      subs pc, lr, #4
+                                         });
+                state.GPR(arm::GPR::R1) = 0x12345678;
+                state.GPR(arm::GPR::R3) = 0x10000;
+                state.GPR(arm::GPR::R12) = kMMIOBase;
+                state.CPSR().i = 0;
+            },
+        .sliceCycles = 100,
+        .irqStorm = true,
+    },
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Runner
+
+struct BenchOptions {
+    double duration = 1.0;
+    CPUModel model = CPUModel::ARM946ES;
+
+    // Backs the memory map tables, code buffer and block cache with huge pages
+    HugePageMode hugePages = HugePageMode::None;
+
+    // Enables 8 KiB instruction and data caches with RAM as the only cacheable region (ARM946E-S only).
+    // This also enables the protection unit.
+    bool caches = false;
+
+    // Enables the cache timing model
+    bool cacheModel = false;
+
+    // Counts cycles with the SubinstructionTimingTable method, with RAM taking extra cycles on nonsequential accesses
+    bool timingTable = false;
+
+    // Enables idle and polling loop recognition
+    bool idiomRecognition = false;
+
+    Options::Optimizer::Passes passes{};
+};
+
+// Optimizer passes that can be toggled individually from the command line
+struct PassSwitch {
+    const char *name;
+    bool Options::Optimizer::Passes::*enabled;
+};
+
+using Passes = Options::Optimizer::Passes;
+static const std::array<PassSwitch, 12> kPassSwitches = {{
+    {"const-prop", &Passes::constantPropagation},
+    {"cse", &Passes::commonSubexpressionElimination},
+    {"rle", &Passes::redundantLoadElimination},
+    {"dead-reg", &Passes::deadRegisterStoreElimination},
+    {"dead-gpr", &Passes::deadGPRStoreElimination},
+    {"dead-hflags", &Passes::deadHostFlagStoreElimination},
+    {"dead-flags", &Passes::deadFlagValueStoreElimination},
+    {"dead-var", &Passes::deadVariableStoreElimination},
+    {"bitwise", &Passes::bitwiseOpsCoalescence},
+    {"arith", &Passes::arithmeticOpsCoalescence},
+    {"hflags", &Passes::hostFlagsOpsCoalescence},
+    {"var-lifetime", &Passes::varLifetimeOptimization},
+}};
+
+// Enables or disables the named pass, or all passes if the name is "all". Returns false if the name is unknown.
+bool setPass(Passes &passes, const std::string &name, bool enabled) {
+    if (name == "all") {
+        passes.SetAll(enabled);
+        return true;
+    }
+    for (auto &pass : kPassSwitches) {
+        if (name == pass.name) {
+            passes.*pass.enabled = enabled;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Configures the caches and the protection unit:
+//   region 0: 00000000..FFFFFFFF, full access, not cacheable
+//   region 1: 02000000..023FFFFF, full access, cacheable
+void setupCaches(arm::State &state) {
+    auto &cp15 = state.GetSystemControlCoprocessor();
+    if (!cp15.IsPresent()) {
+        return;
+    }
+
+    using namespace arm::cp15;
+    cp15.ConfigureCache({
+        .type = cache::Type::WriteBackReg7CleanLockdownB,
+        .separateCodeDataCaches = true,
+        .code = {.size = 0x2000, .lineLength = cache::LineLength::_32B, .associativity = cache::Associativity::_4Way},
+        .data = {.size = 0x2000, .lineLength = cache::LineLength::_32B, .associativity = cache::Associativity::_4Way},
+    });
+    cp15.StoreRegister(0x0600, 0x0000003F); // region 0
+    cp15.StoreRegister(0x0610, 0x0200002B); // region 1
+    cp15.StoreRegister(0x0502, 0x00000033); // data access permissions
+    cp15.StoreRegister(0x0503, 0x00000033); // instruction access permissions
+    cp15.StoreRegister(0x0200, 0b10);       // data cachability bits
+    cp15.StoreRegister(0x0201, 0b10);       // instruction cachability bits
+    cp15.StoreRegister(0x0100, cp15.LoadRegister(0x0100) | 0x1005); // PU, data cache and instruction cache
+}
+
+// Counts the dTLB and iTLB load misses of this thread in user mode through perf_event_open.
+// The counters are unavailable on other platforms, or if the kernel does not allow unprivileged access to them (see
+// /proc/sys/kernel/perf_event_paranoid) or the CPU does not expose them.
+class TLBMissCounters {
+public:
+    TLBMissCounters() {
+#if defined(__linux__)
+        m_dtlbFD = Open(PERF_COUNT_HW_CACHE_DTLB);
+        m_itlbFD = Open(PERF_COUNT_HW_CACHE_ITLB);
+#endif
+    }
+
+    ~TLBMissCounters() {
+#if defined(__linux__)
+        if (m_dtlbFD >= 0) {
+            close(m_dtlbFD);
+        }
+        if (m_itlbFD >= 0) {
+            close(m_itlbFD);
+        }
+#endif
+    }
+
+    TLBMissCounters(const TLBMissCounters &) = delete;
+    TLBMissCounters &operator=(const TLBMissCounters &) = delete;
+
+    void Start() {
+#if defined(__linux__)
+        for (int fd : {m_dtlbFD, m_itlbFD}) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void Stop() {
+#if defined(__linux__)
+        for (int fd : {m_dtlbFD, m_itlbFD}) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+#endif
+    }
+
+    // Returns the number of misses counted between Start() and Stop(), or -1 if the counter is unavailable
+    int64_t DTLBMisses() const {
+        return Read(m_dtlbFD);
+    }
+    int64_t ITLBMisses() const {
+        return Read(m_itlbFD);
+    }
+
+private:
+    int m_dtlbFD = -1;
+    int m_itlbFD = -1;
+
+#if defined(__linux__)
+    static int Open(uint64_t cache) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+    static int64_t Read(int fd) {
+#if defined(__linux__)
+        uint64_t count;
+        if (fd >= 0 && read(fd, &count, sizeof(count)) == sizeof(count)) {
+            return static_cast<int64_t>(count);
+        }
+#endif
+        return -1;
+    }
+};
+
+struct Result {
+    double seconds;
+    uint64_t cycles;
+    CompilerStatistics stats;
+
+    // TLB load misses while running the workload, or -1 if unavailable
+    int64_t dtlbMisses;
+    int64_t itlbMisses;
+};
+
+Result runWorkload(const Workload &workload, const BenchOptions &benchOptions) {
+    using Method = Options::Translator::CycleCountingMethod;
+
+    Options options{};
+    options.translator.cycleCountingMethod =
+        benchOptions.timingTable ? Method::SubinstructionTimingTable : Method::InstructionFixed;
+    options.translator.cyclesPerInstruction = 1;
+    options.translator.idiomRecognition = benchOptions.idiomRecognition;
+    options.optimizer.passes = benchOptions.passes;
+    options.compiler.cacheTimingModel = benchOptions.cacheModel;
+    options.compiler.hugePages = benchOptions.hugePages;
+    options.collectStatistics = true;
+
+    auto sys = std::make_unique<BenchSystem>(benchOptions.hugePages);
+    if (benchOptions.timingTable) {
+        sys->GetMemoryMap().SetTimings(MemoryArea::All, kCodeBase, sys->ram.size(),
+                                       {.nonsequential = {3, 3, 3}, .sequential = {1, 1, 1}});
+    }
+    Recompiler jit{{
+        .system = *sys,
+        .model = benchOptions.model,
+        .options = &options,
+    }};
+
+    auto &armState = jit.GetARMState();
+    sys->armState = &armState;
+    armState.SetMode(arm::Mode::System);
+    armState.GPR(arm::GPR::SP) = kStackTop;
+    if (benchOptions.caches) {
+        setupCaches(armState);
+    }
+    workload.setup(*sys, armState);
+    armState.JumpTo(kCodeBase, workload.thumb);
+
+    const double duration = benchOptions.duration;
+
+    TLBMissCounters tlbMisses{};
+    tlbMisses.Start();
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const auto deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(duration));
+    uint64_t cycles = 0;
+    auto now = start;
+    while (now < deadline) {
+        // Check the clock every few slices to keep its overhead out of short slices
+        for (int i = 0; i < 64; i++) {
+            if (workload.irqStorm) {
+                armState.IRQLine() = true;
+            }
+            cycles += jit.Run(workload.sliceCycles);
+        }
+        now = Clock::now();
+    }
+    tlbMisses.Stop();
+
+    return {
+        .seconds = std::chrono::duration<double>(now - start).count(),
+        .cycles = cycles,
+        .stats = jit.GetStatistics(),
+        .dtlbMisses = tlbMisses.DTLBMisses(),
+        .itlbMisses = tlbMisses.ITLBMisses(),
+    };
+}
+
+// Prints the guest throughput and the compilation speed of a workload.
+// blocks/s is the number of blocks compiled per second spent translating, optimizing and compiling, which excludes the
+// time spent running guest code.
+// dTLB/Mc and iTLB/Mc are the TLB load misses per million guest cycles, which compares huge page modes independently of
+// the throughput; "-" means the counter is unavailable.
+void printResult(const Workload &workload, const Result &result) {
+    const auto &stats = result.stats;
+    auto avgUs = [](uint64_t timeNs, uint64_t blocks) { return blocks > 0 ? timeNs / 1000.0 / blocks : 0.0; };
+    const uint64_t compileNs = stats.translator.timeNs + stats.optimizer.timeNs + stats.compiler.timeNs;
+    const double blocksPerSec = compileNs > 0 ? stats.compiler.blocks * 1e9 / compileNs : 0.0;
+    auto missRate = [&](int64_t misses) {
+        char buf[16];
+        if (misses < 0 || result.cycles == 0) {
+            snprintf(buf, sizeof(buf), "-");
+        } else {
+            snprintf(buf, sizeof(buf), "%.2f", misses * 1e6 / result.cycles);
+        }
+        return std::string{buf};
+    };
+
+    printf("%-12s %10.2f %12.1f %10.2f %10.2f %10.2f %12llu %10s %10s\n", workload.name,
+           result.cycles / result.seconds / 1e6, blocksPerSec, avgUs(stats.translator.timeNs, stats.translator.blocks),
+           avgUs(stats.optimizer.timeNs, stats.optimizer.blocks), avgUs(stats.compiler.timeNs, stats.compiler.blocks),
+           (unsigned long long)stats.compiler.codeBytes, missRate(result.dtlbMisses).c_str(),
+           missRate(result.itlbMisses).c_str());
+}
+
+void printUsage(const char *argv0) {
+    printf("usage: %s [options] [workload...]\n\n", argv0);
+    printf("options:\n");
+    printf("  -t <seconds>               run each workload for the given time (default: 1)\n");
+    printf("  -m arm7|arm9               select the CPU model (default: arm9)\n");
+    printf("  -hp none|thp|explicit      back lookup tables and the code buffer with regular, transparent huge or\n");
+    printf("                             hugetlbfs pages (default: none); compare the TLB miss columns across modes\n");
+    printf("  -c                         enable instruction and data caches on RAM (ARM946E-S only)\n");
+    printf("  -cm                        enable the cache timing model\n");
+    printf("  -tt                        count cycles with the memory timing table\n");
+    printf("  -idiom                     enable idle and polling loop recognition\n");
+    printf("  -p <pass>, -np <pass>      enable or disable an optimizer pass, or all passes with \"all\"\n\n");
+    printf("passes:\n ");
+    for (auto &pass : kPassSwitches) {
+        printf(" %s", pass.name);
+    }
+    printf("\n\nworkloads:\n");
+    for (auto &workload : kWorkloads) {
+        printf("  %-12s %s\n", workload.name, workload.description);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions benchOptions{};
+    std::vector<const Workload *> selected;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-t" && i + 1 < argc) {
+            benchOptions.duration = std::atof(argv[++i]);
+        } else if (arg == "-m" && i + 1 < argc) {
+            const std::string name = argv[++i];
+            if (name == "arm7") {
+                benchOptions.model = CPUModel::ARM7TDMI;
+            } else if (name == "arm9") {
+                benchOptions.model = CPUModel::ARM946ES;
+            } else {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "-hp" && i + 1 < argc) {
+            const std::string name = argv[++i];
+            if (name == "none") {
+                benchOptions.hugePages = HugePageMode::None;
+            } else if (name == "thp") {
+                benchOptions.hugePages = HugePageMode::Transparent;
+            } else if (name == "explicit") {
+                benchOptions.hugePages = HugePageMode::Explicit;
+            } else {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "-c") {
+            benchOptions.caches = true;
+        } else if (arg == "-cm") {
+            benchOptions.cacheModel = true;
+        } else if (arg == "-tt") {
+            benchOptions.timingTable = true;
+        } else if (arg == "-idiom") {
+            benchOptions.idiomRecognition = true;
+        } else if ((arg == "-p" || arg == "-np") && i + 1 < argc) {
+            const std::string name = argv[++i];
+            if (!setPass(benchOptions.passes, name, arg == "-p")) {
+                printf("unknown pass: %s\n\n", name.c_str());
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return EXIT_SUCCESS;
+        } else {
+            const Workload *match = nullptr;
+            for (auto &workload : kWorkloads) {
+                if (arg == workload.name) {
+                    match = &workload;
+                    break;
+                }
+            }
+            if (match == nullptr) {
+                printf("unknown workload: %s\n\n", arg.c_str());
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            selected.push_back(match);
+        }
+    }
+    if (selected.empty()) {
+        for (auto &workload : kWorkloads) {
+            selected.push_back(&workload);
+        }
+    }
+
+    printf("armajitto %s\n\n", version::name);
+    printf("%-12s %10s %12s %10s %10s %10s %12s %10s %10s\n", "workload", "MIPS", "blocks/s", "xlat us", "opt us",
+           "comp us", "code bytes", "dTLB/Mc", "iTLB/Mc");
+    for (auto *workload : selected) {
+        printResult(*workload, runWorkload(*workload, benchOptions));
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,7 +1,9 @@
 #include <armajitto/armajitto.hpp>
 
 #include <algorithm>
+#include <array>
 #include <random>
+#include <string_view>
 
 #include "interp.hpp"
 #include "system.hpp"
@@ -989,7 +991,574 @@ void DualJITFuzzer(uint32_t offset, uint32_t limit) {
     }
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Generates random ARM and Thumb instructions that keep execution within a generated sequence.
+// Instructions never write to PC, change modes, raise exceptions or use UNPREDICTABLE register combinations.
+// Branches only jump forwards to an instruction within the sequence.
+class InstructionGenerator {
+public:
+    InstructionGenerator(uint32_t seed)
+        : m_generator(seed) {}
+
+    // Generates the ARM instruction at <index> of a sequence of <count> instructions followed by an infinite loop.
+    uint32_t ARM(uint32_t index, uint32_t count) {
+        const uint32_t kind = Rand(99);
+        if (kind < 40) {
+            return ARMDataProcessing();
+        } else if (kind < 50) {
+            return ARMMultiply();
+        } else if (kind < 56) {
+            return ARMDSP();
+        } else if (kind < 74) {
+            return ARMSingleDataTransfer();
+        } else if (kind < 84) {
+            return ARMHalfwordDataTransfer();
+        } else if (kind < 92) {
+            return ARMBlockDataTransfer();
+        } else {
+            // Branch to any instruction past this one, up to the infinite loop
+            const uint32_t target = index + 1 + Rand(count - index - 1);
+            const uint32_t offset = (target - index - 2) & 0xFFFFFF;
+            return (Cond() << 28) | 0x0A000000 | (Rand(1) << 24) | offset;
+        }
+    }
+
+    // Generates the Thumb instruction at <index> of a sequence of <count> instructions followed by an infinite loop.
+    uint16_t Thumb(uint32_t index, uint32_t count) {
+        const uint32_t kind = Rand(99);
+        if (kind < 8) {
+            // Move shifted register
+            return (Rand(2) << 11) | (Rand(31) << 6) | (Rand(7) << 3) | Rand(7);
+        } else if (kind < 16) {
+            // Add/subtract
+            return 0x1800 | (Rand(3) << 9) | (Rand(7) << 6) | (Rand(7) << 3) | Rand(7);
+        } else if (kind < 26) {
+            // Move/compare/add/subtract immediate
+            return 0x2000 | (Rand(3) << 11) | (Rand(7) << 8) | Rand(255);
+        } else if (kind < 40) {
+            // ALU operations
+            return 0x4000 | (Rand(15) << 6) | (Rand(7) << 3) | Rand(7);
+        } else if (kind < 46) {
+            // Hi register operations (ADD, CMP, MOV) with at least one high register and no writes to PC
+            const uint32_t rs = Rand(15);
+            const uint32_t rd = (rs < 8) ? 8 + Rand(6) : Rand(14);
+            return 0x4400 | (Rand(2) << 8) | ((rd >> 3) << 7) | (rs << 3) | (rd & 7);
+        } else if (kind < 50) {
+            // PC-relative load
+            return 0x4800 | (Rand(7) << 8) | Rand(255);
+        } else if (kind < 58) {
+            // Load/store with register offset; load/store sign-extended byte/halfword
+            return 0x5000 | (Rand(7) << 9) | (Rand(7) << 6) | (Rand(7) << 3) | Rand(7);
+        } else if (kind < 66) {
+            // Load/store with immediate offset
+            return 0x6000 | (Rand(3) << 11) | (Rand(31) << 6) | (Rand(7) << 3) | Rand(7);
+        } else if (kind < 70) {
+            // Load/store halfword
+            return 0x8000 | (Rand(1) << 11) | (Rand(31) << 6) | (Rand(7) << 3) | Rand(7);
+        } else if (kind < 74) {
+            // SP-relative load/store
+            return 0x9000 | (Rand(1) << 11) | (Rand(7) << 8) | Rand(255);
+        } else if (kind < 78) {
+            // Load address
+            return 0xA000 | (Rand(1) << 11) | (Rand(7) << 8) | Rand(255);
+        } else if (kind < 80) {
+            // Add offset to stack pointer
+            return 0xB000 | (Rand(1) << 7) | Rand(127);
+        } else if (kind < 84) {
+            // Push registers (optionally LR) or pop registers (never PC)
+            const uint32_t load = Rand(1);
+            const uint32_t lr = load ? 0 : Rand(1);
+            return 0xB400 | (load << 11) | (lr << 8) | (1 + Rand(254));
+        } else if (kind < 90) {
+            // Multiple load/store, excluding the base register from the list
+            const uint32_t rb = Rand(7);
+            const uint32_t rlist = (1 + Rand(254)) & ~(1 << rb);
+            return 0xC000 | (Rand(1) << 11) | (rb << 8) | (rlist != 0 ? rlist : (1 << ((rb + 1) & 7)));
+        } else {
+            // Conditional or unconditional branch to any instruction past this one, up to the infinite loop
+            const uint32_t target = index + 1 + Rand(count - index - 1);
+            const uint32_t offset = target - index - 2;
+            if (Rand(1)) {
+                return 0xD000 | (Rand(13) << 8) | (offset & 0xFF);
+            } else {
+                return 0xE000 | (offset & 0x7FF);
+            }
+        }
+    }
+
+private:
+    std::default_random_engine m_generator;
+
+    // Returns a random number in the range [0, max]
+    uint32_t Rand(uint32_t max) {
+        return std::uniform_int_distribution<uint32_t>{0, max}(m_generator);
+    }
+
+    // Returns a random condition code, favoring AL
+    uint32_t Cond() {
+        return Rand(3) != 0 ? 0xE : Rand(13);
+    }
+
+    // Returns a random register in R0..R14
+    uint32_t Reg() {
+        return Rand(14);
+    }
+
+    // Returns <count> distinct random registers in R0..R14
+    template <size_t count>
+    std::array<uint32_t, count> DistinctRegs() {
+        std::array<uint32_t, count> regs{};
+        for (size_t i = 0; i < count; i++) {
+            bool unique;
+            do {
+                regs[i] = Reg();
+                unique = std::find(regs.begin(), regs.begin() + i, regs[i]) == regs.begin() + i;
+            } while (!unique);
+        }
+        return regs;
+    }
+
+    uint32_t ARMDataProcessing() {
+        const uint32_t opcode = Rand(15);
+        const bool compare = opcode >= 0x8 && opcode <= 0xB;
+        const bool move = opcode == 0xD || opcode == 0xF;
+        const uint32_t s = compare ? 1 : Rand(1);
+        const uint32_t rd = compare ? 0 : Reg();
+
+        uint32_t rn;
+        uint32_t op2;
+        switch (Rand(2)) {
+        case 0: // Immediate
+            rn = Rand(15);
+            op2 = (1 << 25) | (Rand(15) << 8) | Rand(255);
+            break;
+        case 1: // Register shifted by immediate
+            rn = Rand(15);
+            op2 = (Rand(31) << 7) | (Rand(3) << 5) | Rand(15);
+            break;
+        default: // Register shifted by register; PC is not allowed in any operand
+            rn = Reg();
+            op2 = (Reg() << 8) | (Rand(3) << 5) | (1 << 4) | Reg();
+            break;
+        }
+        if (move) {
+            rn = 0;
+        }
+        return (Cond() << 28) | (opcode << 21) | (s << 20) | (rn << 16) | (rd << 12) | op2;
+    }
+
+    uint32_t ARMMultiply() {
+        if (Rand(1)) {
+            // MUL, MLA
+            const auto [rd, rm, rn, rs] = DistinctRegs<4>();
+            return (Cond() << 28) | 0x00000090 | (Rand(1) << 21) | (Rand(1) << 20) | (rd << 16) | (rn << 12) |
+                   (rs << 8) | rm;
+        } else {
+            // UMULL, UMLAL, SMULL, SMLAL
+            const auto [rdHi, rdLo, rm, rs] = DistinctRegs<4>();
+            return (Cond() << 28) | 0x00800090 | (Rand(3) << 21) | (Rand(1) << 20) | (rdHi << 16) | (rdLo << 12) |
+                   (rs << 8) | rm;
+        }
+    }
+
+    uint32_t ARMDSP() {
+        const auto [rd, rn, rs, rm] = DistinctRegs<4>();
+        const uint32_t yx = Rand(3) << 5;
+        switch (Rand(6)) {
+        case 0: // CLZ
+            return (Cond() << 28) | 0x016F0F10 | (rd << 12) | rm;
+        case 1: // QADD, QSUB, QDADD, QDSUB
+            return (Cond() << 28) | 0x01000050 | (Rand(3) << 21) | (rn << 16) | (rd << 12) | rm;
+        case 2: // SMLAxy
+            return (Cond() << 28) | 0x01000080 | (rd << 16) | (rn << 12) | (rs << 8) | yx | rm;
+        case 3: // SMLAWy
+            return (Cond() << 28) | 0x01200080 | (rd << 16) | (rn << 12) | (rs << 8) | (yx & 0x40) | rm;
+        case 4: // SMULWy
+            return (Cond() << 28) | 0x012000A0 | (rd << 16) | (rs << 8) | (yx & 0x40) | rm;
+        case 5: // SMLALxy
+            return (Cond() << 28) | 0x01400080 | (rd << 16) | (rn << 12) | (rs << 8) | yx | rm;
+        default: // SMULxy
+            return (Cond() << 28) | 0x01600080 | (rd << 16) | (rs << 8) | yx | rm;
+        }
+    }
+
+    // Returns the P, U and W bits of a load/store addressing mode, avoiding post-indexed writeback (LDRT/STRT)
+    // and writeback with PC as the base register.
+    uint32_t ARMAddressingMode(uint32_t &rn, uint32_t rd) {
+        const uint32_t p = Rand(1);
+        const uint32_t w = p ? Rand(1) : 0;
+        if (!p || w) {
+            // Writeback; base must not be PC or the transfer register
+            do {
+                rn = Reg();
+            } while (rn == rd);
+        } else {
+            rn = Rand(15);
+        }
+        return (p << 24) | (Rand(1) << 23) | (w << 21);
+    }
+
+    // Returns a random offset register that differs from the base register
+    uint32_t OffsetReg(uint32_t rn) {
+        uint32_t rm;
+        do {
+            rm = Reg();
+        } while (rm == rn);
+        return rm;
+    }
+
+    uint32_t ARMSingleDataTransfer() {
+        const uint32_t rd = Reg();
+        uint32_t rn;
+        const uint32_t puw = ARMAddressingMode(rn, rd);
+        const uint32_t offset = Rand(1) ? (1 << 25) | (Rand(31) << 7) | (Rand(3) << 5) | OffsetReg(rn) : Rand(0xFFF);
+        return (Cond() << 28) | 0x04000000 | puw | (Rand(1) << 22) | (Rand(1) << 20) | (rn << 16) | (rd << 12) |
+               offset;
+    }
+
+    uint32_t ARMHalfwordDataTransfer() {
+        const uint32_t rd = Reg();
+        uint32_t rn;
+        const uint32_t puw = ARMAddressingMode(rn, rd);
+        const uint32_t load = Rand(1);
+        const uint32_t sh = load ? 1 + Rand(2) : 1; // LDRH, LDRSB, LDRSH or STRH
+        const uint32_t offset = Rand(1) ? (1 << 22) | (Rand(15) << 8) | Rand(15) : OffsetReg(rn);
+        return (Cond() << 28) | 0x00000090 | puw | (load << 20) | (rn << 16) | (rd << 12) | (sh << 5) | offset;
+    }
+
+    uint32_t ARMBlockDataTransfer() {
+        const uint32_t rn = Reg();
+        const uint32_t w = Rand(1);
+        uint32_t rlist = Rand(0x7FFF);
+        if (w) {
+            rlist &= ~(1 << rn);
+        }
+        if (rlist == 0) {
+            rlist = 1 << ((rn + 1) % 15);
+        }
+        return (Cond() << 28) | 0x08000000 | (Rand(3) << 23) | (w << 21) | (Rand(1) << 20) | (rn << 16) | rlist;
+    }
+};
+
+// Optimizer passes that can be disabled from the command line to narrow down discrepancies
+struct PassSwitch {
+    const char *name;
+    bool Options::Optimizer::Passes::*enabled;
+};
+
+using Passes = Options::Optimizer::Passes;
+static const std::array<PassSwitch, 12> kPassSwitches = {{
+    {"const-prop", &Passes::constantPropagation},
+    {"cse", &Passes::commonSubexpressionElimination},
+    {"rle", &Passes::redundantLoadElimination},
+    {"dead-reg", &Passes::deadRegisterStoreElimination},
+    {"dead-gpr", &Passes::deadGPRStoreElimination},
+    {"dead-hflags", &Passes::deadHostFlagStoreElimination},
+    {"dead-flags", &Passes::deadFlagValueStoreElimination},
+    {"dead-var", &Passes::deadVariableStoreElimination},
+    {"bitwise", &Passes::bitwiseOpsCoalescence},
+    {"arith", &Passes::arithmeticOpsCoalescence},
+    {"hflags", &Passes::hostFlagsOpsCoalescence},
+    {"var-lifetime", &Passes::varLifetimeOptimization},
+}};
+
+struct BlockFuzzerOptions {
+    // Starts with all passes enabled, including those disabled by default
+    Passes passes = [] {
+        Passes passes{};
+        passes.SetAll(true);
+        return passes;
+    }();
+    bool lazyFlags = true;
+    bool quiet = false;
+};
+
+void interpVsJITBlockFuzzer(uint32_t seed, uint32_t iterations, const BlockFuzzerOptions &fuzzerOptions) {
+    FuzzerSystem interpSys;
+    FuzzerSystem jitSys;
+
+    auto interp = MakeARM946ESInterpreter(interpSys);
+
+    Specification spec{jitSys, CPUModel::ARM946ES};
+    Recompiler jit{spec};
+
+    // Keep the default block size, enable every optimizer pass and lazy flags materialization, and link blocks so
+    // that branches within the generated sequence are exercised
+    auto &options = jit.GetOptions();
+    options.optimizer.passes = fuzzerOptions.passes;
+    options.compiler.enableBlockLinking = true;
+    options.compiler.lazyFlagsMaterialization = fuzzerOptions.lazyFlags;
+    options.translator.cycleCountingMethod = Options::Translator::CycleCountingMethod::InstructionFixed;
+    options.translator.cyclesPerInstruction = 1;
+
+    auto &jitState = jit.GetARMState();
+
+    auto compareStates = [&] {
+        bool anyMismatch = false;
+
+        for (int i = 0; i < 16; i++) {
+            auto interpReg = interp->GPR(static_cast<arm::GPR>(i));
+            auto jitReg = jitState.GPR(static_cast<arm::GPR>(i));
+            if (interpReg != jitReg) {
+                anyMismatch = true;
+                printf("    R%d: expected %08X  !=  actual %08X\n", i, interpReg, jitReg);
+            }
+        }
+
+        auto interpCPSR = interp->GetCPSR();
+        auto jitCPSR = jitState.CPSR().u32;
+        if (interpCPSR != jitCPSR) {
+            anyMismatch = true;
+            printf("    CPSR: expected %08X  !=  actual %08X\n", interpCPSR, jitCPSR);
+        }
+
+        for (int i = 0; i < 256; i++) {
+            auto interpMem = interpSys.mem[i];
+            auto jitMem = jitSys.mem[i];
+            if (interpMem != jitMem) {
+                anyMismatch = true;
+                printf("    Memory [%02X]: expected %02X  !=  actual %02X\n", i, interpMem, jitMem);
+            }
+        }
+
+        return !anyMismatch;
+    };
+
+    InstructionGenerator generator{seed};
+    std::default_random_engine rng{seed};
+    std::uniform_int_distribution<uint32_t> flagsDistribution{0, 15};
+    std::uniform_int_distribution<uint32_t> armCountDistribution{1, jitSys.codemem.size() / sizeof(uint32_t) - 1};
+    std::uniform_int_distribution<uint32_t> thumbCountDistribution{1, jitSys.codemem.size() / sizeof(uint16_t) - 1};
+
+    uint32_t failures = 0;
+    for (uint32_t iteration = 0; iteration < iterations; iteration++) {
+        const bool thumb = (iteration & 1) != 0;
+        const auto mode = std::array{arm::Mode::System, arm::Mode::IRQ, arm::Mode::FIQ}[(iteration >> 1) % 3];
+
+        // Reset interpreter and JIT
+        interp->Reset();
+        jit.Reset();
+
+        // Reset system memory
+        interpSys.Reset();
+        jitSys.Reset();
+
+        // Fill code memory with a random sequence of instructions ending in an infinite loop
+        if (thumb) {
+            auto *code = reinterpret_cast<uint16_t *>(&jitSys.codemem[0]);
+            const uint32_t count = thumbCountDistribution(rng);
+            for (uint32_t i = 0; i < count; i++) {
+                code[i] = generator.Thumb(i, count);
+            }
+            code[count] = 0xE7FE; // b $
+        } else {
+            auto *code = reinterpret_cast<uint32_t *>(&jitSys.codemem[0]);
+            const uint32_t count = armCountDistribution(rng);
+            for (uint32_t i = 0; i < count; i++) {
+                code[i] = generator.ARM(i, count);
+            }
+            code[count] = 0xEAFFFFFE; // b $
+        }
+        interpSys.codemem = jitSys.codemem;
+
+        initInterp(*interp, mode, 0x10000, thumb);
+        initJIT(jitState, mode, 0x10000, thumb);
+
+        // Start with random flags
+        const uint32_t flags = flagsDistribution(rng) << 28;
+        jitState.CPSR().u32 |= flags;
+        interp->SetCPSR(interp->GetCPSR() | flags);
+
+        // Run both the interpreter and the JIT until they reach the infinite loop
+        auto cyclesExecuted = jit.Run(256);
+        interp->Run(cyclesExecuted);
+
+        // Compare states and print any discrepancies
+        if (!compareStates()) {
+            ++failures;
+            if (fuzzerOptions.quiet) {
+                continue;
+            }
+            printf("[!] Discrepancies found on iteration %u (seed %u, mode %d, %s)\n", iteration, seed,
+                   static_cast<int>(mode), thumb ? "Thumb" : "ARM");
+            printf("========================================================\n");
+            printf("Interpreter state\n");
+            printInterpState(*interp, interpSys, true);
+            printf("------------------------------------------------------------------------\n");
+            printf("JIT state\n");
+            printJITState(jitState, jitSys, true);
+            printf("========================================================\n\n");
+        }
+    }
+
+    printf("%u of %u sequences mismatched\n", failures, iterations);
+}
+
+// Runs the same random blocks through a JIT with every optimizer pass disabled and eager flags materialization and
+// through a JIT with the selected passes, isolating optimizer discrepancies from translator and interpreter ones
+void unoptVsOptBlockFuzzer(uint32_t seed, uint32_t iterations, const BlockFuzzerOptions &fuzzerOptions) {
+    FuzzerSystem unoptSys;
+    FuzzerSystem optSys;
+
+    Specification unoptSpec{unoptSys, CPUModel::ARM946ES};
+    Specification optSpec{optSys, CPUModel::ARM946ES};
+    Recompiler unoptJIT{unoptSpec};
+    Recompiler optJIT{optSpec};
+
+    for (auto *jit : {&unoptJIT, &optJIT}) {
+        auto &options = jit->GetOptions();
+        options.compiler.enableBlockLinking = true;
+        options.translator.cycleCountingMethod = Options::Translator::CycleCountingMethod::InstructionFixed;
+        options.translator.cyclesPerInstruction = 1;
+    }
+    unoptJIT.GetOptions().optimizer.passes.SetAll(false);
+    unoptJIT.GetOptions().compiler.lazyFlagsMaterialization = false;
+    optJIT.GetOptions().optimizer.passes = fuzzerOptions.passes;
+    optJIT.GetOptions().compiler.lazyFlagsMaterialization = fuzzerOptions.lazyFlags;
+
+    auto &unoptState = unoptJIT.GetARMState();
+    auto &optState = optJIT.GetARMState();
+
+    auto compareStates = [&](uint64_t unoptCycles, uint64_t optCycles) {
+        bool anyMismatch = false;
+
+        if (unoptCycles != optCycles) {
+            anyMismatch = true;
+            printf("    Cycles: expected %llu  !=  actual %llu\n", static_cast<unsigned long long>(unoptCycles),
+                   static_cast<unsigned long long>(optCycles));
+        }
+
+        for (int i = 0; i < 16; i++) {
+            auto unoptReg = unoptState.GPR(static_cast<arm::GPR>(i));
+            auto optReg = optState.GPR(static_cast<arm::GPR>(i));
+            if (unoptReg != optReg) {
+                anyMismatch = true;
+                printf("    R%d: expected %08X  !=  actual %08X\n", i, unoptReg, optReg);
+            }
+        }
+
+        auto unoptCPSR = unoptState.CPSR().u32;
+        auto optCPSR = optState.CPSR().u32;
+        if (unoptCPSR != optCPSR) {
+            anyMismatch = true;
+            printf("    CPSR: expected %08X  !=  actual %08X\n", unoptCPSR, optCPSR);
+        }
+
+        for (int i = 0; i < 256; i++) {
+            auto unoptMem = unoptSys.mem[i];
+            auto optMem = optSys.mem[i];
+            if (unoptMem != optMem) {
+                anyMismatch = true;
+                printf("    Memory [%02X]: expected %02X  !=  actual %02X\n", i, unoptMem, optMem);
+            }
+        }
+
+        return !anyMismatch;
+    };
+
+    InstructionGenerator generator{seed};
+    std::default_random_engine rng{seed};
+    std::uniform_int_distribution<uint32_t> flagsDistribution{0, 15};
+    std::uniform_int_distribution<uint32_t> armCountDistribution{1, optSys.codemem.size() / sizeof(uint32_t) - 1};
+    std::uniform_int_distribution<uint32_t> thumbCountDistribution{1, optSys.codemem.size() / sizeof(uint16_t) - 1};
+
+    uint32_t failures = 0;
+    for (uint32_t iteration = 0; iteration < iterations; iteration++) {
+        const bool thumb = (iteration & 1) != 0;
+        const auto mode = std::array{arm::Mode::System, arm::Mode::IRQ, arm::Mode::FIQ}[(iteration >> 1) % 3];
+
+        unoptJIT.Reset();
+        optJIT.Reset();
+        unoptSys.Reset();
+        optSys.Reset();
+
+        // Fill code memory with a random sequence of instructions ending in an infinite loop
+        if (thumb) {
+            auto *code = reinterpret_cast<uint16_t *>(&optSys.codemem[0]);
+            const uint32_t count = thumbCountDistribution(rng);
+            for (uint32_t i = 0; i < count; i++) {
+                code[i] = generator.Thumb(i, count);
+            }
+            code[count] = 0xE7FE; // b $
+        } else {
+            auto *code = reinterpret_cast<uint32_t *>(&optSys.codemem[0]);
+            const uint32_t count = armCountDistribution(rng);
+            for (uint32_t i = 0; i < count; i++) {
+                code[i] = generator.ARM(i, count);
+            }
+            code[count] = 0xEAFFFFFE; // b $
+        }
+        unoptSys.codemem = optSys.codemem;
+
+        initJIT(unoptState, mode, 0x10000, thumb);
+        initJIT(optState, mode, 0x10000, thumb);
+
+        // Start with random flags
+        const uint32_t flags = flagsDistribution(rng) << 28;
+        unoptState.CPSR().u32 |= flags;
+        optState.CPSR().u32 |= flags;
+
+        // Both JITs must reach the infinite loop at the same time
+        const uint64_t unoptCycles = unoptJIT.Run(256);
+        const uint64_t optCycles = optJIT.Run(256);
+
+        // Compare states and print any discrepancies
+        if (!compareStates(unoptCycles, optCycles)) {
+            ++failures;
+            if (fuzzerOptions.quiet) {
+                continue;
+            }
+            printf("[!] Discrepancies found on iteration %u (seed %u, mode %d, %s)\n", iteration, seed,
+                   static_cast<int>(mode), thumb ? "Thumb" : "ARM");
+            printf("========================================================\n");
+            printf("Unoptimized JIT state\n");
+            printJITState(unoptState, unoptSys, true);
+            printf("------------------------------------------------------------------------\n");
+            printf("Optimized JIT state\n");
+            printJITState(optState, optSys, true);
+            printf("========================================================\n\n");
+        }
+    }
+
+    printf("%u of %u sequences mismatched\n", failures, iterations);
+}
+
 int main(int argc, char *argv[]) {
+    // armajitto-fuzzer blocks [seed] [iterations] [-np <pass>]... [-no-lazy-flags] [-q]
+    // armajitto-fuzzer passes [seed] [iterations] [-np <pass>]... [-no-lazy-flags] [-q]
+    if (argc >= 2 && (std::string_view{argv[1]} == "blocks" || std::string_view{argv[1]} == "passes")) {
+        const uint32_t seed = (argc >= 3) ? atoi(argv[2]) : 0;
+        const uint32_t iterations = (argc >= 4) ? atoi(argv[3]) : 100000;
+        BlockFuzzerOptions fuzzerOptions{};
+        for (int i = 4; i < argc; i++) {
+            const std::string_view arg = argv[i];
+            if (arg == "-np" && i + 1 < argc) {
+                const std::string_view name = argv[++i];
+                auto it = std::find_if(kPassSwitches.begin(), kPassSwitches.end(),
+                                       [&](const PassSwitch &pass) { return name == pass.name; });
+                if (it == kPassSwitches.end()) {
+                    printf("unknown pass: %s\n", argv[i]);
+                    return 1;
+                }
+                fuzzerOptions.passes.*it->enabled = false;
+            } else if (arg == "-no-lazy-flags") {
+                fuzzerOptions.lazyFlags = false;
+            } else if (arg == "-q") {
+                fuzzerOptions.quiet = true;
+            } else {
+                printf("unknown option: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        if (std::string_view{argv[1]} == "blocks") {
+            interpVsJITBlockFuzzer(seed, iterations, fuzzerOptions);
+        } else {
+            unoptVsOptBlockFuzzer(seed, iterations, fuzzerOptions);
+        }
+        return 0;
+    }
+
     {
         int offset = 0;
         uint32_t limit = 0x20;
@@ -9,14 +9,26 @@ namespace armajitto {
 struct MemoryMapPrivateAccess;
 
 struct MemoryMap {
-    MemoryMap(size_t pageSize);
+    MemoryMap(size_t pageSize, HugePageMode hugePages = HugePageMode::None);
     ~MemoryMap();
 
+    // The optimizer checks the attributes of regions accessed through constant addresses while compiling blocks.
+    // Changes to the data areas discard blocks compiled with those checks before the recompiler looks up the next
+    // block. Blocks already running, including those directly linked to them, finish with the previous layout.
     void Map(MemoryArea areas, uint8_t layer, uint32_t baseAddress, uint32_t size, MemoryAttributes attrs, uint8_t *ptr,
              uint64_t mirrorSize = 0x1'0000'0000);
 
     void Unmap(MemoryArea areas, uint8_t layer, uint32_t baseAddress, uint64_t size);
 
+    // Assigns access timings to a range of the address space for the specified areas.
+    // Timings are tracked in blocks of kTimingBlockSize bytes; the range is expanded to cover whole blocks.
+    // Only used with the SubinstructionTimingTable cycle counting method. Code fetches and accesses to constant
+    // addresses are folded into compiled blocks, so the code cache should be invalidated after changing timings.
+    void SetTimings(MemoryArea areas, uint32_t baseAddress, uint64_t size, const MemoryAccessTimings &timings);
+
+    static constexpr uint32_t kTimingBlockShift = 20;
+    static constexpr uint64_t kTimingBlockSize = 1ull << kTimingBlockShift;
+
 private:
     struct Impl;
     std::unique_ptr<Impl> m_impl;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 
 namespace armajitto {
@@ -34,4 +35,26 @@ enum class MemoryAttributes {
     RWV = Readable | Writable | Volatile,   // MMIO areas
 };
 
+// Specifies how large lookup tables and code buffers are backed by huge pages.
+// Huge pages are only supported on Linux; other platforms always use regular pages.
+enum class HugePageMode {
+    // Use regular pages.
+    None,
+
+    // Request transparent huge pages with madvise(MADV_HUGEPAGE).
+    Transparent,
+
+    // Allocate huge pages from the hugetlbfs pool with MAP_HUGETLB.
+    // Falls back to transparent huge pages if the pool is exhausted.
+    Explicit,
+};
+
+// Number of cycles taken by memory accesses to a region of the address space.
+// Used by the SubinstructionTimingTable cycle counting method.
+// The arrays are indexed by access size: 0 = byte, 1 = halfword, 2 = word.
+struct alignas(8) MemoryAccessTimings {
+    uint8_t nonsequential[3] = {1, 1, 1};
+    uint8_t sequential[3] = {1, 1, 1};
+};
+
 } // namespace armajitto
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "memory_params.hpp"
+
 #include <cstdint>
 
 namespace armajitto {
@@ -11,6 +13,13 @@ struct Options {
         // Specifies the maximum number of instructions to translate into a basic block.
         uint32_t maxBlockSize = 32;
 
+        // Inserts a deadline check between every <deadlineCheckInterval> instructions of a basic block, allowing
+        // execution to stop in the middle of a block once the cycle count deadline is reached instead of running the
+        // block to completion. Zero disables mid-block checks, leaving deadline checks only at the end of blocks.
+        // Use this instead of lowering maxBlockSize to stop closer to the requested number of cycles.
+        // Guest state is updated at every check, which limits optimizations across instructions on either side.
+        uint32_t deadlineCheckInterval = 0;
+
         enum class CycleCountingMethod {
             // Each instruction takes a fixed amount of cycles to execute.
             InstructionFixed,
@@ -18,9 +27,10 @@ struct Options {
             // Compute S/N/I cycles, assuming all memory accesses take a constant number of cycles.
             SubinstructionFixed,
 
-            // TODO: implement this
-            // Compute S/N/I cycles using a memory access timing table.
-            // SubinstructionTimingTable,
+            // Compute S/N/I cycles using the memory access timings assigned with MemoryMap::SetTimings.
+            // Code fetches and accesses to constant addresses are computed at compile time; other accesses look up
+            // the timing table at runtime.
+            SubinstructionTimingTable,
         };
 
         // Specifies how the translator counts cycles.
@@ -33,6 +43,17 @@ struct Options {
         // Number of cycles per memory access.
         // Used when method == CycleCountingMethod::SubinstructionFixed.
         uint64_t cyclesPerMemoryAccess = 1;
+
+        // Recognizes memory copy and fill loops and runs all but their last iteration with host memory operations
+        // Copy loops: LDMIA/STMIA pairs, or post-indexed LDR/STR pairs of any size (ARM only)
+        // Fill loops: STMIA, or post-indexed STR of any size (ARM only)
+        // The loop counter must be decremented by a constant with SUBS (ARM) or SUB (Thumb) and checked by the branch
+        // closing the loop with NE, GT, GE, HI or CS
+        // Accesses to unmapped memory (e.g. MMIO) are always executed by the loop itself
+        // Has no effect with the SubinstructionTimingTable cycle counting method or the cache timing model
+        bool idiomRecognition = false;
+
+        bool operator==(const Translator &) const = default;
     } translator;
 
     // Options for the optimization stage
@@ -41,6 +62,13 @@ struct Options {
         struct Passes {
             bool constantPropagation = true;
 
+            // Reuses values of identical computations and register reads within a block
+            bool commonSubexpressionElimination = true;
+
+            // Forwards stored values to subsequent loads and eliminates duplicate loads from RAM
+            // Has no effect while the cache timing model is enabled
+            bool redundantLoadElimination = true;
+
             bool deadRegisterStoreElimination = true;
             bool deadGPRStoreElimination = true;
             bool deadHostFlagStoreElimination = true;
@@ -51,10 +79,13 @@ struct Options {
             bool arithmeticOpsCoalescence = true;
             bool hostFlagsOpsCoalescence = true;
 
-            // bool varLifetimeOptimization = true;
+            // Reorders instructions to shorten variable lifetimes, reducing register pressure in long blocks
+            bool varLifetimeOptimization = true;
 
             void SetAll(bool enabled) {
                 constantPropagation = enabled;
+                commonSubexpressionElimination = enabled;
+                redundantLoadElimination = enabled;
 
                 deadRegisterStoreElimination = enabled;
                 deadGPRStoreElimination = enabled;
@@ -66,12 +97,23 @@ struct Options {
                 arithmeticOpsCoalescence = enabled;
                 hostFlagsOpsCoalescence = enabled;
 
-                // varLifetimeOptimization = enabled;
+                varLifetimeOptimization = enabled;
             }
+
+            bool operator==(const Passes &) const = default;
         } passes;
 
-        // Maximum number of optimization iterations to perform
+        // Maximum number of rounds over the enabled passes. Each round runs the passes that may still change the block,
+        // and each of those scans the whole block.
         uint8_t maxIterations = 20;
+
+        // Assumes that memory accesses relative to the stack pointer always target plain RAM.
+        // The redundant load elimination pass can only prove that accesses to constant addresses target RAM by checking
+        // their attributes in the memory map. Enabling this option allows it to also forward values spilled to the
+        // stack. Do not enable this if the guest may point SP to MMIO registers.
+        bool assumeStackInRAM = false;
+
+        bool operator==(const Optimizer &) const = default;
     } optimizer;
 
     // Options for the host compiler stage
@@ -88,7 +130,85 @@ struct Options {
         // Enables block linking, which can significantly speed up execution
         // This option only takes effect on construction or after invoking Host::Clear()
         bool enableBlockLinking = true;
+
+        // Emits inline ITCM/DTCM range checks ahead of the memory map lookup on variable address memory accesses
+        // Speeds up TCM accesses at the cost of a few extra instructions on accesses to other regions
+        // Only applies to CPUs with a system control coprocessor and configured TCMs
+        // This option only takes effect on construction or after invoking Host::Clear()
+        bool inlineTCMAccesses = true;
+
+        // Defers the copy of the NZCV flags into CPSR at the end of blocks to the direct link to the next block, and
+        // skips it entirely if the linked block copies the same flags into CPSR before anything else can observe them
+        // CPSR is always up to date when leaving compiled code or entering exceptions; memory access handlers may
+        // observe stale NZCV flags in CPSR, as they already might within a block
+        // Requires enableBlockLinking
+        // Off by default since memory access handlers may then observe flags left stale by an earlier linked block,
+        // which breaks systems that inspect CPSR from those handlers
+        // Only implemented by the x86-64 host; other hosts ignore it
+        // This option only takes effect on construction or after invoking Host::Clear()
+        bool lazyFlagsMaterialization = false;
+
+        // Models the instruction and data cache tag arrays configured through the system control coprocessor
+        // Instruction fetches and data reads that miss a cacheable line take cacheLineFillCycles extra cycles
+        // Data writes never allocate lines (the ARM946E-S caches are read-allocate)
+        // Cache hits and uncacheable accesses take no extra cycles beyond those counted by the translator
+        // Only applies to CPUs with a system control coprocessor and configured caches
+        // This option only takes effect on construction or after invoking Host::Clear()
+        bool cacheTimingModel = false;
+
+        // Number of cycles taken to fill a cache line
+        // Used when cacheTimingModel is enabled
+        uint64_t cacheLineFillCycles = 8;
+
+        // Instruments compiled code with per-block execution counters and counts slow memory accesses, blocks discarded
+        // by the memory generation check, block link patches and exits to the dispatcher by reason
+        // The counters are retrievable through Recompiler::GetRuntimeStatistics()
+        // Adds a few instructions to every block and slow memory access
+        // This option only takes effect on construction or after invoking Host::Clear()
+        bool instrumentation = false;
+
+        // Checks for invalidations posted from other threads through Recompiler::PostMemoryWrite() or
+        // Recompiler::PostInvalidateCodeCacheRange() on entry to every block, returning to the dispatcher to apply them
+        // When disabled, posted invalidations are only applied when execution returns to the dispatcher on its own
+        // Adds a memory load and a branch to every block
+        // This option only takes effect on construction or after invoking Host::Clear()
+        bool pollInvalidationQueue = false;
+
+        // Backs the code buffer, block cache and memory generation tracker with huge pages to reduce TLB misses
+        // Falls back to regular pages if huge pages cannot be allocated
+        // This option only takes effect on construction; see Specification::options
+        // The guest memory map tables are configured separately through ISystem
+        HugePageMode hugePages = HugePageMode::None;
+
+        // Writes the address, size and name of compiled code to /tmp/perf-<pid>.map so that the Linux perf profiler
+        // can symbolize samples in compiled code; blocks are named after their guest location
+        // Only supported on Linux
+        // This option only takes effect on construction
+        bool perfMap = false;
+
+        // Writes compiled code and its names to /tmp/jit-<pid>.dump in the jitdump format, which allows perf annotate
+        // to disassemble compiled code after merging the profile with perf inject --jit
+        // Record profiles with perf record -k 1 to match the timestamps in the dump
+        // Only supported on Linux
+        // This option only takes effect on construction
+        bool perfJitDump = false;
     } compiler;
+
+    // Collects compile-time statistics for every stage, retrievable through Recompiler::GetStatistics()
+    // Adds a small overhead to block compilation; has no effect on the generated code
+    bool collectStatistics = false;
+
+    // Options for the guest code sampling profiler
+    struct Profiler {
+        // Samples the guest location every samplingInterval cycles, retrievable through Recompiler::GetProfile()
+        // Execution is split into slices that end on sample points, which adds a dispatcher round trip per sample
+        // With a cycle count deadline, changes to the deadline made while running code only take effect at the next
+        // sample point
+        bool enabled = false;
+
+        // Number of cycles between samples
+        uint64_t samplingInterval = 10000;
+    } profiler;
 };
 
 } // namespace armajitto
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "armajitto/guest/arm/mode.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace armajitto {
+
+// Guest code location sampled by the profiler while Options::Profiler::enabled is set.
+struct ProfiledBlock {
+    // Location of the block
+    uint32_t pc = 0;
+    arm::Mode mode = arm::Mode::User;
+    bool thumb = false;
+
+    // Number of samples taken at this location
+    uint64_t samples = 0;
+
+    // Size of the most recent compilation of the block.
+    // These are zero if the block was compiled while the profiler was disabled.
+    uint32_t instructions = 0; // Guest instructions
+    uint32_t irOps = 0;        // IR ops after optimization
+    uint64_t codeBytes = 0;    // Bytes of host code
+};
+
+// Sampling profile collected since the profiler was enabled or the last call to Recompiler::ResetProfile().
+struct GuestProfile {
+    uint64_t totalSamples = 0;
+
+    // Sampled blocks, ordered from most to least samples
+    std::vector<ProfiledBlock> blocks;
+};
+
+} // namespace armajitto
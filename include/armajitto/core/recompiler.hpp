@@ -3,7 +3,9 @@
 #include "armajitto/guest/arm/state.hpp"
 #include "context.hpp"
 #include "options.hpp"
+#include "profiler.hpp"
 #include "specification.hpp"
+#include "statistics.hpp"
 
 #include <memory>
 
@@ -52,6 +54,33 @@ public:
 
     void ReportMemoryWrite(uint32_t start, uint32_t end);
 
+    // Thread-safe variants of ReportMemoryWrite() and InvalidateCodeCacheRange(), meant for DMA controllers and other
+    // devices emulated on separate threads. Requests are queued and applied by the thread calling Run() the next time
+    // execution returns to the dispatcher, or on entry to the next block if Options::Compiler::pollInvalidationQueue is
+    // enabled. Both <start> and <end> are inclusive.
+    void PostMemoryWrite(uint32_t start, uint32_t end);
+    void PostInvalidateCodeCacheRange(uint32_t start, uint32_t end);
+
+    // Retrieves the compile-time statistics collected while Options::collectStatistics is enabled.
+    const CompilerStatistics &GetStatistics() const;
+
+    // Resets all compile-time statistics.
+    void ResetStatistics();
+
+    // Retrieves a snapshot of the runtime statistics collected while Options::Compiler::instrumentation is enabled,
+    // including up to <maxBlocks> of the most executed blocks.
+    RuntimeStatistics GetRuntimeStatistics(size_t maxBlocks = 32) const;
+
+    // Resets all runtime statistics.
+    void ResetRuntimeStatistics();
+
+    // Retrieves up to <maxBlocks> of the most sampled blocks from the profile collected while
+    // Options::Profiler::enabled is set.
+    GuestProfile GetProfile(size_t maxBlocks = 32) const;
+
+    // Discards all samples collected by the profiler.
+    void ResetProfile();
+
 private:
     Specification m_spec;
     Context m_context;
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+namespace armajitto {
+
+struct SharedCodeCachePrivateAccess;
+
+// Thread-safe cache of translated and optimized guest code shared by multiple Recompiler instances, which may run on
+// different threads. Assign it to Specification::sharedCodeCache to let instances reuse each other's blocks.
+//
+// Blocks are looked up by guest location and verified against the guest code they were translated from, so instances
+// running different code at the same addresses never pick up each other's blocks. Only instances with the same CPU
+// model and translator and optimizer options share blocks. Each instance still compiles host code and links blocks on
+// its own; sharing skips the translation and optimization stages.
+struct SharedCodeCache {
+    SharedCodeCache();
+    ~SharedCodeCache();
+
+    // Discards all shared blocks. Blocks already compiled by Recompiler instances are not affected.
+    void Clear();
+
+    // Retrieves the number of blocks in the cache.
+    size_t BlockCount() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+
+    friend struct SharedCodeCachePrivateAccess;
+};
+
+} // namespace armajitto
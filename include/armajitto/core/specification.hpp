@@ -1,6 +1,8 @@
 #pragma once
 
 #include "armajitto/defs/cpu_model.hpp"
+#include "options.hpp"
+#include "shared_code_cache.hpp"
 #include "system_interface.hpp"
 
 namespace armajitto {
@@ -18,6 +20,17 @@ struct Specification {
     // Pointing this to a variable is useful in scenarios where the next deadline might change while JITted code is
     // executed, requiring an early break out of a block.
     const uint64_t *cycleCountDeadline = nullptr;
+
+    // Specifies a cache of translated and optimized blocks shared with other Recompiler instances, which may run on
+    // other threads. Blocks are only reused if they were translated from identical guest code.
+    // Instances sharing a cache must use identical memory map layouts and attributes, as the optimizer relies on them.
+    // The cache must outlive the recompiler. Blocks are not shared with the SubinstructionTimingTable cycle counting
+    // method or if they end in an idle loop, since those depend on the memory map timings and on runtime state.
+    SharedCodeCache *sharedCodeCache = nullptr;
+
+    // Specifies the initial options. If not specified, the recompiler starts with default options.
+    // Options that only take effect on construction, such as Options::Compiler::hugePages, must be set here.
+    const Options *options = nullptr;
 };
 
 } // namespace armajitto
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "armajitto/guest/arm/mode.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace armajitto {
+
+// Optimization passes, in the order they are scheduled by the optimizer
+enum class OptimizerPass : uint8_t {
+    ConstantPropagation,
+    CommonSubexpressionElimination,
+    RedundantLoadElimination,
+    DeadRegisterStoreElimination,
+    DeadGPRStoreElimination,
+    DeadHostFlagStoreElimination,
+    DeadFlagValueStoreElimination,
+    DeadVariableStoreElimination,
+    BitwiseOpsCoalescence,
+    ArithmeticOpsCoalescence,
+    HostFlagsOpsCoalescence,
+    VarLifetimeOptimization,
+
+    _Count
+};
+
+inline constexpr size_t kNumOptimizerPasses = static_cast<size_t>(OptimizerPass::_Count);
+
+// Compile-time statistics gathered while Options::collectStatistics is enabled.
+// All counters are cumulative since construction or the last call to Recompiler::ResetStatistics().
+// Times are measured in nanoseconds of wall-clock time.
+struct CompilerStatistics {
+    // Translation stage
+    struct Translator {
+        uint64_t blocks = 0;
+        uint64_t instructions = 0;
+        uint64_t timeNs = 0;
+    } translator;
+
+    // Optimization stage
+    struct Optimizer {
+        struct Pass {
+            uint64_t invocations = 0;        // Number of times the pass ran
+            uint64_t changedInvocations = 0; // Number of runs that modified the block
+            uint64_t opsRemoved = 0;         // IR ops erased by the pass
+            uint64_t opsReplaced = 0;        // IR ops overwritten by the pass
+            uint64_t timeNs = 0;
+        };
+
+        uint64_t blocks = 0;
+        uint64_t timeNs = 0;
+
+        // Number of scheduling rounds taken to reach a fixpoint
+        uint64_t totalIterations = 0;
+        uint64_t maxIterations = 0;
+
+        // Number of blocks that hit Options::Optimizer::maxIterations before reaching a fixpoint
+        uint64_t unfinishedBlocks = 0;
+
+        std::array<Pass, kNumOptimizerPasses> passes{};
+
+        Pass &operator[](OptimizerPass pass) {
+            return passes[static_cast<size_t>(pass)];
+        }
+
+        const Pass &operator[](OptimizerPass pass) const {
+            return passes[static_cast<size_t>(pass)];
+        }
+    } optimizer;
+
+    // Host compilation stage
+    struct Compiler {
+        uint64_t blocks = 0;
+        uint64_t timeNs = 0;
+
+        // Bytes of host code emitted, excluding the common prolog/epilog and patches applied to other blocks
+        uint64_t codeBytes = 0;
+        uint64_t maxBlockCodeBytes = 0;
+    } compiler;
+
+    // Shared code cache lookups, made while Specification::sharedCodeCache is set.
+    // Hits skip the translation and optimization stages and are not counted in their statistics.
+    struct SharedCache {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    } sharedCache;
+};
+
+// Runtime statistics gathered while Options::Compiler::instrumentation is enabled.
+// All counters are cumulative since construction or the last call to Recompiler::ResetRuntimeStatistics().
+struct RuntimeStatistics {
+    struct Block {
+        uint32_t pc = 0;
+        arm::Mode mode = arm::Mode::User;
+        bool thumb = false;
+        uint64_t executions = 0;
+    };
+
+    // Number of times compiled blocks were entered, including through block links and self-loops
+    uint64_t blockExecutions = 0;
+
+    // Most executed blocks, ordered from most to least executions
+    std::vector<Block> blocks;
+
+    // Memory accesses to addresses absent from the memory map, handled by ISystem callbacks
+    uint64_t slowMemoryAccesses = 0;
+
+    // Block lookups made by the dispatcher, and lookups that found no compiled code
+    uint64_t codeLookups = 0;
+    uint64_t codeLookupMisses = 0;
+
+    // Blocks discarded by the memory generation check after their code was written to
+    uint64_t invalidatedBlocks = 0;
+
+    // Direct block link patches applied to and reverted from compiled code
+    uint64_t patchesApplied = 0;
+    uint64_t patchesReverted = 0;
+
+    // Returns from compiled code to the dispatcher, by reason
+    struct Exits {
+        uint64_t deadline = 0;       // Ran out of cycles
+        uint64_t halt = 0;           // CPU halted
+        uint64_t unlinkedBranch = 0; // Branched to a block that is not compiled or linked, or was invalidated
+        uint64_t irq = 0;            // Entered an IRQ or FIQ handler that is not compiled or linked
+    } exits;
+};
+
+} // namespace armajitto
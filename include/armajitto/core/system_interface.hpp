@@ -18,11 +18,26 @@ public:
     virtual void MemWriteHalf(uint32_t address, uint16_t value) = 0;
     virtual void MemWriteWord(uint32_t address, uint32_t value) = 0;
 
+    // Determines if loops that poll the specified address may be fast-forwarded to the cycle count deadline.
+    // Consulted while compiling loops whose only external inputs are reads from unmapped or Volatile memory regions.
+    // Return true only if the value at the address cannot change until the deadline is reached, such as registers that
+    // are exclusively updated by scheduled events (e.g. VCOUNT or interrupt flags).
+    // Invalidate the code cache if the result changes for an address.
+    virtual bool CanSkipPollingLoop(uint32_t /*address*/) {
+        return false;
+    }
+
     MemoryMap &GetMemoryMap() {
         return m_memMap;
     }
 
 protected:
+    ISystem() = default;
+
+    // Backs the memory map's lookup tables with huge pages.
+    ISystem(HugePageMode hugePages)
+        : m_memMap{4096, hugePages} {}
+
     MemoryMap m_memMap{4096};
 };
 
@@ -11,6 +11,7 @@
 #include "cp15/cp15_tcm.hpp"
 
 #include <bit>
+#include <span>
 #include <vector>
 
 namespace armajitto {
@@ -22,6 +23,7 @@ class Host;
 namespace armajitto::arm {
 
 using InvalidateCodeCacheCallback = void (*)(uint32_t start, uint32_t end, void *ctx);
+using ReportMemoryWriteCallback = void (*)(uint32_t start, uint32_t end, void *ctx);
 
 class SystemControlCoprocessor : public Coprocessor {
 public:
@@ -68,6 +70,22 @@ public:
         return m_cache;
     }
 
+    // Simulates an instruction fetch or data access through the caches for the cache timing model.
+    // Fills the line on a cacheable miss. Uncacheable accesses, including those to the TCMs, never allocate lines.
+    // Returns true if the access missed a cacheable line.
+    bool CodeCacheMiss(uint32_t address);
+    bool DataCacheMiss(uint32_t address);
+
+    // Appends the coprocessor registers, cache tag arrays and TCM contents to <out>.
+    void SaveState(std::vector<uint8_t> &out) const;
+
+    // Restores the state written by SaveState() from the start of <in> and returns the number of bytes consumed.
+    // Returns 0 without modifying the coprocessor if the data is truncated or was saved with a different TCM or cache
+    // configuration.
+    // Registers are only rewritten if their values differ, so compiled code is preserved unless the protection unit is
+    // toggled. Changes to TCM contents and mappings are reported as memory writes to the affected address ranges.
+    size_t LoadState(std::span<const uint8_t> in);
+
     // -------------------------------------------------------------------------
     // Coprocessor interface implementation
 
@@ -83,16 +101,44 @@ private:
     bool m_installed = false;
 
     ExecState &m_execState;
+    MemoryMap *m_memMap = nullptr;
 
     InvalidateCodeCacheCallback m_invalidateCodeCacheCallback = nullptr;
     void *m_invalidateCodeCacheCallbackCtx = nullptr;
 
+    ReportMemoryWriteCallback m_reportMemoryWriteCallback = nullptr;
+    void *m_reportMemoryWriteCallbackCtx = nullptr;
+
     cp15::Identification m_id;
     cp15::ControlRegister m_ctl;
     cp15::ProtectionUnit m_pu;
     cp15::TCM m_tcm;
     cp15::Cache m_cache;
 
+    // Whether the memory map permission views are currently filtered by the protection unit.
+    bool m_puEnforced = false;
+
+    // Installs or removes the protection unit filters on the memory map permission views.
+    void SetupPermissionMaps(bool enable);
+
+    // Re-evaluates the memory map permission views over the specified range.
+    void UpdatePermissionMaps(uint32_t baseAddress, uint64_t size, bool data, bool code);
+
+    // Re-evaluates the memory map permission views over the ranges of the regions whose access permissions changed.
+    void UpdatePermissionMaps(uint32_t prevPerms, uint32_t newPerms, bool code);
+
+    // Rebuilds the cacheability maps of the cache timing model from the control register, the protection unit
+    // cachability bits and the TCM ranges.
+    void UpdateCacheabilityMaps();
+
+    // Reports a memory write to the specified range through the callback, if set.
+    void ReportMemoryWrite(uint32_t start, uint32_t end);
+
+    // Copies <contents> into the TCM buffer and reports memory writes to the guest addresses that map to the changed
+    // bytes, starting at <baseAddress> and repeated every <tcmSize> bytes for <mappedSize> bytes.
+    void RestoreTCMContents(uint8_t *tcm, uint32_t tcmSize, std::span<const uint8_t> contents, uint32_t baseAddress,
+                            uint32_t mappedSize);
+
     // Gives hosts access to the callback fields above.
     struct PrivateAccess;
     friend class armajitto::Host;
@@ -3,9 +3,51 @@
 #include "armajitto/guest/arm/coprocessors/cp15/cp15_defs.hpp"
 
 #include <cstdint>
+#include <vector>
 
 namespace armajitto::arm::cp15 {
 
+// Tag array of a set-associative cache.
+// Only tracks which lines are present for timing purposes; cache contents are not emulated.
+struct CacheTagArray {
+    // Marks an empty way. Never matches a line number since lines are at least 8 bytes long.
+    static constexpr uint32_t kInvalidTag = 0xFFFFFFFF;
+
+    uint32_t lineShift = 0;
+    uint32_t setMask = 0;
+    uint32_t numWays = 0; // 0 = cache absent
+
+    // Line numbers (address >> lineShift) indexed by [set * numWays + way]
+    std::vector<uint32_t> tags;
+
+    // Next way to replace on each set (round-robin)
+    std::vector<uint8_t> nextWay;
+
+    // Lockdown register (format B):
+    //   31     L    Load bit: 1 = line fills are forced into the lockdown base way
+    //   1-0    Lockdown base way; ways below it are locked and never replaced
+    uint32_t lockdown = 0;
+
+    void Configure(uint32_t size, uint32_t lineLength, uint32_t ways);
+
+    bool IsPresent() const {
+        return numWays != 0;
+    }
+
+    // Looks up the line containing address and fills it on a miss.
+    // Returns true if the line was present.
+    bool Access(uint32_t address);
+
+    // Invalidates all lines.
+    void Invalidate();
+
+    // Invalidates the line containing address, if present.
+    void InvalidateLine(uint32_t address);
+
+    // Invalidates the line at the set and way specified in the set/index format used by CP15 register 7.
+    void InvalidateSetWay(uint32_t value);
+};
+
 // NOTE: Cache parameters as defined by the ARM946E-S Technical Reference Manual
 struct Cache {
     union {
@@ -46,6 +88,24 @@ struct Cache {
     };
 
     void Configure(const Configuration &config);
+
+    // Invalidates both caches and clears the lockdown registers.
+    void Reset();
+
+    // Tag arrays used by the cache timing model.
+    // In unified cache configurations, dataTags is used for both instructions and data.
+    CacheTagArray codeTags;
+    CacheTagArray dataTags;
+
+    // Cacheability maps used by the cache timing model, one bit per page of kCacheablePageSize bytes.
+    // A clear bit means accesses to the page are never cached, either because the cache is disabled or because the page
+    // is outside the cacheable protection regions or entirely covered by a TCM. Set bits are refined on tag misses by
+    // SystemControlCoprocessor::CodeCacheMiss and DataCacheMiss.
+    // Both maps are maintained by the system control coprocessor and are empty if the respective cache is absent.
+    static constexpr uint32_t kCacheablePageShift = 12;
+    static constexpr uint32_t kCacheablePageSize = 1u << kCacheablePageShift;
+    std::vector<uint32_t> codeCacheablePages;
+    std::vector<uint32_t> dataCacheablePages;
 };
 
 } // namespace armajitto::arm::cp15
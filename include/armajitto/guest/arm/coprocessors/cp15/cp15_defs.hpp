@@ -45,6 +45,20 @@ namespace tcm {
 
 // -----------------------------------------------------------------------------
 
+namespace pu {
+    // Types of memory accesses checked by the protection unit.
+    enum class Access : uint32_t {
+        Read,    // Data reads
+        Write,   // Data writes
+        Execute, // Instruction fetches
+    };
+
+    // Size of the smallest protection region. Regions are always aligned to their size.
+    inline constexpr uint32_t kMinRegionSize = 4096;
+} // namespace pu
+
+// -----------------------------------------------------------------------------
+
 // NOTE: Cache parameters as defined by the ARM946E-S Technical Reference Manual
 namespace cache {
     // Cache types, bits 28..25.
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "armajitto/guest/arm/coprocessors/cp15/cp15_defs.hpp"
+
+#include <cstddef>
 #include <cstdint>
 
 namespace armajitto::arm::cp15 {
@@ -21,6 +24,18 @@ struct ProtectionUnit {
                 : 6,           // 6-11  Reserved/zero
                 baseAddr : 20; // 12-31 Protection Region Base address (Addr = Y*4K; must be SIZE-aligned)
         };
+
+        uint64_t Size() const {
+            return 2ull << (size < 11 ? 11 : size);
+        }
+
+        uint32_t Start() const {
+            return (baseAddr << 12) & ~static_cast<uint32_t>(Size() - 1);
+        }
+
+        bool Contains(uint32_t address) const {
+            return enable && address - Start() < Size();
+        }
     };
 
     Region regions[8];
@@ -35,6 +50,17 @@ struct ProtectionUnit {
             regions[i].u32 = 0;
         }
     }
+
+    // Determines if the protection unit allows the specified type of access to the whole address range.
+    // Addresses not covered by any enabled region are never accessible.
+    bool IsAccessAllowed(uint32_t address, uint32_t size, pu::Access access, bool privileged) const;
+
+    // Retrieves the extended access permission bits for the region that covers the given address.
+    // Returns 0 (no access) if no enabled region covers the address.
+    uint32_t GetAccessPermissions(uint32_t address, pu::Access access) const;
+
+    // Determines if the region that covers the given address is cacheable by the instruction or data cache.
+    bool IsCacheable(uint32_t address, bool code) const;
 };
 
 } // namespace armajitto::arm::cp15
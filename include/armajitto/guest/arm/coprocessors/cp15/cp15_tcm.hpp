@@ -36,8 +36,8 @@ struct TCM {
 
     uint8_t *itcm = nullptr;
     uint8_t *dtcm = nullptr;
-    uint32_t itcmSize;
-    uint32_t dtcmSize;
+    uint32_t itcmSize = 0;
+    uint32_t dtcmSize = 0;
 
     MemoryMap *memMap = nullptr;
 
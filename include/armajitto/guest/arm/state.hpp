@@ -14,6 +14,8 @@
 #include <array>
 #include <cassert>
 #include <cstdint>
+#include <span>
+#include <vector>
 
 namespace armajitto::arm {
 
@@ -40,6 +42,22 @@ public:
     // Convenience method that forces the processor to enter the specified exception vector.
     void EnterException(Exception vector);
 
+    // -------------------------------------------------------------------------
+    // Save states
+
+    // Writes a compact binary snapshot of the CPU state to <out>, replacing its contents.
+    // Includes all banked registers, PSRs, the interrupt lines, the execution state and the system control coprocessor
+    // registers, cache tags and TCM contents. Reuse the same vector across calls to avoid reallocations.
+    void SaveState(std::vector<uint8_t> &out) const;
+
+    // Restores a snapshot written by SaveState().
+    // Returns false without modifying the state if the snapshot is malformed or was saved with a different coprocessor
+    // configuration.
+    // Compiled code is preserved unless the protection unit is toggled; changes to TCM contents or mappings are
+    // reported to the recompiler as memory writes. Guest memory outside the TCMs is not part of the snapshot; report
+    // ranges whose contents changed when restoring it with Recompiler::ReportMemoryWrite().
+    bool LoadState(std::span<const uint8_t> in);
+
     // -------------------------------------------------------------------------
     // State accessors
 
@@ -72,6 +90,10 @@ public:
         return m_irqLine;
     }
 
+    bool &FIQLine() {
+        return m_fiqLine;
+    }
+
     ExecState &ExecutionState() {
         return m_execState;
     }
@@ -119,6 +141,10 @@ public:
         return const_cast<State *>(this)->IRQLine();
     }
 
+    const bool &FIQLine() const {
+        return const_cast<State *>(this)->FIQLine();
+    }
+
     const ExecState &ExecutionState() const {
         return const_cast<State *>(this)->ExecutionState();
     }
@@ -176,11 +202,13 @@ private:
     DummyDebugCoprocessor m_cp14;
     SystemControlCoprocessor m_cp15;
 
-    // IRQ line
+    // Interrupt lines
+    // The FIQ line must immediately follow the IRQ line so that compiled code can check both with a single load.
     bool m_irqLine = false;
+    bool m_fiqLine = false;
 
     // Execution state.
-    // When halted or stopped, the CPU stops executing code until the IRQ line is raised.
+    // When halted or stopped, the CPU stops executing code until the IRQ or FIQ line is raised.
     ExecState m_execState = ExecState::Running;
 
     // -------------------------------------------------------------------------
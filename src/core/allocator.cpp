@@ -1,6 +1,9 @@
 #include "allocator.hpp"
 
+#include "util/huge_pages.hpp"
+
 #include <cassert>
+#include <new>
 
 namespace armajitto::memory {
 
@@ -24,12 +27,19 @@ static inline void AlignedFree(void *ptr) {
 }
 #endif
 
-Allocator::Allocator() {
-    AllocatePage(kPageChunkSize);
+Allocator::Allocator(HugePageMode hugePages)
+    : m_hugePages(hugePages) {
+
+    if (!AllocatePage(kPageChunkSize)) {
+        throw std::bad_alloc();
+    }
 }
 
 Allocator::~Allocator() {
     Release();
+    if (m_head != nullptr) {
+        FreePage(m_head);
+    }
 }
 
 void *Allocator::AllocateRaw(std::size_t bytes, std::size_t alignment) {
@@ -100,8 +110,7 @@ void Allocator::Free(void *p) {
             page->next->prev = page->prev;
         }
 
-        AlignedFree(page->ptr);
-        delete page;
+        FreePage(page);
     }
 }
 
@@ -115,8 +124,7 @@ void Allocator::Release() {
     Page *page = m_head->next;
     while (page != nullptr) {
         Page *next = page->next;
-        AlignedFree(page->ptr);
-        delete page;
+        FreePage(page);
         page = next;
     }
     m_head->next = nullptr;
@@ -127,7 +135,13 @@ bool Allocator::AllocatePage(std::size_t bytes) {
         bytes = kPageChunkSize;
     }
     std::size_t pageSize = (bytes + kPageChunkAlign) & ~kPageChunkAlign;
-    void *ptr = AlignedAlloc(pageSize, kPageAlign);
+    void *ptr;
+    if (m_hugePages != HugePageMode::None) {
+        pageSize = util::RoundUpToPageGranularity(pageSize, m_hugePages);
+        ptr = util::AllocatePages(pageSize, m_hugePages);
+    } else {
+        ptr = AlignedAlloc(pageSize, kPageAlign);
+    }
     if (ptr == nullptr) {
         return false;
     }
@@ -145,4 +159,13 @@ bool Allocator::AllocatePage(std::size_t bytes) {
     return true;
 }
 
+void Allocator::FreePage(Page *page) {
+    if (m_hugePages != HugePageMode::None) {
+        util::FreePages(page->ptr, page->size, m_hugePages);
+    } else {
+        AlignedFree(page->ptr);
+    }
+    delete page;
+}
+
 } // namespace armajitto::memory
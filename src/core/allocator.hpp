@@ -1,5 +1,7 @@
 #pragma once
 
+#include "armajitto/core/memory_params.hpp"
+
 #include <array>
 #include <bit>
 #include <limits>
@@ -71,7 +73,7 @@ public:
         friend class Allocator;
     };
 
-    Allocator();
+    Allocator(HugePageMode hugePages = HugePageMode::None);
     ~Allocator();
 
     void *AllocateRaw(std::size_t bytes, std::size_t alignment = sizeof(void *));
@@ -119,8 +121,10 @@ private:
     };
 
     Page *m_head = nullptr;
+    HugePageMode m_hugePages;
 
     bool AllocatePage(std::size_t bytes);
+    void FreePage(Page *page);
 };
 
 } // namespace armajitto::memory
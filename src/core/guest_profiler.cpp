@@ -0,0 +1,64 @@
+#include "guest_profiler.hpp"
+
+#include <algorithm>
+
+namespace armajitto {
+
+void GuestProfiler::Advance(uint64_t cycles, LocationRef loc) {
+    if (cycles < m_cyclesToNextSample) {
+        m_cyclesToNextSample -= cycles;
+        return;
+    }
+
+    const uint64_t overshoot = cycles - m_cyclesToNextSample;
+    const uint64_t samples = 1 + overshoot / m_interval;
+    m_cyclesToNextSample = m_interval - overshoot % m_interval;
+
+    m_entries[loc.ToUint64()].samples += samples;
+    m_totalSamples += samples;
+}
+
+void GuestProfiler::RecordBlock(LocationRef loc, uint32_t instructions, uint32_t irOps, uint64_t codeBytes) {
+    auto &entry = m_entries[loc.ToUint64()];
+    entry.instructions = instructions;
+    entry.irOps = irOps;
+    entry.codeBytes = codeBytes;
+}
+
+GuestProfile GuestProfiler::GetProfile(size_t maxBlocks) const {
+    GuestProfile profile{};
+    profile.totalSamples = m_totalSamples;
+    for (auto &[key, entry] : m_entries) {
+        if (entry.samples == 0) {
+            continue;
+        }
+        const LocationRef loc{static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32ull)};
+        profile.blocks.push_back({
+            .pc = loc.PC(),
+            .mode = loc.Mode(),
+            .thumb = loc.IsThumbMode(),
+            .samples = entry.samples,
+            .instructions = entry.instructions,
+            .irOps = entry.irOps,
+            .codeBytes = entry.codeBytes,
+        });
+    }
+
+    auto bySamples = [](const ProfiledBlock &lhs, const ProfiledBlock &rhs) { return lhs.samples > rhs.samples; };
+    if (profile.blocks.size() > maxBlocks) {
+        std::partial_sort(profile.blocks.begin(), profile.blocks.begin() + maxBlocks, profile.blocks.end(),
+                          bySamples);
+        profile.blocks.resize(maxBlocks);
+    } else {
+        std::sort(profile.blocks.begin(), profile.blocks.end(), bySamples);
+    }
+    return profile;
+}
+
+void GuestProfiler::Reset() {
+    m_entries.clear();
+    m_totalSamples = 0;
+    m_cyclesToNextSample = m_interval;
+}
+
+} // namespace armajitto
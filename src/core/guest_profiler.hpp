@@ -0,0 +1,57 @@
+#pragma once
+
+#include "armajitto/core/profiler.hpp"
+
+#include "location_ref.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+
+namespace armajitto {
+
+// Samples the guest location every <interval> cycles of execution.
+// The dispatcher splits execution into slices that end on sample points, then reports the location where each slice
+// stopped. Blocks only check the cycle budget on exit, so samples land on the first block executed after the sample
+// point; blocks that run past several sample points are credited once per sample point crossed.
+class GuestProfiler {
+public:
+    // Restarts the countdown to the next sample if the interval changes.
+    void SetInterval(uint64_t interval) {
+        interval = std::max<uint64_t>(interval, 1);
+        if (interval != m_interval) {
+            m_interval = interval;
+            m_cyclesToNextSample = interval;
+        }
+    }
+
+    // Number of cycles to execute before taking the next sample.
+    uint64_t CyclesToNextSample() const {
+        return m_cyclesToNextSample;
+    }
+
+    // Accounts for <cycles> executed cycles, sampling <loc> if a sample point was reached.
+    void Advance(uint64_t cycles, LocationRef loc);
+
+    // Records the size of a newly compiled block.
+    void RecordBlock(LocationRef loc, uint32_t instructions, uint32_t irOps, uint64_t codeBytes);
+
+    GuestProfile GetProfile(size_t maxBlocks) const;
+
+    void Reset();
+
+private:
+    struct Entry {
+        uint64_t samples = 0;
+        uint32_t instructions = 0;
+        uint32_t irOps = 0;
+        uint64_t codeBytes = 0;
+    };
+
+    uint64_t m_interval = 0;
+    uint64_t m_cyclesToNextSample = 0;
+    uint64_t m_totalSamples = 0;
+    std::unordered_map<uint64_t, Entry> m_entries;
+};
+
+} // namespace armajitto
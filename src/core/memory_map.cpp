@@ -2,10 +2,12 @@
 
 #include "memory_map_impl.hpp"
 
+#include <algorithm>
+
 namespace armajitto {
 
-MemoryMap::MemoryMap(size_t pageSize)
-    : m_impl(std::make_unique<Impl>(pageSize)) {}
+MemoryMap::MemoryMap(size_t pageSize, HugePageMode hugePages)
+    : m_impl(std::make_unique<Impl>(pageSize, hugePages)) {}
 
 MemoryMap::~MemoryMap() = default;
 
@@ -22,6 +24,9 @@ void MemoryMap::Map(MemoryArea areas, uint8_t layer, uint32_t baseAddress, uint3
     if (bmAreas.AllOf(MemoryArea::DataWrite)) {
         impl.dataWrite.Map(layer, baseAddress, size, attrs, ptr, mirrorSize);
     }
+    if (bmAreas.AnyOf(MemoryArea::DataRead | MemoryArea::DataWrite)) {
+        ++impl.dataGeneration;
+    }
 }
 
 void MemoryMap::Unmap(MemoryArea areas, uint8_t layer, uint32_t baseAddress, uint64_t size) {
@@ -36,6 +41,31 @@ void MemoryMap::Unmap(MemoryArea areas, uint8_t layer, uint32_t baseAddress, uin
     if (bmAreas.AllOf(MemoryArea::DataWrite)) {
         impl.dataWrite.Unmap(layer, baseAddress, size);
     }
+    if (bmAreas.AnyOf(MemoryArea::DataRead | MemoryArea::DataWrite)) {
+        ++impl.dataGeneration;
+    }
+}
+
+void MemoryMap::SetTimings(MemoryArea areas, uint32_t baseAddress, uint64_t size, const MemoryAccessTimings &timings) {
+    if (size == 0) {
+        return;
+    }
+    auto &impl = *m_impl;
+    auto bmAreas = BitmaskEnum(areas);
+    const uint64_t endAddress = std::min<uint64_t>((uint64_t)baseAddress + size, 0x1'0000'0000);
+    const size_t startIndex = baseAddress >> kTimingBlockShift;
+    const size_t endIndex = (endAddress + kTimingBlockSize - 1) >> kTimingBlockShift;
+    for (size_t i = startIndex; i < endIndex; i++) {
+        if (bmAreas.AllOf(MemoryArea::CodeRead)) {
+            impl.codeReadTimings[i] = timings;
+        }
+        if (bmAreas.AllOf(MemoryArea::DataRead)) {
+            impl.dataReadTimings[i] = timings;
+        }
+        if (bmAreas.AllOf(MemoryArea::DataWrite)) {
+            impl.dataWriteTimings[i] = timings;
+        }
+    }
 }
 
 } // namespace armajitto
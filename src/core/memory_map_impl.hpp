@@ -5,20 +5,44 @@
 #include "util/bitmask_enum.hpp"
 #include "util/layered_memory_map.hpp"
 
+#include <array>
+
 ENABLE_BITMASK_OPERATORS(armajitto::MemoryArea);
 ENABLE_BITMASK_OPERATORS(armajitto::MemoryAttributes);
 
 namespace armajitto {
 
 struct MemoryMap::Impl {
-    Impl(size_t pageSize)
-        : codeRead(pageSize)
-        , dataRead(pageSize)
-        , dataWrite(pageSize) {}
-
-    util::LayeredMemoryMap<3, MemoryAttributes> codeRead;
-    util::LayeredMemoryMap<3, MemoryAttributes> dataRead;
-    util::LayeredMemoryMap<3, MemoryAttributes> dataWrite;
+    // Permission views used to enforce memory protection.
+    // Without protection, every view mirrors the effective page map.
+    static constexpr size_t kUserView = 0;
+    static constexpr size_t kPrivilegedView = 1;
+    static constexpr size_t kNumViews = 2;
+
+    using Map = util::LayeredMemoryMap<3, MemoryAttributes, kNumViews>;
+
+    // Access timings for every kTimingBlockSize bytes of the address space.
+    // Host code indexes these tables directly, so each entry must be exactly 8 bytes long.
+    static constexpr size_t kNumTimingBlocks = size_t(1) << (32 - kTimingBlockShift);
+    using TimingTable = std::array<MemoryAccessTimings, kNumTimingBlocks>;
+    static_assert(sizeof(MemoryAccessTimings) == 8);
+
+    Impl(size_t pageSize, HugePageMode hugePages)
+        : codeRead(pageSize, hugePages)
+        , dataRead(pageSize, hugePages)
+        , dataWrite(pageSize, hugePages) {}
+
+    Map codeRead;
+    Map dataRead;
+    Map dataWrite;
+
+    // Incremented whenever the data read or write maps change.
+    // Blocks optimized based on the layout of the data maps are discarded when this changes.
+    uint64_t dataGeneration = 0;
+
+    TimingTable codeReadTimings;
+    TimingTable dataReadTimings;
+    TimingTable dataWriteTimings;
 };
 
 } // namespace armajitto
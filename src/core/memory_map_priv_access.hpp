@@ -2,17 +2,48 @@
 
 #include "memory_map_impl.hpp"
 
+#include "ir/defs/memory_access.hpp"
+
 namespace armajitto {
 
 struct MemoryMapPrivateAccess {
+    using Map = MemoryMap::Impl::Map;
+    using TimingTable = MemoryMap::Impl::TimingTable;
+
+    static constexpr size_t kUserView = MemoryMap::Impl::kUserView;
+    static constexpr size_t kPrivilegedView = MemoryMap::Impl::kPrivilegedView;
+    static constexpr size_t kNumViews = MemoryMap::Impl::kNumViews;
+
+    // Retrieves the number of cycles taken by an access of the given size and type to the address.
+    static uint8_t GetAccessCycles(const TimingTable &table, uint32_t address, ir::MemAccessSize size,
+                                   ir::MemAccessType type) {
+        auto &timings = table[address >> MemoryMap::kTimingBlockShift];
+        const size_t sizeIndex = static_cast<size_t>(size);
+        if (type == ir::MemAccessType::Sequential) {
+            return timings.sequential[sizeIndex];
+        } else {
+            return timings.nonsequential[sizeIndex];
+        }
+    }
+
     MemoryMapPrivateAccess(MemoryMap &memMap)
         : codeRead(memMap.m_impl->codeRead)
         , dataRead(memMap.m_impl->dataRead)
-        , dataWrite(memMap.m_impl->dataWrite) {}
+        , dataWrite(memMap.m_impl->dataWrite)
+        , codeReadTimings(memMap.m_impl->codeReadTimings)
+        , dataReadTimings(memMap.m_impl->dataReadTimings)
+        , dataWriteTimings(memMap.m_impl->dataWriteTimings)
+        , dataGeneration(memMap.m_impl->dataGeneration) {}
+
+    Map &codeRead;
+    Map &dataRead;
+    Map &dataWrite;
+
+    TimingTable &codeReadTimings;
+    TimingTable &dataReadTimings;
+    TimingTable &dataWriteTimings;
 
-    util::LayeredMemoryMap<3, MemoryAttributes> &codeRead;
-    util::LayeredMemoryMap<3, MemoryAttributes> &dataRead;
-    util::LayeredMemoryMap<3, MemoryAttributes> &dataWrite;
+    const uint64_t &dataGeneration;
 };
 
 } // namespace armajitto
@@ -4,21 +4,32 @@
 #include "host/x86_64/x86_64_host.hpp" // TODO: select based on host system
 
 #include "core/allocator.hpp"
+#include "core/guest_profiler.hpp"
+#include "core/memory_map_priv_access.hpp"
+#include "core/shared_code_cache_priv_access.hpp"
 
 #include "ir/optimizer.hpp"
 #include "ir/translator.hpp"
 #include "ir/verifier.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <memory_resource>
+#include <vector>
 
 namespace armajitto {
 
 struct Recompiler::Impl {
     Impl(Context &context, Specification spec, Options &params)
         : context(context)
+        , model(spec.model)
+        , sharedCodeCache(spec.sharedCodeCache)
+        , options(params)
         , translator(context, params.translator)
-        , optimizer(context, params.optimizer, pmrBuffer)
-        , host(context, params.compiler, spec.cycleCountDeadline, pmrBuffer) {}
+        , optimizer(context, params, translator, allocator, pmrBuffer)
+        , host(context, params.compiler, spec.cycleCountDeadline, pmrBuffer)
+        , memMap(context.GetSystem().GetMemoryMap())
+        , memMapGeneration(memMap.dataGeneration) {}
 
     void Reset() {
         FlushCachedBlocks();
@@ -30,12 +41,37 @@ struct Recompiler::Impl {
         uint32_t &pc = armState.GPR(arm::GPR::PC);
 
         const bool hasDeadline = armState.deadlinePtr != nullptr;
+        const bool instrumented = options.compiler.instrumentation;
+        auto &counters = host.GetRuntimeCounters();
+        const bool profile = options.profiler.enabled;
+        if (profile) {
+            profiler.SetInterval(options.profiler.samplingInterval);
+        }
 
         uint64_t cycles = initialCycles;
         while (hasDeadline ? (cycles < *armState.deadlinePtr) : ((int64_t)cycles > 0)) {
+            // Apply invalidations posted from other threads before looking up code
+            if (host.HasPostedInvalidations()) {
+                host.ApplyPostedInvalidations();
+            }
+
+            // Discard blocks optimized for a previous layout of the memory map
+            if (memMap.dataGeneration != memMapGeneration) {
+                memMapGeneration = memMap.dataGeneration;
+                if (memMapDependentBlocks) {
+                    InvalidateCodeCache();
+                }
+            }
+
             // Build location reference and get its code
             const LocationRef loc{pc, armState.CPSR().u32};
             auto code = host.GetCodeForLocation(loc);
+            if (instrumented) {
+                ++counters.codeLookups;
+                if (code == nullptr) {
+                    ++counters.codeLookupMisses;
+                }
+            }
 
             // Compile code if not yet compiled
             if (code == nullptr) {
@@ -43,12 +79,37 @@ struct Recompiler::Impl {
                 // This should clean up pending patches and undo applied patches.
                 host.Invalidate(loc);
 
-                // Compile the new block
+                // Compile the new block, reusing the translation from the shared code cache if possible
                 auto *block = allocator.Allocate<ir::BasicBlock>(allocator, loc);
-                translator.Translate(*block);
-                optimizer.Optimize(*block);
-                verifier.Verify(*block);
-                code = host.Compile(*block);
+                const bool sharing = IsSharingBlocks();
+                if (!sharing || !FetchSharedBlock(*block)) {
+                    if (options.collectStatistics) {
+                        TranslateWithStatistics(*block, sharing);
+                    } else {
+                        translator.Translate(*block);
+                        if (sharing) {
+                            sharedOpcodes.assign(translator.FetchedOpcodes().begin(),
+                                                 translator.FetchedOpcodes().end());
+                        }
+                        optimizer.Optimize(*block);
+                        verifier.Verify(*block);
+                    }
+
+                    // Blocks that rely on the current memory map layout are kept private
+                    const bool memMapDependent = optimizer.DependsOnMemoryMap();
+                    memMapDependentBlocks |= memMapDependent;
+                    if (sharing && !memMapDependent) {
+                        PublishSharedBlock(*block);
+                    }
+                }
+                if (options.collectStatistics) {
+                    code = CompileWithStatistics(*block);
+                } else {
+                    code = host.Compile(*block);
+                }
+                if (profile) {
+                    RecordProfiledBlock(*block);
+                }
 
                 // Cleanup
                 if constexpr (ir::BasicBlock::kFreeErasedIROps) {
@@ -64,9 +125,20 @@ struct Recompiler::Impl {
             }
 
             // Invoke code
-            auto nextCycles = host.Call(code, cycles);
-            if (nextCycles == cycles) {
-                // CPU is halted and no IRQs were raised
+            const uint64_t irqExits = counters.irqExits;
+            const uint64_t nextCycles = profile ? CallProfiled(code, cycles) : host.Call(code, cycles);
+            if (instrumented && counters.irqExits == irqExits) {
+                if (nextCycles == cycles || armState.ExecutionState() != arm::ExecState::Running) {
+                    ++counters.haltExits;
+                } else if (hasDeadline ? (nextCycles >= *armState.deadlinePtr) : ((int64_t)nextCycles <= 0)) {
+                    ++counters.deadlineExits;
+                } else {
+                    ++counters.unlinkedBranchExits;
+                }
+            }
+            if (nextCycles == cycles && !host.HasPostedInvalidations()) {
+                // CPU is halted and no interrupts were raised
+                // Blocks may also exit without running any code to apply posted invalidations
                 break;
             }
             cycles = nextCycles;
@@ -74,8 +146,128 @@ struct Recompiler::Impl {
         return hasDeadline ? (cycles - initialCycles) : (initialCycles - cycles);
     }
 
+    // Runs the code up to the next sample point, then samples the location where execution stopped.
+    uint64_t CallProfiled(HostCode code, uint64_t cycles) {
+        auto &armState = context.GetARMState();
+        const uint64_t cyclesToSample = profiler.CyclesToNextSample();
+
+        uint64_t nextCycles;
+        uint64_t elapsed;
+        if (armState.deadlinePtr != nullptr) {
+            // Point the deadline to the sample point while running the code if it comes first
+            const uint64_t *deadlinePtr = armState.deadlinePtr;
+            const uint64_t sampleDeadline = cycles + cyclesToSample;
+            if (sampleDeadline < *deadlinePtr) {
+                armState.deadlinePtr = &sampleDeadline;
+            }
+            nextCycles = host.Call(code, cycles);
+            armState.deadlinePtr = deadlinePtr;
+            elapsed = nextCycles - cycles;
+        } else {
+            // Run a slice of the remaining cycles that ends on the sample point
+            const uint64_t slice = std::min(cycles, cyclesToSample);
+            elapsed = slice - host.Call(code, slice);
+            nextCycles = cycles - elapsed;
+        }
+
+        const LocationRef loc{armState.GPR(arm::GPR::PC), armState.CPSR().u32};
+        profiler.Advance(elapsed, loc);
+        return nextCycles;
+    }
+
+    void RecordProfiledBlock(const ir::BasicBlock &block) {
+        uint32_t irOps = 0;
+        for (auto *op = block.Head(); op != nullptr; op = op->Next()) {
+            ++irOps;
+        }
+        profiler.RecordBlock(block.Location(), block.InstructionCount(), irOps, host.LastCompiledCodeSize());
+    }
+
+    // Determines if blocks are shared with other instances through the shared code cache.
+    // Code fetch timings depend on this instance's memory map, so blocks that use them are never shared.
+    bool IsSharingBlocks() const {
+        using Method = Options::Translator::CycleCountingMethod;
+        return sharedCodeCache != nullptr &&
+               options.translator.cycleCountingMethod != Method::SubinstructionTimingTable;
+    }
+
+    SharedCodeCachePrivateAccess::Config SharedConfig() const {
+        return {.model = model, .translator = options.translator, .optimizer = options.optimizer};
+    }
+
+    // Copies the optimized IR for the block's location from the shared code cache if it was translated from the same
+    // guest code.
+    bool FetchSharedBlock(ir::BasicBlock &block) {
+        SharedCodeCachePrivateAccess shared{*sharedCodeCache};
+        const LocationRef loc = block.Location();
+        const bool hit = shared.impl.Fetch(
+            SharedConfig(), loc, [&](uint32_t index) { return translator.FetchOpcode(loc, index); }, block);
+        if (options.collectStatistics) {
+            if (hit) {
+                ++statistics.sharedCache.hits;
+            } else {
+                ++statistics.sharedCache.misses;
+            }
+        }
+        return hit;
+    }
+
+    // Publishes the optimized IR of a newly translated block to the shared code cache.
+    // Idle loops are detected using runtime register values and ISystem::CanSkipPollingLoop, so they're kept private.
+    void PublishSharedBlock(const ir::BasicBlock &block) {
+        if (block.GetTerminal() == ir::BasicBlock::Terminal::IdleLoop) {
+            return;
+        }
+        SharedCodeCachePrivateAccess shared{*sharedCodeCache};
+        shared.impl.Store(SharedConfig(), sharedOpcodes, block);
+    }
+
+    void TranslateWithStatistics(ir::BasicBlock &block, bool sharing) {
+        using Clock = std::chrono::steady_clock;
+        auto elapsedNs = [](Clock::time_point start, Clock::time_point end) -> uint64_t {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        };
+
+        const auto translateStart = Clock::now();
+        translator.Translate(block);
+        if (sharing) {
+            sharedOpcodes.assign(translator.FetchedOpcodes().begin(), translator.FetchedOpcodes().end());
+        }
+        const auto optimizeStart = Clock::now();
+        optimizer.Optimize(block, &statistics.optimizer);
+        const auto optimizeEnd = Clock::now();
+        verifier.Verify(block);
+
+        ++statistics.translator.blocks;
+        statistics.translator.instructions += block.InstructionCount();
+        statistics.translator.timeNs += elapsedNs(translateStart, optimizeStart);
+
+        ++statistics.optimizer.blocks;
+        statistics.optimizer.timeNs += elapsedNs(optimizeStart, optimizeEnd);
+    }
+
+    HostCode CompileWithStatistics(ir::BasicBlock &block) {
+        using Clock = std::chrono::steady_clock;
+        auto elapsedNs = [](Clock::time_point start, Clock::time_point end) -> uint64_t {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        };
+
+        const auto compileStart = Clock::now();
+        auto code = host.Compile(block);
+        const auto compileEnd = Clock::now();
+
+        const size_t codeSize = host.LastCompiledCodeSize();
+        ++statistics.compiler.blocks;
+        statistics.compiler.timeNs += elapsedNs(compileStart, compileEnd);
+        statistics.compiler.codeBytes += codeSize;
+        statistics.compiler.maxBlockCodeBytes = std::max<uint64_t>(statistics.compiler.maxBlockCodeBytes, codeSize);
+
+        return code;
+    }
+
     void FlushCachedBlocks() {
         host.Clear();
+        memMapDependentBlocks = false;
         allocator.Release();
         pmrBuffer.release();
         compiledBlocks = 0;
@@ -83,6 +275,7 @@ struct Recompiler::Impl {
 
     void InvalidateCodeCache() {
         host.InvalidateCodeCache();
+        memMapDependentBlocks = false;
     }
 
     void InvalidateCodeCacheRange(uint32_t start, uint32_t end) {
@@ -93,11 +286,22 @@ struct Recompiler::Impl {
         host.ReportMemoryWrite(start, end);
     }
 
+    void PostMemoryWrite(uint32_t start, uint32_t end) {
+        host.PostMemoryWrite(start, end);
+    }
+
+    void PostInvalidateCodeCacheRange(uint32_t start, uint32_t end) {
+        host.PostInvalidateCodeCacheRange(start, end);
+    }
+
     memory::Allocator allocator;
     // std::pmr::monotonic_buffer_resource pmrBuffer{std::pmr::get_default_resource()};
     std::pmr::unsynchronized_pool_resource pmrBuffer{std::pmr::get_default_resource()};
 
     Context &context;
+    CPUModel model;
+    SharedCodeCache *sharedCodeCache;
+    Options &options;
     ir::Translator translator;
     ir::Optimizer optimizer;
     ir::Verifier verifier;
@@ -106,6 +310,17 @@ struct Recompiler::Impl {
     x86_64::x64Host host;
     // interp::InterpreterHost host;
 
+    CompilerStatistics statistics;
+    GuestProfiler profiler;
+
+    // Tracks changes to the data memory map; see ir::Optimizer::DependsOnMemoryMap()
+    MemoryMapPrivateAccess memMap;
+    uint64_t memMapGeneration;
+    bool memMapDependentBlocks = false;
+
+    // Opcodes of the block being translated, published along with its IR to the shared code cache
+    std::vector<uint32_t> sharedOpcodes;
+
     uint32_t compiledBlocks = 0;
     static constexpr uint32_t kCompiledBlocksReleaseThreshold = 500;
 };
@@ -113,6 +328,7 @@ struct Recompiler::Impl {
 Recompiler::Recompiler(Specification spec)
     : m_spec(spec)
     , m_context(spec.model, spec.system)
+    , m_options(spec.options != nullptr ? *spec.options : Options{})
     , m_impl(std::make_unique<Impl>(m_context, spec, m_options)) {}
 
 Recompiler::~Recompiler() = default;
@@ -141,4 +357,73 @@ void Recompiler::ReportMemoryWrite(uint32_t start, uint32_t end) {
     m_impl->ReportMemoryWrite(start, end);
 }
 
+void Recompiler::PostMemoryWrite(uint32_t start, uint32_t end) {
+    m_impl->PostMemoryWrite(start, end);
+}
+
+void Recompiler::PostInvalidateCodeCacheRange(uint32_t start, uint32_t end) {
+    m_impl->PostInvalidateCodeCacheRange(start, end);
+}
+
+const CompilerStatistics &Recompiler::GetStatistics() const {
+    return m_impl->statistics;
+}
+
+void Recompiler::ResetStatistics() {
+    m_impl->statistics = {};
+}
+
+RuntimeStatistics Recompiler::GetRuntimeStatistics(size_t maxBlocks) const {
+    const auto &counters = m_impl->host.GetRuntimeCounters();
+
+    RuntimeStatistics stats{};
+    stats.slowMemoryAccesses = counters.slowMemoryAccesses;
+    stats.codeLookups = counters.codeLookups;
+    stats.codeLookupMisses = counters.codeLookupMisses;
+    stats.invalidatedBlocks = counters.generationMismatches;
+    stats.patchesApplied = counters.patchesApplied;
+    stats.patchesReverted = counters.patchesReverted;
+    stats.exits.deadline = counters.deadlineExits;
+    stats.exits.halt = counters.haltExits;
+    stats.exits.unlinkedBranch = counters.unlinkedBranchExits;
+    stats.exits.irq = counters.irqExits;
+
+    for (auto &[key, executions] : counters.blockExecutions) {
+        if (executions == 0) {
+            continue;
+        }
+        const LocationRef loc{static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32ull)};
+        stats.blockExecutions += executions;
+        stats.blocks.push_back({
+            .pc = loc.PC(),
+            .mode = loc.Mode(),
+            .thumb = loc.IsThumbMode(),
+            .executions = executions,
+        });
+    }
+
+    auto byExecutions = [](const RuntimeStatistics::Block &lhs, const RuntimeStatistics::Block &rhs) {
+        return lhs.executions > rhs.executions;
+    };
+    if (stats.blocks.size() > maxBlocks) {
+        std::partial_sort(stats.blocks.begin(), stats.blocks.begin() + maxBlocks, stats.blocks.end(), byExecutions);
+        stats.blocks.resize(maxBlocks);
+    } else {
+        std::sort(stats.blocks.begin(), stats.blocks.end(), byExecutions);
+    }
+    return stats;
+}
+
+void Recompiler::ResetRuntimeStatistics() {
+    m_impl->host.GetRuntimeCounters().Reset();
+}
+
+GuestProfile Recompiler::GetProfile(size_t maxBlocks) const {
+    return m_impl->profiler.GetProfile(maxBlocks);
+}
+
+void Recompiler::ResetProfile() {
+    m_impl->profiler.Reset();
+}
+
 } // namespace armajitto
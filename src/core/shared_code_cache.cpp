@@ -0,0 +1,20 @@
+#include "armajitto/core/shared_code_cache.hpp"
+
+#include "shared_code_cache_impl.hpp"
+
+namespace armajitto {
+
+SharedCodeCache::SharedCodeCache()
+    : m_impl(std::make_unique<Impl>()) {}
+
+SharedCodeCache::~SharedCodeCache() = default;
+
+void SharedCodeCache::Clear() {
+    m_impl->Clear();
+}
+
+size_t SharedCodeCache::BlockCount() const {
+    return m_impl->BlockCount();
+}
+
+} // namespace armajitto
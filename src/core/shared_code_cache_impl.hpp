@@ -0,0 +1,141 @@
+#pragma once
+
+#include "armajitto/core/options.hpp"
+#include "armajitto/core/shared_code_cache.hpp"
+#include "armajitto/defs/cpu_model.hpp"
+
+#include "core/allocator.hpp"
+#include "core/location_ref.hpp"
+#include "ir/basic_block.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace armajitto {
+
+struct SharedCodeCache::Impl {
+    // Parameters that affect the translation and optimization of blocks
+    struct Config {
+        CPUModel model;
+        Options::Translator translator;
+        Options::Optimizer optimizer;
+
+        bool operator==(const Config &) const = default;
+    };
+
+    // Maximum number of blocks with different code kept for a single location.
+    // The oldest block is dropped when a new one is added past this limit; its storage is reclaimed on Clear().
+    static constexpr size_t kMaxVersionsPerLocation = 4;
+
+    // Copies the block at <loc> into <block> if one was translated from the code returned by fetchOpcode(index).
+    // Returns true if a block was copied.
+    template <typename FetchOpcodeFn>
+    bool Fetch(const Config &config, LocationRef loc, FetchOpcodeFn &&fetchOpcode, ir::BasicBlock &block) const {
+        std::shared_lock lock{mutex};
+
+        auto *partition = FindPartition(config);
+        if (partition == nullptr) {
+            return false;
+        }
+        auto it = partition->entries.find(loc.ToUint64());
+        if (it == partition->entries.end()) {
+            return false;
+        }
+
+        // Opcodes are fetched lazily and reused across versions
+        std::vector<uint32_t> opcodes;
+        for (auto &entry : it->second) {
+            bool match = true;
+            for (size_t i = 0; i < entry.opcodes.size(); i++) {
+                if (i == opcodes.size()) {
+                    opcodes.push_back(fetchOpcode(static_cast<uint32_t>(i)));
+                }
+                if (opcodes[i] != entry.opcodes[i]) {
+                    match = false;
+                    break;
+                }
+            }
+            if (match) {
+                block.CopyFrom(*entry.block);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Adds a copy of <block>, translated from <opcodes>, to the cache.
+    void Store(const Config &config, std::span<const uint32_t> opcodes, const ir::BasicBlock &block) {
+        std::unique_lock lock{mutex};
+
+        auto *partition = FindPartition(config);
+        if (partition == nullptr) {
+            partition = &partitions.emplace_back(Partition{.config = config});
+        }
+
+        // Another instance may have published the same block in the meantime
+        auto &versions = partition->entries[block.Location().ToUint64()];
+        for (auto &entry : versions) {
+            if (std::equal(entry.opcodes.begin(), entry.opcodes.end(), opcodes.begin(), opcodes.end())) {
+                return;
+            }
+        }
+        if (versions.size() == kMaxVersionsPerLocation) {
+            versions.erase(versions.begin());
+            --blockCount;
+        }
+
+        auto *copy = allocator.Allocate<ir::BasicBlock>(allocator, block.Location());
+        copy->CopyFrom(block);
+        versions.push_back({.opcodes = {opcodes.begin(), opcodes.end()}, .block = copy});
+        ++blockCount;
+    }
+
+    void Clear() {
+        std::unique_lock lock{mutex};
+        partitions.clear();
+        allocator.Release();
+        blockCount = 0;
+    }
+
+    size_t BlockCount() const {
+        std::shared_lock lock{mutex};
+        return blockCount;
+    }
+
+private:
+    // Optimized IR of a block and the opcodes it was translated from
+    struct Entry {
+        std::vector<uint32_t> opcodes;
+        ir::BasicBlock *block;
+    };
+
+    struct Partition {
+        Config config;
+
+        // Versions of blocks by LocationRef::ToUint64()
+        std::unordered_map<uint64_t, std::vector<Entry>> entries;
+    };
+
+    mutable std::shared_mutex mutex;
+    memory::Allocator allocator;
+    std::deque<Partition> partitions;
+    size_t blockCount = 0;
+
+    const Partition *FindPartition(const Config &config) const {
+        auto it = std::find_if(partitions.begin(), partitions.end(),
+                               [&](const Partition &partition) { return partition.config == config; });
+        return (it != partitions.end()) ? &*it : nullptr;
+    }
+
+    Partition *FindPartition(const Config &config) {
+        return const_cast<Partition *>(std::as_const(*this).FindPartition(config));
+    }
+};
+
+} // namespace armajitto
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "shared_code_cache_impl.hpp"
+
+namespace armajitto {
+
+struct SharedCodeCachePrivateAccess {
+    using Config = SharedCodeCache::Impl::Config;
+
+    SharedCodeCachePrivateAccess(SharedCodeCache &cache)
+        : impl(*cache.m_impl) {}
+
+    SharedCodeCache::Impl &impl;
+};
+
+} // namespace armajitto
@@ -1,13 +1,23 @@
 #include "armajitto/guest/arm/coprocessors/coproc_15_sys_control.hpp"
 
+#include "core/memory_map_priv_access.hpp"
+
+#include "util/byte_stream.hpp"
+
+#include <algorithm>
+#include <cstring>
+
 namespace armajitto::arm {
 
 void SystemControlCoprocessor::Reset() {
     m_ctl.Reset();
     m_pu.Reset();
     m_tcm.Reset();
+    m_cache.Reset();
     m_tcm.SetupITCM(m_ctl.value.itcmEnable, m_ctl.value.itcmLoad);
     m_tcm.SetupDTCM(m_ctl.value.dtcmEnable, m_ctl.value.dtcmLoad);
+    SetupPermissionMaps(m_ctl.value.puEnable);
+    UpdateCacheabilityMaps();
 }
 
 void SystemControlCoprocessor::Install(cp15::id::Implementor implementor, uint32_t variant,
@@ -20,11 +30,13 @@ void SystemControlCoprocessor::Install(cp15::id::Implementor implementor, uint32
     m_id.primaryPartNumber = primaryPartNumber;
     m_id.revision = revision;
     m_tcm.memMap = &memMap;
+    m_memMap = &memMap;
 }
 
 void SystemControlCoprocessor::Uninstall() {
     m_installed = false;
     m_tcm.Disable();
+    SetupPermissionMaps(false);
 }
 
 void SystemControlCoprocessor::ConfigureTCM(const cp15::TCM::Configuration &config) {
@@ -33,6 +45,89 @@ void SystemControlCoprocessor::ConfigureTCM(const cp15::TCM::Configuration &conf
 
 void SystemControlCoprocessor::ConfigureCache(const cp15::Cache::Configuration &config) {
     m_cache.Configure(config);
+    UpdateCacheabilityMaps();
+
+    // Compiled code may refer to the previous tag arrays
+    if (m_invalidateCodeCacheCallback != nullptr) {
+        m_invalidateCodeCacheCallback(0, 0xFFFFFFFF, m_invalidateCodeCacheCallbackCtx);
+    }
+}
+
+bool SystemControlCoprocessor::CodeCacheMiss(uint32_t address) {
+    if (!m_ctl.value.codeCache || !m_ctl.value.puEnable || !m_pu.IsCacheable(address, true)) {
+        return false;
+    }
+    if (address < m_tcm.itcmReadSize) {
+        return false;
+    }
+    auto &tags = m_cache.params.separateCodeDataCaches ? m_cache.codeTags : m_cache.dataTags;
+    return tags.IsPresent() && !tags.Access(address);
+}
+
+bool SystemControlCoprocessor::DataCacheMiss(uint32_t address) {
+    if (!m_ctl.value.dataCache || !m_ctl.value.puEnable || !m_pu.IsCacheable(address, false)) {
+        return false;
+    }
+    if (address < m_tcm.itcmWriteSize || address - m_tcm.dtcmBase < m_tcm.dtcmWriteSize) {
+        return false;
+    }
+    return m_cache.dataTags.IsPresent() && !m_cache.dataTags.Access(address);
+}
+
+void SystemControlCoprocessor::UpdateCacheabilityMaps() {
+    // Sets or clears the bits of the pages in [start, start + size)
+    auto fill = [](std::vector<uint32_t> &pages, uint64_t start, uint64_t size, bool cacheable) {
+        uint64_t page = start >> cp15::Cache::kCacheablePageShift;
+        const uint64_t end = (start + size) >> cp15::Cache::kCacheablePageShift;
+        while (page < end) {
+            const uint32_t bit = page & 31;
+            const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(32 - bit, end - page));
+            const uint32_t mask = (count == 32) ? ~0u : (((1u << count) - 1) << bit);
+            if (cacheable) {
+                pages[page >> 5] |= mask;
+            } else {
+                pages[page >> 5] &= ~mask;
+            }
+            page += count;
+        }
+    };
+
+    // Clears the pages entirely covered by [start, start + size)
+    auto clearCovered = [&](std::vector<uint32_t> &pages, uint64_t start, uint64_t size) {
+        static constexpr uint64_t kPageMask = cp15::Cache::kCacheablePageSize - 1;
+        const uint64_t alignedStart = (start + kPageMask) & ~kPageMask;
+        const uint64_t alignedEnd = (start + size) & ~kPageMask;
+        if (alignedEnd > alignedStart) {
+            fill(pages, alignedStart, alignedEnd - alignedStart, false);
+        }
+    };
+
+    auto update = [&](std::vector<uint32_t> &pages, bool enabled, uint32_t cachabilityBits, uint32_t itcmSize) {
+        if (pages.empty()) {
+            return;
+        }
+        std::fill(pages.begin(), pages.end(), 0);
+        if (!enabled || !m_ctl.value.puEnable) {
+            return;
+        }
+
+        // Higher numbered regions have priority over lower numbered ones
+        for (size_t i = 0; i < 8; i++) {
+            auto &region = m_pu.regions[i];
+            if (region.enable) {
+                fill(pages, region.Start(), region.Size(), (cachabilityBits >> i) & 1);
+            }
+        }
+
+        // Pages partially covered by a TCM keep their bit; the miss handler excludes the TCM part
+        clearCovered(pages, 0, itcmSize);
+    };
+
+    update(m_cache.codeCacheablePages, m_ctl.value.codeCache, m_pu.codeCachabilityBits, m_tcm.itcmReadSize);
+    update(m_cache.dataCacheablePages, m_ctl.value.dataCache, m_pu.dataCachabilityBits, m_tcm.itcmWriteSize);
+    if (!m_cache.dataCacheablePages.empty() && m_tcm.dtcmWriteSize != 0) {
+        clearCovered(m_cache.dataCacheablePages, m_tcm.dtcmBase, m_tcm.dtcmWriteSize);
+    }
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -100,11 +195,9 @@ uint32_t SystemControlCoprocessor::LoadRegister(CopRegister reg) const {
         return m_pu.regions[reg.crm].u32;
 
     case 0x0900: // 0,C9,C0,0 - Data cache lockdown register
-        // TODO: implement
-        return 0;
+        return m_cache.dataTags.lockdown;
     case 0x0901: // 0,C9,C0,1 - Instruction cache lockdown register
-        // TODO: implement
-        return 0;
+        return m_cache.codeTags.lockdown;
     case 0x0910: // 0,C9,C1,0 - Data TCM size/base
         return m_tcm.dtcmParams;
     case 0x0911: // 0,C9,C1,1 - Instruction TCM size/base
@@ -198,18 +291,28 @@ void SystemControlCoprocessor::StoreRegister(CopRegister reg, uint32_t value) {
         m_tcm.SetupITCM(m_ctl.value.itcmEnable, m_ctl.value.itcmLoad);
         m_tcm.SetupDTCM(m_ctl.value.dtcmEnable, m_ctl.value.dtcmLoad);
         // TODO: UpdateTimingMaps();
-        // TODO: UpdatePermissionMaps();
+        UpdateCacheabilityMaps();
+        if (m_ctl.value.puEnable != m_puEnforced) {
+            SetupPermissionMaps(m_ctl.value.puEnable);
+
+            // Compiled code depends on the protection unit state
+            if (m_invalidateCodeCacheCallback != nullptr) {
+                m_invalidateCodeCacheCallback(0, 0xFFFFFFFF, m_invalidateCodeCacheCallbackCtx);
+            }
+        }
         break;
     }
 
     case 0x0200: { // 0,C2,C0,0 - Cachability bits for data/unified protection region
         m_pu.dataCachabilityBits = value;
         // TODO: UpdateTimingMaps();
+        UpdateCacheabilityMaps();
         break;
     }
     case 0x0201: { // 0,C2,C0,1 - Cachability bits for instruction protection region
         m_pu.codeCachabilityBits = value;
         // TODO: UpdateTimingMaps();
+        UpdateCacheabilityMaps();
         break;
     }
     case 0x0300: { // 0,C3,C0,0 - Cache write-bufferability bits for data protection regions
@@ -219,30 +322,34 @@ void SystemControlCoprocessor::StoreRegister(CopRegister reg, uint32_t value) {
 
     case 0x0500: { // 0,C5,C0,0 - Access permission data/unified protection region
         auto &bits = m_pu.dataAccessPermissions;
+        const uint32_t prevBits = bits;
         bits = 0;
         for (size_t i = 0; i < 8; i++) {
             bits |= (value & (0x3 << (i * 2))) << (i * 2);
         }
-        // TODO: UpdatePermissionMaps();
+        UpdatePermissionMaps(prevBits, bits, false);
         break;
     }
     case 0x0501: { // 0,C5,C0,1 - Access permission instruction protection region
         auto &bits = m_pu.codeAccessPermissions;
+        const uint32_t prevBits = bits;
         bits = 0;
         for (size_t i = 0; i < 8; i++) {
             bits |= (value & (0x3 << (i * 2))) << (i * 2);
         }
-        // TODO: UpdatePermissionMaps();
+        UpdatePermissionMaps(prevBits, bits, true);
         break;
     }
     case 0x0502: { // 0,C5,C0,2 - Extended access permission data/unified protection region
+        const uint32_t prevBits = m_pu.dataAccessPermissions;
         m_pu.dataAccessPermissions = value;
-        // TODO: UpdatePermissionMaps();
+        UpdatePermissionMaps(prevBits, value, false);
         break;
     }
     case 0x0503: { // 0,C5,C0,3 - Extended access permission instruction protection region
+        const uint32_t prevBits = m_pu.codeAccessPermissions;
         m_pu.codeAccessPermissions = value;
-        // TODO: UpdatePermissionMaps();
+        UpdatePermissionMaps(prevBits, value, true);
         break;
     }
 
@@ -261,11 +368,20 @@ void SystemControlCoprocessor::StoreRegister(CopRegister reg, uint32_t value) {
     case 0x0660: // 0,C6,C6,0 - Protection unit data/unified region 6
     case 0x0661: // 0,C6,C6,1 - Protection unit instruction region 6
     case 0x0670: // 0,C6,C7,0 - Protection unit data/unified region 7
-    case 0x0671: // 0,C6,C7,1 - Protection unit instruction region 7
-        m_pu.regions[reg.crm].u32 = value;
+    case 0x0671: { // 0,C6,C7,1 - Protection unit instruction region 7
+        auto &region = m_pu.regions[reg.crm];
+        const auto prevRegion = region;
+        region.u32 = value;
         // TODO: UpdateTimingMaps();
-        // TODO: UpdatePermissionMaps();
+        UpdateCacheabilityMaps();
+        if (prevRegion.enable) {
+            UpdatePermissionMaps(prevRegion.Start(), prevRegion.Size(), true, true);
+        }
+        if (region.enable) {
+            UpdatePermissionMaps(region.Start(), region.Size(), true, true);
+        }
         break;
+    }
 
     case 0x0704: // 0,C7,C0,4 - Wait for interrupt
     case 0x0782: // 0,C7,C8,2 - Wait for interrupt (deprecated encoding)
@@ -273,11 +389,13 @@ void SystemControlCoprocessor::StoreRegister(CopRegister reg, uint32_t value) {
         break;
 
     case 0x0750: // 0,C7,C5,0 - Invalidate entire instruction cache
+        m_cache.codeTags.Invalidate();
         if (m_invalidateCodeCacheCallback != nullptr) {
             m_invalidateCodeCacheCallback(0, 0xFFFFFFFF, m_invalidateCodeCacheCallbackCtx);
         }
         break;
     case 0x0751: // 0,C7,C5,1 - Invalidate instruction cache line (by address)
+        m_cache.codeTags.InvalidateLine(value);
         if (m_invalidateCodeCacheCallback != nullptr) {
             uint32_t start = (value & ~0x1F);
             uint32_t end = start + 0x1F;
@@ -285,7 +403,7 @@ void SystemControlCoprocessor::StoreRegister(CopRegister reg, uint32_t value) {
         }
         break;
     case 0x0752: // 0,C7,C5,2 - Invalidate instruction cache line (by set and index)
-        // TODO: implement
+        m_cache.codeTags.InvalidateSetWay(value);
         break;
     case 0x0754: // 0,C7,C5,4 - Flush prefetch buffer
         // TODO: implement
@@ -298,76 +416,80 @@ void SystemControlCoprocessor::StoreRegister(CopRegister reg, uint32_t value) {
         break;
 
     case 0x0760: // 0,C7,C6,0 - Invalidate entire data cache
-        // TODO: implement
+        m_cache.dataTags.Invalidate();
         break;
     case 0x0761: // 0,C7,C6,1 - Invalidate data cache line (by address)
-        // TODO: implement
+        m_cache.dataTags.InvalidateLine(value);
         break;
     case 0x0762: // 0,C7,C6,2 - Invalidate data cache line (by set and index)
-        // TODO: implement
+        m_cache.dataTags.InvalidateSetWay(value);
         break;
 
     case 0x0770: // 0,C7,C7,0 - Invalidate entire unified cache or both instruction and data caches
-        // TODO: implement
+        m_cache.codeTags.Invalidate();
+        m_cache.dataTags.Invalidate();
         break;
     case 0x0771: // 0,C7,C7,1 - Invalidate unified cache line (by address)
-        // TODO: implement
+        m_cache.codeTags.InvalidateLine(value);
+        m_cache.dataTags.InvalidateLine(value);
         break;
     case 0x0772: // 0,C7,C7,2 - Invalidate unified cache line (by set and index)
-        // TODO: implement
+        m_cache.codeTags.InvalidateSetWay(value);
+        m_cache.dataTags.InvalidateSetWay(value);
         break;
 
+    // The cache model only tracks tags and all writes reach memory immediately, so there are never dirty lines to clean
     case 0x07A1: // 0,C7,C10,1 - Clean data cache line (by address)
-        // TODO: implement
-        break;
     case 0x07A2: // 0,C7,C10,2 - Clean data cache line (by set and index)
-        // TODO: implement
         break;
     case 0x07A4: // 0,C7,C10,4 - Drain write buffer
         // TODO: implement
         break;
 
     case 0x07B1: // 0,C7,C11,1 - Clean unified cache line (by address)
-        // TODO: implement
-        break;
     case 0x07B2: // 0,C7,C11,2 - Clean unified cache line (by set and index)
-        // TODO: implement
+        // Nothing to clean; see above
         break;
 
     case 0x07D1: // 0,C7,C13,1 - Prefetch instruction cache line (by address)
         // TODO: implement
         break;
 
+    // Cleaning is a no-op (see above); only the invalidation affects the tag arrays
     case 0x07E1: // 0,C7,C14,1 - Clean and invalidate data cache line (by address)
-        // TODO: implement
+        m_cache.dataTags.InvalidateLine(value);
         break;
     case 0x07E2: // 0,C7,C14,2 - Clean and invalidate data cache line (by set and index)
-        // TODO: implement
+        m_cache.dataTags.InvalidateSetWay(value);
         break;
 
     case 0x07F1: // 0,C7,C15,1 - Clean and invalidate unified cache line (by address)
-        // TODO: implement
+        m_cache.codeTags.InvalidateLine(value);
+        m_cache.dataTags.InvalidateLine(value);
         break;
     case 0x07F2: // 0,C7,C15,2 - Clean and invalidate unified cache line (by set and index)
-        // TODO: implement
+        m_cache.codeTags.InvalidateSetWay(value);
+        m_cache.dataTags.InvalidateSetWay(value);
         break;
 
     case 0x0900: // 0,C9,C0,0 - Data cache lockdown register
-        // TODO: implement
+        m_cache.dataTags.lockdown = value & 0x80000003;
         break;
     case 0x0901: // 0,C9,C0,1 - Instruction cache lockdown register
-        // TODO: implement
+        m_cache.codeTags.lockdown = value & 0x80000003;
         break;
 
     case 0x0910: // 0,C9,C1,0 - Data TCM Size/Base
         m_tcm.dtcmParams = value;
         m_tcm.SetupDTCM(m_ctl.value.dtcmEnable, m_ctl.value.dtcmLoad);
         // TODO: UpdateTimingMaps();
+        UpdateCacheabilityMaps();
         break;
     case 0x0911: // 0,C9,C1,1 - Instruction TCM Size/Base
         m_tcm.itcmParams = value;
         m_tcm.SetupITCM(m_ctl.value.itcmEnable, m_ctl.value.itcmLoad);
         // TODO: UpdateTimingMaps();
+        UpdateCacheabilityMaps();
         break;
 
     case 0x0D01: // 0,C13,C0,1 - Trace process ID
@@ -451,6 +573,7 @@ void SystemControlCoprocessor::StoreRegister(CopRegister reg, uint32_t value) {
 
 bool SystemControlCoprocessor::RegStoreHasSideEffects(CopRegister reg) const {
     switch (reg.u16) {
+    case 0x0100: // 0,C1,C0,0 - Control register (toggling the protection unit invalidates the code cache)
     case 0x0704: // 0,C7,C0,4 - Wait for interrupt
     case 0x0782: // 0,C7,C8,2 - Wait for interrupt (deprecated encoding)
     case 0x0750: // 0,C7,C5,0 - Invalidate entire instruction cache
@@ -460,4 +583,254 @@ bool SystemControlCoprocessor::RegStoreHasSideEffects(CopRegister reg) const {
     }
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+// Protection unit
+
+template <cp15::pu::Access access, bool privileged>
+static bool PermissionFilter(void *ctx, uint32_t address, uint32_t size) {
+    auto &pu = *static_cast<const cp15::ProtectionUnit *>(ctx);
+    return pu.IsAccessAllowed(address, size, access, privileged);
+}
+
+void SystemControlCoprocessor::SetupPermissionMaps(bool enable) {
+    m_puEnforced = enable;
+    if (m_memMap == nullptr) {
+        return;
+    }
+
+    using Access = cp15::pu::Access;
+    constexpr size_t kUser = MemoryMapPrivateAccess::kUserView;
+    constexpr size_t kPriv = MemoryMapPrivateAccess::kPrivilegedView;
+    MemoryMapPrivateAccess memMap{*m_memMap};
+    void *ctx = &m_pu;
+    if (enable) {
+        memMap.codeRead.SetViewFilter(kUser, PermissionFilter<Access::Execute, false>, ctx);
+        memMap.codeRead.SetViewFilter(kPriv, PermissionFilter<Access::Execute, true>, ctx);
+        memMap.dataRead.SetViewFilter(kUser, PermissionFilter<Access::Read, false>, ctx);
+        memMap.dataRead.SetViewFilter(kPriv, PermissionFilter<Access::Read, true>, ctx);
+        memMap.dataWrite.SetViewFilter(kUser, PermissionFilter<Access::Write, false>, ctx);
+        memMap.dataWrite.SetViewFilter(kPriv, PermissionFilter<Access::Write, true>, ctx);
+    } else {
+        for (size_t view = 0; view < MemoryMapPrivateAccess::kNumViews; view++) {
+            memMap.codeRead.SetViewFilter(view, nullptr, nullptr);
+            memMap.dataRead.SetViewFilter(view, nullptr, nullptr);
+            memMap.dataWrite.SetViewFilter(view, nullptr, nullptr);
+        }
+    }
+}
+
+void SystemControlCoprocessor::UpdatePermissionMaps(uint32_t baseAddress, uint64_t size, bool data, bool code) {
+    if (!m_puEnforced || m_memMap == nullptr) {
+        return;
+    }
+
+    MemoryMapPrivateAccess memMap{*m_memMap};
+    for (size_t view = 0; view < MemoryMapPrivateAccess::kNumViews; view++) {
+        if (code) {
+            memMap.codeRead.RefreshView(view, baseAddress, size);
+        }
+        if (data) {
+            memMap.dataRead.RefreshView(view, baseAddress, size);
+            memMap.dataWrite.RefreshView(view, baseAddress, size);
+        }
+    }
+}
+
+void SystemControlCoprocessor::UpdatePermissionMaps(uint32_t prevPerms, uint32_t newPerms, bool code) {
+    const uint32_t changed = prevPerms ^ newPerms;
+    for (size_t i = 0; i < 8; i++) {
+        const auto &region = m_pu.regions[i];
+        if (region.enable && ((changed >> (i * 4)) & 0xF) != 0) {
+            UpdatePermissionMaps(region.Start(), region.Size(), !code, code);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Save states
+
+// Architectural register values stored in save states
+struct CP15SavedRegisters {
+    uint32_t control;
+    uint32_t dataCachabilityBits;
+    uint32_t codeCachabilityBits;
+    uint32_t bufferabilityBits;
+    uint32_t dataAccessPermissions;
+    uint32_t codeAccessPermissions;
+    uint32_t regions[8];
+    uint32_t dataCacheLockdown;
+    uint32_t codeCacheLockdown;
+    uint32_t dtcmParams;
+    uint32_t itcmParams;
+};
+
+void SystemControlCoprocessor::SaveState(std::vector<uint8_t> &out) const {
+    util::ByteWriter writer{out};
+
+    writer.Write<uint8_t>(m_installed);
+    if (!m_installed) {
+        return;
+    }
+
+    CP15SavedRegisters regs{};
+    regs.control = m_ctl.value.u32;
+    regs.dataCachabilityBits = m_pu.dataCachabilityBits;
+    regs.codeCachabilityBits = m_pu.codeCachabilityBits;
+    regs.bufferabilityBits = m_pu.bufferabilityBits;
+    regs.dataAccessPermissions = m_pu.dataAccessPermissions;
+    regs.codeAccessPermissions = m_pu.codeAccessPermissions;
+    for (size_t i = 0; i < 8; i++) {
+        regs.regions[i] = m_pu.regions[i].u32;
+    }
+    regs.dataCacheLockdown = m_cache.dataTags.lockdown;
+    regs.codeCacheLockdown = m_cache.codeTags.lockdown;
+    regs.dtcmParams = m_tcm.dtcmParams;
+    regs.itcmParams = m_tcm.itcmParams;
+    writer.Write(regs);
+
+    auto writeTags = [&](const cp15::CacheTagArray &tagArray) {
+        writer.Write(static_cast<uint32_t>(tagArray.tags.size()));
+        writer.WriteBytes(tagArray.tags.data(), tagArray.tags.size() * sizeof(uint32_t));
+        writer.WriteBytes(tagArray.nextWay.data(), tagArray.nextWay.size());
+    };
+    writeTags(m_cache.codeTags);
+    writeTags(m_cache.dataTags);
+
+    writer.Write(m_tcm.itcmSize);
+    writer.WriteBytes(m_tcm.itcm, m_tcm.itcmSize);
+    writer.Write(m_tcm.dtcmSize);
+    writer.WriteBytes(m_tcm.dtcm, m_tcm.dtcmSize);
+}
+
+size_t SystemControlCoprocessor::LoadState(std::span<const uint8_t> in) {
+    util::ByteReader reader{in};
+
+    uint8_t installed;
+    if (!reader.Read(installed) || installed != m_installed) {
+        return 0;
+    }
+    if (!m_installed) {
+        return in.size() - reader.Remaining();
+    }
+
+    // Validate the entire snapshot before modifying anything
+    CP15SavedRegisters regs;
+    if (!reader.Read(regs)) {
+        return 0;
+    }
+
+    auto readTags = [&](const cp15::CacheTagArray &tagArray, std::span<const uint8_t> &tags,
+                        std::span<const uint8_t> &nextWay) {
+        uint32_t numTags;
+        if (!reader.Read(numTags) || numTags != tagArray.tags.size()) {
+            return false;
+        }
+        tags = reader.ReadSpan(numTags * sizeof(uint32_t));
+        nextWay = reader.ReadSpan(tagArray.nextWay.size());
+        return tags.size() == numTags * sizeof(uint32_t) && nextWay.size() == tagArray.nextWay.size();
+    };
+    std::span<const uint8_t> codeTags, codeNextWay;
+    std::span<const uint8_t> dataTags, dataNextWay;
+    if (!readTags(m_cache.codeTags, codeTags, codeNextWay) || !readTags(m_cache.dataTags, dataTags, dataNextWay)) {
+        return 0;
+    }
+
+    auto readTCM = [&](uint32_t tcmSize, std::span<const uint8_t> &contents) {
+        uint32_t size;
+        if (!reader.Read(size) || size != tcmSize) {
+            return false;
+        }
+        contents = reader.ReadSpan(size);
+        return contents.size() == size;
+    };
+    std::span<const uint8_t> itcm, dtcm;
+    if (!readTCM(m_tcm.itcmSize, itcm) || !readTCM(m_tcm.dtcmSize, dtcm)) {
+        return 0;
+    }
+
+    // Rewrite registers that differ through the regular store path to apply their side effects
+    const uint32_t prevITCMReadSize = m_tcm.itcmReadSize;
+    const uint32_t prevDTCMBase = m_tcm.dtcmBase;
+    const uint32_t prevDTCMReadSize = m_tcm.dtcmReadSize;
+
+    auto restore = [&](CopRegister reg, uint32_t value) {
+        if (LoadRegister(reg) != value) {
+            StoreRegister(reg, value);
+        }
+    };
+    restore(0x0200, regs.dataCachabilityBits);
+    restore(0x0201, regs.codeCachabilityBits);
+    restore(0x0300, regs.bufferabilityBits);
+    restore(0x0502, regs.dataAccessPermissions);
+    restore(0x0503, regs.codeAccessPermissions);
+    for (uint8_t i = 0; i < 8; i++) {
+        restore(CopRegister{0, 6, i, 0}, regs.regions[i]);
+    }
+    restore(0x0900, regs.dataCacheLockdown);
+    restore(0x0901, regs.codeCacheLockdown);
+    restore(0x0910, regs.dtcmParams);
+    restore(0x0911, regs.itcmParams);
+    restore(0x0100, regs.control);
+
+    // The tag arrays are copied in place since compiled code may point to them
+    std::memcpy(m_cache.codeTags.tags.data(), codeTags.data(), codeTags.size());
+    std::memcpy(m_cache.codeTags.nextWay.data(), codeNextWay.data(), codeNextWay.size());
+    std::memcpy(m_cache.dataTags.tags.data(), dataTags.data(), dataTags.size());
+    std::memcpy(m_cache.dataTags.nextWay.data(), dataNextWay.data(), dataNextWay.size());
+
+    // Code previously fetched from or through remapped TCM windows is stale.
+    // Content changes need not be reported separately on windows that were reported in full.
+    const bool itcmRemapped = m_tcm.itcmReadSize != prevITCMReadSize;
+    if (itcmRemapped) {
+        ReportMemoryWrite(0, std::max(m_tcm.itcmReadSize, prevITCMReadSize) - 1);
+    }
+    const bool dtcmRemapped = m_tcm.dtcmBase != prevDTCMBase || m_tcm.dtcmReadSize != prevDTCMReadSize;
+    if (dtcmRemapped) {
+        if (prevDTCMReadSize != 0) {
+            ReportMemoryWrite(prevDTCMBase, prevDTCMBase + prevDTCMReadSize - 1);
+        }
+        if (m_tcm.dtcmReadSize != 0) {
+            ReportMemoryWrite(m_tcm.dtcmBase, m_tcm.dtcmBase + m_tcm.dtcmReadSize - 1);
+        }
+    }
+
+    RestoreTCMContents(m_tcm.itcm, m_tcm.itcmSize, itcm, 0, itcmRemapped ? 0 : m_tcm.itcmReadSize);
+    RestoreTCMContents(m_tcm.dtcm, m_tcm.dtcmSize, dtcm, m_tcm.dtcmBase, dtcmRemapped ? 0 : m_tcm.dtcmReadSize);
+
+    return in.size() - reader.Remaining();
+}
+
+void SystemControlCoprocessor::ReportMemoryWrite(uint32_t start, uint32_t end) {
+    if (m_reportMemoryWriteCallback != nullptr) {
+        m_reportMemoryWriteCallback(start, end, m_reportMemoryWriteCallbackCtx);
+    }
+}
+
+void SystemControlCoprocessor::RestoreTCMContents(uint8_t *tcm, uint32_t tcmSize, std::span<const uint8_t> contents,
+                                                  uint32_t baseAddress, uint32_t mappedSize) {
+    // TCM sizes are powers of two no smaller than 4 KiB, so they always contain a whole number of chunks
+    static constexpr uint32_t kChunkSize = 256;
+
+    auto chunkChanged = [&](uint32_t offset) { return std::memcmp(&tcm[offset], &contents[offset], kChunkSize) != 0; };
+
+    uint32_t offset = 0;
+    while (offset < tcmSize) {
+        if (!chunkChanged(offset)) {
+            offset += kChunkSize;
+            continue;
+        }
+
+        // Copy the whole run of changed chunks and report it on every mirror
+        const uint32_t start = offset;
+        do {
+            offset += kChunkSize;
+        } while (offset < tcmSize && chunkChanged(offset));
+
+        std::copy_n(&contents[start], offset - start, &tcm[start]);
+        for (uint64_t mirror = 0; mirror < mappedSize; mirror += tcmSize) {
+            ReportMemoryWrite(baseAddress + mirror + start, baseAddress + mirror + offset - 1);
+        }
+    }
+}
+
 } // namespace armajitto::arm
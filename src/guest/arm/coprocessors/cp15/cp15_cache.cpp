@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <bit>
+#include <tuple>
 #include <utility>
 
 namespace armajitto::arm::cp15 {
@@ -49,6 +50,121 @@ void Cache::Configure(const Configuration &config) {
     params.separateCodeDataCaches = config.separateCodeDataCaches;
     params.type = config.type;
     params._padding = 0;
+
+    auto tagParams = [](cache::Size size, cache::LineLength lineLength, cache::Associativity associativity) {
+        const uint32_t sizeBytes = 0x200 << static_cast<uint32_t>(size);
+        const uint32_t lineBytes = 8 << static_cast<uint32_t>(lineLength);
+        const uint32_t ways = 1 << static_cast<uint32_t>(associativity);
+        return std::make_tuple(sizeBytes, lineBytes, ways);
+    };
+
+    if (params.codeCacheBaseSize) {
+        codeTags.Configure(0, 0, 0);
+    } else {
+        auto [size, lineLength, ways] =
+            tagParams(params.codeCacheSize, params.codeCacheLineLength, params.codeCacheAssociativity);
+        codeTags.Configure(size, lineLength, ways);
+    }
+    if (params.dataCacheBaseSize) {
+        dataTags.Configure(0, 0, 0);
+    } else {
+        auto [size, lineLength, ways] =
+            tagParams(params.dataCacheSize, params.dataCacheLineLength, params.dataCacheAssociativity);
+        dataTags.Configure(size, lineLength, ways);
+    }
+
+    // Unified caches look up instructions in the data tag array
+    static constexpr size_t kNumPageWords = (1ull << (32 - kCacheablePageShift)) / 32;
+    const bool codeCachePresent = params.separateCodeDataCaches ? codeTags.IsPresent() : dataTags.IsPresent();
+    codeCacheablePages.assign(codeCachePresent ? kNumPageWords : 0, 0);
+    dataCacheablePages.assign(dataTags.IsPresent() ? kNumPageWords : 0, 0);
+}
+
+void Cache::Reset() {
+    codeTags.Invalidate();
+    codeTags.lockdown = 0;
+    dataTags.Invalidate();
+    dataTags.lockdown = 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+void CacheTagArray::Configure(uint32_t size, uint32_t lineLength, uint32_t ways) {
+    if (size == 0 || lineLength == 0 || ways == 0) {
+        lineShift = 0;
+        setMask = 0;
+        numWays = 0;
+        tags.clear();
+        nextWay.clear();
+        return;
+    }
+
+    const uint32_t numSets = std::max(size / lineLength / ways, 1u);
+    lineShift = std::countr_zero(lineLength);
+    setMask = numSets - 1;
+    numWays = ways;
+    tags.assign(numSets * ways, kInvalidTag);
+    nextWay.assign(numSets, 0);
+}
+
+bool CacheTagArray::Access(uint32_t address) {
+    if (numWays == 0) {
+        return false;
+    }
+
+    const uint32_t line = address >> lineShift;
+    const uint32_t set = line & setMask;
+    uint32_t *setTags = &tags[set * numWays];
+    for (uint32_t way = 0; way < numWays; way++) {
+        if (setTags[way] == line) {
+            return true;
+        }
+    }
+
+    // Select a victim, skipping locked ways
+    const uint32_t lockBase = std::min(lockdown & 3, numWays - 1);
+    uint32_t victim;
+    if (lockdown & (1u << 31)) {
+        victim = lockBase;
+    } else {
+        victim = nextWay[set];
+        if (victim < lockBase || victim >= numWays) {
+            victim = lockBase;
+        }
+        nextWay[set] = victim + 1;
+    }
+    setTags[victim] = line;
+    return false;
+}
+
+void CacheTagArray::Invalidate() {
+    std::fill(tags.begin(), tags.end(), kInvalidTag);
+    std::fill(nextWay.begin(), nextWay.end(), 0);
+}
+
+void CacheTagArray::InvalidateLine(uint32_t address) {
+    if (numWays == 0) {
+        return;
+    }
+
+    const uint32_t line = address >> lineShift;
+    const uint32_t set = line & setMask;
+    for (uint32_t way = 0; way < numWays; way++) {
+        if (tags[set * numWays + way] == line) {
+            tags[set * numWays + way] = kInvalidTag;
+        }
+    }
+}
+
+void CacheTagArray::InvalidateSetWay(uint32_t value) {
+    if (numWays == 0) {
+        return;
+    }
+
+    // Way in bits 31..30, set index starting at the line offset
+    const uint32_t set = (value >> lineShift) & setMask;
+    const uint32_t way = (value >> 30) & (numWays - 1);
+    tags[set * numWays + way] = kInvalidTag;
 }
 
 } // namespace armajitto::arm::cp15
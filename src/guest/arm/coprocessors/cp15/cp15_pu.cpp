@@ -0,0 +1,62 @@
+#include "armajitto/guest/arm/coprocessors/cp15/cp15_pu.hpp"
+
+namespace armajitto::arm::cp15 {
+
+bool ProtectionUnit::IsAccessAllowed(uint32_t address, uint32_t size, pu::Access access, bool privileged) const {
+    // Regions are at least kMinRegionSize bytes long and aligned to their size, so checking one address per block of
+    // that size covers the whole range
+    const uint64_t startAddress = address & ~(pu::kMinRegionSize - 1);
+    const uint64_t endAddress = (uint64_t)address + (size == 0 ? 1 : size);
+    for (uint64_t blockAddress = startAddress; blockAddress < endAddress; blockAddress += pu::kMinRegionSize) {
+        const uint32_t perms = GetAccessPermissions(blockAddress, access);
+
+        // Extended access permissions:
+        //   Privileged  User
+        //   ----------  ----
+        //   0: --       --
+        //   1: RW       --
+        //   2: RW       R-
+        //   3: RW       RW
+        //   5: R-       --
+        //   6: R-       R-
+        //   Everything else is reserved and denies all accesses.
+        // Execute permissions follow the same rules as reads.
+        const bool write = access == pu::Access::Write;
+        bool allowed;
+        switch (perms) {
+        case 1: allowed = privileged; break;
+        case 2: allowed = privileged || !write; break;
+        case 3: allowed = true; break;
+        case 5: allowed = privileged && !write; break;
+        case 6: allowed = !write; break;
+        default: allowed = false; break;
+        }
+        if (!allowed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t ProtectionUnit::GetAccessPermissions(uint32_t address, pu::Access access) const {
+    // Higher numbered regions have priority over lower numbered ones
+    const uint32_t bits = (access == pu::Access::Execute) ? codeAccessPermissions : dataAccessPermissions;
+    for (size_t i = 7; i < 8; i--) {
+        if (regions[i].Contains(address)) {
+            return (bits >> (i * 4)) & 0xF;
+        }
+    }
+    return 0;
+}
+
+bool ProtectionUnit::IsCacheable(uint32_t address, bool code) const {
+    const uint32_t bits = code ? codeCachabilityBits : dataCachabilityBits;
+    for (size_t i = 7; i < 8; i--) {
+        if (regions[i].Contains(address)) {
+            return (bits >> i) & 1;
+        }
+    }
+    return false;
+}
+
+} // namespace armajitto::arm::cp15
@@ -71,13 +71,17 @@ void TCM::Configure(const Configuration &config) {
 void TCM::Disable() {
     if (itcm != nullptr) {
         delete[] itcm;
+        itcm = nullptr;
     }
     itcmSize = 0;
+    itcmWriteSize = itcmReadSize = 0;
 
     if (dtcm != nullptr) {
         delete[] dtcm;
+        dtcm = nullptr;
     }
     dtcmSize = 0;
+    dtcmWriteSize = dtcmReadSize = 0;
 }
 
 void TCM::SetupITCM(bool enable, bool load) {
@@ -15,6 +15,13 @@ struct SystemControlCoprocessor::PrivateAccess {
         m_cp15.m_invalidateCodeCacheCallbackCtx = ctx;
     }
 
+    // Configures the callback invoked when restoring a save state changes the contents or mappings of the TCMs.
+    // Should be automatically invoked by hosts.
+    void SetReportMemoryWriteCallback(ReportMemoryWriteCallback callback, void *ctx) {
+        m_cp15.m_reportMemoryWriteCallback = callback;
+        m_cp15.m_reportMemoryWriteCallbackCtx = ctx;
+    }
+
 private:
     SystemControlCoprocessor &m_cp15;
 };
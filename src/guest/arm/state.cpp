@@ -3,6 +3,10 @@
 #include "guest/arm/exception_vectors.hpp"
 #include "guest/arm/mode_utils.hpp"
 
+#include "util/byte_stream.hpp"
+
+#include <cstring>
+
 namespace armajitto::arm {
 
 State::State()
@@ -70,6 +74,7 @@ void State::Reset() {
     CPSR().t = 0;
 
     m_irqLine = false;
+    m_fiqLine = false;
     m_execState = ExecState::Running;
 }
 
@@ -100,7 +105,93 @@ void State::EnterException(Exception vector) {
         (m_cp15.IsPresent() ? m_cp15.GetControlRegister().baseVectorAddress : 0x00000000);
 
     GPR(GPR::LR) = pc + nn;
-    GPR(GPR::PC) = baseVectorAddress + static_cast<uint32_t>(vector) * 4 + instrSize * 2;
+    // Exception handlers always run in ARM mode
+    GPR(GPR::PC) = baseVectorAddress + static_cast<uint32_t>(vector) * 4 + sizeof(uint32_t) * 2;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Save states
+
+// Header: magic, version, total size in bytes (including the header)
+static constexpr uint32_t kSaveStateMagic = 0x5453414A; // "JAST" in little-endian
+static constexpr uint32_t kSaveStateVersion = 3;
+static constexpr size_t kSaveStateSizeOffset = 2 * sizeof(uint32_t);
+
+void State::SaveState(std::vector<uint8_t> &out) const {
+    out.clear();
+    util::ByteWriter writer{out};
+
+    writer.Write(kSaveStateMagic);
+    writer.Write(kSaveStateVersion);
+    writer.Write<uint32_t>(0); // size, filled in at the end
+
+    writer.Write(m_regsUSR);
+    writer.Write(m_regsSVC);
+    writer.Write(m_regsABT);
+    writer.Write(m_regsIRQ);
+    writer.Write(m_regsUND);
+    writer.Write(m_regsFIQ);
+    writer.Write(m_psrs);
+    writer.Write<uint8_t>(m_irqLine);
+    writer.Write<uint8_t>(m_fiqLine);
+    writer.Write(static_cast<uint8_t>(m_execState));
+
+    m_cp15.SaveState(out);
+
+    const auto size = static_cast<uint32_t>(out.size());
+    std::memcpy(&out[kSaveStateSizeOffset], &size, sizeof(size));
+}
+
+bool State::LoadState(std::span<const uint8_t> in) {
+    util::ByteReader reader{in};
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    if (!reader.Read(magic) || magic != kSaveStateMagic || !reader.Read(version) || version != kSaveStateVersion ||
+        !reader.Read(size) || size != in.size()) {
+        return false;
+    }
+
+    // Read everything into temporaries first so that the state is left untouched if the snapshot is malformed
+    decltype(m_regsUSR) regsUSR;
+    decltype(m_regsSVC) regsSVC;
+    decltype(m_regsABT) regsABT;
+    decltype(m_regsIRQ) regsIRQ;
+    decltype(m_regsUND) regsUND;
+    decltype(m_regsFIQ) regsFIQ;
+    decltype(m_psrs) psrs;
+    uint8_t irqLine;
+    uint8_t fiqLine;
+    uint8_t execState;
+    if (!reader.Read(regsUSR) || !reader.Read(regsSVC) || !reader.Read(regsABT) || !reader.Read(regsIRQ) ||
+        !reader.Read(regsUND) || !reader.Read(regsFIQ) || !reader.Read(psrs) || !reader.Read(irqLine) ||
+        !reader.Read(fiqLine) || !reader.Read(execState)) {
+        return false;
+    }
+
+    // Booleans and enums must hold valid values
+    if (irqLine > 1 || fiqLine > 1 || execState > static_cast<uint8_t>(ExecState::Stopped)) {
+        return false;
+    }
+
+    // The coprocessor validates its own data before applying any of it
+    const size_t cp15Offset = in.size() - reader.Remaining();
+    if (m_cp15.LoadState(in.subspan(cp15Offset)) == 0) {
+        return false;
+    }
+
+    m_regsUSR = regsUSR;
+    m_regsSVC = regsSVC;
+    m_regsABT = regsABT;
+    m_regsIRQ = regsIRQ;
+    m_regsUND = regsUND;
+    m_regsFIQ = regsFIQ;
+    m_psrs = psrs;
+    m_irqLine = irqLine != 0;
+    m_fiqLine = fiqLine != 0;
+    m_execState = static_cast<ExecState>(execState);
+    return true;
 }
 
 } // namespace armajitto::arm
@@ -21,6 +21,8 @@ public:
         m_gprTableOffset = CastUintPtr(state.m_gprPtrs.data()) - statePtr;
 
         m_irqLineOffset = CastUintPtr(&state.m_irqLine) - statePtr;
+        m_fiqLineOffset = CastUintPtr(&state.m_fiqLine) - statePtr;
+        assert(m_fiqLineOffset == m_irqLineOffset + 1); // compiled code loads both lines at once
         m_execStateOffset = CastUintPtr(&state.m_execState) - statePtr;
         m_deadlinePtrOffset = CastUintPtr(&state.deadlinePtr) - statePtr;
     }
@@ -49,6 +51,10 @@ public:
         return m_irqLineOffset;
     }
 
+    uintptr_t FIQLineOffset() const {
+        return m_fiqLineOffset;
+    }
+
     uintptr_t ExecutionStateOffset() const {
         return m_execStateOffset;
     }
@@ -64,6 +70,7 @@ private:
     uintptr_t m_gprTableOffset;
 
     uintptr_t m_irqLineOffset;
+    uintptr_t m_fiqLineOffset;
     uintptr_t m_execStateOffset;
     uintptr_t m_deadlinePtrOffset;
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/allocator.hpp"
+#include "util/huge_pages.hpp"
 #include "util/pointer_cast.hpp"
 
 #include "host_code.hpp"
@@ -31,13 +32,16 @@ public:
     static constexpr uint64_t kL3Mask = kL3Size - 1u;
     static constexpr uint64_t kL3Shift = 0;
 
-    BlockCache() {
-        m_map = new Page[kL1Size];
+    BlockCache(HugePageMode hugePages = HugePageMode::None)
+        : m_allocator(hugePages)
+        , m_hugePages(hugePages) {
+
+        m_map = static_cast<Page *>(util::AllocatePagesOrThrow(sizeof(Page) * kL1Size, hugePages));
         std::fill_n(m_map, kL1Size, nullptr);
     }
 
     ~BlockCache() {
-        delete[] m_map;
+        util::FreePages(m_map, sizeof(Page) * kL1Size, m_hugePages);
     }
 
     HostCode *Get(uint64_t key) const {
@@ -83,6 +87,7 @@ public:
 
 private:
     memory::Allocator m_allocator;
+    HugePageMode m_hugePages;
 
     using Block = HostCode *; // array of kL3Size HostCodes
     using Page = Block *;     // array of kL2Size Blocks
@@ -9,6 +9,8 @@
 #include "guest/arm/state_offsets.hpp"
 
 #include "host_code.hpp"
+#include "invalidation_queue.hpp"
+#include "runtime_counters.hpp"
 
 namespace armajitto {
 
@@ -26,6 +28,20 @@ public:
     // Use the block's LocationRef to call the code.
     virtual HostCode Compile(ir::BasicBlock &block) = 0;
 
+    // Retrieves the size in bytes of the code generated by the last call to Compile().
+    size_t LastCompiledCodeSize() const {
+        return m_lastCompiledCodeSize;
+    }
+
+    // Retrieves the counters updated by compiled code while Options::Compiler::instrumentation is enabled.
+    RuntimeCounters &GetRuntimeCounters() {
+        return m_runtimeCounters;
+    }
+
+    const RuntimeCounters &GetRuntimeCounters() const {
+        return m_runtimeCounters;
+    }
+
     // Retrieves the compiled code for the specified location, if present.
     // Returns 0 if no code was compiled at that location.
     virtual HostCode GetCodeForLocation(LocationRef loc) = 0;
@@ -69,16 +85,58 @@ public:
         ReportMemoryWrite(address, address + sizeof(T) - 1);
     }
 
+    // Posts a memory write report to be applied later by ApplyPostedInvalidations(). Safe to call from any thread.
+    // Both <start> and <end> are inclusive.
+    void PostMemoryWrite(uint32_t start, uint32_t end) {
+        m_invalidationQueue.Post({InvalidationQueue::Kind::MemoryWrite, start, end});
+    }
+
+    // Posts a code cache range invalidation to be applied later by ApplyPostedInvalidations(). Safe to call from any
+    // thread. Both <start> and <end> are inclusive.
+    void PostInvalidateCodeCacheRange(uint32_t start, uint32_t end) {
+        m_invalidationQueue.Post({InvalidationQueue::Kind::InvalidateRange, start, end});
+    }
+
+    // Determines if there are posted invalidations waiting to be applied.
+    bool HasPostedInvalidations() const {
+        return m_invalidationQueue.HasPending();
+    }
+
+    // Applies all posted invalidations. Must only be called from the thread running the compiled code, between calls.
+    void ApplyPostedInvalidations() {
+        m_invalidationQueue.Drain(
+            [this](const InvalidationQueue::Request &request) {
+                switch (request.kind) {
+                case InvalidationQueue::Kind::MemoryWrite: ReportMemoryWrite(request.start, request.end); break;
+                case InvalidationQueue::Kind::InvalidateRange:
+                    InvalidateCodeCacheRange(request.start, request.end);
+                    break;
+                }
+            },
+            [this] { InvalidateCodeCache(); });
+    }
+
 protected:
     Context &m_context;
     Options::Compiler &m_options;
 
     arm::StateOffsets m_stateOffsets;
 
+    size_t m_lastCompiledCodeSize = 0;
+
+    RuntimeCounters m_runtimeCounters;
+
+    InvalidationQueue m_invalidationQueue;
+
     void SetInvalidateCodeCacheCallback(arm::InvalidateCodeCacheCallback callback, void *ctx) {
         arm::SystemControlCoprocessor::PrivateAccess{m_context.GetARMState().GetSystemControlCoprocessor()}
             .SetInvalidateCodeCacheCallback(callback, ctx);
     }
+
+    void SetReportMemoryWriteCallback(arm::ReportMemoryWriteCallback callback, void *ctx) {
+        arm::SystemControlCoprocessor::PrivateAccess{m_context.GetARMState().GetSystemControlCoprocessor()}
+            .SetReportMemoryWriteCallback(callback, ctx);
+    }
 };
 
 } // namespace armajitto
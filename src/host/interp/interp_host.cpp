@@ -24,6 +24,13 @@ InterpreterHost::InterpreterHost(Context &context, Options::Compiler &options, s
             host.InvalidateCodeCacheRange(start, end);
         },
         this);
+
+    SetReportMemoryWriteCallback(
+        [](uint32_t start, uint32_t end, void *ctx) {
+            auto &host = *reinterpret_cast<InterpreterHost *>(ctx);
+            host.ReportMemoryWrite(start, end);
+        },
+        this);
 }
 
 InterpreterHost::~InterpreterHost() {}
@@ -45,6 +52,7 @@ HostCode InterpreterHost::Compile(ir::BasicBlock &block) {
         op = op->Next();
     }
 
+    m_lastCompiledCodeSize = compiledBlock.instrs.size() * sizeof(InterpInstr);
     return HostCode(key);
 }
 
@@ -110,6 +118,16 @@ uint32_t InterpreterHost::Get(ir::ImmediateArg arg) {
     return arg.value;
 }
 
+void InterpreterHost::CountAccessCycles(const MemoryMapPrivateAccess::TimingTable &table, uint32_t address,
+                                        ir::MemAccessSize size, const ir::MemAccessTiming &timing) {
+    if (timing.timed) {
+        const uint8_t cycles = MemoryMapPrivateAccess::GetAccessCycles(table, address, size, timing.type);
+        if (cycles > timing.parallelCycles) {
+            m_accessCycles += cycles - timing.parallelCycles;
+        }
+    }
+}
+
 int64_t InterpreterHost::Execute(const CompiledBlock &block) {
     auto evalCondition = [&](arm::Condition cond) {
         auto bmFlags = BitmaskEnum(m_flags);
@@ -140,10 +158,15 @@ int64_t InterpreterHost::Execute(const CompiledBlock &block) {
     };
 
     if (evalCondition(block.cond)) {
+        m_accessCycles = 0;
+        m_checkpointCycles.reset();
         for (auto &instr : block.instrs) {
             (this->*instr.fn)(instr.op, block.loc);
+            if (m_checkpointCycles) {
+                return *m_checkpointCycles + m_accessCycles;
+            }
         }
-        return block.passCycles;
+        return block.passCycles + m_accessCycles;
     } else {
         const uint32_t instrSize = block.loc.IsThumbMode() ? sizeof(uint16_t) : sizeof(uint32_t);
         m_armState.GPR(arm::GPR::PC) = block.loc.PC() + block.instrCount * instrSize;
@@ -295,6 +318,10 @@ auto InterpreterHost::CompileOp(const ir::IRBranchExchangeOp *op) -> InterpInstr
     return {&InterpreterHost::HandleBranchExchange, {*op}};
 }
 
+auto InterpreterHost::CompileOp(const ir::IRCheckpointOp *op) -> InterpInstr {
+    return {&InterpreterHost::HandleCheckpoint, {*op}};
+}
+
 auto InterpreterHost::CompileOp(const ir::IRLoadCopRegisterOp *op) -> InterpInstr {
     return {&InterpreterHost::HandleLoadCopRegister, {*op}};
 }
@@ -398,6 +425,7 @@ void InterpreterHost::HandleMemRead(const Op &varOp, LocationRef loc) {
     auto &op = std::get<ir::IRMemReadOp>(varOp);
     auto &sys = m_context.GetSystem();
     const auto addr = Get(op.address);
+    CountAccessCycles(m_memMap.dataReadTimings, addr, op.size, op.timing);
 
     auto &mem = op.bus == ir::MemAccessBus::Code ? m_memMap.codeRead : m_memMap.dataRead;
 
@@ -478,6 +506,7 @@ void InterpreterHost::HandleMemWrite(const Op &varOp, LocationRef loc) {
     auto &sys = m_context.GetSystem();
     const auto addr = Get(op.address);
     const auto value = Get(op.src);
+    CountAccessCycles(m_memMap.dataWriteTimings, addr, op.size, op.timing);
 
     auto &mem = m_memMap.dataWrite;
 
@@ -817,6 +846,16 @@ void InterpreterHost::HandleBranchExchange(const Op &varOp, LocationRef loc) {
     cpsr.t = thumb;
 }
 
+void InterpreterHost::HandleCheckpoint(const Op &varOp, LocationRef loc) {
+    auto &op = std::get<ir::IRCheckpointOp>(varOp);
+
+    // Leave the block if the budget runs out after counting the cycles taken so far
+    if (static_cast<int64_t>(m_cycleBudget - m_accessCycles) <= static_cast<int64_t>(op.cycles)) {
+        m_armState.GPR(arm::GPR::PC) = op.pc;
+        m_checkpointCycles = op.cycles;
+    }
+}
+
 void InterpreterHost::HandleLoadCopRegister(const Op &varOp, LocationRef loc) {
     auto &op = std::get<ir::IRLoadCopRegisterOp>(varOp);
     auto &cop = m_armState.GetCoprocessor(op.cpnum);
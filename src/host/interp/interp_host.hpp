@@ -12,6 +12,7 @@
 
 #include <map>
 #include <memory_resource>
+#include <optional>
 #include <variant>
 #include <vector>
 
@@ -61,6 +62,14 @@ public:
         }
         m_cacheInvalidations.clear();
 
+        // FIQ takes priority over IRQ
+        if (m_armState.FIQLine()) {
+            m_armState.ExecutionState() = arm::ExecState::Running;
+            if (!m_armState.CPSR().f) {
+                m_armState.EnterException(arm::Exception::FastInterrupt);
+                return cycles - 1;
+            }
+        }
         if (m_armState.IRQLine()) {
             m_armState.ExecutionState() = arm::ExecState::Running;
             if (!m_armState.CPSR().i) {
@@ -77,6 +86,7 @@ public:
 
         auto it = m_blockCache.find(uint64_t(code));
         if (it != m_blockCache.end()) {
+            m_cycleBudget = cycles;
             cycles -= Execute(it->second);
         }
 
@@ -126,6 +136,18 @@ private:
     arm::Flags m_flags = arm::Flags::None;
     bool m_flagQ = false;
 
+    // Cycles taken by timed memory accesses in the block being executed
+    uint64_t m_accessCycles = 0;
+
+    // Cycles available to the block being executed, checked by checkpoints
+    uint64_t m_cycleBudget = 0;
+
+    // Set by a checkpoint that reached the budget to the number of cycles taken by the block up to that point
+    std::optional<uint64_t> m_checkpointCycles;
+
+    void CountAccessCycles(const MemoryMapPrivateAccess::TimingTable &table, uint32_t address, ir::MemAccessSize size,
+                           const ir::MemAccessTiming &timing);
+
     void SetVar(ir::Variable var, uint32_t value);
     uint32_t GetVar(ir::Variable var);
 
@@ -158,7 +180,7 @@ private:
         ir::IRStoreFlagsOp, ir::IRLoadFlagsOp, ir::IRLoadStickyOverflowOp,
 
         // Branching
-        ir::IRBranchOp, ir::IRBranchExchangeOp,
+        ir::IRBranchOp, ir::IRBranchExchangeOp, ir::IRCheckpointOp,
 
         // Coprocessor operations
         ir::IRLoadCopRegisterOp, ir::IRStoreCopRegisterOp,
@@ -230,6 +252,7 @@ private:
     InterpInstr CompileOp(const ir::IRLoadStickyOverflowOp *op);
     InterpInstr CompileOp(const ir::IRBranchOp *op);
     InterpInstr CompileOp(const ir::IRBranchExchangeOp *op);
+    InterpInstr CompileOp(const ir::IRCheckpointOp *op);
     InterpInstr CompileOp(const ir::IRLoadCopRegisterOp *op);
     InterpInstr CompileOp(const ir::IRStoreCopRegisterOp *op);
     InterpInstr CompileOp(const ir::IRConstantOp *op);
@@ -275,6 +298,7 @@ private:
     void HandleLoadStickyOverflow(const Op &varOp, LocationRef loc);
     void HandleBranch(const Op &varOp, LocationRef loc);
     void HandleBranchExchange(const Op &varOp, LocationRef loc);
+    void HandleCheckpoint(const Op &varOp, LocationRef loc);
     void HandleLoadCopRegister(const Op &varOp, LocationRef loc);
     void HandleStoreCopRegister(const Op &varOp, LocationRef loc);
     void HandleConstant(const Op &varOp, LocationRef loc);
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace armajitto {
+
+// Bounded lock-free queue of code invalidation requests posted from any thread and applied by the thread running the
+// recompiler.
+//
+// Any number of threads may post requests concurrently; only the thread running the recompiler may drain the queue.
+// If the queue fills up, further requests are dropped and the next drain reports an overflow, which must be handled by
+// invalidating all code.
+class InvalidationQueue {
+public:
+    enum class Kind : uint8_t {
+        MemoryWrite,     // Host::ReportMemoryWrite
+        InvalidateRange, // Host::InvalidateCodeCacheRange
+    };
+
+    struct Request {
+        Kind kind;
+        uint32_t start;
+        uint32_t end;
+    };
+
+    static constexpr uint32_t kCapacity = 1024;
+    static_assert((kCapacity & (kCapacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::atomic<bool>::is_always_lock_free && sizeof(std::atomic<bool>) == 1,
+                  "Compiled code reads the pending flag as a plain byte");
+
+    InvalidationQueue() {
+        for (uint32_t i = 0; i < kCapacity; i++) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Posts a request. Safe to call from any thread.
+    void Post(const Request &request) {
+        if (!TryPush(request)) {
+            m_overflow.store(true, std::memory_order_release);
+        }
+        m_pending.store(true, std::memory_order_release);
+    }
+
+    // Determines if there are requests waiting to be drained.
+    bool HasPending() const {
+        return m_pending.load(std::memory_order_acquire);
+    }
+
+    // Address of the flag raised when requests are posted, polled by compiled code.
+    const std::atomic<bool> *PendingFlag() const {
+        return &m_pending;
+    }
+
+    // Invokes fn(request) for every posted request, or overflowFn() once if requests were dropped.
+    // Must only be called from the thread running the recompiler.
+    template <typename Fn, typename OverflowFn>
+    void Drain(Fn &&fn, OverflowFn &&overflowFn) {
+        // Clear the flag first so that requests posted while draining raise it again
+        m_pending.store(false, std::memory_order_release);
+
+        Request request;
+        while (TryPop(request)) {
+            fn(request);
+        }
+        if (m_overflow.exchange(false, std::memory_order_acq_rel)) {
+            overflowFn();
+        }
+    }
+
+private:
+    // Multi-producer, single-consumer variant of Dmitry Vyukov's bounded queue.
+    // Each cell's sequence number tells producers and the consumer whose turn it is to access the cell.
+    struct Cell {
+        std::atomic<uint32_t> sequence;
+        Request request;
+    };
+
+    std::array<Cell, kCapacity> m_cells;
+    alignas(64) std::atomic<uint32_t> m_enqueuePos = 0;
+    alignas(64) uint32_t m_dequeuePos = 0;
+    std::atomic<bool> m_pending = false;
+    std::atomic<bool> m_overflow = false;
+
+    bool TryPush(const Request &request) {
+        uint32_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &m_cells[pos & (kCapacity - 1)];
+            const uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const int32_t diff = static_cast<int32_t>(sequence - pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // Queue is full
+                return false;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->request = request;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(Request &request) {
+        Cell &cell = m_cells[m_dequeuePos & (kCapacity - 1)];
+        const uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<int32_t>(sequence - (m_dequeuePos + 1)) < 0) {
+            // Queue is empty or the next request is still being written
+            return false;
+        }
+        request = cell.request;
+        cell.sequence.store(m_dequeuePos + kCapacity, std::memory_order_release);
+        ++m_dequeuePos;
+        return true;
+    }
+};
+
+} // namespace armajitto
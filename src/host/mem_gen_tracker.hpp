@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/allocator.hpp"
+#include "util/huge_pages.hpp"
 #include "util/pointer_cast.hpp"
 
 #include <algorithm>
@@ -42,9 +43,21 @@ public:
         uint32_t level;
     };
 
+    MemoryGenerationTracker(HugePageMode hugePages = HugePageMode::None)
+        : m_allocator(hugePages)
+        , m_hugePages(hugePages) {
+
+        // Zero-filled memory is equivalent to all level 1 counters set to zero
+        m_map = static_cast<L1Entry *>(util::AllocatePagesOrThrow(sizeof(L1Entry), hugePages));
+    }
+
+    ~MemoryGenerationTracker() {
+        util::FreePages(m_map, sizeof(L1Entry), m_hugePages);
+    }
+
     Entry Get(uint32_t address) {
         const auto l1Index = Level1Index(address);
-        auto &l1 = m_map[l1Index];
+        auto &l1 = (*m_map)[l1Index];
         if (l1.counter < kL1SplitThreshold) {
             return {l1.counter, 1};
         }
@@ -73,7 +86,7 @@ public:
 
     uint32_t GetLevel(uint32_t address) {
         const auto l1Index = Level1Index(address);
-        auto &l1 = m_map[l1Index];
+        auto &l1 = (*m_map)[l1Index];
         if (l1.counter < kL1SplitThreshold) {
             return 1;
         }
@@ -102,7 +115,7 @@ public:
         const auto l1EndIndex = Level1Index(end);
 
         for (auto l1Index = l1StartIndex; l1Index <= l1EndIndex; l1Index++) {
-            auto &l1 = m_map[l1Index];
+            auto &l1 = (*m_map)[l1Index];
             if (l1.counter == 0xFF) {
                 const auto start2 = std::max(start, l1Index << kL1Shift);
                 const auto end2 = std::min(end, start2 + (1 << kL1Shift) - 1);
@@ -136,11 +149,11 @@ public:
 
     void Clear() {
         m_allocator.Release();
-        m_map.fill({.counter = 0});
+        m_map->fill({.counter = 0});
     }
 
     uintptr_t MapAddress() const {
-        return CastUintPtr(&m_map);
+        return CastUintPtr(m_map);
     }
 
     template <typename T>
@@ -177,7 +190,7 @@ public:
     using L3Entry = std::array<uint32_t, kL3Size>;
     using L2Entry = std::array<PackedCounterPointer<L3Entry>, kL2Size>;
     using L1Entry = std::array<PackedCounterPointer<L2Entry>, kL1Size>;
-    L1Entry m_map;
+    L1Entry *m_map;
 
     static constexpr uint32_t Level1Index(uint32_t address) {
         return (address >> kL1Shift) & kL1Mask;
@@ -193,6 +206,7 @@ public:
 
 private:
     memory::Allocator m_allocator;
+    HugePageMode m_hugePages;
 };
 
 } // namespace armajitto
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "core/location_ref.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace armajitto {
+
+// Runtime counters updated by instrumented code and by the host while Options::Compiler::instrumentation is enabled.
+struct RuntimeCounters {
+    // Updated by compiled code
+    uint64_t slowMemoryAccesses = 0;   // Memory accesses handled by ISystem callbacks
+    uint64_t generationMismatches = 0; // Blocks discarded by the memory generation check
+    uint64_t irqExits = 0;             // IRQ and FIQ entries that could not link to the exception handler block
+
+    // Updated by the host
+    uint64_t patchesApplied = 0;
+    uint64_t patchesReverted = 0;
+
+    // Updated by the dispatcher
+    uint64_t codeLookups = 0;
+    uint64_t codeLookupMisses = 0;
+    uint64_t deadlineExits = 0;
+    uint64_t haltExits = 0;
+    uint64_t unlinkedBranchExits = 0;
+
+    // Number of times each block was entered, by LocationRef::ToUint64().
+    // Compiled code increments these directly, so entries are never erased; references to unordered_map elements
+    // remain valid across rehashes.
+    std::unordered_map<uint64_t, uint64_t> blockExecutions;
+
+    // Retrieves the execution counter of the block at the specified location.
+    uint64_t &BlockExecutionCounter(LocationRef loc) {
+        return blockExecutions[loc.ToUint64()];
+    }
+
+    void Reset() {
+        slowMemoryAccesses = 0;
+        generationMismatches = 0;
+        irqExits = 0;
+        patchesApplied = 0;
+        patchesReverted = 0;
+        codeLookups = 0;
+        codeLookupMisses = 0;
+        deadlineExits = 0;
+        haltExits = 0;
+        unlinkedBranchExits = 0;
+        for (auto &[key, count] : blockExecutions) {
+            count = 0;
+        }
+    }
+};
+
+} // namespace armajitto
@@ -0,0 +1,234 @@
+#include "perf_map.hpp"
+
+#ifdef __linux__
+    #include <elf.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+
+    #include <cstdio>
+    #include <cstring>
+    #include <ctime>
+    #include <mutex>
+    #include <string>
+#endif
+
+namespace perf {
+
+#ifdef __linux__
+
+namespace {
+
+// Jitdump format, as specified in tools/perf/Documentation/jitdump-specification.txt in the Linux kernel sources
+constexpr uint32_t kJitDumpMagic = 0x4A695444; // "JiTD"
+constexpr uint32_t kJitDumpVersion = 1;
+
+constexpr uint32_t kJitCodeLoad = 0;
+constexpr uint32_t kJitCodeClose = 3;
+
+struct JitDumpHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t totalSize;
+    uint32_t elfMach;
+    uint32_t pad1;
+    uint32_t pid;
+    uint64_t timestamp;
+    uint64_t flags;
+};
+
+struct JitRecordHeader {
+    uint32_t id;
+    uint32_t totalSize;
+    uint64_t timestamp;
+};
+
+// Followed by the null-terminated function name and the code bytes
+struct JitCodeLoadRecord {
+    JitRecordHeader header;
+    uint32_t pid;
+    uint32_t tid;
+    uint64_t vma;
+    uint64_t codeAddr;
+    uint64_t codeSize;
+    uint64_t codeIndex;
+};
+
+// perf record -k 1 timestamps samples with the monotonic clock
+uint64_t Timestamp() {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// Perf map and jitdump files shared by all reporters in the process
+class Files {
+public:
+    static Files &Instance() {
+        static Files files;
+        return files;
+    }
+
+    ~Files() {
+        std::lock_guard lock{m_mutex};
+        if (m_perfMap != nullptr) {
+            std::fclose(m_perfMap);
+        }
+        if (m_jitDump != nullptr) {
+            const JitRecordHeader record{
+                .id = kJitCodeClose,
+                .totalSize = sizeof(JitRecordHeader),
+                .timestamp = Timestamp(),
+            };
+            std::fwrite(&record, sizeof(record), 1, m_jitDump);
+            std::fclose(m_jitDump);
+            munmap(m_jitDumpMarker, m_jitDumpMarkerSize);
+        }
+    }
+
+    void OpenPerfMap() {
+        std::lock_guard lock{m_mutex};
+        if (m_perfMap != nullptr) {
+            return;
+        }
+        const std::string path = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+        m_perfMap = std::fopen(path.c_str(), "w");
+    }
+
+    void OpenJitDump() {
+        std::lock_guard lock{m_mutex};
+        if (m_jitDump != nullptr) {
+            return;
+        }
+        const std::string path = "/tmp/jit-" + std::to_string(getpid()) + ".dump";
+        const int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0666);
+        if (fd == -1) {
+            return;
+        }
+
+        // perf finds the dump through an executable mapping of the file, which must stay alive while profiling
+        m_jitDumpMarkerSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        m_jitDumpMarker = mmap(nullptr, m_jitDumpMarkerSize, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0);
+        if (m_jitDumpMarker == MAP_FAILED) {
+            close(fd);
+            return;
+        }
+
+        m_jitDump = fdopen(fd, "wb");
+        if (m_jitDump == nullptr) {
+            munmap(m_jitDumpMarker, m_jitDumpMarkerSize);
+            close(fd);
+            return;
+        }
+
+        const JitDumpHeader header{
+            .magic = kJitDumpMagic,
+            .version = kJitDumpVersion,
+            .totalSize = sizeof(JitDumpHeader),
+            .elfMach = EM_X86_64,
+            .pad1 = 0,
+            .pid = static_cast<uint32_t>(getpid()),
+            .timestamp = Timestamp(),
+            .flags = 0,
+        };
+        std::fwrite(&header, sizeof(header), 1, m_jitDump);
+        std::fflush(m_jitDump);
+    }
+
+    void WritePerfMap(uintptr_t codeStart, uintptr_t codeEnd, const char *fnName) {
+        std::lock_guard lock{m_mutex};
+        if (m_perfMap == nullptr) {
+            return;
+        }
+        std::fprintf(m_perfMap, "%zx %zx %s\n", static_cast<size_t>(codeStart),
+                     static_cast<size_t>(codeEnd - codeStart), fnName);
+        std::fflush(m_perfMap);
+    }
+
+    void WriteJitDump(uintptr_t codeStart, uintptr_t codeEnd, const char *fnName) {
+        std::lock_guard lock{m_mutex};
+        if (m_jitDump == nullptr) {
+            return;
+        }
+        const size_t nameSize = std::strlen(fnName) + 1;
+        const size_t codeSize = codeEnd - codeStart;
+        const JitCodeLoadRecord record{
+            .header =
+                {
+                    .id = kJitCodeLoad,
+                    .totalSize = static_cast<uint32_t>(sizeof(JitCodeLoadRecord) + nameSize + codeSize),
+                    .timestamp = Timestamp(),
+                },
+            .pid = static_cast<uint32_t>(getpid()),
+            .tid = static_cast<uint32_t>(syscall(SYS_gettid)),
+            .vma = codeStart,
+            .codeAddr = codeStart,
+            .codeSize = codeSize,
+            .codeIndex = m_codeIndex++,
+        };
+        std::fwrite(&record, sizeof(record), 1, m_jitDump);
+        std::fwrite(fnName, nameSize, 1, m_jitDump);
+        std::fwrite(reinterpret_cast<const void *>(codeStart), codeSize, 1, m_jitDump);
+        std::fflush(m_jitDump);
+    }
+
+private:
+    std::mutex m_mutex;
+    FILE *m_perfMap = nullptr;
+    FILE *m_jitDump = nullptr;
+    void *m_jitDumpMarker = nullptr;
+    size_t m_jitDumpMarkerSize = 0;
+    uint64_t m_codeIndex = 0;
+};
+
+} // namespace
+
+CodeReporter::CodeReporter(bool perfMap, bool jitDump)
+    : m_perfMap(perfMap)
+    , m_jitDump(jitDump) {
+
+    if (m_perfMap) {
+        Files::Instance().OpenPerfMap();
+    }
+    if (m_jitDump) {
+        Files::Instance().OpenJitDump();
+    }
+}
+
+void CodeReporter::ReportCode(uintptr_t codeStart, uintptr_t codeEnd, const char *fnName) {
+    if (!m_perfMap && !m_jitDump) {
+        return;
+    }
+
+    const std::string methodName = std::string("armajitto::jit::") + fnName;
+    if (m_perfMap) {
+        Files::Instance().WritePerfMap(codeStart, codeEnd, methodName.c_str());
+    }
+    if (m_jitDump) {
+        Files::Instance().WriteJitDump(codeStart, codeEnd, methodName.c_str());
+    }
+}
+
+void CodeReporter::ReportBasicBlock(uintptr_t codeStart, uintptr_t codeEnd, armajitto::LocationRef loc) {
+    if (!m_perfMap && !m_jitDump) {
+        return;
+    }
+
+    const std::string fnName = "block_" + loc.ToString();
+    ReportCode(codeStart, codeEnd, fnName.c_str());
+}
+
+#else
+
+CodeReporter::CodeReporter(bool perfMap, bool jitDump)
+    : m_perfMap(false)
+    , m_jitDump(false) {}
+
+void CodeReporter::ReportCode(uintptr_t codeStart, uintptr_t codeEnd, const char *fnName) {}
+
+void CodeReporter::ReportBasicBlock(uintptr_t codeStart, uintptr_t codeEnd, armajitto::LocationRef loc) {}
+
+#endif
+
+} // namespace perf
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "core/location_ref.hpp"
+
+#include <cstdint>
+
+namespace perf {
+
+// Reports JIT-compiled code to the Linux perf profiler.
+//
+// Perf map files (/tmp/perf-<pid>.map) list the address, size and name of each piece of code. perf report reads them
+// directly to symbolize samples taken in JIT-compiled code.
+//
+// Jitdump files (/tmp/jit-<pid>.dump) also contain the code bytes, which allows perf annotate to disassemble the code
+// after the profile is processed with perf inject --jit. Record the profile with perf record -k 1 so that the sample
+// timestamps match those in the dump.
+//
+// The files are shared by all reporters in the process and stay open until it exits.
+// Both formats are only supported on Linux; reporters do nothing on other platforms.
+class CodeReporter {
+public:
+    CodeReporter(bool perfMap, bool jitDump);
+
+    void ReportCode(uintptr_t codeStart, uintptr_t codeEnd, const char *fnName);
+    void ReportBasicBlock(uintptr_t codeStart, uintptr_t codeEnd, armajitto::LocationRef loc);
+
+private:
+    bool m_perfMap;
+    bool m_jitDump;
+};
+
+} // namespace perf
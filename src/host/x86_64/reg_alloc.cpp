@@ -36,6 +36,10 @@ void RegisterAllocator::Analyze(const ir::BasicBlock &block) {
     m_leastRecentReg = nullptr;
 }
 
+void RegisterAllocator::Reserve(Xbyak::Reg32 reg) {
+    m_freeRegs.Erase(reg);
+}
+
 void RegisterAllocator::SetInstruction(const ir::IROp *op) {
     m_currOp = op;
 }
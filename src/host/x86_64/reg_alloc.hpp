@@ -24,6 +24,10 @@ public:
     // Analyzes the given basic block, building the variable lifetime table.
     void Analyze(const ir::BasicBlock &block);
 
+    // Removes the specified register from the pool of allocatable registers for the rest of the block.
+    // Must be invoked after Analyze() and before any allocations.
+    void Reserve(Xbyak::Reg32 reg);
+
     // Sets the current instruction being compiled.
     void SetInstruction(const ir::IROp *op);
 
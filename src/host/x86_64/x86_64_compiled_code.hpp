@@ -1,30 +1,71 @@
 #pragma once
 
 #include "core/location_ref.hpp"
+#include "core/memory_map_priv_access.hpp"
+#include "guest/arm/flags.hpp"
 #include "host/block_cache.hpp"
 #include "host/host_code.hpp"
 #include "host/mem_gen_tracker.hpp"
+#include "host/runtime_counters.hpp"
+#include "ir/basic_block.hpp"
 #include "util/pointer_cast.hpp"
 
+#include <atomic>
 #include <cstdint>
 #include <map> // TODO: I'll probably regret this...
+#include <unordered_map>
+#include <vector>
 
 namespace armajitto::x86_64 {
 
 struct CompiledCode {
+    CompiledCode(HugePageMode hugePages)
+        : blockCache(hugePages)
+        , memGenTracker(hugePages) {}
+
     struct PatchInfo {
         uint64_t cachedBlockKey;
         const uint8_t *codePos;
         const uint8_t *codeEnd;
         // TODO: patch type?
+
+        // Deferred copy of the NZCV flags into CPSR emitted right before codePos, if any.
+        // Skipped by jumping from flagsSyncPos if the target block copies the same flags before observing CPSR.
+        const uint8_t *flagsSyncPos = nullptr;
+        arm::Flags flagsSync = arm::Flags::None;
+    };
+
+    // Memory copy or fill loop run by a block before its body.
+    struct LoopIdiomInfo {
+        ir::BasicBlock::LoopIdiom idiom;
+        uint32_t loopAddress; // Address of the first instruction of the loop
+
+        // Memory maps and the level 1 tables used to access them, which may be permission views
+        const MemoryMapPrivateAccess::Map *readMap;
+        const MemoryMapPrivateAccess::Map *writeMap;
+        uintptr_t readL1MapAddress;
+        uintptr_t writeL1MapAddress;
     };
 
     using PrologFn = int64_t (*)(HostCode blockFn, uint64_t cycles);
     PrologFn prolog;
     HostCode epilog;
+    HostCode flagsSyncEpilog; // Copies the host NZCV flags into CPSR then runs the epilog
     HostCode irqEntry;
+    HostCode fiqEntry;
+    HostCode interruptEntry; // Enters the FIQ handler if FIQs are pending and enabled, or the IRQ handler otherwise
 
     bool enableBlockLinking;
+    bool inlineTCMAccesses;
+    bool lazyFlags;
+    bool cacheTimingModel;
+    uint64_t cacheLineFillCycles;
+
+    // Counters incremented by instrumented code; nullptr if instrumentation is disabled
+    RuntimeCounters *runtimeCounters;
+
+    // Flag raised when invalidations are posted from other threads; nullptr if blocks do not poll the queue
+    const std::atomic<bool> *pendingInvalidations;
 
     // Cached blocks by LocationRef::ToUint64()
     BlockCache blockCache;
@@ -33,9 +74,19 @@ struct CompiledCode {
     std::multimap<uint64_t, PatchInfo> pendingPatches;
     std::multimap<uint64_t, PatchInfo> appliedPatches;
 
+    // NZCV flags copied into CPSR by blocks before being observed, by LocationRef::ToUint64()
+    std::unordered_map<uint64_t, arm::Flags> resyncedFlags;
+
     // Memory generation tracker; used to invalidate modified blocks
     MemoryGenerationTracker memGenTracker;
 
+    // Loop idioms referenced by compiled blocks, by LocationRef::ToUint64().
+    // Entries of invalidated blocks are retired rather than freed immediately, since the blocks may still be running.
+    // Retired entries are freed before compiling the next block, when no compiled code is running.
+    std::unordered_map<uint64_t, LoopIdiomInfo> loopIdioms;
+    std::vector<uint64_t> retiredLoopIdioms;
+    bool retireAllLoopIdioms = false;
+
     // Retrieves the cached block for the specified location, or nullptr if no block was compiled there.
     HostCode GetCodeForLocation(LocationRef loc) {
         auto *entry = blockCache.Get(loc.ToUint64());
@@ -45,14 +96,48 @@ struct CompiledCode {
         return *entry;
     }
 
+    // Retrieves the NZCV flags that the block at the specified location copies into CPSR before they can be observed.
+    arm::Flags GetResyncedFlags(LocationRef loc) const {
+        auto it = resyncedFlags.find(loc.ToUint64());
+        if (it == resyncedFlags.end()) {
+            return arm::Flags::None;
+        }
+        return it->second;
+    }
+
+    void RetireLoopIdiom(uint64_t key) {
+        if (loopIdioms.contains(key)) {
+            retiredLoopIdioms.push_back(key);
+        }
+    }
+
+    void FreeRetiredLoopIdioms() {
+        if (retireAllLoopIdioms) {
+            loopIdioms.clear();
+        } else {
+            for (uint64_t key : retiredLoopIdioms) {
+                loopIdioms.erase(key);
+            }
+        }
+        retiredLoopIdioms.clear();
+        retireAllLoopIdioms = false;
+    }
+
     void Clear() {
         blockCache.Clear();
         pendingPatches.clear();
         appliedPatches.clear();
+        resyncedFlags.clear();
         memGenTracker.Clear();
+        loopIdioms.clear();
+        retiredLoopIdioms.clear();
+        retireAllLoopIdioms = false;
         prolog = nullptr;
         epilog = nullptr;
+        flagsSyncEpilog = nullptr;
         irqEntry = nullptr;
+        fiqEntry = nullptr;
+        interruptEntry = nullptr;
     }
 };
 
@@ -8,8 +8,11 @@
 #include "cpuid.hpp"
 #include "x86_64_flags.hpp"
 
+#include <algorithm>
+#include <array>
 #include <bit>
 #include <cassert>
+#include <cstring>
 
 namespace armajitto::x86_64 {
 
@@ -107,6 +110,262 @@ static void SystemStoreCopExtRegister(arm::State &state, uint32_t cpnum, uint32_
     return state.GetCoprocessor(cpnum & 0xF).StoreExtRegister(reg & 0xFFFF, value);
 }
 
+// Protection unit checks
+// While the protection unit is enabled, the slow memory access path checks the permission and performs the access in a
+// single host call.
+
+// Packs the access type and privilege level of a protection unit check into a host function argument.
+static uint32_t PackAccessPermission(arm::cp15::pu::Access access, bool privileged) {
+    return static_cast<uint32_t>(access) | (privileged ? 0x100 : 0);
+}
+
+static bool IsAccessAllowed(Context &context, uint32_t address, uint32_t permission) {
+    auto &pu = context.GetARMState().GetSystemControlCoprocessor().GetProtectionUnit();
+    return pu.IsAccessAllowed(address, 1, static_cast<arm::cp15::pu::Access>(permission & 0xFF),
+                              (permission & 0x100) != 0);
+}
+
+// Returned by checked reads if the access is denied; values read are zero-extended to 64 bits.
+static constexpr uint64_t kAccessDenied = 1ull << 32;
+
+using SystemMemReadFn = uint32_t (*)(ISystem &system, uint32_t address);
+
+static uint64_t SystemMemReadChecked(Context &context, SystemMemReadFn readFn, uint32_t address,
+                                     uint32_t permission) {
+    if (!IsAccessAllowed(context, address, permission)) {
+        return kAccessDenied;
+    }
+    return readFn(context.GetSystem(), address);
+}
+
+// Returns zero if the access is denied.
+template <void (*writeFn)(ISystem &, uint32_t, uint32_t)>
+static uint32_t SystemMemWriteChecked(Context &context, uint32_t address, uint32_t value, uint32_t permission) {
+    if (!IsAccessAllowed(context, address, permission)) {
+        return 0;
+    }
+    writeFn(context.GetSystem(), address, value);
+    return 1;
+}
+
+static void SystemEnterDataAbort(arm::State &state, uint32_t instrAddress) {
+    const uint32_t instrSize = state.CPSR().t ? sizeof(uint16_t) : sizeof(uint32_t);
+    state.GPR(arm::GPR::PC) = instrAddress + instrSize * 2;
+    state.EnterException(arm::Exception::DataAbort);
+}
+
+// Cache timing model
+
+static uint32_t SystemCodeCacheMiss(arm::SystemControlCoprocessor &cp15, uint32_t address) {
+    return cp15.CodeCacheMiss(address);
+}
+
+static uint32_t SystemDataCacheMiss(arm::SystemControlCoprocessor &cp15, uint32_t address) {
+    return cp15.DataCacheMiss(address);
+}
+
+// Loop idioms
+
+// Returns the host pointer to the guest address through a level 1 table of the memory map, or nullptr if unmapped.
+static uint8_t *LoopIdiomGetPointer(const MemoryMapPrivateAccess::Map &map, uintptr_t l1MapAddress,
+                                    uint32_t address) {
+    auto *l1Table = reinterpret_cast<void ***>(l1MapAddress);
+    void **l2Table = l1Table[address >> map.GetL1Shift()];
+    if (l2Table == nullptr) {
+        return nullptr;
+    }
+    auto *page = static_cast<uint8_t *>(l2Table[(address >> map.GetL2Shift()) & map.GetL2Mask()]);
+    if (page == nullptr) {
+        return nullptr;
+    }
+    return page + (address & map.GetPageMask());
+}
+
+// Returns the number of bytes from the guest address to the end of its page.
+static uint32_t LoopIdiomPageRemaining(const MemoryMapPrivateAccess::Map &map, uint32_t address) {
+    return map.GetPageMask() - (address & map.GetPageMask()) + 1;
+}
+
+// Returns the number of consecutive mapped bytes starting at the address, up to <length>.
+static uint64_t LoopIdiomMappedLength(const MemoryMapPrivateAccess::Map &map, uintptr_t l1MapAddress,
+                                      uint32_t address, uint64_t length) {
+    uint64_t mapped = 0;
+    while (mapped < length) {
+        const uint32_t pageAddress = address + static_cast<uint32_t>(mapped);
+        if (LoopIdiomGetPointer(map, l1MapAddress, pageAddress) == nullptr) {
+            break;
+        }
+        mapped += LoopIdiomPageRemaining(map, pageAddress);
+    }
+    return std::min(mapped, length);
+}
+
+// Returns the total number of iterations of the loop given the initial counter, or 0 if it cannot be determined.
+// The loop branches back while <counter> <cond> <decrement> holds before each subtraction.
+static uint64_t LoopIdiomIterations(arm::Condition cond, uint32_t counter, uint32_t decrement) {
+    switch (cond) {
+    case arm::Condition::NE:
+        // Loops that skip over zero run until the counter wraps around
+        if (counter == 0 || counter % decrement != 0) {
+            return 0;
+        }
+        return counter / decrement;
+    case arm::Condition::HI: return std::max<uint64_t>(1, ((uint64_t)counter + decrement - 1) / decrement);
+    case arm::Condition::CS: return counter / decrement + 1;
+    case arm::Condition::GT: {
+        const int32_t signedCounter = static_cast<int32_t>(counter);
+        if (signedCounter <= 0) {
+            return 1;
+        }
+        return std::max<uint64_t>(1, ((uint64_t)signedCounter + decrement - 1) / decrement);
+    }
+    case arm::Condition::GE: {
+        const int32_t signedCounter = static_cast<int32_t>(counter);
+        if (signedCounter < 0) {
+            return 1;
+        }
+        return (uint64_t)signedCounter / decrement + 1;
+    }
+    default: return 0;
+    }
+}
+
+// Runs iterations of a copy or fill loop, except for the last one, while the loop stays within mapped memory and the
+// cycle budget. Returns the number of cycles taken.
+static uint64_t SystemRunLoopIdiom(CompiledCode &compiledCode, arm::State &state,
+                                   const CompiledCode::LoopIdiomInfo &info, uint64_t cycleCount) {
+    using Kind = ir::BasicBlock::LoopIdiom::Kind;
+    const auto &idiom = info.idiom;
+
+    // Compute how many cycles are left until the deadline
+    uint64_t budget;
+    if (state.deadlinePtr != nullptr) {
+        const uint64_t deadline = *state.deadlinePtr;
+        if (cycleCount >= deadline) {
+            return 0;
+        }
+        budget = deadline - cycleCount;
+    } else {
+        if (static_cast<int64_t>(cycleCount) <= 0) {
+            return 0;
+        }
+        budget = cycleCount;
+    }
+
+    // Leave the last iteration to the block so that it sets the flags and falls out of the loop
+    uint32_t &counter = state.GPR(idiom.counter.gpr, idiom.counter.Mode());
+    const uint64_t totalIterations = LoopIdiomIterations(idiom.cond, counter, idiom.decrement);
+    if (totalIterations <= 1) {
+        return 0;
+    }
+    uint64_t iterations = std::min(totalIterations - 1, budget / idiom.cyclesPerIteration);
+
+    // Transfers must be aligned; the guest would otherwise force the alignment or rotate the data
+    const bool copy = idiom.kind == Kind::Copy;
+    const uint32_t chunkSize = idiom.bytesPerIteration;
+    const uint32_t alignMask = (idiom.size == ir::MemAccessSize::Word)   ? 3
+                               : (idiom.size == ir::MemAccessSize::Half) ? 1
+                                                                         : 0;
+    uint32_t &dst = state.GPR(idiom.dst.gpr, idiom.dst.Mode());
+    uint32_t *src = copy ? &state.GPR(idiom.src.gpr, idiom.src.Mode()) : nullptr;
+    const uint32_t dstAddress = dst;
+    const uint32_t srcAddress = copy ? *src : 0;
+    if ((dstAddress & alignMask) != 0 || (srcAddress & alignMask) != 0) {
+        return 0;
+    }
+
+    // Stop before wrapping around the address space
+    iterations = std::min<uint64_t>(iterations, (0x1'0000'0000ull - dstAddress) / chunkSize);
+    if (copy) {
+        iterations = std::min<uint64_t>(iterations, (0x1'0000'0000ull - srcAddress) / chunkSize);
+    }
+
+    // Each iteration loads all of its data before storing it. A destination that trails the source by less than an
+    // iteration would read data before it is overwritten, which cannot be reproduced with forward copies.
+    const uint32_t distance = dstAddress - srcAddress;
+    if (copy && dstAddress > srcAddress && distance < chunkSize) {
+        return 0;
+    }
+
+    // Only access mapped memory; MMIO and protected regions are left to the block
+    iterations = std::min<uint64_t>(
+        iterations,
+        LoopIdiomMappedLength(*info.writeMap, info.writeL1MapAddress, dstAddress, iterations * chunkSize) / chunkSize);
+    if (copy) {
+        iterations = std::min<uint64_t>(
+            iterations,
+            LoopIdiomMappedLength(*info.readMap, info.readL1MapAddress, srcAddress, iterations * chunkSize) /
+                chunkSize);
+    }
+    if (iterations == 0) {
+        return 0;
+    }
+    const uint32_t length = static_cast<uint32_t>(iterations * chunkSize);
+
+    // Leave loops that overwrite their own code to the block
+    const uint32_t instrSize = state.CPSR().t ? sizeof(uint16_t) : sizeof(uint32_t);
+    const uint32_t loopSize = idiom.instrCount * instrSize;
+    if (dstAddress < info.loopAddress + loopSize && info.loopAddress < dstAddress + length) {
+        return 0;
+    }
+
+    if (copy) {
+        // Copy in segments that don't cross page boundaries. Segments never exceed the distance between the pointers,
+        // so that overlapping data is copied forward just like the guest would.
+        const uint32_t maxSegment = (dstAddress > srcAddress && distance < length) ? distance : length;
+        uint32_t offset = 0;
+        while (offset < length) {
+            const uint32_t srcPos = srcAddress + offset;
+            const uint32_t dstPos = dstAddress + offset;
+            const uint32_t segment =
+                std::min({length - offset, maxSegment, LoopIdiomPageRemaining(*info.readMap, srcPos),
+                          LoopIdiomPageRemaining(*info.writeMap, dstPos)});
+            std::memmove(LoopIdiomGetPointer(*info.writeMap, info.writeL1MapAddress, dstPos),
+                         LoopIdiomGetPointer(*info.readMap, info.readL1MapAddress, srcPos), segment);
+            offset += segment;
+        }
+        *src = srcAddress + length;
+    } else {
+        // Build the pattern stored on each iteration; registers are stored in ascending order
+        std::array<uint8_t, 16 * sizeof(uint32_t)> pattern{};
+        uint32_t patternPos = 0;
+        for (uint32_t reg = 0; reg < 16; reg++) {
+            if (idiom.regList & (1u << reg)) {
+                const uint32_t value = state.GPR(static_cast<arm::GPR>(reg), idiom.dst.Mode());
+                const uint32_t size = (chunkSize < sizeof(uint32_t)) ? chunkSize : sizeof(uint32_t);
+                std::memcpy(&pattern[patternPos], &value, size);
+                patternPos += size;
+            }
+        }
+
+        uint32_t offset = 0;
+        while (offset < length) {
+            const uint32_t dstPos = dstAddress + offset;
+            const uint32_t segment = std::min(length - offset, LoopIdiomPageRemaining(*info.writeMap, dstPos));
+            uint8_t *ptr = LoopIdiomGetPointer(*info.writeMap, info.writeL1MapAddress, dstPos);
+            if (chunkSize == 1) {
+                std::memset(ptr, pattern[0], segment);
+            } else {
+                uint32_t phase = offset % chunkSize;
+                uint32_t remaining = segment;
+                while (remaining > 0) {
+                    const uint32_t size = std::min(remaining, chunkSize - phase);
+                    std::memcpy(ptr, &pattern[phase], size);
+                    ptr += size;
+                    remaining -= size;
+                    phase = 0;
+                }
+            }
+            offset += segment;
+        }
+    }
+    compiledCode.memGenTracker.Increment(dstAddress, dstAddress + length - 1);
+
+    dst = dstAddress + length;
+    counter -= static_cast<uint32_t>(iterations * idiom.decrement);
+    return iterations * idiom.cyclesPerIteration;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 
 x64Host::Compiler::Compiler(Context &context, arm::StateOffsets &stateOffsets, CompiledCode &compiledCode,
@@ -118,11 +377,61 @@ x64Host::Compiler::Compiler(Context &context, arm::StateOffsets &stateOffsets, C
     , m_armState(context.GetARMState())
     , m_stateOffsets(stateOffsets)
     , m_codegen(codegen)
-    , m_memMap(context.GetSystem().GetMemoryMap()) {
+    , m_memMap(context.GetSystem().GetMemoryMap())
+    , m_flagsAnalyzer(alloc) {
 
     m_regAlloc.Analyze(block);
     m_mode = block.Location().Mode();
     m_thumb = block.Location().IsThumbMode();
+    m_baseAddress = block.Location().PC() - (m_thumb ? sizeof(uint16_t) : sizeof(uint32_t)) * 2;
+
+    auto &cp15 = m_armState.GetSystemControlCoprocessor();
+    m_memProtection = cp15.IsPresent() && cp15.GetControlRegister().value.puEnable;
+
+    if (m_compiledCode.lazyFlags) {
+        m_flagsAnalyzer.Analyze(block, m_memProtection);
+    }
+
+    m_codeSize = block.InstructionCount() * (m_thumb ? sizeof(uint16_t) : sizeof(uint32_t));
+
+    m_selfLoop = m_compiledCode.enableBlockLinking && block.GetTerminal() == ir::BasicBlock::Terminal::DirectLink &&
+                 block.GetTerminalLocation().ToUint64() == block.Location().ToUint64();
+    if (!m_selfLoop) {
+        return;
+    }
+
+    // Pick the loop registers among the guest registers read and then written by the block.
+    // Loop idioms update their registers in the ARM state at the start of the block, so they keep them in memory.
+    if (block.GetLoopIdiom().kind != ir::BasicBlock::LoopIdiom::Kind::None) {
+        return;
+    }
+    static constexpr std::array<Xbyak::Reg32, kMaxLoopRegs> kLoopHostRegs = {r15d, r14d}; // nonvolatile in all ABIs
+    for (auto *op = block.Head(); op != nullptr && m_loopRegCount < kMaxLoopRegs; op = op->Next()) {
+        if (op->type != ir::IROpcodeType::GetRegister) {
+            continue;
+        }
+        auto *getOp = static_cast<const ir::IRGetRegisterOp *>(op);
+        if (getOp->src.gpr == arm::GPR::PC) {
+            continue;
+        }
+
+        // Registers banked in different modes may share storage, so they're identified by their ARM state offset
+        const auto offset = m_stateOffsets.GPROffset(getOp->src.gpr, getOp->src.Mode());
+        if (GetLoopRegister(offset).isNone()) {
+            for (auto *nextOp = op->Next(); nextOp != nullptr; nextOp = nextOp->Next()) {
+                if (nextOp->type != ir::IROpcodeType::SetRegister) {
+                    continue;
+                }
+                auto *setOp = static_cast<const ir::IRSetRegisterOp *>(nextOp);
+                if (m_stateOffsets.GPROffset(setOp->dst.gpr, setOp->dst.Mode()) == offset) {
+                    const auto hostReg = kLoopHostRegs[m_loopRegCount];
+                    m_loopRegs[m_loopRegCount++] = {static_cast<uint32_t>(offset), hostReg};
+                    m_regAlloc.Reserve(hostReg);
+                    break;
+                }
+            }
+        }
+    }
 }
 
 void x64Host::Compiler::PreProcessOp(const ir::IROp *op) {
@@ -134,12 +443,47 @@ void x64Host::Compiler::PostProcessOp(const ir::IROp *op) {
     m_regAlloc.ReleaseTemporaries();
 }
 
-void x64Host::Compiler::CompileGenerationCheck(const LocationRef &baseLoc, const uint32_t instrCount) {
-    // TODO: handle mirrored regions
-
+void x64Host::Compiler::CompileGenerationCheck(const LocationRef &baseLoc, const uint32_t instrCount,
+                                               const uint32_t precedingInstrCount) {
     const uint32_t instrSize = baseLoc.IsThumbMode() ? sizeof(uint16_t) : sizeof(uint32_t);
-    const uint32_t baseAddress = baseLoc.PC() - instrSize * 2;
-    const uint32_t finalAddress = baseAddress + instrSize * instrCount - 1;
+    const uint32_t blockAddress = baseLoc.PC() - instrSize * 2;
+    const uint32_t baseAddress = blockAddress - instrSize * precedingInstrCount;
+    const uint32_t finalAddress = blockAddress + instrSize * instrCount - 1;
+
+    auto basePtrReg64 = m_regAlloc.GetTemporary().cvt64();
+
+    Xbyak::Label lblContinue{};
+    Xbyak::Label lblInvalidate{};
+
+    CompileGenerationCompare(baseAddress, finalAddress, lblInvalidate);
+    m_codegen.jmp(lblContinue);
+
+    // One of the entries has a generation mismatch, which means code was potentially modified
+    m_codegen.L(lblInvalidate);
+    {
+        // Mark block as invalid by setting the host code pointer to null.
+        // This will cause the recompiler to request a block invalidation later on, to clean up patches.
+        const auto blockPtr = m_compiledCode.blockCache.Get(baseLoc.ToUint64());
+        if (blockPtr != nullptr) {
+            m_codegen.mov(basePtrReg64, CastUintPtr(blockPtr));
+            m_codegen.mov(qword[basePtrReg64], CastUintPtr(nullptr));
+        }
+
+        CompileCounterIncrement(&RuntimeCounters::generationMismatches, basePtrReg64);
+
+        // Go to epilog to recompile the block
+        // The previous block may have deferred copying the flags into CPSR to this block
+        m_codegen.jmp(m_compiledCode.lazyFlags ? m_compiledCode.flagsSyncEpilog : m_compiledCode.epilog);
+    }
+
+    // All checks passed, continue execution
+    m_codegen.L(lblContinue);
+    m_regAlloc.ReleaseTemporaries();
+}
+
+void x64Host::Compiler::CompileGenerationCompare(const uint32_t baseAddress, const uint32_t finalAddress,
+                                                 Xbyak::Label &lblInvalidate) {
+    // TODO: handle mirrored regions
 
     auto basePtrReg64 = m_regAlloc.GetTemporary().cvt64();
     auto l2BasePtrReg64 = m_regAlloc.GetTemporary().cvt64();
@@ -147,9 +491,6 @@ void x64Host::Compiler::CompileGenerationCheck(const LocationRef &baseLoc, const
     // auto counterReg8 = GetReg8(m_regAlloc.GetTemporary());
     const uint8_t addrBits = 64 - CPUID::VirtualAddressBits();
 
-    Xbyak::Label lblContinue{};
-    Xbyak::Label lblInvalidate{};
-
     // Check the generation tracker for all entries corresponding to this block
     using MGT = MemoryGenerationTracker;
     auto &mgt = m_compiledCode.memGenTracker;
@@ -214,42 +555,158 @@ void x64Host::Compiler::CompileGenerationCheck(const LocationRef &baseLoc, const
             }
         }
     }
-    m_codegen.jmp(lblContinue);
+}
 
-    // One of the entries has a generation mismatch, which means code was potentially modified
-    m_codegen.L(lblInvalidate);
-    {
-        // Mark block as invalid by setting the host code pointer to null.
-        // This will cause the recompiler to request a block invalidation later on, to clean up patches.
-        const auto blockPtr = m_compiledCode.blockCache.Get(baseLoc.ToUint64());
-        if (blockPtr != nullptr) {
-            m_codegen.mov(basePtrReg64, CastUintPtr(blockPtr));
-            m_codegen.mov(qword[basePtrReg64], CastUintPtr(nullptr));
-        }
+void x64Host::Compiler::CompileInvalidationQueueCheck() {
+    auto *pending = m_compiledCode.pendingInvalidations;
+    if (pending == nullptr) {
+        return;
+    }
 
-        // Go to epilog to recompile the block
-        m_codegen.jmp(m_compiledCode.epilog);
+    auto tmpReg64 = m_regAlloc.GetTemporary().cvt64();
+    m_codegen.mov(tmpReg64, CastUintPtr(pending));
+    m_codegen.cmp(byte[tmpReg64], 0);
+
+    // Return to the dispatcher to apply the posted invalidations
+    // The previous block may have deferred copying the flags into CPSR to this block
+    m_codegen.jnz(m_compiledCode.lazyFlags ? m_compiledCode.flagsSyncEpilog : m_compiledCode.epilog);
+    m_regAlloc.ReleaseTemporaries();
+}
+
+void x64Host::Compiler::CompileExecutionCounter(const ir::BasicBlock &block) {
+    auto *counters = m_compiledCode.runtimeCounters;
+    if (counters == nullptr) {
+        return;
     }
 
-    // All checks passed, continue execution
-    m_codegen.L(lblContinue);
+    auto tmpReg64 = m_regAlloc.GetTemporary().cvt64();
+    m_codegen.mov(tmpReg64, CastUintPtr(&counters->BlockExecutionCounter(block.Location())));
+    m_codegen.inc(qword[tmpReg64]);
     m_regAlloc.ReleaseTemporaries();
 }
 
-void x64Host::Compiler::CompileIRQLineCheck() {
+void x64Host::Compiler::CompileLoopHeader() {
+    if (m_selfLoop) {
+        for (size_t i = 0; i < m_loopRegCount; i++) {
+            m_codegen.mov(m_loopRegs[i].reg, dword[abi::kARMStateReg + m_loopRegs[i].offset]);
+        }
+        m_loopHeader = m_codegen.getCurr<HostCode>();
+    }
+}
+
+Xbyak::Reg32 x64Host::Compiler::GetLoopRegister(uint32_t offset) const {
+    for (size_t i = 0; i < m_loopRegCount; i++) {
+        if (m_loopRegs[i].offset == offset) {
+            return m_loopRegs[i].reg;
+        }
+    }
+    return {};
+}
+
+void x64Host::Compiler::CompileInterruptLinesCheck() {
     const auto irqLineOffset = m_stateOffsets.IRQLineOffset();
-    auto tmpReg8 = GetReg8(m_regAlloc.GetTemporary());
+    auto tmpReg32 = m_regAlloc.GetTemporary();
+
+    // Get inverted CPSR I and F bits, lined up with the IRQ and FIQ line bytes
+    m_codegen.mov(tmpReg32, abi::kHostFlagsReg);
+    m_codegen.shr(tmpReg32, x64flgIPos);
+    m_codegen.not_(tmpReg32);
+
+    // Compare against both interrupt lines at once
+    m_codegen.test(word[abi::kARMStateReg + irqLineOffset], tmpReg32.cvt16());
+
+    // Jump to the interrupt switch code if any line is raised and its interrupts are not inhibited
+    m_codegen.jnz(m_compiledCode.interruptEntry);
+    m_regAlloc.ReleaseTemporaries();
+}
+
+void x64Host::Compiler::CompileCodeCacheAccesses(const ir::BasicBlock &block) {
+    auto *tags = GetCacheTags(true);
+    if (tags == nullptr || block.InstructionCount() == 0) {
+        return;
+    }
+
+    // Fetch every cache line spanned by the block
+    const uint32_t instrSize = m_thumb ? sizeof(uint16_t) : sizeof(uint32_t);
+    const uint32_t firstLine = m_baseAddress >> tags->lineShift;
+    const uint32_t lastLine = (m_baseAddress + (block.InstructionCount() - 1) * instrSize) >> tags->lineShift;
+    auto tmpReg64 = m_regAlloc.GetTemporary().cvt64();
+    for (uint32_t line = firstLine; line <= lastLine; line++) {
+        CompileCacheAccess(line << tags->lineShift, true, tmpReg64, {});
+    }
+    m_regAlloc.ReleaseTemporaries();
+}
+
+void x64Host::Compiler::CompileLoopIdiom(const ir::BasicBlock &block) {
+    using Kind = ir::BasicBlock::LoopIdiom::Kind;
+    const auto &idiom = block.GetLoopIdiom();
+    if (idiom.kind == Kind::None || m_compiledCode.cacheTimingModel) {
+        return;
+    }
 
-    // Get inverted CPSR I bit
-    m_codegen.test(abi::kHostFlagsReg, x64flgI);
-    m_codegen.sete(tmpReg8);
+    // The branch back to the loop is in the following block, so every iteration enters this block again.
+    // Skip the host call unless the counter allows at least two more iterations, since the helper leaves the last one
+    // to the block; this is always the case once the helper has run the bulk of the loop. The threshold matches
+    // LoopIdiomIterations() for each condition.
+    const uint64_t decrement = idiom.decrement;
+    const bool signedCompare = idiom.cond == arm::Condition::GT || idiom.cond == arm::Condition::GE;
+    uint64_t threshold; // minimum counter value
+    switch (idiom.cond) {
+    case arm::Condition::NE: threshold = decrement * 2; break;
+    case arm::Condition::HI: threshold = decrement + 1; break;
+    case arm::Condition::CS: threshold = decrement; break;
+    case arm::Condition::GT: threshold = decrement + 1; break;
+    case arm::Condition::GE: threshold = decrement; break;
+    default: return; // the helper cannot determine the iteration count
+    }
+    if (decrement == 0 || threshold > (signedCompare ? 0x7FFFFFFFull : 0xFFFFFFFFull)) {
+        // The loop never runs two iterations
+        return;
+    }
 
-    // Compare against IRQ line
-    m_codegen.test(byte[abi::kARMStateReg + irqLineOffset], tmpReg8);
+    Xbyak::Label lblSkip{};
+    const auto counterOffset = m_stateOffsets.GPROffset(idiom.counter.gpr, idiom.counter.Mode());
+    m_codegen.cmp(dword[abi::kARMStateReg + counterOffset], static_cast<uint32_t>(threshold));
+    if (signedCompare) {
+        m_codegen.jl(lblSkip, Xbyak::CodeGenerator::T_NEAR);
+    } else {
+        m_codegen.jb(lblSkip, Xbyak::CodeGenerator::T_NEAR);
+    }
 
-    // Jump to IRQ switch code if the IRQ line is raised and interrupts are not inhibited
-    m_codegen.jnz(m_compiledCode.irqEntry);
+    // Misaligned pointers are left to the block as well
+    const uint32_t alignMask = (idiom.size == ir::MemAccessSize::Word)   ? 3
+                               : (idiom.size == ir::MemAccessSize::Half) ? 1
+                                                                         : 0;
+    if (alignMask != 0) {
+        const auto dstOffset = m_stateOffsets.GPROffset(idiom.dst.gpr, idiom.dst.Mode());
+        m_codegen.test(dword[abi::kARMStateReg + dstOffset], alignMask);
+        m_codegen.jnz(lblSkip, Xbyak::CodeGenerator::T_NEAR);
+        if (idiom.kind == Kind::Copy) {
+            const auto srcOffset = m_stateOffsets.GPROffset(idiom.src.gpr, idiom.src.Mode());
+            m_codegen.test(dword[abi::kARMStateReg + srcOffset], alignMask);
+            m_codegen.jnz(lblSkip, Xbyak::CodeGenerator::T_NEAR);
+        }
+    }
+
+    auto &info = m_compiledCode.loopIdioms[block.Location().ToUint64()];
+    info.idiom = idiom;
+    info.loopAddress = m_baseAddress;
+    info.readMap = &m_memMap.dataRead;
+    info.writeMap = &m_memMap.dataWrite;
+    info.readL1MapAddress = GetL1MapAddress(m_memMap.dataRead);
+    info.writeL1MapAddress = GetL1MapAddress(m_memMap.dataWrite);
+
+    // Run as many iterations as possible on the host and count the cycles taken
+    auto tmpReg64 = m_regAlloc.GetTemporary().cvt64();
+    CompileInvokeHostFunction(tmpReg64, SystemRunLoopIdiom, m_compiledCode, m_armState, info, abi::kCycleCountReg);
+    if (m_armState.deadlinePtr != nullptr) {
+        m_codegen.add(abi::kCycleCountReg, tmpReg64);
+    } else {
+        m_codegen.sub(abi::kCycleCountReg, tmpReg64);
+    }
     m_regAlloc.ReleaseTemporaries();
+
+    m_codegen.L(lblSkip);
 }
 
 void x64Host::Compiler::CompileCondCheck(arm::Condition cond, Xbyak::Label &lblCondFail) {
@@ -336,7 +793,19 @@ void x64Host::Compiler::CompileTerminal(const ir::BasicBlock &block) {
 
     switch (block.GetTerminal()) {
     case Terminal::DirectLink: {
-        CompileDirectLink(block.GetTerminalLocation(), blockLocKey);
+        if (m_selfLoop) {
+            // The loop header skips the generation check; go through the block entry if the code was modified by the
+            // block itself, by DMA or by anything else that updates the memory generation tracker
+            Xbyak::Label lblLoop{};
+            Xbyak::Label lblModified{};
+            CompileGenerationCompare(m_baseAddress, m_baseAddress + m_codeSize - 1, lblModified);
+            m_regAlloc.ReleaseTemporaries();
+            m_codegen.jmp(lblLoop, Xbyak::CodeGenerator::T_NEAR);
+            m_codegen.L(lblModified);
+            CompileDirectLink(block.GetTerminalLocation(), blockLocKey, m_flagsAnalyzer.DeferredFlags(), false);
+            m_codegen.L(lblLoop);
+        }
+        CompileDirectLink(block.GetTerminalLocation(), blockLocKey, m_flagsAnalyzer.DeferredFlags());
         break;
     }
     case Terminal::IndirectLink: {
@@ -399,7 +868,16 @@ void x64Host::Compiler::CompileTerminal(const ir::BasicBlock &block) {
         break;
     }
     case Terminal::Return: CompileExit(); break;
-    case Terminal::IdleLoop:
+    case Terminal::IdleLoop: {
+        // Run the loop normally if any of the registers it depends on changed
+        Xbyak::Label lblRunLoop{};
+        const auto guards = block.IdleLoopGuards();
+        for (auto &guard : guards) {
+            const auto gprOffset = m_stateOffsets.GPROffset(guard.reg.gpr, guard.reg.Mode());
+            m_codegen.cmp(dword[abi::kARMStateReg + gprOffset], guard.value);
+            m_codegen.jne(lblRunLoop, Xbyak::CodeGenerator::T_NEAR);
+        }
+
         // Skip cycles until the deadline is reached
         if (m_armState.deadlinePtr != nullptr) {
             const auto deadlinePtrOffset = m_stateOffsets.CycleDeadlinePointerOffset();
@@ -409,8 +887,14 @@ void x64Host::Compiler::CompileTerminal(const ir::BasicBlock &block) {
             m_codegen.xor_(abi::kCycleCountReg, abi::kCycleCountReg);
         }
         CompileExit();
+
+        if (!guards.empty()) {
+            m_codegen.L(lblRunLoop);
+            CompileDirectLink(block.GetTerminalLocation(), blockLocKey);
+        }
         break;
     }
+    }
 }
 
 void x64Host::Compiler::CompileDirectLinkToSuccessor(const ir::BasicBlock &block) {
@@ -433,9 +917,9 @@ void x64Host::Compiler::ReserveTerminalRegisters(const ir::BasicBlock &block) {
         return;
     }
 
-    // Indirect links use three temporary registers.
+    // Indirect links and the generation check on the back-edge of self-loops use three temporary registers.
     // Reserve them now to force variable spilling before branches.
-    if (block.GetTerminal() == ir::BasicBlock::Terminal::IndirectLink) {
+    if (block.GetTerminal() == ir::BasicBlock::Terminal::IndirectLink || m_selfLoop) {
         m_regAlloc.GetTemporary();
         m_regAlloc.GetTemporary();
         m_regAlloc.GetTemporary();
@@ -459,18 +943,41 @@ void x64Host::Compiler::CountCycles(uint64_t cycles) {
     }
 }
 
-void x64Host::Compiler::CompileDirectLink(LocationRef target, uint64_t blockLocKey) {
+void x64Host::Compiler::CompileDirectLink(LocationRef target, uint64_t blockLocKey, arm::Flags flagsSync,
+                                          bool toLoopHeader) {
     if (!m_compiledCode.enableBlockLinking) {
         CompileExit();
         return;
     }
 
+    // Copy the flags deferred by the block into CPSR before leaving it
+    const uint8_t *flagsSyncPos = nullptr;
+    if (flagsSync != arm::Flags::None) {
+        flagsSyncPos = m_codegen.getCurr();
+        x64Host::CompileFlagsSync(m_codegen, m_stateOffsets.CPSROffset(), flagsSync);
+    }
+
     CompiledCode::PatchInfo patchInfo{.cachedBlockKey = blockLocKey, .codePos = m_codegen.getCurr()};
     patchInfo.codeEnd = m_codegen.getCurr();
+    patchInfo.flagsSyncPos = flagsSyncPos;
+    patchInfo.flagsSync = flagsSync;
 
     auto block = m_compiledCode.blockCache.Get(target.ToUint64());
     if (block != nullptr && *block != nullptr) {
+        // Self-loops jump straight to the loop header.
+        // The back-edge is still registered as a patch so that invalidating the block breaks out of the loop.
         auto code = *block;
+        if (toLoopHeader && m_loopHeader != nullptr && target.ToUint64() == blockLocKey) {
+            code = m_loopHeader;
+        }
+
+        // Skip the copy if the target block copies the same flags into CPSR before they can be observed
+        if (flagsSyncPos != nullptr && BitmaskEnum(flagsSync).NoneExcept(m_compiledCode.GetResyncedFlags(target))) {
+            const auto codeSize = m_codegen.getSize();
+            m_codegen.setSize(flagsSyncPos - m_codegen.getCode());
+            m_codegen.jmp(code, Xbyak::CodeGenerator::T_NEAR);
+            m_codegen.setSize(codeSize);
+        }
 
         // Jump to the compiled code's address directly
         m_codegen.jmp(code, Xbyak::CodeGenerator::T_NEAR);
@@ -491,16 +998,27 @@ void x64Host::Compiler::CompileDirectLink(LocationRef target, uint64_t blockLocK
 void x64Host::Compiler::CompileOp(const ir::IRGetRegisterOp *op) {
     auto dstReg32 = m_regAlloc.Get(op->dst.var);
     auto offset = m_stateOffsets.GPROffset(op->src.gpr, op->src.Mode());
-    m_codegen.mov(dstReg32, dword[abi::kARMStateReg + offset]);
+    if (auto loopReg32 = GetLoopRegister(offset); !loopReg32.isNone()) {
+        m_codegen.mov(dstReg32, loopReg32);
+    } else {
+        m_codegen.mov(dstReg32, dword[abi::kARMStateReg + offset]);
+    }
 }
 
 void x64Host::Compiler::CompileOp(const ir::IRSetRegisterOp *op) {
     auto offset = m_stateOffsets.GPROffset(op->dst.gpr, op->dst.Mode());
+    auto loopReg32 = GetLoopRegister(offset);
     if (op->src.immediate) {
         m_codegen.mov(dword[abi::kARMStateReg + offset], op->src.imm.value);
+        if (!loopReg32.isNone()) {
+            m_codegen.mov(loopReg32, op->src.imm.value);
+        }
     } else {
         auto srcReg32 = m_regAlloc.Get(op->src.var.var);
         m_codegen.mov(dword[abi::kARMStateReg + offset], srcReg32);
+        if (!loopReg32.isNone()) {
+            m_codegen.mov(loopReg32, srcReg32);
+        }
     }
 }
 
@@ -515,26 +1033,34 @@ void x64Host::Compiler::CompileOp(const ir::IRSetCPSROp *op) {
     if (op->src.immediate) {
         m_codegen.mov(dword[abi::kARMStateReg + offset], op->src.imm.value);
 
-        // Update I in EAX
+        // Update I and F in EAX
         if (op->updateIFlag) {
-            if (bit::test<ARMflgIPos>(op->src.imm.value)) {
-                m_codegen.or_(abi::kHostFlagsReg, x64flgI);
-            } else {
-                m_codegen.and_(abi::kHostFlagsReg, ~x64flgI);
+            const uint32_t ones = (bit::test<ARMflgIPos>(op->src.imm.value) ? x64flgI : 0) |
+                                  (bit::test<ARMflgFPos>(op->src.imm.value) ? x64flgF : 0);
+            const uint32_t zeros = ~ones & (x64flgI | x64flgF);
+            if (ones != 0) {
+                m_codegen.or_(abi::kHostFlagsReg, ones);
+            }
+            if (zeros != 0) {
+                m_codegen.and_(abi::kHostFlagsReg, ~zeros);
             }
         }
     } else {
         auto srcReg32 = m_regAlloc.Get(op->src.var.var);
         m_codegen.mov(dword[abi::kARMStateReg + offset], srcReg32);
 
-        // Update I in EAX
+        // Update I and F in EAX
         if (op->updateIFlag) {
             auto tmpReg32 = m_regAlloc.GetTemporary();
+            m_codegen.and_(abi::kHostFlagsReg, ~(x64flgI | x64flgF));
             m_codegen.mov(tmpReg32, srcReg32);
             m_codegen.and_(tmpReg32, ARMflgI);
-            m_codegen.and_(abi::kHostFlagsReg, ~x64flgI);
             m_codegen.shl(tmpReg32, x64flgIPos - ARMflgIPos);
             m_codegen.or_(abi::kHostFlagsReg, tmpReg32);
+            m_codegen.mov(tmpReg32, srcReg32);
+            m_codegen.and_(tmpReg32, ARMflgF);
+            m_codegen.shl(tmpReg32, x64flgFPos - ARMflgFPos);
+            m_codegen.or_(abi::kHostFlagsReg, tmpReg32);
         }
     }
 }
@@ -582,6 +1108,13 @@ void x64Host::Compiler::CompileOp(const ir::IRMemReadOp *op) {
         indexReg32 = m_regAlloc.GetTemporary();
     }
 
+    // Reserve temporary register for the TCM fast path
+    const bool tcmFastPath = !op->address.immediate && IsTCMFastPathEnabled(op->bus);
+    Xbyak::Reg32 tcmMaskReg32{};
+    if (tcmFastPath) {
+        tcmMaskReg32 = m_regAlloc.GetTemporary();
+    }
+
     auto compileRead = [this, op, &lblEnd, &baseAddrReg32](Xbyak::Reg32 dstReg32, Xbyak::Reg64 addrReg64, auto offset) {
         switch (op->size) {
         case ir::MemAccessSize::Byte:
@@ -666,8 +1199,28 @@ void x64Host::Compiler::CompileOp(const ir::IRMemReadOp *op) {
     // Get memory map for the corresponding bus
     auto &memMapRef = (op->bus == ir::MemAccessBus::Code) ? m_memMap.codeRead : m_memMap.dataRead;
 
+    // Count access cycles
+    if (op->bus == ir::MemAccessBus::Data) {
+        CompileMemAccessTiming(m_memMap.dataReadTimings, op->address, op->size, op->timing, memMapReg64,
+                               indexReg32.cvt64());
+    }
+
+    // Check TCMs before walking the memory map
+    if (tcmFastPath) {
+        Xbyak::Label lblNotTCM{};
+        CompileTCMCheck(baseAddrReg32, memMapReg64, indexReg32, tcmMaskReg32, op->bus, false, addrMask, lblNotTCM);
+        if (op->dst.var.IsPresent()) {
+            compileRead(dstReg32, memMapReg64, indexReg32.cvt64());
+        }
+        m_codegen.jmp(lblEnd, Xbyak::CodeGenerator::T_NEAR);
+        m_codegen.L(lblNotTCM);
+    }
+
+    // Account for cache line fills
+    CompileCacheAccess(op->address, op->bus == ir::MemAccessBus::Code, memMapReg64, indexReg32.cvt64());
+
     // Get map pointer
-    m_codegen.mov(memMapReg64, memMapRef.GetL1MapAddress());
+    m_codegen.mov(memMapReg64, GetL1MapAddress(memMapRef));
 
     if (op->address.immediate) {
         const uint32_t address = op->address.imm.value;
@@ -716,12 +1269,11 @@ void x64Host::Compiler::CompileOp(const ir::IRMemReadOp *op) {
     // Skip slow memory handler
     m_codegen.jmp(lblEnd);
     m_codegen.L(lblSlowMem);
+    CompileCounterIncrement(&RuntimeCounters::slowMemoryAccesses, memMapReg64);
 
     // Select parameters based on size
     // Valid combinations: aligned/signed byte, aligned/unaligned/signed half, aligned/unaligned word
-    using ReadFn = uint32_t (*)(ISystem &system, uint32_t address);
-
-    ReadFn readFn;
+    SystemMemReadFn readFn;
     switch (op->size) {
     case ir::MemAccessSize::Byte:
         if (op->mode == ir::MemAccessMode::Signed) {
@@ -757,13 +1309,35 @@ void x64Host::Compiler::CompileOp(const ir::IRMemReadOp *op) {
     default: util::unreachable();
     }
 
-    auto &system = m_context.GetSystem();
+    if (m_memProtection) {
+        // Pages denied by the protection unit are absent from the permission views, which sends all such accesses
+        // here. Pages that are allowed but not mapped (e.g. MMIO) also land here, so the permission must be checked
+        // explicitly.
+        const auto access = (op->bus == ir::MemAccessBus::Code) ? arm::cp15::pu::Access::Execute
+                                                                 : arm::cp15::pu::Access::Read;
+        const uint32_t permission = PackAccessPermission(access, m_mode != arm::Mode::User);
+        if (op->address.immediate) {
+            CompileInvokeHostFunction(memMapReg64, SystemMemReadChecked, m_context, readFn, op->address.imm.value,
+                                      permission);
+        } else {
+            auto addrReg32 = m_regAlloc.Get(op->address.var.var);
+            CompileInvokeHostFunction(memMapReg64, SystemMemReadChecked, m_context, readFn, addrReg32, permission);
+        }
 
-    if (op->address.immediate) {
-        CompileInvokeHostFunction(dstReg32, readFn, system, op->address.imm.value);
+        Xbyak::Label lblAllowed{};
+        m_codegen.bt(memMapReg64, 32);
+        m_codegen.jnc(lblAllowed, Xbyak::CodeGenerator::T_NEAR);
+        CompileDataAbort(op->instrIndex, op->abortCycles);
+        m_codegen.L(lblAllowed);
+        m_codegen.mov(dstReg32, memMapReg64.cvt32());
     } else {
-        auto addrReg32 = m_regAlloc.Get(op->address.var.var);
-        CompileInvokeHostFunction(dstReg32, readFn, system, addrReg32);
+        auto &system = m_context.GetSystem();
+        if (op->address.immediate) {
+            CompileInvokeHostFunction(dstReg32, readFn, system, op->address.imm.value);
+        } else {
+            auto addrReg32 = m_regAlloc.Get(op->address.var.var);
+            CompileInvokeHostFunction(dstReg32, readFn, system, addrReg32);
+        }
     }
 
     m_codegen.L(lblEnd);
@@ -795,6 +1369,13 @@ void x64Host::Compiler::CompileOp(const ir::IRMemWriteOp *op) {
         indexReg32 = m_regAlloc.GetTemporary();
     }
 
+    // Reserve temporary register for the TCM fast path
+    const bool tcmFastPath = !op->address.immediate && IsTCMFastPathEnabled(ir::MemAccessBus::Data);
+    Xbyak::Reg32 tcmMaskReg32{};
+    if (tcmFastPath) {
+        tcmMaskReg32 = m_regAlloc.GetTemporary();
+    }
+
     using MGT = MemoryGenerationTracker;
     auto &mgt = m_compiledCode.memGenTracker;
 
@@ -802,6 +1383,11 @@ void x64Host::Compiler::CompileOp(const ir::IRMemWriteOp *op) {
     Xbyak::Label lblSplit{};
     Xbyak::Label lblDone{};
     auto genReg64 = m_regAlloc.GetTemporary().cvt64();
+
+    // Count access cycles
+    CompileMemAccessTiming(m_memMap.dataWriteTimings, op->address, op->size, op->timing, genReg64,
+                           indexReg32.cvt64());
+
     const uint8_t addrBits = 64 - CPUID::VirtualAddressBits();
     if (op->address.immediate) {
         const uint32_t address = op->address.imm.value;
@@ -913,9 +1499,39 @@ void x64Host::Compiler::CompileOp(const ir::IRMemWriteOp *op) {
     // Get memory map for the corresponding bus
     auto &memMapRef = m_memMap.dataWrite;
 
-    // Get map pointer
+    auto compileWrite = [this, op, &srcReg32](Xbyak::Reg64 ptrReg64, Xbyak::Reg64 offsetReg64) {
+        if (op->src.immediate) {
+            const uint32_t imm = op->src.imm.value;
+            switch (op->size) {
+            case ir::MemAccessSize::Byte: m_codegen.mov(byte[ptrReg64 + offsetReg64], (uint8_t)imm); break;
+            case ir::MemAccessSize::Half: m_codegen.mov(word[ptrReg64 + offsetReg64], (uint16_t)imm); break;
+            case ir::MemAccessSize::Word: m_codegen.mov(dword[ptrReg64 + offsetReg64], imm); break;
+            default: util::unreachable();
+            }
+        } else {
+            switch (op->size) {
+            case ir::MemAccessSize::Byte: m_codegen.mov(byte[ptrReg64 + offsetReg64], GetReg8(srcReg32)); break;
+            case ir::MemAccessSize::Half: m_codegen.mov(word[ptrReg64 + offsetReg64], srcReg32.cvt16()); break;
+            case ir::MemAccessSize::Word: m_codegen.mov(dword[ptrReg64 + offsetReg64], srcReg32); break;
+            default: util::unreachable();
+            }
+        }
+    };
+
     auto memMapReg64 = genReg64; // Reuse generation register
-    m_codegen.mov(memMapReg64, memMapRef.GetL1MapAddress());
+
+    // Check TCMs before walking the memory map
+    if (tcmFastPath) {
+        Xbyak::Label lblNotTCM{};
+        CompileTCMCheck(addrReg32, memMapReg64, indexReg32, tcmMaskReg32, ir::MemAccessBus::Data, true, addrMask,
+                        lblNotTCM);
+        compileWrite(memMapReg64, indexReg32.cvt64());
+        m_codegen.jmp(lblEnd, Xbyak::CodeGenerator::T_NEAR);
+        m_codegen.L(lblNotTCM);
+    }
+
+    // Get map pointer
+    m_codegen.mov(memMapReg64, GetL1MapAddress(memMapRef));
 
     if (op->address.immediate) {
         const uint32_t address = op->address.imm.value;
@@ -969,26 +1585,7 @@ void x64Host::Compiler::CompileOp(const ir::IRMemWriteOp *op) {
         // Write to selected page
         m_codegen.mov(indexReg32, addrReg32);
         m_codegen.and_(indexReg32, memMapRef.GetPageMask() & addrMask);
-        if (op->src.immediate) {
-            const uint32_t imm = op->src.imm.value;
-            switch (op->size) {
-            case ir::MemAccessSize::Byte: m_codegen.mov(byte[memMapReg64 + indexReg32.cvt64()], (uint8_t)imm); break;
-            case ir::MemAccessSize::Half: m_codegen.mov(word[memMapReg64 + indexReg32.cvt64()], (uint16_t)imm); break;
-            case ir::MemAccessSize::Word: m_codegen.mov(dword[memMapReg64 + indexReg32.cvt64()], imm); break;
-            default: util::unreachable();
-            }
-        } else {
-            switch (op->size) {
-            case ir::MemAccessSize::Byte:
-                m_codegen.mov(byte[memMapReg64 + indexReg32.cvt64()], GetReg8(srcReg32));
-                break;
-            case ir::MemAccessSize::Half:
-                m_codegen.mov(word[memMapReg64 + indexReg32.cvt64()], srcReg32.cvt16());
-                break;
-            case ir::MemAccessSize::Word: m_codegen.mov(dword[memMapReg64 + indexReg32.cvt64()], srcReg32); break;
-            default: util::unreachable();
-            }
-        }
+        compileWrite(memMapReg64, indexReg32.cvt64());
     }
 
     // Skip slow memory handler
@@ -996,55 +1593,91 @@ void x64Host::Compiler::CompileOp(const ir::IRMemWriteOp *op) {
 
     // Handle slow memory access
     m_codegen.L(lblSlowMem);
+    CompileCounterIncrement(&RuntimeCounters::slowMemoryAccesses, memMapReg64);
+
+    if (m_memProtection) {
+        // Check the permission and write in a single call; see the read path above
+        const uint32_t permission = PackAccessPermission(arm::cp15::pu::Access::Write, m_mode != arm::Mode::User);
+        auto resultReg32 = memMapReg64.cvt32();
+        auto invokeCheckedFn = [&](auto fn) {
+            if (op->address.immediate) {
+                if (op->src.immediate) {
+                    CompileInvokeHostFunction(resultReg32, fn, m_context, op->address.imm.value, op->src.imm.value,
+                                              permission);
+                } else {
+                    CompileInvokeHostFunction(resultReg32, fn, m_context, op->address.imm.value, srcReg32, permission);
+                }
+            } else {
+                if (op->src.immediate) {
+                    CompileInvokeHostFunction(resultReg32, fn, m_context, addrReg32, op->src.imm.value, permission);
+                } else {
+                    CompileInvokeHostFunction(resultReg32, fn, m_context, addrReg32, srcReg32, permission);
+                }
+            }
+        };
 
-    auto &system = m_context.GetSystem();
-
-    auto invokeFnImm8 = [&](auto fn, const ir::VarOrImmArg &address, uint8_t src) {
-        if (address.immediate) {
-            CompileInvokeHostFunction(fn, system, address.imm.value, (uint32_t)src);
-        } else {
-            CompileInvokeHostFunction(fn, system, addrReg32, (uint32_t)src);
+        switch (op->size) {
+        case ir::MemAccessSize::Byte: invokeCheckedFn(SystemMemWriteChecked<SystemMemWriteByte>); break;
+        case ir::MemAccessSize::Half: invokeCheckedFn(SystemMemWriteChecked<SystemMemWriteHalf>); break;
+        case ir::MemAccessSize::Word: invokeCheckedFn(SystemMemWriteChecked<SystemMemWriteWord>); break;
+        default: util::unreachable();
         }
-    };
 
-    auto invokeFnImm16 = [&](auto fn, const ir::VarOrImmArg &address, uint16_t src) {
-        if (address.immediate) {
-            CompileInvokeHostFunction(fn, system, address.imm.value, (uint32_t)src);
-        } else {
-            CompileInvokeHostFunction(fn, system, addrReg32, (uint32_t)src);
-        }
-    };
+        Xbyak::Label lblAllowed{};
+        m_codegen.test(resultReg32, resultReg32);
+        m_codegen.jnz(lblAllowed, Xbyak::CodeGenerator::T_NEAR);
+        CompileDataAbort(op->instrIndex, op->abortCycles);
+        m_codegen.L(lblAllowed);
+    } else {
+        auto &system = m_context.GetSystem();
 
-    auto invokeFnImm32 = [&](auto fn, const ir::VarOrImmArg &address, uint32_t src) {
-        if (address.immediate) {
-            CompileInvokeHostFunction(fn, system, address.imm.value, src);
-        } else {
-            CompileInvokeHostFunction(fn, system, addrReg32, src);
-        }
-    };
+        auto invokeFnImm8 = [&](auto fn, const ir::VarOrImmArg &address, uint8_t src) {
+            if (address.immediate) {
+                CompileInvokeHostFunction(fn, system, address.imm.value, (uint32_t)src);
+            } else {
+                CompileInvokeHostFunction(fn, system, addrReg32, (uint32_t)src);
+            }
+        };
 
-    auto invokeFnReg32 = [&](auto fn, const ir::VarOrImmArg &address, ir::Variable src) {
-        if (address.immediate) {
-            CompileInvokeHostFunction(fn, system, address.imm.value, srcReg32);
-        } else {
-            CompileInvokeHostFunction(fn, system, addrReg32, srcReg32);
-        }
-    };
+        auto invokeFnImm16 = [&](auto fn, const ir::VarOrImmArg &address, uint16_t src) {
+            if (address.immediate) {
+                CompileInvokeHostFunction(fn, system, address.imm.value, (uint32_t)src);
+            } else {
+                CompileInvokeHostFunction(fn, system, addrReg32, (uint32_t)src);
+            }
+        };
 
-    auto invokeFn = [&](auto valueFn, auto fn) {
-        if (op->src.immediate) {
-            valueFn(fn, op->address, op->src.imm.value);
-        } else {
-            invokeFnReg32(fn, op->address, op->src.var.var);
-        }
-    };
+        auto invokeFnImm32 = [&](auto fn, const ir::VarOrImmArg &address, uint32_t src) {
+            if (address.immediate) {
+                CompileInvokeHostFunction(fn, system, address.imm.value, src);
+            } else {
+                CompileInvokeHostFunction(fn, system, addrReg32, src);
+            }
+        };
 
-    // Invoke appropriate write function
-    switch (op->size) {
-    case ir::MemAccessSize::Byte: invokeFn(invokeFnImm8, SystemMemWriteByte); break;
-    case ir::MemAccessSize::Half: invokeFn(invokeFnImm16, SystemMemWriteHalf); break;
-    case ir::MemAccessSize::Word: invokeFn(invokeFnImm32, SystemMemWriteWord); break;
-    default: util::unreachable();
+        auto invokeFnReg32 = [&](auto fn, const ir::VarOrImmArg &address, ir::Variable src) {
+            if (address.immediate) {
+                CompileInvokeHostFunction(fn, system, address.imm.value, srcReg32);
+            } else {
+                CompileInvokeHostFunction(fn, system, addrReg32, srcReg32);
+            }
+        };
+
+        auto invokeFn = [&](auto valueFn, auto fn) {
+            if (op->src.immediate) {
+                valueFn(fn, op->address, op->src.imm.value);
+            } else {
+                invokeFnReg32(fn, op->address, op->src.var.var);
+            }
+        };
+
+        // Invoke appropriate write function
+        switch (op->size) {
+        case ir::MemAccessSize::Byte: invokeFn(invokeFnImm8, SystemMemWriteByte); break;
+        case ir::MemAccessSize::Half: invokeFn(invokeFnImm16, SystemMemWriteHalf); break;
+        case ir::MemAccessSize::Word: invokeFn(invokeFnImm32, SystemMemWriteWord); break;
+        default: util::unreachable();
+        }
     }
 
     m_codegen.L(lblEnd);
@@ -2902,6 +3535,34 @@ void x64Host::Compiler::CompileOp(const ir::IRBranchExchangeOp *op) {
     m_codegen.L(lblEnd);
 }
 
+void x64Host::Compiler::CompileOp(const ir::IRCheckpointOp *op) {
+    Xbyak::Label lblContinue{};
+
+    // Continue if the deadline is not reached after counting the cycles taken so far.
+    // The comparison is signed since cycles added by the loop idiom or the cache timing model may have already pushed
+    // the cycle count past the deadline.
+    if (m_armState.deadlinePtr != nullptr) {
+        const auto deadlinePtrOffset = m_stateOffsets.CycleDeadlinePointerOffset();
+        auto tmpReg64 = m_regAlloc.GetTemporary().cvt64();
+        m_codegen.mov(tmpReg64, qword[abi::kARMStateReg + deadlinePtrOffset]);
+        m_codegen.mov(tmpReg64, qword[tmpReg64]);
+        m_codegen.sub(tmpReg64, abi::kCycleCountReg);
+        m_codegen.cmp(tmpReg64, op->cycles);
+    } else {
+        m_codegen.cmp(abi::kCycleCountReg, op->cycles);
+    }
+    m_codegen.jg(lblContinue);
+
+    // Count cycles up to this point, update PC and leave the block.
+    // CPSR is up to date since no flag copies are deferred past checkpoints.
+    CountCycles(op->cycles);
+    const auto pcRegOffset = m_stateOffsets.GPROffset(arm::GPR::PC, m_mode);
+    m_codegen.mov(dword[abi::kARMStateReg + pcRegOffset], op->pc);
+    m_codegen.jmp(m_compiledCode.epilog);
+
+    m_codegen.L(lblContinue);
+}
+
 void x64Host::Compiler::CompileOp(const ir::IRLoadCopRegisterOp *op) {
     if (!op->dstValue.var.IsPresent()) {
         return;
@@ -3203,6 +3864,247 @@ void x64Host::Compiler::AssignLongImmResultWithNZ(const ir::VariableArg &dstLo,
 
 // ---------------------------------------------------------------------------------------------------------------------
 
+bool x64Host::Compiler::IsTCMFastPathEnabled(ir::MemAccessBus bus) const {
+    // TCM accesses are also subject to protection unit checks, which are enforced by the memory map views
+    if (!m_compiledCode.inlineTCMAccesses || m_memProtection) {
+        return false;
+    }
+    auto &cp15 = m_armState.GetSystemControlCoprocessor();
+    if (!cp15.IsPresent()) {
+        return false;
+    }
+    auto &tcm = cp15.GetTCM();
+    return tcm.itcm != nullptr || (tcm.dtcm != nullptr && bus == ir::MemAccessBus::Data);
+}
+
+void x64Host::Compiler::CompileTCMCheck(Xbyak::Reg32 addrReg32, Xbyak::Reg64 baseReg64, Xbyak::Reg32 offsetReg32,
+                                        Xbyak::Reg32 maskReg32, ir::MemAccessBus bus, bool write, uint32_t addrMask,
+                                        Xbyak::Label &lblMiss) {
+    // The TCM parameters are read at runtime since they can be reconfigured through CP15 at any point.
+    // TCM sizes are powers of two and the regions are mirrored across the enabled range.
+    using TCM = arm::cp15::TCM;
+    auto &tcm = m_armState.GetSystemControlCoprocessor().GetTCM();
+    const bool checkITCM = tcm.itcm != nullptr;
+    const bool checkDTCM = tcm.dtcm != nullptr && bus == ir::MemAccessBus::Data; // DTCM is not on the code bus
+
+    Xbyak::Label lblHit{};
+    Xbyak::Label lblCheckDTCM{};
+
+    m_codegen.mov(baseReg64, CastUintPtr(&tcm));
+
+    const size_t itcmSizeOffset = write ? offsetof(TCM, itcmWriteSize) : offsetof(TCM, itcmReadSize);
+    const size_t dtcmSizeOffset = write ? offsetof(TCM, dtcmWriteSize) : offsetof(TCM, dtcmReadSize);
+
+    // ITCM is always mapped from address 0
+    if (checkITCM) {
+        m_codegen.cmp(addrReg32, dword[baseReg64 + itcmSizeOffset]);
+        m_codegen.jae(checkDTCM ? lblCheckDTCM : lblMiss, Xbyak::CodeGenerator::T_NEAR);
+
+        m_codegen.mov(offsetReg32, dword[baseReg64 + offsetof(TCM, itcmSize)]);
+        m_codegen.dec(offsetReg32);
+        m_codegen.and_(offsetReg32, addrMask);
+        m_codegen.and_(offsetReg32, addrReg32);
+        m_codegen.mov(baseReg64, qword[baseReg64 + offsetof(TCM, itcm)]);
+        if (checkDTCM) {
+            m_codegen.jmp(lblHit, Xbyak::CodeGenerator::T_NEAR);
+        }
+    }
+
+    // DTCM is mapped at dtcmBase
+    if (checkDTCM) {
+        m_codegen.L(lblCheckDTCM);
+        m_codegen.mov(offsetReg32, addrReg32);
+        m_codegen.sub(offsetReg32, dword[baseReg64 + offsetof(TCM, dtcmBase)]);
+        m_codegen.cmp(offsetReg32, dword[baseReg64 + dtcmSizeOffset]);
+        m_codegen.jae(lblMiss, Xbyak::CodeGenerator::T_NEAR);
+
+        m_codegen.mov(maskReg32, dword[baseReg64 + offsetof(TCM, dtcmSize)]);
+        m_codegen.dec(maskReg32);
+        m_codegen.and_(maskReg32, addrMask);
+        m_codegen.and_(offsetReg32, maskReg32);
+        m_codegen.mov(baseReg64, qword[baseReg64 + offsetof(TCM, dtcm)]);
+    }
+
+    m_codegen.L(lblHit);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+uintptr_t x64Host::Compiler::GetL1MapAddress(const MemoryMapPrivateAccess::Map &map) const {
+    if (!m_memProtection) {
+        return map.GetL1MapAddress();
+    }
+    const bool privileged = m_mode != arm::Mode::User;
+    return map.GetViewL1MapAddress(privileged ? MemoryMapPrivateAccess::kPrivilegedView
+                                              : MemoryMapPrivateAccess::kUserView);
+}
+
+void x64Host::Compiler::CompileCounterIncrement(uint64_t RuntimeCounters::*counter, Xbyak::Reg64 tmpReg64) {
+    auto *counters = m_compiledCode.runtimeCounters;
+    if (counters == nullptr) {
+        return;
+    }
+
+    m_codegen.mov(tmpReg64, CastUintPtr(&(counters->*counter)));
+    m_codegen.inc(qword[tmpReg64]);
+}
+
+void x64Host::Compiler::CompileDataAbort(uint32_t instrIndex, uint64_t cycles) {
+    // Enter the data abort vector and leave the block
+    const uint32_t instrSize = m_thumb ? sizeof(uint16_t) : sizeof(uint32_t);
+    CompileInvokeHostFunction(SystemEnterDataAbort, m_armState, m_baseAddress + instrIndex * instrSize);
+
+    // Count the cycles of the block up to the aborted access and the pipeline refill at the vector
+    CountCycles(cycles);
+    CompileExit();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+const arm::cp15::CacheTagArray *x64Host::Compiler::GetCacheTags(bool code) const {
+    if (!m_compiledCode.cacheTimingModel) {
+        return nullptr;
+    }
+    auto &cp15 = m_armState.GetSystemControlCoprocessor();
+    if (!cp15.IsPresent()) {
+        return nullptr;
+    }
+    auto &cache = cp15.GetCache();
+    auto &tags = (code && cache.params.separateCodeDataCaches) ? cache.codeTags : cache.dataTags;
+    return tags.IsPresent() ? &tags : nullptr;
+}
+
+void x64Host::Compiler::CompileCacheAccess(const ir::VarOrImmArg &address, bool code, Xbyak::Reg64 tmpReg64,
+                                           Xbyak::Reg64 addrTmpReg64) {
+    auto *tags = GetCacheTags(code);
+    if (tags == nullptr) {
+        return;
+    }
+
+    // The tag arrays and cacheability maps are only reallocated when the cache is reconfigured, which also invalidates
+    // all compiled code
+    auto &cache = m_armState.GetSystemControlCoprocessor().GetCache();
+    auto &cacheablePages = code ? cache.codeCacheablePages : cache.dataCacheablePages;
+    const uint32_t setShift = std::countr_zero(tags->numWays * sizeof(uint32_t));
+    Xbyak::Label lblHit{};
+
+    // Skip the model entirely for pages that are never cached, such as when the cache is disabled or on TCM and MMIO
+    // regions. Their bits only change at runtime, so they must be checked on every access.
+    if (address.immediate) {
+        const uint32_t page = address.imm.value >> arm::cp15::Cache::kCacheablePageShift;
+        m_codegen.mov(tmpReg64, CastUintPtr(&cacheablePages[page >> 5]));
+        m_codegen.test(dword[tmpReg64], 1u << (page & 31));
+        m_codegen.jz(lblHit, Xbyak::CodeGenerator::T_NEAR);
+    } else {
+        auto addrReg32 = m_regAlloc.Get(address.var.var);
+        auto pageReg32 = addrTmpReg64.cvt32();
+        auto bitsReg32 = tmpReg64.cvt32();
+
+        // bitsReg32 = cacheablePages[page / 32]
+        m_codegen.mov(pageReg32, addrReg32);
+        m_codegen.shr(pageReg32, arm::cp15::Cache::kCacheablePageShift + 5);
+        m_codegen.mov(tmpReg64, CastUintPtr(cacheablePages.data()));
+        m_codegen.mov(bitsReg32, dword[tmpReg64 + addrTmpReg64 * sizeof(uint32_t)]);
+
+        // Test bit (page % 32); bt masks the bit offset of register operands
+        m_codegen.mov(pageReg32, addrReg32);
+        m_codegen.shr(pageReg32, arm::cp15::Cache::kCacheablePageShift);
+        m_codegen.bt(bitsReg32, pageReg32);
+        m_codegen.jnc(lblHit, Xbyak::CodeGenerator::T_NEAR);
+    }
+
+    if (address.immediate) {
+        const uint32_t line = address.imm.value >> tags->lineShift;
+        const uint32_t set = line & tags->setMask;
+        m_codegen.mov(tmpReg64, CastUintPtr(&tags->tags[set * tags->numWays]));
+        for (uint32_t way = 0; way < tags->numWays; way++) {
+            m_codegen.cmp(dword[tmpReg64 + way * sizeof(uint32_t)], line);
+            m_codegen.je(lblHit, Xbyak::CodeGenerator::T_NEAR);
+        }
+    } else {
+        auto addrReg32 = m_regAlloc.Get(address.var.var);
+        auto lineReg32 = addrTmpReg64.cvt32();
+
+        // tmpReg64 = &tags[set * numWays]
+        m_codegen.mov(lineReg32, addrReg32);
+        m_codegen.shr(lineReg32, tags->lineShift);
+        m_codegen.and_(lineReg32, tags->setMask);
+        m_codegen.shl(lineReg32, setShift);
+        m_codegen.mov(tmpReg64, CastUintPtr(tags->tags.data()));
+        m_codegen.add(tmpReg64, addrTmpReg64);
+
+        // Compare line number against all ways
+        m_codegen.mov(lineReg32, addrReg32);
+        m_codegen.shr(lineReg32, tags->lineShift);
+        for (uint32_t way = 0; way < tags->numWays; way++) {
+            m_codegen.cmp(dword[tmpReg64 + way * sizeof(uint32_t)], lineReg32);
+            m_codegen.je(lblHit, Xbyak::CodeGenerator::T_NEAR);
+        }
+    }
+
+    // Tag miss; let the model decide if the access is cacheable within the page and fill the line
+    auto &cp15 = m_armState.GetSystemControlCoprocessor();
+    auto resultReg32 = tmpReg64.cvt32();
+    auto missFn = code ? SystemCodeCacheMiss : SystemDataCacheMiss;
+    if (address.immediate) {
+        CompileInvokeHostFunction(resultReg32, missFn, cp15, address.imm.value);
+    } else {
+        CompileInvokeHostFunction(resultReg32, missFn, cp15, m_regAlloc.Get(address.var.var));
+    }
+    m_codegen.test(resultReg32, resultReg32);
+    m_codegen.jz(lblHit);
+    CountCycles(m_compiledCode.cacheLineFillCycles);
+
+    m_codegen.L(lblHit);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+void x64Host::Compiler::CompileMemAccessTiming(const MemoryMapPrivateAccess::TimingTable &table,
+                                               const ir::VarOrImmArg &address, ir::MemAccessSize size,
+                                               const ir::MemAccessTiming &timing, Xbyak::Reg64 tmpReg64,
+                                               Xbyak::Reg64 addrTmpReg64) {
+    if (!timing.timed) {
+        return;
+    }
+
+    if (address.immediate) {
+        const uint8_t cycles = MemoryMapPrivateAccess::GetAccessCycles(table, address.imm.value, size, timing.type);
+        if (cycles > timing.parallelCycles) {
+            CountCycles(cycles - timing.parallelCycles);
+        }
+        return;
+    }
+
+    const size_t fieldOffset = ((timing.type == ir::MemAccessType::Sequential)
+                                    ? offsetof(MemoryAccessTimings, sequential)
+                                    : offsetof(MemoryAccessTimings, nonsequential)) +
+                               static_cast<size_t>(size);
+
+    // tmpReg64 = table[address >> kTimingBlockShift].<type>[size]
+    auto addrReg32 = m_regAlloc.Get(address.var.var);
+    auto cyclesReg32 = tmpReg64.cvt32();
+    m_codegen.mov(addrTmpReg64.cvt32(), addrReg32);
+    m_codegen.shr(addrTmpReg64.cvt32(), MemoryMap::kTimingBlockShift);
+    m_codegen.mov(tmpReg64, CastUintPtr(table.data()));
+    m_codegen.movzx(cyclesReg32, byte[tmpReg64 + addrTmpReg64 * sizeof(MemoryAccessTimings) + fieldOffset]);
+
+    // Only count cycles exceeding those of a parallel code fetch
+    Xbyak::Label lblDone{};
+    if (timing.parallelCycles > 0) {
+        m_codegen.sub(cyclesReg32, timing.parallelCycles);
+        m_codegen.jbe(lblDone);
+    }
+    if (m_armState.deadlinePtr != nullptr) {
+        m_codegen.add(abi::kCycleCountReg, tmpReg64);
+    } else {
+        m_codegen.sub(abi::kCycleCountReg, tmpReg64);
+    }
+    m_codegen.L(lblDone);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
 template <typename T>
 constexpr bool is_raw_integral_v = std::is_integral_v<std::remove_cvref_t<T>>;
 
@@ -3,6 +3,7 @@
 #include "x86_64_host.hpp"
 
 #include "core/memory_map_priv_access.hpp"
+#include "ir/flags_materialization.hpp"
 
 #include "util/unreachable.hpp"
 
@@ -13,6 +14,7 @@
 #endif
 #include <xbyak/xbyak.h>
 
+#include <array>
 #include <memory_resource>
 
 namespace armajitto::x86_64 {
@@ -25,8 +27,18 @@ public:
     void PreProcessOp(const ir::IROp *op);
     void PostProcessOp(const ir::IROp *op);
 
-    void CompileGenerationCheck(const LocationRef &baseLoc, const uint32_t instrCount);
-    void CompileIRQLineCheck();
+    // Checks the memory generation of the block's code, plus <precedingInstrCount> instructions before the block.
+    void CompileGenerationCheck(const LocationRef &baseLoc, const uint32_t instrCount,
+                                const uint32_t precedingInstrCount = 0);
+    void CompileInvalidationQueueCheck();
+    void CompileExecutionCounter(const ir::BasicBlock &block);
+    void CompileInterruptLinesCheck();
+    void CompileCodeCacheAccesses(const ir::BasicBlock &block);
+
+    // Runs all but the last iterations of the copy or fill loop implemented by the block, if any, with host memory
+    // operations. The block itself executes the remaining iterations.
+    void CompileLoopIdiom(const ir::BasicBlock &block);
+
     void CompileCondCheck(arm::Condition cond, Xbyak::Label &lblCondFail);
     void CompileTerminal(const ir::BasicBlock &block);
     void CompileDirectLinkToSuccessor(const ir::BasicBlock &block);
@@ -36,8 +48,43 @@ public:
 
     void CountCycles(uint64_t cycles);
 
+    // Lazy flags materialization
+    // The trailing CPSR flags store of the block is deferred to its direct link when DeferredFlags() is not None.
+    // Exits taken after the block's instructions must then copy the host flags into CPSR through flagsSyncEpilog.
+    bool IsDeferredFlagsOp(const ir::IROp *op) const {
+        return m_flagsAnalyzer.IsDeferred(op);
+    }
+
+    arm::Flags DeferredFlags() const {
+        return m_flagsAnalyzer.DeferredFlags();
+    }
+
+    arm::Flags ResyncedFlags() const {
+        return m_flagsAnalyzer.ResyncedFlags();
+    }
+
+    // Self-loops
+    // Blocks that branch directly to themselves jump back to a loop header within the block instead of going through
+    // the block entry. The header follows the generation check, so the back-edge compares the memory generation of the
+    // block's code on its own and goes through the block entry if it changed.
+    // Up to kMaxLoopRegs guest registers that are both read and written by the block stay in host registers across
+    // the back-edge. They are loaded before the loop header and written through to the ARM state on every write, so
+    // the ARM state remains up to date on every exit.
+
+    // Loads the loop registers and marks the current position as the loop header of self-loops.
+    void CompileLoopHeader();
+
 private:
-    void CompileDirectLink(LocationRef target, uint64_t blockLocKey);
+    void CompileDirectLink(LocationRef target, uint64_t blockLocKey, arm::Flags flagsSync = arm::Flags::None,
+                           bool toLoopHeader = true);
+
+    // Compares the memory generation of the range from baseAddress to finalAddress (inclusive) against the current
+    // generation and jumps to lblInvalidate if it differs. Uses three temporary registers.
+    void CompileGenerationCompare(const uint32_t baseAddress, const uint32_t finalAddress, Xbyak::Label &lblInvalidate);
+
+    // Retrieves the host register holding the guest register at the given ARM state offset across the loop back-edge,
+    // or an empty register if there is none.
+    Xbyak::Reg32 GetLoopRegister(uint32_t offset) const;
 
 public:
     // Catch-all method for unimplemented ops, required by the visitor
@@ -80,6 +127,7 @@ public:
     void CompileOp(const ir::IRLoadStickyOverflowOp *op);
     void CompileOp(const ir::IRBranchOp *op);
     void CompileOp(const ir::IRBranchExchangeOp *op);
+    void CompileOp(const ir::IRCheckpointOp *op);
     void CompileOp(const ir::IRLoadCopRegisterOp *op);
     void CompileOp(const ir::IRStoreCopRegisterOp *op);
     void CompileOp(const ir::IRConstantOp *op);
@@ -120,6 +168,56 @@ public:
     void AssignLongImmResultWithNZ(const ir::VariableArg &dstLo, const ir::VariableArg &dstHi, uint64_t result,
                                    arm::Flags flagsMask);
 
+    // -------------------------------------------------------------------------
+    // TCM fast path
+
+    // Determines if memory accesses on the given bus should check the TCMs inline.
+    bool IsTCMFastPathEnabled(ir::MemAccessBus bus) const;
+
+    // Compiles an inline range check of addrReg32 against the ITCM and DTCM.
+    // On a hit, falls through with the TCM base pointer in baseReg64 and the aligned offset into it in offsetReg32.
+    // On a miss, jumps to lblMiss.
+    void CompileTCMCheck(Xbyak::Reg32 addrReg32, Xbyak::Reg64 baseReg64, Xbyak::Reg32 offsetReg32,
+                         Xbyak::Reg32 maskReg32, ir::MemAccessBus bus, bool write, uint32_t addrMask,
+                         Xbyak::Label &lblMiss);
+
+    // -------------------------------------------------------------------------
+    // Memory protection
+
+    // Retrieves the level 1 table of the memory map to be used by the fast memory access path.
+    // While the protection unit is enabled, this is the permission view for the privilege level of the block.
+    uintptr_t GetL1MapAddress(const MemoryMapPrivateAccess::Map &map) const;
+
+    // Increments the runtime counter if instrumentation is enabled. Clobbers tmpReg64 and the x86 flags.
+    void CompileCounterIncrement(uint64_t RuntimeCounters::*counter, Xbyak::Reg64 tmpReg64);
+
+    // Compiles the exit taken by slow memory accesses denied by the protection unit, which raises a data abort on the
+    // instruction that issued the access and counts the given cycles.
+    void CompileDataAbort(uint32_t instrIndex, uint64_t cycles);
+
+    // -------------------------------------------------------------------------
+    // Cache timing model
+
+    // Retrieves the tag array to be checked by instruction fetches or data accesses.
+    // Returns nullptr if the cache timing model is disabled or the cache is absent.
+    const arm::cp15::CacheTagArray *GetCacheTags(bool code) const;
+
+    // Compiles an inline tag lookup for the given address, with a call into the cache model on misses to fill the line
+    // and count the line fill cycles. Accesses to pages that are never cached skip the lookup.
+    // tmpReg64 is always used; addrTmpReg64 is only used for variable addresses.
+    void CompileCacheAccess(const ir::VarOrImmArg &address, bool code, Xbyak::Reg64 tmpReg64,
+                            Xbyak::Reg64 addrTmpReg64);
+
+    // -------------------------------------------------------------------------
+    // Memory access timing
+
+    // Compiles cycle counting for a data access timed with the memory map timing tables.
+    // Constant addresses are looked up at compile time; variable addresses look up the table at runtime using
+    // tmpReg64 and addrTmpReg64.
+    void CompileMemAccessTiming(const MemoryMapPrivateAccess::TimingTable &table, const ir::VarOrImmArg &address,
+                                ir::MemAccessSize size, const ir::MemAccessTiming &timing, Xbyak::Reg64 tmpReg64,
+                                Xbyak::Reg64 addrTmpReg64);
+
     // -------------------------------------------------------------------------
     // Host function calls
 
@@ -149,6 +247,24 @@ private:
     MemoryMapPrivateAccess m_memMap;
     arm::Mode m_mode;
     bool m_thumb;
+    uint32_t m_baseAddress;  // Address of the first instruction in the block
+    bool m_memProtection;    // Whether the protection unit was enabled when the block was compiled
+
+    uint32_t m_codeSize;     // Size of the block's code in bytes
+
+    bool m_selfLoop;                   // Whether the block branches directly to itself
+    HostCode m_loopHeader = nullptr;   // Target of the self-loop back-edge
+
+    // Guest registers kept in host registers across the self-loop back-edge
+    struct LoopRegister {
+        uint32_t offset; // ARM state offset of the guest register
+        Xbyak::Reg32 reg;
+    };
+    static constexpr size_t kMaxLoopRegs = 2;
+    std::array<LoopRegister, kMaxLoopRegs> m_loopRegs;
+    size_t m_loopRegCount = 0;
+
+    ir::FlagsMaterializationAnalyzer m_flagsAnalyzer;
 };
 
 // ---------------------------------------------------------------------------------------------------------------------
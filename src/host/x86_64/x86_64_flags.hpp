@@ -15,20 +15,25 @@ constexpr uint32_t ARMTox64FlagsMult = 0x1081;
 constexpr uint32_t x64ToARMFlagsMult = 0x1021'0000;
 
 constexpr uint32_t ARMflgIPos = 7u;
+constexpr uint32_t ARMflgFPos = 6u;
 constexpr uint32_t ARMflgTPos = 5u;
 constexpr uint32_t ARMflgQPos = 27u;
 constexpr uint32_t ARMflgNZCVShift = 28u;
 
 constexpr uint32_t ARMflgI = (1u << ARMflgIPos);
+constexpr uint32_t ARMflgF = (1u << ARMflgFPos);
 constexpr uint32_t ARMflgT = (1u << ARMflgTPos);
 
+// I and F are 8 bits apart to match the layout of the IRQ and FIQ line bytes in arm::State
 constexpr uint32_t x64flgIPos = 16u;
+constexpr uint32_t x64flgFPos = 24u;
 constexpr uint32_t x64flgNPos = 15u;
 constexpr uint32_t x64flgZPos = 14u;
 constexpr uint32_t x64flgCPos = 8u;
 constexpr uint32_t x64flgVPos = 0u;
 
 constexpr uint32_t x64flgI = (1u << x64flgIPos);
+constexpr uint32_t x64flgF = (1u << x64flgFPos);
 constexpr uint32_t x64flgN = (1u << x64flgNPos);
 constexpr uint32_t x64flgZ = (1u << x64flgZPos);
 constexpr uint32_t x64flgC = (1u << x64flgCPos);
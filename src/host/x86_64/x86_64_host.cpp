@@ -2,12 +2,16 @@
 
 #include "armajitto/guest/arm/exceptions.hpp"
 
+#include "guest/arm/exception_vectors.hpp"
+
 #include "ir/ops/ir_ops_visitor.hpp"
 
+#include "util/huge_pages.hpp"
 #include "util/pointer_cast.hpp"
 
 #include "abi.hpp"
 #include "cpuid.hpp"
+#include "perf_map.hpp"
 #include "vtune.hpp"
 #include "x86_64_compiler.hpp"
 #include "x86_64_flags.hpp"
@@ -27,9 +31,12 @@ x64Host::x64Host(Context &context, Options::Compiler &options, const uint64_t *c
                  std::pmr::memory_resource &alloc)
     : Host(context, options)
     , m_commonData(std::make_unique<CommonData>(context.GetARMState()))
-    , m_codeBuffer(new uint8_t[options.initialCodeBufferSize])
-    , m_codeBufferSize(options.initialCodeBufferSize)
-    , m_codegen(options.initialCodeBufferSize, m_codeBuffer.get())
+    , m_hugePages(options.hugePages)
+    , m_codeBufferSize(util::RoundUpToPageGranularity(options.initialCodeBufferSize, m_hugePages))
+    , m_codeBuffer(static_cast<uint8_t *>(util::AllocatePagesOrThrow(m_codeBufferSize, m_hugePages)))
+    , m_codegen(m_codeBufferSize, m_codeBuffer)
+    , m_compiledCode(m_hugePages)
+    , m_perfReporter(options.perfMap, options.perfJitDump)
     , m_alloc(alloc) {
 
     context.GetARMState().deadlinePtr = cycleCountDeadline;
@@ -41,14 +48,29 @@ x64Host::x64Host(Context &context, Options::Compiler &options, const uint64_t *c
         },
         this);
 
+    SetReportMemoryWriteCallback(
+        [](uint32_t start, uint32_t end, void *ctx) {
+            auto &host = *reinterpret_cast<x64Host *>(ctx);
+            host.ReportMemoryWrite(start, end);
+        },
+        this);
+
     m_codegen.setProtectMode(Xbyak::CodeGenerator::PROTECT_RWE);
 
     m_compiledCode.enableBlockLinking = options.enableBlockLinking;
+    m_compiledCode.inlineTCMAccesses = options.inlineTCMAccesses;
+    m_compiledCode.lazyFlags = options.enableBlockLinking && options.lazyFlagsMaterialization;
+    m_compiledCode.cacheTimingModel = options.cacheTimingModel;
+    m_compiledCode.cacheLineFillCycles = options.cacheLineFillCycles;
+    m_compiledCode.runtimeCounters = options.instrumentation ? &m_runtimeCounters : nullptr;
+    m_compiledCode.pendingInvalidations =
+        options.pollInvalidationQueue ? m_invalidationQueue.PendingFlag() : nullptr;
     CompileCommon();
 }
 
 x64Host::~x64Host() {
     m_codegen.setProtectModeRW();
+    util::FreePages(m_codeBuffer, m_codeBufferSize, m_hugePages);
 }
 
 HostCode x64Host::Compile(ir::BasicBlock &block) {
@@ -65,9 +87,19 @@ HostCode x64Host::Compile(ir::BasicBlock &block) {
                 if (m_codeBufferSize > m_options.maximumCodeBufferSize) {
                     m_codeBufferSize = m_options.maximumCodeBufferSize;
                 }
+                m_codeBufferSize = util::RoundUpToPageGranularity(m_codeBufferSize, m_hugePages);
                 if (prevCodeBufferSize != m_codeBufferSize) {
-                    m_codeBuffer.reset(new uint8_t[m_codeBufferSize]);
-                    m_codegen.setCodeBuffer(m_codeBuffer.get(), m_codeBufferSize);
+                    // Keep the current buffer if the larger one cannot be allocated
+                    auto *codeBuffer = static_cast<uint8_t *>(util::AllocatePages(m_codeBufferSize, m_hugePages));
+                    if (codeBuffer == nullptr) {
+                        m_codeBufferSize = prevCodeBufferSize;
+                        Clear();
+                        throw std::bad_alloc();
+                    }
+                    m_codegen.setProtectModeRW();
+                    util::FreePages(m_codeBuffer, prevCodeBufferSize, m_hugePages);
+                    m_codeBuffer = codeBuffer;
+                    m_codegen.setCodeBuffer(m_codeBuffer, m_codeBufferSize);
                     m_codegen.setProtectMode(Xbyak::CodeGenerator::PROTECT_RWE);
                 }
                 Clear();
@@ -86,6 +118,13 @@ void x64Host::Clear() {
     m_compiledCode.Clear();
     m_codegen.reset();
     m_compiledCode.enableBlockLinking = m_options.enableBlockLinking;
+    m_compiledCode.inlineTCMAccesses = m_options.inlineTCMAccesses;
+    m_compiledCode.lazyFlags = m_options.enableBlockLinking && m_options.lazyFlagsMaterialization;
+    m_compiledCode.cacheTimingModel = m_options.cacheTimingModel;
+    m_compiledCode.cacheLineFillCycles = m_options.cacheLineFillCycles;
+    m_compiledCode.runtimeCounters = m_options.instrumentation ? &m_runtimeCounters : nullptr;
+    m_compiledCode.pendingInvalidations =
+        m_options.pollInvalidationQueue ? m_invalidationQueue.PendingFlag() : nullptr;
 
     CompileCommon();
 }
@@ -104,12 +143,15 @@ void x64Host::Invalidate(LocationRef loc) {
 
     // Remove the block from the cache
     *block = nullptr;
+    m_compiledCode.RetireLoopIdiom(key);
 }
 
 void x64Host::InvalidateCodeCache() {
     m_compiledCode.blockCache.Clear();
     m_compiledCode.pendingPatches.clear();
     m_compiledCode.appliedPatches.clear();
+    m_compiledCode.resyncedFlags.clear();
+    m_compiledCode.retireAllLoopIdioms = true;
 }
 
 void x64Host::InvalidateCodeCacheRange(uint32_t start, uint32_t end) {
@@ -136,6 +178,7 @@ void x64Host::InvalidateCodeCacheRange(uint32_t start, uint32_t end) {
 
             // Remove the block from the cache
             *block = nullptr;
+            m_compiledCode.RetireLoopIdiom(key);
         }
     }
 }
@@ -147,8 +190,8 @@ void x64Host::ReportMemoryWrite(uint32_t start, uint32_t end) {
 
 void x64Host::CompileCommon() {
     CompileEpilog();
-    CompileIRQEntry();
-    CompileProlog(); // Depends on Epilog and IRQEntry being compiled
+    CompileInterruptEntries();
+    CompileProlog(); // Depends on Epilog and InterruptEntries being compiled
 }
 
 void x64Host::CompileProlog() {
@@ -171,14 +214,19 @@ void x64Host::CompileProlog() {
     m_codegen.mov(abi::kARMStateReg, CastUintPtr(&armState)); // rbx = ARM state pointer
     m_codegen.mov(abi::kCycleCountReg, abi::kIntArgRegs[1]);  // r10 = remaining/initial cycle count
 
-    // Copy CPSR NZCV and I flags to EAX
+    // Copy CPSR NZCV, I and F flags to EAX
     auto flagsReg32 = abi::kHostFlagsReg;
-    auto iFlagReg32 = r15d;
+    auto ifFlagsReg32 = r15d;
+    auto fFlagReg32 = r14d;
     m_codegen.mov(flagsReg32, dword[CastUintPtr(&armState.CPSR())]);
-    m_codegen.mov(iFlagReg32, flagsReg32);
-    m_codegen.and_(iFlagReg32, (1 << ARMflgIPos));      // Keep I flag
-    m_codegen.shl(iFlagReg32, x64flgIPos - ARMflgIPos); // Shift I flag to correct place
-    m_codegen.shr(flagsReg32, ARMflgNZCVShift);         // Shift NZCV bits to [3..0]
+    m_codegen.mov(ifFlagsReg32, flagsReg32);
+    m_codegen.and_(ifFlagsReg32, ARMflgI);                // Keep I flag
+    m_codegen.shl(ifFlagsReg32, x64flgIPos - ARMflgIPos); // Shift I flag to correct place
+    m_codegen.mov(fFlagReg32, flagsReg32);
+    m_codegen.and_(fFlagReg32, ARMflgF);                  // Keep F flag
+    m_codegen.shl(fFlagReg32, x64flgFPos - ARMflgFPos);   // Shift F flag to correct place
+    m_codegen.or_(ifFlagsReg32, fFlagReg32);
+    m_codegen.shr(flagsReg32, ARMflgNZCVShift); // Shift NZCV bits to [3..0]
     if (CPUID::HasFastPDEPAndPEXT()) {
         // AH       AL
         // SZ0A0P1C -------V
@@ -190,7 +238,7 @@ void x64Host::CompileProlog() {
         m_codegen.imul(flagsReg32, flagsReg32, ARMTox64FlagsMult); // -------- -------- NZCV-NZC V---NZCV
         m_codegen.and_(flagsReg32, x64FlagsMask);                  // -------- -------- NZ-----C -------V
     }
-    m_codegen.or_(flagsReg32, iFlagReg32); // -------- -------I NZ-----C -------V
+    m_codegen.or_(flagsReg32, ifFlagsReg32); // -------F -------I NZ-----C -------V
 
     // -----------------------------------------------------------------------------------------------------------------
     // Execution state check
@@ -205,21 +253,27 @@ void x64Host::CompileProlog() {
 
         // At this point, the CPU is halted
         {
-            // Check if IRQ line is asserted
+            // Check if the IRQ or FIQ lines are asserted
             const auto irqLineOffset = m_stateOffsets.IRQLineOffset();
-            m_codegen.test(byte[abi::kARMStateReg + irqLineOffset], 1);
+            auto linesReg32 = r15d;
+            m_codegen.movzx(linesReg32, word[abi::kARMStateReg + irqLineOffset]);
+            m_codegen.test(linesReg32, linesReg32);
 
             // Exit if not asserted
             m_codegen.jz(m_compiledCode.epilog);
 
-            // IRQ line is asserted
+            // An interrupt line is asserted
             {
                 // Change execution state to Running
                 m_codegen.mov(byte[abi::kARMStateReg + execStateOfs], static_cast<uint8_t>(arm::ExecState::Running));
 
-                // Jump to IRQ vector if not suppressed by CPSR I bit
-                m_codegen.test(abi::kHostFlagsReg, x64flgI);
-                m_codegen.jz(m_compiledCode.irqEntry);
+                // Jump to the interrupt vectors if not suppressed by the CPSR I and F bits
+                auto maskReg32 = r14d;
+                m_codegen.mov(maskReg32, abi::kHostFlagsReg);
+                m_codegen.shr(maskReg32, x64flgIPos);
+                m_codegen.not_(maskReg32);
+                m_codegen.test(linesReg32, maskReg32);
+                m_codegen.jnz(m_compiledCode.interruptEntry);
 
                 // Otherwise, fallthrough and jump to block
             }
@@ -236,9 +290,14 @@ void x64Host::CompileProlog() {
     m_codegen.jmp(abi::kIntArgRegs[0]);
 
     vtune::ReportCode(CastUintPtr(m_compiledCode.prolog), m_codegen.getCurr<uintptr_t>(), "__prolog");
+    m_perfReporter.ReportCode(CastUintPtr(m_compiledCode.prolog), m_codegen.getCurr<uintptr_t>(), "__prolog");
 }
 
 void x64Host::CompileEpilog() {
+    // Exits from blocks that deferred copying flags into CPSR enter here
+    m_compiledCode.flagsSyncEpilog = m_codegen.getCurr<HostCode>();
+    CompileFlagsSync(m_codegen, m_stateOffsets.CPSROffset(), arm::Flags::NZCV);
+
     m_compiledCode.epilog = m_codegen.getCurr<HostCode>();
 
     // Copy remaining/current cycles to return value
@@ -255,13 +314,36 @@ void x64Host::CompileEpilog() {
     // Return from call
     m_codegen.ret();
 
-    vtune::ReportCode(CastUintPtr(m_compiledCode.epilog), m_codegen.getCurr<uintptr_t>(), "__epilog");
+    vtune::ReportCode(CastUintPtr(m_compiledCode.flagsSyncEpilog), m_codegen.getCurr<uintptr_t>(), "__epilog");
+    m_perfReporter.ReportCode(CastUintPtr(m_compiledCode.flagsSyncEpilog), m_codegen.getCurr<uintptr_t>(), "__epilog");
+}
+
+void x64Host::CompileInterruptEntries() {
+    m_compiledCode.irqEntry = CompileInterruptEntry(arm::Exception::NormalInterrupt);
+    m_compiledCode.fiqEntry = CompileInterruptEntry(arm::Exception::FastInterrupt);
+
+    // Entered when at least one interrupt line is raised and not inhibited
+    m_compiledCode.interruptEntry = m_codegen.getCurr<HostCode>();
+
+    // FIQ takes priority over IRQ
+    const auto fiqLineOffset = m_stateOffsets.FIQLineOffset();
+    m_codegen.test(byte[abi::kARMStateReg + fiqLineOffset], 1);
+    m_codegen.jz(m_compiledCode.irqEntry);
+    m_codegen.test(abi::kHostFlagsReg, x64flgF);
+    m_codegen.jz(m_compiledCode.fiqEntry);
+    m_codegen.jmp(m_compiledCode.irqEntry);
+
+    vtune::ReportCode(CastUintPtr(m_compiledCode.interruptEntry), m_codegen.getCurr<uintptr_t>(), "__interruptEntry");
+    m_perfReporter.ReportCode(CastUintPtr(m_compiledCode.interruptEntry), m_codegen.getCurr<uintptr_t>(),
+                              "__interruptEntry");
 }
 
-void x64Host::CompileIRQEntry() {
-    m_compiledCode.irqEntry = m_codegen.getCurr<HostCode>();
+HostCode x64Host::CompileInterruptEntry(arm::Exception vector) {
+    auto entry = m_codegen.getCurr<HostCode>();
 
     auto &armState = m_context.GetARMState();
+    const auto &vectorInfo = arm::kExceptionVectorInfos[static_cast<size_t>(vector)];
+    const bool fiq = vector == arm::Exception::FastInterrupt;
 
     // Get temporary registers for operations
     auto pcReg32 = abi::kIntArgRegs[0].cvt32();
@@ -270,18 +352,25 @@ void x64Host::CompileIRQEntry() {
 
     // Get field offsets
     const auto cpsrOffset = m_stateOffsets.CPSROffset();
-    const auto spsrOffset = m_stateOffsets.SPSROffset(arm::Mode::IRQ);
+    const auto spsrOffset = m_stateOffsets.SPSROffset(vectorInfo.mode);
     const auto pcOffset = m_stateOffsets.GPROffset(arm::GPR::PC, arm::Mode::User);
-    const auto lrOffset = m_stateOffsets.GPROffset(arm::GPR::LR, arm::Mode::IRQ);
+    const auto lrOffset = m_stateOffsets.GPROffset(arm::GPR::LR, vectorInfo.mode); // R14_irq or R14_fiq
     const auto execStateOffset = m_stateOffsets.ExecutionStateOffset();
 
     // -----------------------------------------------------------------------------------------------------------------
-    // IRQ exception vector entry
+    // IRQ or FIQ exception vector entry
+    // Switching CPSR to the exception mode is enough to select the banked registers, since compiled code addresses
+    // them by mode; only the banked LR is written here
+
+    // The previous block may have deferred copying flags into CPSR
+    if (m_compiledCode.lazyFlags) {
+        CompileFlagsSync(m_codegen, cpsrOffset, arm::Flags::NZCV);
+    }
 
     // Use PC register as temporary storage for CPSR to avoid two memory reads
     m_codegen.mov(pcReg32, dword[abi::kARMStateReg + cpsrOffset]);
 
-    // Copy CPSR to SPSR_irq
+    // Copy CPSR to SPSR_irq or SPSR_fiq
     m_codegen.mov(cpsrReg32, pcReg32);
     m_codegen.mov(dword[abi::kARMStateReg + spsrOffset], cpsrReg32);
 
@@ -293,19 +382,18 @@ void x64Host::CompileIRQEntry() {
     m_codegen.lea(lrReg32, dword[lrReg32 + cpsrReg32 * 4 - 4]);  // LR = PC + 0 (Thumb)
     m_codegen.mov(dword[abi::kARMStateReg + lrOffset], lrReg32); // LR = PC - 4 (ARM)
 
-    // Modify CPSR T and mode bits
-    constexpr uint32_t setBits = static_cast<uint32_t>(arm::Mode::IRQ) | (1u << ARMflgIPos);
+    // Modify CPSR T and mode bits, and inhibit IRQs (and FIQs on FIQ entry)
+    const uint32_t setBits = static_cast<uint32_t>(vectorInfo.mode) | ARMflgI | (vectorInfo.F ? ARMflgF : 0);
     m_codegen.mov(cpsrReg32, pcReg32);
     m_codegen.and_(cpsrReg32, ~0b11'1111);
     m_codegen.or_(cpsrReg32, setBits);
     m_codegen.mov(dword[abi::kARMStateReg + cpsrOffset], cpsrReg32);
 
-    // Update I in EAX
-    m_codegen.or_(abi::kHostFlagsReg, x64flgI);
+    // Update I and F in EAX
+    m_codegen.or_(abi::kHostFlagsReg, x64flgI | (vectorInfo.F ? x64flgF : 0));
 
     // Set PC
-    constexpr uint32_t irqVectorOffset =
-        (2u + static_cast<uint32_t>(arm::Exception::NormalInterrupt)) * sizeof(uint32_t);
+    const uint32_t vectorOffset = (2u + static_cast<uint32_t>(vector)) * sizeof(uint32_t);
     auto &cp15 = armState.GetSystemControlCoprocessor();
     if (cp15.IsPresent()) {
         // Load base vector address from CP15
@@ -313,10 +401,10 @@ void x64Host::CompileIRQEntry() {
         const auto baseVectorAddressOfs = offsetof(arm::cp15::ControlRegister, baseVectorAddress);
         m_codegen.mov(pcReg32.cvt64(), CastUintPtr(&cp15ctl));
         m_codegen.mov(pcReg32, dword[pcReg32.cvt64() + baseVectorAddressOfs]);
-        m_codegen.add(pcReg32, irqVectorOffset);
+        m_codegen.add(pcReg32, vectorOffset);
     } else {
         // Assume 00000000 if CP15 is absent
-        m_codegen.mov(pcReg32, irqVectorOffset);
+        m_codegen.mov(pcReg32, vectorOffset);
     }
     m_codegen.mov(dword[abi::kARMStateReg + pcOffset], pcReg32);
 
@@ -332,13 +420,25 @@ void x64Host::CompileIRQEntry() {
     }
 
     // -----------------------------------------------------------------------------------------------------------------
-    // IRQ handler block linking
+    // Exception handler block linking
+
+    // Instrumented code counts exits to the dispatcher
+    auto *counters = m_compiledCode.runtimeCounters;
+    Xbyak::Label lblExit{};
 
     if (m_options.enableBlockLinking) {
         auto cpsrReg64 = cpsrReg32.cvt64();
         auto pcReg64 = pcReg32.cvt64();
         auto lrReg64 = lrReg32.cvt64();
 
+        auto jzExit = [&] {
+            if (counters != nullptr) {
+                m_codegen.jz(lblExit, Xbyak::CodeGenerator::T_NEAR);
+            } else {
+                m_codegen.jz(m_compiledCode.epilog);
+            }
+        };
+
         // Build cache key
         m_codegen.mov(cpsrReg64.cvt32(), dword[abi::kARMStateReg + cpsrOffset]);
         m_codegen.and_(cpsrReg64, 0x3F); // We only need the mode and T bits
@@ -356,7 +456,7 @@ void x64Host::CompileIRQEntry() {
         // m_codegen.and_(lrReg64, CacheType::kL1Mask); // shouldn't be necessary
         m_codegen.mov(pcReg64, qword[pcReg64 + lrReg64 * sizeof(void *)]);
         m_codegen.test(pcReg64, pcReg64);
-        m_codegen.jz(m_compiledCode.epilog);
+        jzExit();
 
         // Level 2 check
         m_codegen.mov(lrReg64, cpsrReg64);
@@ -364,7 +464,7 @@ void x64Host::CompileIRQEntry() {
         m_codegen.and_(lrReg64, CacheType::kL2Mask);
         m_codegen.mov(pcReg64, qword[pcReg64 + lrReg64 * sizeof(void *)]);
         m_codegen.test(pcReg64, pcReg64);
-        m_codegen.jz(m_compiledCode.epilog);
+        jzExit();
 
         // Level 3 check
         // m_codegen.shr(cpsrReg64, CacheType::kL3Shift); // shift by zero
@@ -379,19 +479,57 @@ void x64Host::CompileIRQEntry() {
 
         // Jump to block if present, or epilog if not
         m_codegen.test(pcReg64, pcReg64);
-        m_codegen.mov(cpsrReg64, CastUintPtr(m_compiledCode.epilog));
-        m_codegen.cmovnz(cpsrReg64, pcReg64);
-        m_codegen.jmp(cpsrReg64);
-    } else {
+        if (counters != nullptr) {
+            m_codegen.jz(lblExit);
+            m_codegen.jmp(pcReg64);
+        } else {
+            m_codegen.mov(cpsrReg64, CastUintPtr(m_compiledCode.epilog));
+            m_codegen.cmovnz(cpsrReg64, pcReg64);
+            m_codegen.jmp(cpsrReg64);
+        }
+    } else if (counters == nullptr) {
         // Jump to epilog if block linking is disabled.
-        // This allows the dispatcher to see and react to the IRQ entry.
+        // This allows the dispatcher to see and react to the interrupt entry.
         m_codegen.jmp(m_compiledCode.epilog);
     }
 
-    vtune::ReportCode(CastUintPtr(m_compiledCode.irqEntry), m_codegen.getCurr<uintptr_t>(), "__irqEntry");
+    if (counters != nullptr) {
+        m_codegen.L(lblExit);
+        m_codegen.mov(pcReg32.cvt64(), CastUintPtr(&counters->irqExits));
+        m_codegen.inc(qword[pcReg32.cvt64()]);
+        m_codegen.jmp(m_compiledCode.epilog);
+    }
+
+    const char *name = fiq ? "__fiqEntry" : "__irqEntry";
+    vtune::ReportCode(CastUintPtr(entry), m_codegen.getCurr<uintptr_t>(), name);
+    m_perfReporter.ReportCode(CastUintPtr(entry), m_codegen.getCurr<uintptr_t>(), name);
+    return entry;
+}
+
+void x64Host::CompileFlagsSync(Xbyak::CodeGenerator &codegen, uint32_t cpsrOffset, arm::Flags flags) {
+    const uint32_t cpsrMask = static_cast<uint32_t>(flags);
+
+    // Convert host flags to the ARM format
+    if (CPUID::HasFastPDEPAndPEXT()) {
+        codegen.mov(edx, x64FlagsMask);
+        codegen.pext(edx, abi::kHostFlagsReg, edx);
+        codegen.shl(edx, ARMflgNZCVShift);
+    } else {
+        codegen.imul(edx, abi::kHostFlagsReg, x64ToARMFlagsMult);
+    }
+    codegen.and_(edx, cpsrMask);
+
+    // Merge them into CPSR
+    codegen.mov(ecx, dword[abi::kARMStateReg + cpsrOffset]);
+    codegen.and_(ecx, ~cpsrMask);
+    codegen.or_(ecx, edx);
+    codegen.mov(dword[abi::kARMStateReg + cpsrOffset], ecx);
 }
 
 HostCode x64Host::CompileImpl(ir::BasicBlock &block) {
+    // No compiled code is running while compiling, so nothing refers to retired loop idioms anymore
+    m_compiledCode.FreeRetiredLoopIdioms();
+
     auto &cachedBlock = m_compiledCode.blockCache.GetOrCreate(block.Location().ToUint64());
     Compiler compiler{m_context, m_commonData->stateOffsets, m_compiledCode, m_codegen, block, m_alloc};
 
@@ -402,19 +540,37 @@ HostCode x64Host::CompileImpl(ir::BasicBlock &block) {
 
     Xbyak::Label lblCondFail{};
 
+    // Links to this block, including from itself, may skip copying the flags it resyncs
+    m_compiledCode.resyncedFlags[block.Location().ToUint64()] = compiler.ResyncedFlags();
+
     const auto deadlinePtrOffset = m_stateOffsets.CycleDeadlinePointerOffset();
 
     // Compile pre-execution checks
-    compiler.CompileGenerationCheck(block.Location(), block.InstructionCount());
-    compiler.CompileIRQLineCheck();
+    // Self-loops branch back to the loop header, past the generation check
+    uint32_t precedingInstrCount = 0;
+    if (block.GetTerminal() == ir::BasicBlock::Terminal::IdleLoop) {
+        // Idle loops spanning several blocks also depend on the code of the preceding blocks
+        const uint32_t instrSize = block.Location().IsThumbMode() ? sizeof(uint16_t) : sizeof(uint32_t);
+        precedingInstrCount = (block.Location().PC() - block.GetTerminalLocation().PC()) / instrSize;
+    }
+    compiler.CompileGenerationCheck(block.Location(), block.InstructionCount(), precedingInstrCount);
+    compiler.CompileLoopHeader();
+    compiler.CompileInvalidationQueueCheck();
+    compiler.CompileExecutionCounter(block);
+    compiler.CompileInterruptLinesCheck();
+    compiler.CompileCodeCacheAccesses(block);
     compiler.CompileCondCheck(block.Condition(), lblCondFail);
 
     // Compile block code
     if (block.Condition() != arm::Condition::NV) {
+        compiler.CompileLoopIdiom(block);
+
         auto *op = block.Head();
         while (op != nullptr) {
             compiler.PreProcessOp(op);
-            ir::VisitIROp(op, [&compiler](const auto *op) -> void { compiler.CompileOp(op); });
+            if (!compiler.IsDeferredFlagsOp(op)) {
+                ir::VisitIROp(op, [&compiler](const auto *op) -> void { compiler.CompileOp(op); });
+            }
             compiler.PostProcessOp(op);
             op = op->Next();
         }
@@ -423,12 +579,14 @@ HostCode x64Host::CompileImpl(ir::BasicBlock &block) {
         compiler.CountCycles(block.PassCycles());
 
         // Bail out if we ran out of cycles
+        const bool deferredFlags = compiler.DeferredFlags() != arm::Flags::None;
+        auto exitCode = deferredFlags ? m_compiledCode.flagsSyncEpilog : m_compiledCode.epilog;
         if (armState.deadlinePtr != nullptr) {
             m_codegen.mov(rcx, qword[abi::kARMStateReg + deadlinePtrOffset]);
             m_codegen.cmp(abi::kCycleCountReg, qword[rcx]);
-            m_codegen.jae(m_compiledCode.epilog);
+            m_codegen.jae(exitCode);
         } else {
-            m_codegen.jle(m_compiledCode.epilog);
+            m_codegen.jle(exitCode);
         }
     }
 
@@ -485,12 +643,15 @@ HostCode x64Host::CompileImpl(ir::BasicBlock &block) {
     }
 
     // Cleanup, cache block and return pointer to code
+    m_lastCompiledCodeSize = m_codegen.getCurr<uintptr_t>() - CastUintPtr(fnPtr);
     vtune::ReportBasicBlock(CastUintPtr(fnPtr), m_codegen.getCurr<uintptr_t>(), block.Location());
+    m_perfReporter.ReportBasicBlock(CastUintPtr(fnPtr), m_codegen.getCurr<uintptr_t>(), block.Location());
     return fnPtr;
 }
 
 void x64Host::ApplyDirectLinkPatches(LocationRef target, HostCode blockCode) {
     const uint64_t key = target.ToUint64();
+    const auto resyncedFlags = m_compiledCode.GetResyncedFlags(target);
     auto itPatch = m_compiledCode.pendingPatches.find(key);
     while (itPatch != m_compiledCode.pendingPatches.end() && itPatch->first == key) {
         auto &patchInfo = itPatch->second;
@@ -499,11 +660,15 @@ void x64Host::ApplyDirectLinkPatches(LocationRef target, HostCode blockCode) {
             // Remember current location
             auto prevSize = m_codegen.getSize();
 
-            // Go to patch location
-            m_codegen.setSize(patchInfo.codePos - m_codegen.getCode());
+            // Go to patch location, skipping the deferred flags copy if the block copies the same flags by itself
+            auto patchPos = patchInfo.codePos;
+            if (patchInfo.flagsSyncPos != nullptr && BitmaskEnum(patchInfo.flagsSync).NoneExcept(resyncedFlags)) {
+                patchPos = patchInfo.flagsSyncPos;
+            }
+            m_codegen.setSize(patchPos - m_codegen.getCode());
 
             // If target is close enough, emit up to three NOPs, otherwise emit a JMP to the target address
-            auto distToTarget = (const uint8_t *)blockCode - patchInfo.codePos;
+            auto distToTarget = (const uint8_t *)blockCode - patchPos;
             if (distToTarget >= 1 && distToTarget <= 27 && blockCode == patchInfo.codeEnd) {
                 for (;;) {
                     if (distToTarget > 9) {
@@ -522,6 +687,10 @@ void x64Host::ApplyDirectLinkPatches(LocationRef target, HostCode blockCode) {
             m_codegen.setSize(prevSize);
         }
 
+        if (m_compiledCode.runtimeCounters != nullptr) {
+            ++m_compiledCode.runtimeCounters->patchesApplied;
+        }
+
         // Move patch to the applied patches list
         m_compiledCode.appliedPatches.insert({key, patchInfo});
 
@@ -538,6 +707,12 @@ void x64Host::RevertDirectLinkPatches(uint64_t key, bool eraseBlock) {
         // Remember current location
         auto prevSize = m_codegen.getSize();
 
+        // Restore the deferred flags copy, which may have been skipped by the patch
+        if (patchInfo.flagsSyncPos != nullptr) {
+            m_codegen.setSize(patchInfo.flagsSyncPos - m_codegen.getCode());
+            CompileFlagsSync(m_codegen, m_stateOffsets.CPSROffset(), patchInfo.flagsSync);
+        }
+
         // Go to patch location
         m_codegen.setSize(patchInfo.codePos - m_codegen.getCode());
 
@@ -547,6 +722,10 @@ void x64Host::RevertDirectLinkPatches(uint64_t key, bool eraseBlock) {
         // Restore code generator position
         m_codegen.setSize(prevSize);
 
+        if (m_compiledCode.runtimeCounters != nullptr) {
+            ++m_compiledCode.runtimeCounters->patchesReverted;
+        }
+
         if (!eraseBlock) {
             // Add the patch to the pending patch list
             m_compiledCode.pendingPatches.insert({itPatch->first, itPatch->second});
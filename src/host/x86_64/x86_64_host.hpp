@@ -8,6 +8,7 @@
 #include "util/pointer_cast.hpp"
 #include "util/type_traits.hpp"
 
+#include "perf_map.hpp"
 #include "x86_64_compiled_code.hpp"
 #include "x86_64_type_traits.hpp"
 
@@ -69,22 +70,29 @@ private:
     struct CommonData;
 
     std::unique_ptr<CommonData> m_commonData;
-    std::unique_ptr<uint8_t[]> m_codeBuffer;
+    const HugePageMode m_hugePages;
     size_t m_codeBufferSize;
+    uint8_t *m_codeBuffer;
     CustomCodeGenerator m_codegen;
     CompiledCode m_compiledCode;
+    perf::CodeReporter m_perfReporter;
     std::pmr::memory_resource &m_alloc;
 
     void CompileCommon();
 
     void CompileProlog();
     void CompileEpilog();
-    void CompileIRQEntry();
+    void CompileInterruptEntries();
+    HostCode CompileInterruptEntry(arm::Exception vector);
 
     HostCode CompileImpl(ir::BasicBlock &block);
 
     void ApplyDirectLinkPatches(LocationRef target, HostCode blockCode);
     void RevertDirectLinkPatches(uint64_t target, bool eraseBlock);
+
+    // Copies the specified NZCV flags from the host flags register into CPSR, clobbering ECX and EDX.
+    // The emitted code only depends on the arguments, which allows reverted patches to restore it.
+    static void CompileFlagsSync(Xbyak::CodeGenerator &codegen, uint32_t cpsrOffset, arm::Flags flags);
 };
 
 } // namespace armajitto::x86_64
@@ -1,6 +1,7 @@
 #include "basic_block.hpp"
 
 #include "ir_ops.hpp"
+#include "ops/ir_ops_visitor.hpp"
 
 #include "util/scope_guard.hpp"
 
@@ -9,6 +10,43 @@
 
 namespace armajitto::ir {
 
+bool BasicBlock::AllocateOpChunk() {
+    void *ptr = m_alloc.AllocateRaw(kOpChunkSize, alignof(OpChunk));
+    if (ptr == nullptr) {
+        return false;
+    }
+    m_opChunks = new (ptr) OpChunk{m_opChunks};
+    m_nextOpPtr = static_cast<uint8_t *>(ptr) + sizeof(OpChunk);
+    m_opChunkEnd = static_cast<uint8_t *>(ptr) + kOpChunkSize;
+    return true;
+}
+
+void BasicBlock::CopyFrom(const BasicBlock &block) {
+    Clear();
+
+    m_location = block.m_location;
+    m_cond = block.m_cond;
+    m_instrCount = block.m_instrCount;
+    m_nextVarID = block.m_nextVarID;
+    m_passCycles = block.m_passCycles;
+    m_failCycles = block.m_failCycles;
+    m_terminal = block.m_terminal;
+    m_terminalLocation = block.m_terminalLocation;
+    m_idleLoopGuards = block.m_idleLoopGuards;
+    m_idleLoopGuardCount = block.m_idleLoopGuardCount;
+    m_loopIdiom = block.m_loopIdiom;
+
+    for (const IROp *op = block.m_opsHead; op != nullptr; op = op->next) {
+        IROp *copy = VisitIROp(const_cast<IROp *>(op), [this](auto *op) -> IROp * {
+            using TOp = std::remove_cvref_t<decltype(*op)>;
+            return CreateOp<TOp>(*op);
+        });
+        copy->prev = nullptr;
+        copy->next = nullptr;
+        InsertTail(copy);
+    }
+}
+
 void BasicBlock::RenameVariables() {
     uint32_t nextVarID = 0;
     void *ptr = m_alloc.AllocateRaw(m_nextVarID * sizeof(Variable));
@@ -269,6 +307,7 @@ void BasicBlock::RenameVariables() {
             map(opImpl->address);
             break;
         }
+        case IROpcodeType::Checkpoint: break;
         case IROpcodeType::LoadCopRegister: {
             auto opImpl = Cast<IRLoadCopRegisterOp>(op);
             map(opImpl->dstValue);
@@ -2,12 +2,17 @@
 
 #include "core/allocator.hpp"
 #include "core/location_ref.hpp"
+#include "defs/arguments.hpp"
+#include "defs/memory_access.hpp"
 #include "defs/variable.hpp"
 #include "guest/arm/instructions.hpp"
 #include "ir/ops/ir_ops_base.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <memory>
+#include <span>
 #include <type_traits>
 #include <vector>
 
@@ -15,8 +20,9 @@ namespace armajitto::ir {
 
 class BasicBlock {
 public:
-    // true = less translator/optimizer performance, lower memory usage
+    // true = IR op storage is returned to the allocator when the block is cleared, lowering memory usage
     // false = faster, but memory is wasted on optimization passes until allocator is released
+    // Erased ops are never freed individually; their storage is reclaimed along with the rest of the block's ops.
     static constexpr bool kFreeErasedIROps = false;
 
     enum class Terminal {
@@ -36,10 +42,49 @@ public:
         Return,
 
         // Idle loop.
-        // Used by branches to the beginning of the block under specific conditions.
+        // Used by branches to the beginning of the block or to a preceding block under specific conditions.
+        // The terminal location points to the first instruction of the loop.
         IdleLoop,
     };
 
+    // Register value that must hold for an idle loop to be skipped.
+    struct IdleLoopGuard {
+        GPRArg reg = arm::GPR::R0;
+        uint32_t value = 0;
+    };
+
+    static constexpr size_t kMaxIdleLoopGuards = 4;
+
+    // Memory copy or fill loop starting at the beginning of the block.
+    // The block contains the loop body; the conditional branch back to the block is in the following block.
+    // Hosts may run any number of iterations except the last one before executing the block, as long as they follow the
+    // guest semantics of the loop. The block then runs the remaining iterations, including the one that sets the flags.
+    struct LoopIdiom {
+        enum class Kind : uint8_t {
+            None, // No idiom recognized
+            Copy, // Loads regList from [src] and stores it to [dst], advancing both pointers
+            Fill, // Stores regList to [dst], advancing the pointer
+        };
+
+        Kind kind = Kind::None;
+        MemAccessSize size = MemAccessSize::Word; // Size of each transfer; LDM/STM transfer words
+        uint16_t regList = 0;                     // Registers transferred on each iteration, in ascending order
+
+        GPRArg src = arm::GPR::R0;
+        GPRArg dst = arm::GPR::R0;
+        GPRArg counter = arm::GPR::R0;
+
+        uint32_t bytesPerIteration = 0;
+        uint32_t decrement = 0; // Subtracted from the counter with SUBS on every iteration
+
+        // Condition of the branch that closes the loop.
+        // The branch is taken if <counter> <cond> <decrement> holds before the subtraction, e.g. counter > decrement.
+        arm::Condition cond = arm::Condition::NE;
+
+        uint32_t instrCount = 0;         // Number of instructions in the loop, including the branch
+        uint64_t cyclesPerIteration = 0; // Cycles taken by an iteration of the loop, including the branch
+    };
+
     BasicBlock(memory::Allocator &alloc, LocationRef location)
         : m_alloc(alloc)
         , m_location(location) {}
@@ -86,13 +131,16 @@ public:
 
     void Clear() {
         if constexpr (kFreeErasedIROps) {
-            IROp *op = m_opsHead;
-            while (op != nullptr) {
-                IROp *next = op->next;
-                m_alloc.Free(op);
-                op = next;
+            OpChunk *chunk = m_opChunks;
+            while (chunk != nullptr) {
+                OpChunk *next = chunk->next;
+                m_alloc.Free(chunk);
+                chunk = next;
             }
         }
+        m_opChunks = nullptr;
+        m_nextOpPtr = nullptr;
+        m_opChunkEnd = nullptr;
         m_opsHead = nullptr;
         m_opsTail = nullptr;
     }
@@ -110,6 +158,21 @@ public:
         return m_terminalLocation;
     }
 
+    // Valid for Terminal::IdleLoop
+    // The loop is only skipped if all registers hold the specified values; otherwise it branches to the loop entry.
+    std::span<const IdleLoopGuard> IdleLoopGuards() const {
+        return {m_idleLoopGuards.data(), m_idleLoopGuardCount};
+    }
+
+    // Memory copy or fill loop implemented by the block, if any.
+    const LoopIdiom &GetLoopIdiom() const {
+        return m_loopIdiom;
+    }
+
+    // Replaces the contents of this block with a copy of the IR and attributes of the given block.
+    // The copy is allocated from this block's allocator, so the source block may be cleared or released afterwards.
+    void CopyFrom(const BasicBlock &block);
+
     // Returns the location reference to the first instruction after this block
     LocationRef NextLocation() const {
         const uint32_t instrSize = m_location.IsThumbMode() ? sizeof(uint16_t) : sizeof(uint32_t);
@@ -124,6 +187,20 @@ private:
 
     IROp *m_opsHead = nullptr;
     IROp *m_opsTail = nullptr;
+
+    // IR ops are packed back to back, in creation order, into chunks of contiguous memory owned by the block.
+    // Passes walking the op list mostly touch sequential memory and ops carry no per-allocation headers.
+    static constexpr std::size_t kOpChunkSize = 4096;
+
+    struct OpChunk {
+        OpChunk *next;
+    };
+
+    OpChunk *m_opChunks = nullptr;
+    uint8_t *m_nextOpPtr = nullptr;
+    uint8_t *m_opChunkEnd = nullptr;
+
+    bool AllocateOpChunk();
     uint32_t m_instrCount = 0; // Number of ARM/Thumb instructions translated into this block
     uint32_t m_nextVarID = 0;
 
@@ -133,6 +210,11 @@ private:
     Terminal m_terminal = Terminal::Return;
     LocationRef m_terminalLocation{};
 
+    std::array<IdleLoopGuard, kMaxIdleLoopGuards> m_idleLoopGuards{};
+    size_t m_idleLoopGuardCount = 0;
+
+    LoopIdiom m_loopIdiom{};
+
     // -------------------------------------------------------------------------
     // Emitter accessors
     // Allows modification of the IR code inside the block
@@ -155,9 +237,26 @@ private:
         m_failCycles += cycles;
     }
 
+    void SetLoopIdiom(const LoopIdiom &idiom) {
+        m_loopIdiom = idiom;
+    }
+
     template <typename T, typename... Args>
     IROp *CreateOp(Args &&...args) {
-        return m_alloc.Allocate<T>(std::forward<Args>(args)...);
+        static_assert(std::is_trivially_destructible_v<T>, "IR ops must be trivially destructible");
+        static_assert(alignof(T) <= alignof(OpChunk), "IR op alignment exceeds the op chunk alignment");
+
+        constexpr std::size_t kOpSize = (sizeof(T) + alignof(OpChunk) - 1) & ~(alignof(OpChunk) - 1);
+        static_assert(sizeof(OpChunk) + kOpSize <= kOpChunkSize, "IR op does not fit in an op chunk");
+
+        if (static_cast<std::size_t>(m_opChunkEnd - m_nextOpPtr) < kOpSize) {
+            if (!AllocateOpChunk()) {
+                return nullptr;
+            }
+        }
+        void *ptr = m_nextOpPtr;
+        m_nextOpPtr += kOpSize;
+        return new (ptr) T(std::forward<Args>(args)...);
     }
 
     template <typename T, typename... Args>
@@ -201,9 +300,6 @@ private:
             if (ref == m_opsTail) {
                 m_opsTail = op;
             }
-            if constexpr (kFreeErasedIROps) {
-                m_alloc.Free(ref);
-            }
         }
         return op;
     }
@@ -239,11 +335,7 @@ private:
     }
 
     IROp *Erase(IROp *op) {
-        IROp *next = Detach(op);
-        if constexpr (kFreeErasedIROps) {
-            m_alloc.Free(op);
-        }
-        return next;
+        return Detach(op);
     }
 
     uint32_t NextVarID() {
@@ -273,8 +365,11 @@ private:
         m_terminal = Terminal::Return;
     }
 
-    void TerminateIdleLoop() {
+    void TerminateIdleLoop(std::span<const IdleLoopGuard> guards) {
+        assert(guards.size() <= kMaxIdleLoopGuards);
         m_terminal = Terminal::IdleLoop;
+        m_idleLoopGuardCount = guards.size();
+        std::copy(guards.begin(), guards.end(), m_idleLoopGuards.begin());
     }
 };
 
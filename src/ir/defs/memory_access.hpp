@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace armajitto::ir {
 
 enum class MemAccessType { Sequential, Nonsequential };
@@ -7,4 +9,15 @@ enum class MemAccessBus { Code, Data };
 enum class MemAccessMode { Aligned, Signed, Unaligned };
 enum class MemAccessSize { Byte, Half, Word };
 
+// Timing parameters of a data access, used by the SubinstructionTimingTable cycle counting method.
+// The host looks up the cost of timed accesses in the memory map timing tables and adds it to the cycle count.
+struct MemAccessTiming {
+    bool timed = false;
+    MemAccessType type = MemAccessType::Nonsequential;
+
+    // Cycles already counted for a code fetch performed in parallel with this access (ARMv5TE).
+    // Only the cycles exceeding this amount are added.
+    uint8_t parallelCycles = 0;
+};
+
 } // namespace armajitto::ir
@@ -53,6 +53,7 @@ enum class IROpcodeType {
     // Branching
     Branch,
     BranchExchange,
+    Checkpoint,
 
     // Coprocessor operations
     LoadCopRegister,
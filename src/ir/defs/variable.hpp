@@ -1,17 +1,18 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 namespace armajitto::ir {
 
 struct Variable {
-    static constexpr size_t kInvalidIndex = ~0;
+    static constexpr uint32_t kInvalidIndex = ~0u;
 
     Variable()
         : index(kInvalidIndex) {}
 
     explicit Variable(size_t index)
-        : index(index) {}
+        : index(static_cast<uint32_t>(index)) {}
 
     size_t Index() const {
         return index;
@@ -32,7 +33,7 @@ struct Variable {
     bool operator==(const Variable &) const = default;
 
 private:
-    size_t index;
+    uint32_t index; // 32 bits keep IR ops compact; blocks never come close to 2^32 variables
 
     friend class Emitter;
 };
@@ -9,6 +9,8 @@ namespace armajitto::ir {
 
 void Emitter::NextInstruction() {
     m_block.NextInstruction();
+    m_instrMemAccesses = 0;
+    m_lastMemAccessTiming = nullptr;
 }
 
 void Emitter::SetCondition(arm::Condition cond) {
@@ -23,6 +25,36 @@ void Emitter::AddFailCycles(uint64_t cycles) {
     m_block.AddFailCycles(cycles);
 }
 
+void Emitter::EnableMemAccessTiming() {
+    m_memAccessTiming = true;
+}
+
+void Emitter::SetAbortRefillCycles(uint64_t cycles) {
+    m_abortRefillCycles = cycles;
+}
+
+void Emitter::SetLastMemAccessType(MemAccessType type) {
+    if (m_lastMemAccessTiming != nullptr) {
+        m_lastMemAccessTiming->type = type;
+    }
+}
+
+void Emitter::SetLastMemAccessParallelCycles(uint8_t cycles) {
+    if (m_lastMemAccessTiming != nullptr) {
+        m_lastMemAccessTiming->parallelCycles = cycles;
+    }
+}
+
+void Emitter::SetupMemAccessTiming(MemAccessTiming &timing) {
+    if (!m_memAccessTiming) {
+        return;
+    }
+    timing.timed = true;
+    timing.type = (m_instrMemAccesses == 0) ? MemAccessType::Nonsequential : MemAccessType::Sequential;
+    ++m_instrMemAccesses;
+    m_lastMemAccessTiming = &timing;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Basic IR instruction emitters
 
@@ -89,6 +121,10 @@ Variable Emitter::MemRead(MemAccessBus bus, MemAccessMode mode, MemAccessSize si
 
 void Emitter::MemWrite(MemAccessSize size, VarOrImmArg src, VarOrImmArg address) {
     Write<IRMemWriteOp>(size, src, address);
+    auto *op = Cast<IRMemWriteOp>(m_currOp);
+    op->instrIndex = m_block.InstructionCount();
+    op->abortCycles = m_block.PassCycles() + m_abortRefillCycles;
+    SetupMemAccessTiming(op->timing);
 }
 
 void Emitter::Preload(VarOrImmArg address) {
@@ -346,6 +382,10 @@ void Emitter::BranchExchangeCPSRThumbFlag(VarOrImmArg address) {
     TerminateIndirectLink();
 }
 
+void Emitter::Checkpoint() {
+    Write<IRCheckpointOp>(m_block.NextLocation().PC(), m_block.PassCycles());
+}
+
 Variable Emitter::LoadCopRegister(uint8_t cpnum, arm::CopRegister reg, bool ext) {
     auto dstValue = Var();
     LoadCopRegister(dstValue, cpnum, reg, ext);
@@ -395,6 +435,12 @@ void Emitter::GetSPSR(VariableArg dst) {
 
 void Emitter::MemRead(MemAccessBus bus, MemAccessMode mode, MemAccessSize size, VariableArg dst, VarOrImmArg address) {
     Write<IRMemReadOp>(bus, mode, size, dst, address);
+    auto *op = Cast<IRMemReadOp>(m_currOp);
+    op->instrIndex = m_block.InstructionCount();
+    op->abortCycles = m_block.PassCycles() + m_abortRefillCycles;
+    if (bus == MemAccessBus::Data) {
+        SetupMemAccessTiming(op->timing);
+    }
 }
 
 void Emitter::LogicalShiftLeft(VariableArg dst, VarOrImmArg value, VarOrImmArg amount, bool setFlags) {
@@ -512,6 +558,12 @@ Variable Emitter::AddQ(VarOrImmArg lhs, VarOrImmArg rhs) {
     return dst;
 }
 
+Variable Emitter::AddNZ(VarOrImmArg lhs, VarOrImmArg rhs) {
+    auto dst = Var();
+    Write<IRAddOp>(dst, lhs, rhs, arm::Flags::NZ);
+    return dst;
+}
+
 Variable Emitter::GetOffsetFromCurrentInstructionAddress(int32_t offset) {
     auto pc = GetRegister(arm::GPR::PC);
     return Add(pc, offset - m_instrSize * 2, false);
@@ -647,8 +699,12 @@ void Emitter::TerminateReturn() {
     m_block.TerminateReturn();
 }
 
-void Emitter::TerminateIdleLoop() {
-    m_block.TerminateIdleLoop();
+void Emitter::TerminateIdleLoop(std::span<const BasicBlock::IdleLoopGuard> guards) {
+    m_block.TerminateIdleLoop(guards);
+}
+
+void Emitter::SetLoopIdiom(const BasicBlock::LoopIdiom &idiom) {
+    m_block.SetLoopIdiom(idiom);
 }
 
 Variable Emitter::Var() {
@@ -80,6 +80,17 @@ public:
     void AddPassCycles(uint64_t cycles);
     void AddFailCycles(uint64_t cycles);
 
+    // Annotates memory accesses emitted from now on with timing parameters for the host to count their cycles.
+    // The first access of each instruction is nonsequential; subsequent accesses are sequential.
+    void EnableMemAccessTiming();
+
+    // Sets the cycles taken to refill the pipeline when a memory access emitted from now on aborts.
+    void SetAbortRefillCycles(uint64_t cycles);
+
+    // Override the timing parameters of the last memory access emitted by the current instruction, if timed.
+    void SetLastMemAccessType(MemAccessType type);
+    void SetLastMemAccessParallelCycles(uint8_t cycles);
+
     // -----------------------------------------------------------------------------------------------------------------
     // Optimizer helper functions
     // TODO: figure out a way to expose these methods only to the optimizers
@@ -167,6 +178,7 @@ public:
             return;
         }
         IROp *result = m_block.Erase(op);
+        ++m_erasedOps;
         if (op == m_currOp) {
             m_currOp = result;
             m_prependNext = true;
@@ -175,6 +187,16 @@ public:
         m_dirty = true;
     }
 
+    // Retrieves the number of IR ops erased through this emitter.
+    uint64_t ErasedOpCount() const {
+        return m_erasedOps;
+    }
+
+    // Retrieves the number of IR ops overwritten through this emitter.
+    uint64_t ReplacedOpCount() const {
+        return m_replacedOps;
+    }
+
     // Determines if the current op was erased.
     bool WasCurrentOpErased() const {
         return m_currOpErased;
@@ -261,6 +283,9 @@ public:
     void BranchExchangeL4(VarOrImmArg address);
     void BranchExchangeCPSRThumbFlag(VarOrImmArg address);
 
+    // Allows the block to be left before the next instruction, counting the cycles taken so far.
+    void Checkpoint();
+
     Variable LoadCopRegister(uint8_t cpnum, arm::CopRegister reg, bool ext);
     void StoreCopRegister(uint8_t cpnum, arm::CopRegister reg, bool ext, VarOrImmArg srcValue);
 
@@ -321,6 +346,9 @@ public:
     // add.v <lhs>, <rhs> -- specifically for multiply-accumulate affecting Q flag
     Variable AddQ(VarOrImmArg lhs, VarOrImmArg rhs);
 
+    // add.nz <lhs>, <rhs> -- specifically for multiply-accumulate setting flags, which leaves C and V unchanged
+    Variable AddNZ(VarOrImmArg lhs, VarOrImmArg rhs);
+
     Variable GetOffsetFromCurrentInstructionAddress(int32_t offset);
 
     void CopySPSRToCPSR();
@@ -342,7 +370,9 @@ public:
     void TerminateIndirectLink();
     void TerminateContinueExecution();
     void TerminateReturn();
-    void TerminateIdleLoop();
+    void TerminateIdleLoop(std::span<const BasicBlock::IdleLoopGuard> guards = {});
+
+    void SetLoopIdiom(const BasicBlock::LoopIdiom &idiom);
 
 private:
     BasicBlock &m_block;
@@ -353,9 +383,18 @@ private:
     uint32_t m_instrSize;
 
     bool m_dirty = false;
+    uint64_t m_erasedOps = 0;
+    uint64_t m_replacedOps = 0;
 
     IROp *m_currOp;
 
+    bool m_memAccessTiming = false;
+    uint32_t m_instrMemAccesses = 0;
+    MemAccessTiming *m_lastMemAccessTiming = nullptr;
+    uint64_t m_abortRefillCycles = 0;
+
+    void SetupMemAccessTiming(MemAccessTiming &timing);
+
     bool m_currOpErased = false;
     bool m_overwriteNext = false;
     bool m_prependNext = false;
@@ -364,6 +403,7 @@ private:
     void Write(Args &&...args) {
         if (m_overwriteNext) {
             m_currOp = m_block.ReplaceOp<T>(m_currOp, std::forward<Args>(args)...);
+            ++m_replacedOps;
             m_overwriteNext = false;
             m_prependNext = false;
         } else if (m_prependNext) {
@@ -0,0 +1,182 @@
+#include "flags_materialization.hpp"
+
+#include "ops/ir_ops_visitor.hpp"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace armajitto::ir {
+
+FlagsMaterializationAnalyzer::FlagsMaterializationAnalyzer(std::pmr::memory_resource &alloc)
+    : m_staleFlags(&alloc)
+    , m_varReads(&alloc) {}
+
+void FlagsMaterializationAnalyzer::Analyze(const BasicBlock &block, bool memAccessesMayAbort) {
+    m_staleFlags.clear();
+    m_staleFlags.resize(block.VariableCount(), arm::Flags::None);
+    m_varReads.clear();
+    m_varReads.resize(block.VariableCount(), 0);
+
+    AnalyzeResync(block, memAccessesMayAbort);
+    AnalyzeDeferral(block, memAccessesMayAbort);
+}
+
+void FlagsMaterializationAnalyzer::AnalyzeResync(const BasicBlock &block, bool memAccessesMayAbort) {
+    m_resyncedFlags = arm::Flags::None;
+    if (block.Condition() != arm::Condition::AL) {
+        return;
+    }
+
+    auto pending = arm::Flags::NZCV;  // CPSR flags that may differ from the host flags
+    auto observed = arm::Flags::None; // Pending flags observed before being copied from the host flags
+
+    auto observeReads = [&](const IROp *op) {
+        VisitIROpVars(op, [&](const auto *, Variable var, bool read) {
+            if (read) {
+                observed |= m_staleFlags[var.Index()];
+            }
+        });
+    };
+
+    const IROp *op = block.Head();
+    while (op != nullptr) {
+        VisitIROp(op, [&](auto *op) {
+            using TOp = std::decay_t<std::remove_cvref_t<decltype(*op)>>;
+            if constexpr (std::is_same_v<TOp, IRGetCPSROp>) {
+                SetStaleFlags(op->dst, pending);
+            } else if constexpr (std::is_same_v<TOp, IRSetCPSROp>) {
+                pending = StaleFlags(op->src);
+            } else if constexpr (std::is_same_v<TOp, IRLoadFlagsOp>) {
+                SetStaleFlags(op->dstCPSR, StaleFlags(op->srcCPSR) & ~op->flags);
+            } else if constexpr (std::is_same_v<TOp, IRLoadStickyOverflowOp>) {
+                SetStaleFlags(op->dstCPSR, StaleFlags(op->srcCPSR));
+            } else if constexpr (std::is_same_v<TOp, IRCopyVarOp>) {
+                SetStaleFlags(op->dst, StaleFlags(op->var));
+            } else if constexpr (std::is_same_v<TOp, IRCheckpointOp>) {
+                // The block may be left here with CPSR as is
+                observed |= pending;
+            } else if constexpr (std::is_same_v<TOp, IRBitwiseAndOp> || std::is_same_v<TOp, IRBitwiseOrOp> ||
+                                 std::is_same_v<TOp, IRBitClearOp>) {
+                // Flag bits are only transferred through masks with immediate values
+                const bool commutative = !std::is_same_v<TOp, IRBitClearOp>;
+                if (op->flags != arm::Flags::None || op->lhs.immediate == op->rhs.immediate ||
+                    (op->lhs.immediate && !commutative)) {
+                    observeReads(op);
+                    return;
+                }
+                const auto &var = op->lhs.immediate ? op->rhs : op->lhs;
+                const auto imm = static_cast<arm::Flags>(op->lhs.immediate ? op->lhs.imm.value : op->rhs.imm.value);
+                if constexpr (std::is_same_v<TOp, IRBitwiseAndOp>) {
+                    SetStaleFlags(op->dst, StaleFlags(var) & imm);
+                } else {
+                    SetStaleFlags(op->dst, StaleFlags(var) & ~imm);
+                }
+            } else {
+                if constexpr (std::is_same_v<TOp, IRMemReadOp> || std::is_same_v<TOp, IRMemWriteOp>) {
+                    // Data aborts copy CPSR into SPSR_abt
+                    if (memAccessesMayAbort) {
+                        observed |= pending;
+                    }
+                }
+                observeReads(op);
+            }
+        });
+        op = op->Next();
+    }
+
+    // Flags left pending at the end of the block are never copied
+    m_resyncedFlags = arm::Flags::NZCV & ~(pending | observed);
+}
+
+void FlagsMaterializationAnalyzer::AnalyzeDeferral(const BasicBlock &block, bool memAccessesMayAbort) {
+    m_deferredFlags = arm::Flags::None;
+    m_deferredLoad = nullptr;
+    m_deferredMerge = nullptr;
+    m_deferredStore = nullptr;
+
+    if (block.GetTerminal() != BasicBlock::Terminal::DirectLink || block.Condition() == arm::Condition::NV) {
+        return;
+    }
+
+    // Find the last CPSR write and count variable reads
+    const IRSetCPSROp *store = nullptr;
+    const IROp *op = block.Head();
+    while (op != nullptr) {
+        if (op->type == IROpcodeType::SetCPSR) {
+            store = static_cast<const IRSetCPSROp *>(op);
+        }
+        VisitIROpVars(op, [&](const auto *, Variable var, bool read) {
+            if (read) {
+                ++m_varReads[var.Index()];
+            }
+        });
+        op = op->Next();
+    }
+    if (store == nullptr || store->src.immediate || store->updateIFlag) {
+        return;
+    }
+
+    // Match the "ld $a, cpsr; ldflg $b, $a; st cpsr, $b" sequence, where $a and $b are not used anywhere else
+    const IRLoadFlagsOp *merge = nullptr;
+    const IRGetCPSROp *load = nullptr;
+    const auto storedVar = store->src.var.var;
+    for (op = store->Prev(); op != nullptr; op = op->Prev()) {
+        if (merge == nullptr && op->type == IROpcodeType::LoadFlags) {
+            auto *ldflg = static_cast<const IRLoadFlagsOp *>(op);
+            if (ldflg->dstCPSR.var == storedVar) {
+                if (ldflg->srcCPSR.immediate || ldflg->flags == arm::Flags::None) {
+                    return;
+                }
+                merge = ldflg;
+            }
+        } else if (merge != nullptr && op->type == IROpcodeType::GetCPSR) {
+            auto *ldcpsr = static_cast<const IRGetCPSROp *>(op);
+            if (ldcpsr->dst.var == merge->srcCPSR.var.var) {
+                load = ldcpsr;
+                break;
+            }
+        } else if (op->type == IROpcodeType::SetCPSR || op->type == IROpcodeType::BranchExchange) {
+            // CPSR was modified after the load
+            return;
+        }
+    }
+    if (load == nullptr || m_varReads[storedVar.Index()] != 1 || m_varReads[load->dst.var.Index()] != 1) {
+        return;
+    }
+
+    // Nothing may observe CPSR after the store
+    for (op = store->Next(); op != nullptr; op = op->Next()) {
+        switch (op->type) {
+        case IROpcodeType::GetCPSR:
+        case IROpcodeType::BranchExchange:
+        case IROpcodeType::Checkpoint: return;
+        case IROpcodeType::MemRead:
+        case IROpcodeType::MemWrite:
+            if (memAccessesMayAbort) {
+                return;
+            }
+            break;
+        default: break;
+        }
+    }
+
+    m_deferredFlags = merge->flags & arm::Flags::NZCV;
+    m_deferredLoad = load;
+    m_deferredMerge = merge;
+    m_deferredStore = store;
+}
+
+arm::Flags FlagsMaterializationAnalyzer::StaleFlags(const VarOrImmArg &arg) const {
+    if (arg.immediate) {
+        return arm::Flags::None;
+    }
+    return m_staleFlags[arg.var.var.Index()];
+}
+
+void FlagsMaterializationAnalyzer::SetStaleFlags(const VariableArg &arg, arm::Flags flags) {
+    if (arg.var.IsPresent()) {
+        m_staleFlags[arg.var.Index()] = flags;
+    }
+}
+
+} // namespace armajitto::ir
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "basic_block.hpp"
+#include "ir_ops.hpp"
+
+#include "guest/arm/flags.hpp"
+
+#include <memory_resource>
+#include <vector>
+
+namespace armajitto::ir {
+
+// Analyzes how a basic block copies the NZCV flags from the host flags into CPSR, allowing the host to defer those
+// copies across directly linked blocks.
+//
+// The host flags hold the current NZCV flags whenever a block is entered or left. Flag-setting instructions update the
+// host flags and copy them into CPSR with the sequence:
+//   ld $a, cpsr
+//   ldflg.<flags> $b, $a
+//   st cpsr, $b
+//
+// If that sequence is the last write to CPSR in a block that links directly to another block and nothing observes
+// CPSR after it, the sequence may be replaced by an equivalent copy at the link site. That copy can be skipped when
+// the linked block itself copies the same flags into CPSR before CPSR is observed in any other way -- those flags are
+// reported by ResyncedFlags().
+//
+// CPSR is observed by reading its flag bits into anything other than flag merges and CPSR writes, by memory accesses
+// that may raise data aborts and by deadline checkpoints. Blocks with conditions other than AL resync no flags since
+// the condition fail path skips the block's instructions.
+class FlagsMaterializationAnalyzer {
+public:
+    FlagsMaterializationAnalyzer(std::pmr::memory_resource &alloc);
+
+    void Analyze(const BasicBlock &block, bool memAccessesMayAbort);
+
+    // NZCV flags copied from the host flags into CPSR before CPSR is observed.
+    arm::Flags ResyncedFlags() const {
+        return m_resyncedFlags;
+    }
+
+    // Flags copied into CPSR by the trailing sequence that may be deferred to the block's direct link, or None if the
+    // block has no such sequence.
+    arm::Flags DeferredFlags() const {
+        return m_deferredFlags;
+    }
+
+    // Determines if the op is part of the deferred sequence.
+    bool IsDeferred(const IROp *op) const {
+        return op != nullptr && (op == m_deferredLoad || op == m_deferredMerge || op == m_deferredStore);
+    }
+
+private:
+    // NZCV bits in each variable that were read from CPSR before being copied from the host flags
+    std::pmr::vector<arm::Flags> m_staleFlags;
+    std::pmr::vector<uint32_t> m_varReads;
+
+    arm::Flags m_resyncedFlags = arm::Flags::None;
+    arm::Flags m_deferredFlags = arm::Flags::None;
+    const IROp *m_deferredLoad = nullptr;
+    const IROp *m_deferredMerge = nullptr;
+    const IROp *m_deferredStore = nullptr;
+
+    void AnalyzeResync(const BasicBlock &block, bool memAccessesMayAbort);
+    void AnalyzeDeferral(const BasicBlock &block, bool memAccessesMayAbort);
+
+    arm::Flags StaleFlags(const VarOrImmArg &arg) const;
+    void SetStaleFlags(const VariableArg &arg, arm::Flags flags);
+};
+
+} // namespace armajitto::ir
@@ -0,0 +1,213 @@
+#include "loop_idiom_matcher.hpp"
+
+#include "util/bit_ops.hpp"
+
+#include <bit>
+
+namespace armajitto::ir {
+
+std::optional<BasicBlock::LoopIdiom> LoopIdiomMatcher::MatchARM(std::span<const uint32_t> opcodes, uint32_t address,
+                                                                arm::Mode mode) {
+    for (uint32_t bodySize = 2; bodySize < kMaxInstructions && bodySize < opcodes.size(); bodySize++) {
+        // The loop must be closed by a conditional branch back to the first instruction
+        const uint32_t branch = opcodes[bodySize];
+        const auto cond = static_cast<arm::Condition>(bit::extract<28, 4>(branch));
+        if ((branch & 0x0F000000) != 0x0A000000 || cond == arm::Condition::AL || cond == arm::Condition::NV) {
+            continue;
+        }
+        const uint32_t branchAddress = address + bodySize * sizeof(uint32_t);
+        const int32_t offset = bit::sign_extend<24>(bit::extract<0, 24>(branch)) * 4;
+        if (branchAddress + 8 + offset != address) {
+            continue;
+        }
+
+        Body body{};
+        bool valid = true;
+        for (uint32_t i = 0; i < bodySize && valid; i++) {
+            const uint32_t opcode = opcodes[i];
+            if (static_cast<arm::Condition>(bit::extract<28, 4>(opcode)) != arm::Condition::AL) {
+                valid = false;
+                break;
+            }
+
+            const uint8_t rn = bit::extract<16, 4>(opcode);
+            const uint8_t rd = bit::extract<12, 4>(opcode);
+            switch (bit::extract<20, 8>(opcode)) {
+            case 0x8B: // LDMIA Rn!, {...}
+            case 0x8A: // STMIA Rn!, {...}
+                valid = AddTransfer(body, {.load = bit::test(20, opcode),
+                                           .base = rn,
+                                           .regList = static_cast<uint16_t>(opcode & 0xFFFF),
+                                           .size = MemAccessSize::Word});
+                break;
+            case 0x49: // LDR Rd, [Rn], #4
+            case 0x48: // STR Rd, [Rn], #4
+                valid = (opcode & 0xFFF) == 4 && AddTransfer(body, {.load = bit::test(20, opcode),
+                                                                    .base = rn,
+                                                                    .regList = static_cast<uint16_t>(1u << rd),
+                                                                    .size = MemAccessSize::Word});
+                break;
+            case 0x4D: // LDRB Rd, [Rn], #1
+            case 0x4C: // STRB Rd, [Rn], #1
+                valid = (opcode & 0xFFF) == 1 && AddTransfer(body, {.load = bit::test(20, opcode),
+                                                                    .base = rn,
+                                                                    .regList = static_cast<uint16_t>(1u << rd),
+                                                                    .size = MemAccessSize::Byte});
+                break;
+            case 0x0D: // LDRH Rd, [Rn], #2
+            case 0x0C: // STRH Rd, [Rn], #2
+                valid = bit::extract<4, 4>(opcode) == 0b1011 && bit::extract<8, 4>(opcode) == 0 &&
+                        bit::extract<0, 4>(opcode) == 2 &&
+                        AddTransfer(body, {.load = bit::test(20, opcode),
+                                           .base = rn,
+                                           .regList = static_cast<uint16_t>(1u << rd),
+                                           .size = MemAccessSize::Half});
+                break;
+            case 0x25: // SUBS Rd, Rn, #imm
+            {
+                const uint32_t imm = std::rotr<uint32_t>(bit::extract<0, 8>(opcode), bit::extract<8, 4>(opcode) * 2);
+                valid = rn == rd && AddDecrement(body, {.reg = rd, .imm = imm});
+                break;
+            }
+            default: valid = false; break;
+            }
+        }
+        if (valid) {
+            return Build(body, cond, bodySize + 1, mode);
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<BasicBlock::LoopIdiom> LoopIdiomMatcher::MatchThumb(std::span<const uint16_t> opcodes, uint32_t address,
+                                                                  arm::Mode mode) {
+    for (uint32_t bodySize = 2; bodySize < kMaxInstructions && bodySize < opcodes.size(); bodySize++) {
+        // The loop must be closed by a conditional branch back to the first instruction
+        const uint16_t branch = opcodes[bodySize];
+        const auto cond = static_cast<arm::Condition>(bit::extract<8, 4>(branch));
+        if ((branch & 0xF000) != 0xD000 || cond == arm::Condition::AL || cond == arm::Condition::NV) {
+            continue;
+        }
+        const uint32_t branchAddress = address + bodySize * sizeof(uint16_t);
+        const int32_t offset = bit::sign_extend<8>(bit::extract<0, 8>(branch)) * 2;
+        if (branchAddress + 4 + offset != address) {
+            continue;
+        }
+
+        Body body{};
+        bool valid = true;
+        for (uint32_t i = 0; i < bodySize && valid; i++) {
+            const uint16_t opcode = opcodes[i];
+            if ((opcode & 0xF000) == 0xC000) {
+                // LDMIA/STMIA Rb!, {...}
+                valid = AddTransfer(body, {.load = bit::test(11, opcode),
+                                           .base = static_cast<uint8_t>(bit::extract<8, 3>(opcode)),
+                                           .regList = static_cast<uint16_t>(opcode & 0xFF),
+                                           .size = MemAccessSize::Word});
+            } else if ((opcode & 0xF800) == 0x3800) {
+                // SUB Rd, #imm8
+                valid = AddDecrement(body, {.reg = static_cast<uint8_t>(bit::extract<8, 3>(opcode)),
+                                            .imm = bit::extract<0, 8>(opcode)});
+            } else if ((opcode & 0xFE00) == 0x1E00) {
+                // SUB Rd, Rs, #imm3
+                const uint8_t rd = bit::extract<0, 3>(opcode);
+                const uint8_t rs = bit::extract<3, 3>(opcode);
+                valid = rd == rs && AddDecrement(body, {.reg = rd, .imm = bit::extract<6, 3>(opcode)});
+            } else {
+                valid = false;
+            }
+        }
+        if (valid) {
+            return Build(body, cond, bodySize + 1, mode);
+        }
+    }
+    return std::nullopt;
+}
+
+bool LoopIdiomMatcher::AddTransfer(Body &body, const Transfer &transfer) {
+    if (transfer.load) {
+        // Loads must precede the store
+        if (body.load || body.store) {
+            return false;
+        }
+        body.load = transfer;
+    } else {
+        if (body.store) {
+            return false;
+        }
+        body.store = transfer;
+    }
+    return true;
+}
+
+bool LoopIdiomMatcher::AddDecrement(Body &body, const Decrement &decrement) {
+    if (body.decrement) {
+        return false;
+    }
+    body.decrement = decrement;
+    return true;
+}
+
+std::optional<BasicBlock::LoopIdiom> LoopIdiomMatcher::Build(const Body &body, arm::Condition cond,
+                                                             uint32_t instrCount, arm::Mode mode) {
+    if (!body.store || !body.decrement) {
+        return std::nullopt;
+    }
+    const auto &store = *body.store;
+    const auto &decrement = *body.decrement;
+
+    // The iteration count can only be computed for loops that run while the counter is above the decrement
+    switch (cond) {
+    case arm::Condition::NE:
+    case arm::Condition::HI:
+    case arm::Condition::CS:
+        if (decrement.imm == 0) {
+            return std::nullopt;
+        }
+        break;
+    case arm::Condition::GT:
+    case arm::Condition::GE:
+        if (decrement.imm == 0 || decrement.imm > 0x7FFFFFFF) {
+            return std::nullopt;
+        }
+        break;
+    default: return std::nullopt;
+    }
+
+    // The transferred registers must not overlap with the pointers or the counter, and PC cannot be involved
+    constexpr uint8_t kPC = 15;
+    const uint16_t regList = store.regList;
+    auto isReserved = [&](uint8_t reg) { return reg == kPC || (regList & (1u << reg)); };
+    if (regList == 0 || (regList & (1u << kPC)) || isReserved(store.base) || isReserved(decrement.reg) ||
+        decrement.reg == store.base) {
+        return std::nullopt;
+    }
+    if (body.load) {
+        const auto &load = *body.load;
+        if (load.regList != regList || load.size != store.size || isReserved(load.base) || load.base == store.base ||
+            load.base == decrement.reg) {
+            return std::nullopt;
+        }
+    }
+
+    BasicBlock::LoopIdiom idiom{};
+    idiom.kind = body.load ? BasicBlock::LoopIdiom::Kind::Copy : BasicBlock::LoopIdiom::Kind::Fill;
+    idiom.size = store.size;
+    idiom.regList = regList;
+    if (body.load) {
+        idiom.src = GPRArg{static_cast<arm::GPR>(body.load->base), mode};
+    }
+    idiom.dst = GPRArg{static_cast<arm::GPR>(store.base), mode};
+    idiom.counter = GPRArg{static_cast<arm::GPR>(decrement.reg), mode};
+    switch (store.size) {
+    case MemAccessSize::Byte: idiom.bytesPerIteration = 1; break;
+    case MemAccessSize::Half: idiom.bytesPerIteration = 2; break;
+    case MemAccessSize::Word: idiom.bytesPerIteration = std::popcount(regList) * sizeof(uint32_t); break;
+    }
+    idiom.decrement = decrement.imm;
+    idiom.cond = cond;
+    idiom.instrCount = instrCount;
+    return idiom;
+}
+
+} // namespace armajitto::ir
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "basic_block.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace armajitto::ir {
+
+// Recognizes memory copy and fill loops from the guest instructions at the start of a block.
+//
+// Copy and fill loops consist of one or two memory transfers that advance their pointers, a counter decremented by a
+// constant, and a conditional branch back to the first instruction:
+//   loop:
+//     ldmia r1!, {r3-r6}   ; load and store instructions in this order; omitted in fill loops
+//     stmia r0!, {r3-r6}
+//     subs r2, r2, #16     ; may appear anywhere in the loop body
+//     bgt loop
+//
+// ARM loops may also use post-indexed LDR/STR instructions of any size, as long as the offset matches the transfer
+// size. Thumb loops must use LDMIA/STMIA since Thumb has no post-indexed transfers.
+//
+// The matcher only inspects the instruction encodings. The translator must make sure the block contains exactly the
+// loop body, and the host must validate the pointers at runtime.
+//
+// Software division routines are not recognized. Their loops leave the divisor, remainder and bit mask registers in
+// states that depend on the toolchain and unrolling factor, and their cycle counts depend on the operands, so an exact
+// replacement needs one matcher per routine. SWI-based divisions such as the BIOS Div call leave compiled code through
+// the exception path and are left to the system's HLE handler.
+class LoopIdiomMatcher {
+public:
+    // Maximum number of instructions in a recognized loop, including the branch
+    static constexpr uint32_t kMaxInstructions = 4;
+
+    // Matches a loop starting at <address> given the opcodes from that address onwards.
+    // <mode> is used to resolve banked registers.
+    static std::optional<BasicBlock::LoopIdiom> MatchARM(std::span<const uint32_t> opcodes, uint32_t address,
+                                                         arm::Mode mode);
+    static std::optional<BasicBlock::LoopIdiom> MatchThumb(std::span<const uint16_t> opcodes, uint32_t address,
+                                                           arm::Mode mode);
+
+private:
+    // Memory transfer that advances its base register by the size of the data transferred
+    struct Transfer {
+        bool load;
+        uint8_t base;
+        uint16_t regList;
+        MemAccessSize size;
+    };
+
+    // SUBS <reg>, <reg>, #<imm>
+    struct Decrement {
+        uint8_t reg;
+        uint32_t imm;
+    };
+
+    struct Body {
+        std::optional<Transfer> load;
+        std::optional<Transfer> store;
+        std::optional<Decrement> decrement;
+    };
+
+    static bool AddTransfer(Body &body, const Transfer &transfer);
+    static bool AddDecrement(Body &body, const Decrement &decrement);
+
+    // Validates the loop body and branch condition and builds the idiom.
+    static std::optional<BasicBlock::LoopIdiom> Build(const Body &body, arm::Condition cond, uint32_t instrCount,
+                                                      arm::Mode mode);
+};
+
+} // namespace armajitto::ir
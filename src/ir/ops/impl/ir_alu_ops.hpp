@@ -27,7 +27,7 @@ namespace detail {
             , setCarry(setCarry)
             , mnemonic(mnemonic) {}
 
-        std::string ToString() const final {
+        std::string ToString() const {
             return std::string(mnemonic) + (setCarry ? ".c" : "") + " " + dst.ToString() + ", " + value.ToString() +
                    ", " + amount.ToString();
         }
@@ -64,7 +64,7 @@ namespace detail {
             , mnemonic(mnemonic)
             , dstAlwaysShown(dstAlwaysShown) {}
 
-        std::string ToString() const final {
+        std::string ToString() const {
             auto flagsSuffix = arm::FlagsSuffixStr(flags, affectedFlags);
             if (dstAlwaysShown || dst.var.IsPresent()) {
                 return std::string(mnemonic) + flagsSuffix + " " + dst.ToString() + ", " + lhs.ToString() + ", " +
@@ -95,7 +95,7 @@ namespace detail {
             , flags(flags)
             , mnemonic(mnemonic) {}
 
-        std::string ToString() const final {
+        std::string ToString() const {
             auto flagsSuffix = arm::FlagsSuffixStr(flags, kAffectedFlags);
             return std::string(mnemonic) + flagsSuffix + " " + dst.ToString() + ", " + value.ToString();
         }
@@ -162,7 +162,7 @@ struct IRRotateRightExtendedOp : public IROpBase<IROpcodeType::RotateRightExtend
         , value(value)
         , setCarry(setCarry) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         return std::string("rrx") + (setCarry ? ".c" : "") + " " + dst.ToString() + ", " + value.ToString();
     }
 };
@@ -234,7 +234,7 @@ struct IRCountLeadingZerosOp : public IROpBase<IROpcodeType::CountLeadingZeros>
         : dst(dst)
         , value(value) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         return std::string("clz ") + dst.ToString() + ", " + value.ToString();
     }
 };
@@ -329,7 +329,7 @@ struct IRSignExtendHalfOp : public IROpBase<IROpcodeType::SignExtendHalf> {
         : dst(dst)
         , value(value) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         return std::string("sx.h ") + dst.ToString() + ", " + value.ToString();
     }
 };
@@ -376,7 +376,7 @@ struct IRMultiplyOp : public IROpBase<IROpcodeType::Multiply> {
         , signedMul(signedMul)
         , flags(setFlags ? arm::Flags::NZ : arm::Flags::None) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         auto flagsSuffix = arm::FlagsSuffixStr(flags, kAffectedFlags);
         return std::string(signedMul ? "s" : "u") + "mul" + flagsSuffix + " " + dst.ToString() + ", " + lhs.ToString() +
                ", " + rhs.ToString();
@@ -412,7 +412,7 @@ struct IRMultiplyLongOp : public IROpBase<IROpcodeType::MultiplyLong> {
         , shiftDownHalf(shiftDownHalf)
         , flags(setFlags ? arm::Flags::NZ : arm::Flags::None) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         auto flagsSuffix = arm::FlagsSuffixStr(flags, kAffectedFlags);
         return std::string(signedMul ? "s" : "u") + "mull" + (shiftDownHalf ? "h" : "") + flagsSuffix + " " +
                dstHi.ToString() + ":" + dstLo.ToString() + ", " + lhs.ToString() + ", " + rhs.ToString();
@@ -445,7 +445,7 @@ struct IRAddLongOp : public IROpBase<IROpcodeType::AddLong> {
         , rhsHi(rhsHi)
         , flags(setFlags ? arm::Flags::NZ : arm::Flags::None) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         auto flagsSuffix = arm::FlagsSuffixStr(flags, kAffectedFlags);
         return std::string("addl") + flagsSuffix + " " + dstHi.ToString() + ":" + dstLo.ToString() + ", " +
                lhsHi.ToString() + ":" + lhsLo.ToString() + ", " + rhsHi.ToString() + ":" + rhsLo.ToString();
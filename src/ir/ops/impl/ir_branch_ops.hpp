@@ -4,6 +4,9 @@
 
 #include "ir/defs/arguments.hpp"
 
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
 #include <string>
 
 namespace armajitto::ir {
@@ -20,7 +23,7 @@ struct IRBranchOp : public IROpBase<IROpcodeType::Branch> {
     IRBranchOp(VarOrImmArg address)
         : address(address) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         return std::string("b ") + address.ToString();
     }
 };
@@ -48,7 +51,7 @@ struct IRBranchExchangeOp : public IROpBase<IROpcodeType::BranchExchange> {
         : bxMode(bxMode)
         , address(address) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         std::string mnemonic;
         switch (bxMode) {
         case ExchangeMode::AddrBit0: mnemonic = "bx"; break;
@@ -60,4 +63,26 @@ struct IRBranchExchangeOp : public IROpBase<IROpcodeType::BranchExchange> {
     }
 };
 
+// Deadline checkpoint
+//   chkpt <imm:pc>, <imm:cycles>
+//
+// Leaves the block with PC set to <pc> if the cycle deadline is reached after counting the <cycles> taken by the
+// preceding instructions of the block. Otherwise, execution continues without counting any cycles.
+// This instruction observes all GPRs and PSRs, which must be up to date with the instructions preceding it.
+// Inserted between instructions by the translator to allow execution to stop in the middle of a block.
+struct IRCheckpointOp : public IROpBase<IROpcodeType::Checkpoint> {
+    uint32_t pc;
+    uint64_t cycles;
+
+    IRCheckpointOp(uint32_t pc, uint64_t cycles)
+        : pc(pc)
+        , cycles(cycles) {}
+
+    std::string ToString() const {
+        std::ostringstream oss;
+        oss << "chkpt #0x" << std::hex << std::uppercase << pc << ", #" << std::dec << cycles;
+        return oss.str();
+    }
+};
+
 } // namespace armajitto::ir
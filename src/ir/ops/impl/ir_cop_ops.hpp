@@ -27,7 +27,7 @@ struct IRLoadCopRegisterOp : public IROpBase<IROpcodeType::LoadCopRegister> {
         , reg(reg)
         , ext(ext) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         return std::string(ext ? "mrc2" : "mrc") + " " + dstValue.ToString() //
                + ", " + std::to_string(cpnum)                                //
                + ", " + std::to_string(reg.opcode1)                          //
@@ -53,7 +53,7 @@ struct IRStoreCopRegisterOp : public IROpBase<IROpcodeType::StoreCopRegister> {
         , reg(reg)
         , ext(ext) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         return std::string(ext ? "mcr2" : "mcr") + " " + srcValue.ToString() //
                + ", " + std::to_string(cpnum)                                //
                + ", " + std::to_string(reg.opcode1)                          //
@@ -22,7 +22,7 @@ struct IRStoreFlagsOp : public IROpBase<IROpcodeType::StoreFlags> {
         : flags(flags)
         , values(values) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         auto flagsSuffix = arm::FlagsSuffixStr(flags, flags);
         if (values.immediate) {
             auto flagsVal = static_cast<arm::Flags>(values.imm.value);
@@ -48,7 +48,7 @@ struct IRLoadFlagsOp : public IROpBase<IROpcodeType::LoadFlags> {
         , dstCPSR(dstCPSR)
         , srcCPSR(srcCPSR) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         auto flagsSuffix = arm::FlagsSuffixStr(flags, flags);
         return std::string("ldflg") + flagsSuffix + " " + dstCPSR.ToString() + ", " + srcCPSR.ToString();
     }
@@ -68,7 +68,7 @@ struct IRLoadStickyOverflowOp : public IROpBase<IROpcodeType::LoadStickyOverflow
         , dstCPSR(dstCPSR)
         , srcCPSR(srcCPSR) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         return std::string(setQ ? "ldflg.q" : "ldflg") + " " + dstCPSR.ToString() + ", " + srcCPSR.ToString();
     }
 };
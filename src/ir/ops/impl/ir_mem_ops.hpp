@@ -31,6 +31,17 @@ struct IRMemReadOp : public IROpBase<IROpcodeType::MemRead> {
     VariableArg dst;
     VarOrImmArg address;
 
+    // Index of the guest instruction that issued this access within the block.
+    // Used to compute the faulting address when the access aborts.
+    uint32_t instrIndex = 0;
+
+    // Cycles counted when the access aborts: the cycles of the block up to this access plus the pipeline refill at the
+    // data abort vector.
+    uint64_t abortCycles = 0;
+
+    // Cycle timing of this access.
+    MemAccessTiming timing;
+
     IRMemReadOp(MemAccessBus bus, MemAccessMode mode, MemAccessSize size, VariableArg dst, VarOrImmArg address)
         : bus(bus)
         , mode(mode)
@@ -38,7 +49,7 @@ struct IRMemReadOp : public IROpBase<IROpcodeType::MemRead> {
         , dst(dst)
         , address(address) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         char busStr;
         switch (bus) {
         case MemAccessBus::Code: busStr = 'c'; break;
@@ -78,12 +89,23 @@ struct IRMemWriteOp : public IROpBase<IROpcodeType::MemWrite> {
     VarOrImmArg src;
     VarOrImmArg address;
 
+    // Index of the guest instruction that issued this access within the block.
+    // Used to compute the faulting address when the access aborts.
+    uint32_t instrIndex = 0;
+
+    // Cycles counted when the access aborts: the cycles of the block up to this access plus the pipeline refill at the
+    // data abort vector.
+    uint64_t abortCycles = 0;
+
+    // Cycle timing of this access.
+    MemAccessTiming timing;
+
     IRMemWriteOp(MemAccessSize size, VarOrImmArg src, VarOrImmArg address)
         : size(size)
         , src(src)
         , address(address) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         char sizeStr;
         switch (size) {
         case MemAccessSize::Byte: sizeStr = 'b'; break;
@@ -106,7 +128,7 @@ struct IRPreloadOp : public IROpBase<IROpcodeType::Preload> {
     IRPreloadOp(VarOrImmArg address)
         : address(address) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         return std::string("pld [") + address.ToString() + "]";
     }
 };
@@ -22,7 +22,7 @@ struct IRConstantOp : public IROpBase<IROpcodeType::Constant> {
         : dst(dst)
         , value(value) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         std::ostringstream oss;
         oss << "const " << dst.ToString() << ", #0x" << std::hex << std::uppercase << value;
         return oss.str();
@@ -41,7 +41,7 @@ struct IRCopyVarOp : public IROpBase<IROpcodeType::CopyVar> {
         : dst(dst)
         , var(var) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         return std::string("copy ") + dst.ToString() + ", " + var.ToString();
     }
 };
@@ -56,7 +56,7 @@ struct IRGetBaseVectorAddressOp : public IROpBase<IROpcodeType::GetBaseVectorAdd
     IRGetBaseVectorAddressOp(VariableArg dst)
         : dst(dst) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         return std::string("ld.xvb ") + dst.ToString();
     }
 };
@@ -20,7 +20,7 @@ struct IRGetRegisterOp : public IROpBase<IROpcodeType::GetRegister> {
         : dst(dst)
         , src(src) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         return std::string("ld ") + dst.ToString() + ", " + src.ToString();
     }
 };
@@ -37,7 +37,7 @@ struct IRSetRegisterOp : public IROpBase<IROpcodeType::SetRegister> {
         : dst(dst)
         , src(src) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         return std::string("st ") + dst.ToString() + ", " + src.ToString();
     }
 };
@@ -52,7 +52,7 @@ struct IRGetCPSROp : public IROpBase<IROpcodeType::GetCPSR> {
     IRGetCPSROp(VariableArg dst)
         : dst(dst) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         return std::string("ld ") + dst.ToString() + ", cpsr";
     }
 };
@@ -61,7 +61,7 @@ struct IRGetCPSROp : public IROpBase<IROpcodeType::GetCPSR> {
 //   st cpsr[.i], <var/imm:src>
 //
 // Copies the value of <src> into CPSR.
-// Also updates the host I flag if [i] is specified.
+// Also updates the host I and F flags if [i] is specified.
 struct IRSetCPSROp : public IROpBase<IROpcodeType::SetCPSR> {
     VarOrImmArg src;
     bool updateIFlag;
@@ -70,7 +70,7 @@ struct IRSetCPSROp : public IROpBase<IROpcodeType::SetCPSR> {
         : src(src)
         , updateIFlag(updateIFlag) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         return std::string(updateIFlag ? "st cpsr.i" : "st cpsr") + ", " + src.ToString();
     }
 };
@@ -87,7 +87,7 @@ struct IRGetSPSROp : public IROpBase<IROpcodeType::GetSPSR> {
         : dst(dst)
         , mode(mode) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         return std::string("ld ") + dst.ToString() + ", spsr_" + ::armajitto::arm::ToString(mode);
     }
 };
@@ -104,7 +104,7 @@ struct IRSetSPSROp : public IROpBase<IROpcodeType::SetSPSR> {
         : mode(mode)
         , src(src) {}
 
-    std::string ToString() const final {
+    std::string ToString() const {
         return std::string("st spsr_") + ::armajitto::arm::ToString(mode) + ", " + src.ToString();
     }
 };
@@ -0,0 +1,11 @@
+#include "ir_ops_base.hpp"
+
+#include "ir_ops_visitor.hpp"
+
+namespace armajitto::ir {
+
+std::string IROp::ToString() const {
+    return VisitIROp(this, [](const auto *op) -> std::string { return op->ToString(); });
+}
+
+} // namespace armajitto::ir
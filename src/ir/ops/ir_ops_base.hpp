@@ -12,7 +12,8 @@ struct IROp {
     IROp(IROpcodeType type)
         : type(type) {}
 
-    virtual std::string ToString() const = 0;
+    // Formats the op as text. Dispatches on the opcode type instead of a vtable to keep ops compact.
+    std::string ToString() const;
 
     IROp *Prev() {
         return prev;
@@ -46,6 +46,7 @@ ReturnType VisitIROp(IROp *op, Visitor &&visitor) {
         case IROpcodeType::LoadStickyOverflow: return visitor(Cast<IRLoadStickyOverflowOp>(op));
         case IROpcodeType::Branch: return visitor(Cast<IRBranchOp>(op));
         case IROpcodeType::BranchExchange: return visitor(Cast<IRBranchExchangeOp>(op));
+        case IROpcodeType::Checkpoint: return visitor(Cast<IRCheckpointOp>(op));
         case IROpcodeType::LoadCopRegister: return visitor(Cast<IRLoadCopRegisterOp>(op));
         case IROpcodeType::StoreCopRegister: return visitor(Cast<IRStoreCopRegisterOp>(op));
         case IROpcodeType::Constant: return visitor(Cast<IRConstantOp>(op));
@@ -129,7 +130,7 @@ namespace detail {
 
     template <bool writesFirst, typename Visitor>
     void VisitIROpVars(ir::IRMemWriteOp *op, Visitor &&visitor) {
-        VisitVar(op, op->src, false, visitor);
+        VisitVar(op, op->src, true, visitor);
         VisitVar(op, op->address, true, visitor);
     }
 
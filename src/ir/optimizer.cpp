@@ -2,6 +2,7 @@
 
 #include "optimizer/arithmetic_ops_coalescence.hpp"
 #include "optimizer/bitwise_ops_coalescence.hpp"
+#include "optimizer/common_subexpression_elimination.hpp"
 #include "optimizer/const_propagation.hpp"
 #include "optimizer/dead_flag_value_store_elimination.hpp"
 #include "optimizer/dead_gpr_store_elimination.hpp"
@@ -9,24 +10,50 @@
 #include "optimizer/dead_reg_store_elimination.hpp"
 #include "optimizer/dead_var_store_elimination.hpp"
 #include "optimizer/host_flags_ops_coalescence.hpp"
-// #include "optimizer/var_lifetime_opt.hpp"
+#include "optimizer/redundant_load_elimination.hpp"
+#include "optimizer/var_lifetime_opt.hpp"
 
 #include "emitter.hpp"
 #include "ir/ops/ir_ops_visitor.hpp"
+#include "polling_loop_analyzer.hpp"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <memory_resource>
 
 namespace armajitto::ir {
 
-bool Optimizer::Optimize(BasicBlock &block) {
-    bool optimized = DoOptimizations(block);
+bool Optimizer::Optimize(BasicBlock &block, CompilerStatistics::Optimizer *stats) {
+    m_dependsOnMemMap = false;
+    bool optimized = DoOptimizations(block, stats);
     DetectIdleLoops(block);
     return optimized;
 }
 
-bool Optimizer::DoOptimizations(BasicBlock &block) {
+// Runs an optimization pass and accumulates its statistics
+static bool RunPass(OptimizerPassBase &pass, const Emitter &emitter, CompilerStatistics::Optimizer::Pass &stats) {
+    const uint64_t erasedBefore = emitter.ErasedOpCount();
+    const uint64_t replacedBefore = emitter.ReplacedOpCount();
+    const auto start = std::chrono::steady_clock::now();
+    const bool changed = pass.Optimize();
+    const auto end = std::chrono::steady_clock::now();
+
+    ++stats.invocations;
+    if (changed) {
+        ++stats.changedInvocations;
+    }
+    stats.opsRemoved += emitter.ErasedOpCount() - erasedBefore;
+    stats.opsReplaced += emitter.ReplacedOpCount() - replacedBefore;
+    stats.timeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    return changed;
+}
+
+bool Optimizer::DoOptimizations(BasicBlock &block, CompilerStatistics::Optimizer *stats) {
     Emitter emitter{block};
     ConstPropagationOptimizerPass constPropPass{emitter, m_pmrBuffer};
+    CommonSubexpressionEliminationOptimizerPass cseElimPass{emitter, m_pmrBuffer};
+    RedundantLoadEliminationOptimizerPass redundantLoadElimPass{emitter, m_context, m_options, m_pmrBuffer};
     DeadRegisterStoreEliminationOptimizerPass deadRegStoreElimPass{emitter, m_pmrBuffer};
     DeadGPRStoreEliminationOptimizerPass deadGPRStoreElimPass{emitter};
     DeadHostFlagStoreEliminationOptimizerPass deadHostFlagStoreElimPass{emitter};
@@ -34,48 +61,80 @@ bool Optimizer::DoOptimizations(BasicBlock &block) {
     DeadVarStoreEliminationOptimizerPass deadVarStoreElimPass{emitter, m_pmrBuffer};
     BitwiseOpsCoalescenceOptimizerPass bitwiseCoalescencePass{emitter, m_pmrBuffer};
     ArithmeticOpsCoalescenceOptimizerPass arithmeticCoalescencePass{emitter, m_pmrBuffer};
-    HostFlagsOpsCoalescenceOptimizerPass hostFlagsCoalescencePass{emitter};
-    // VarLifetimeOptimizerPass varLifetimeOptimizerPass{emitter, m_pmrBuffer};
+    HostFlagsOpsCoalescenceOptimizerPass hostFlagsCoalescencePass{emitter, m_pmrBuffer};
+    VarLifetimeOptimizerPass varLifetimeOptimizerPass{emitter, m_pmrBuffer};
+
+    // Passes run in rounds until a round makes no changes, with dirty tracking at the granularity of whole passes.
+    // Every change made by a pass bumps the block version. A pass is skipped if the block is unchanged since it last
+    // ran without making changes; passes are deterministic, so that run would be a no-op.
+    // This reaches the same fixpoint as rerunning every pass each round and mostly saves the confirming runs at the
+    // end. It is not an op-level worklist: there are no def-use chains, and every pass that runs still scans the whole
+    // block and renames variables when it is done.
+    struct ScheduledPass {
+        bool enabled;
+        OptimizerPassBase &pass;
+        uint64_t cleanVersion = 0; // last block version the pass ran on without making changes
+    };
+    // Must be listed in the same order as the OptimizerPass enum
+    std::array<ScheduledPass, kNumOptimizerPasses> passes{{
+        {m_options.passes.constantPropagation, constPropPass},
+        {m_options.passes.commonSubexpressionElimination, cseElimPass},
+        // Eliminating reads would skip cache line fills
+        {m_options.passes.redundantLoadElimination && !m_compilerOptions.cacheTimingModel, redundantLoadElimPass},
+        {m_options.passes.deadRegisterStoreElimination, deadRegStoreElimPass},
+        {m_options.passes.deadGPRStoreElimination, deadGPRStoreElimPass},
+        {m_options.passes.deadHostFlagStoreElimination, deadHostFlagStoreElimPass},
+        {m_options.passes.deadFlagValueStoreElimination, deadFlagValueStoreElimPass},
+        {m_options.passes.deadVariableStoreElimination, deadVarStoreElimPass},
+        {m_options.passes.bitwiseOpsCoalescence, bitwiseCoalescencePass},
+        {m_options.passes.arithmeticOpsCoalescence, arithmeticCoalescencePass},
+        {m_options.passes.hostFlagsOpsCoalescence, hostFlagsCoalescencePass},
+        {m_options.passes.varLifetimeOptimization, varLifetimeOptimizerPass},
+    }};
 
     bool optimized = false;
+    uint64_t version = 1;
     int maxIters = m_options.maxIterations;
-    for (int i = 0; i < maxIters; i++) {
-        bool dirty = false;
-        if (m_options.passes.constantPropagation) {
-            dirty |= constPropPass.Optimize();
-        }
-        if (m_options.passes.deadRegisterStoreElimination) {
-            dirty |= deadRegStoreElimPass.Optimize();
-        }
-        if (m_options.passes.deadGPRStoreElimination) {
-            dirty |= deadGPRStoreElimPass.Optimize();
-        }
-        if (m_options.passes.deadHostFlagStoreElimination) {
-            dirty |= deadHostFlagStoreElimPass.Optimize();
-        }
-        if (m_options.passes.deadFlagValueStoreElimination) {
-            dirty |= deadFlagValueStoreElimPass.Optimize();
-        }
-        if (m_options.passes.deadVariableStoreElimination) {
-            dirty |= deadVarStoreElimPass.Optimize();
-        }
-        if (m_options.passes.bitwiseOpsCoalescence) {
-            dirty |= bitwiseCoalescencePass.Optimize();
-        }
-        if (m_options.passes.arithmeticOpsCoalescence) {
-            dirty |= arithmeticCoalescencePass.Optimize();
-        }
-        if (m_options.passes.hostFlagsOpsCoalescence) {
-            dirty |= hostFlagsCoalescencePass.Optimize();
+    int iters = 0;
+    bool fixpoint = false;
+    for (; iters < maxIters; iters++) {
+        bool ran = false;
+        for (size_t passIndex = 0; passIndex < passes.size(); passIndex++) {
+            auto &scheduled = passes[passIndex];
+            if (!scheduled.enabled || scheduled.cleanVersion == version) {
+                continue;
+            }
+            ran = true;
+            bool changed;
+            if (stats != nullptr) {
+                changed = RunPass(scheduled.pass, emitter, stats->passes[passIndex]);
+            } else {
+                changed = scheduled.pass.Optimize();
+            }
+            if (changed) {
+                ++version;
+                optimized = true;
+            } else {
+                scheduled.cleanVersion = version;
+            }
         }
-        /*if (m_options.passes.varLifetimeOptimization) {
-            dirty |= varLifetimeOptimizerPass.Optimize();
-        }*/
-        optimized |= dirty;
-        if (!dirty) {
+        if (!ran) {
+            fixpoint = true;
             break;
         }
-    };
+    }
+
+    if (redundantLoadElimPass.DependsOnMemoryMap()) {
+        m_dependsOnMemMap = true;
+    }
+
+    if (stats != nullptr) {
+        stats->totalIterations += iters;
+        stats->maxIterations = std::max<uint64_t>(stats->maxIterations, iters);
+        if (!fixpoint) {
+            ++stats->unfinishedBlocks;
+        }
+    }
     return optimized;
 }
 
@@ -89,10 +148,10 @@ void Optimizer::DetectIdleLoops(ir::BasicBlock &block) {
     // - Branches back to the beginning of the block
     // - Produces no side-effects, including writes to memory, coprocessor registers or CPSR
     // - Only modifies registers read from within the block
+    uint16_t writtenRegs = 0;
+    uint16_t disallowedRegs = 0;
     ir::IROp *op = block.Head();
     while (op != nullptr) {
-        uint16_t writtenRegs = 0;
-        uint16_t disallowedRegs = 0;
         auto result = VisitIROp(op, [&](auto *op) {
             using TOp = std::decay_t<std::remove_cvref_t<decltype(*op)>>;
             if constexpr (std::is_same_v<TOp, ir::IRBranchOp> || std::is_same_v<TOp, ir::IRBranchExchangeOp>) {
@@ -130,11 +189,59 @@ void Optimizer::DetectIdleLoops(ir::BasicBlock &block) {
             if (result == Result::Confirmed) {
                 ir::Emitter emitter{block};
                 emitter.TerminateIdleLoop();
+                return;
             }
             break;
         }
         op = op->Next();
     }
+
+    // Check for loops spanning several blocks, such as MMIO polling loops
+    DetectPollingLoop(block);
+}
+
+bool Optimizer::DetectPollingLoop(ir::BasicBlock &block) {
+    // Limits on the size of the loop body preceding the block
+    static constexpr uint32_t kMaxPrecedingBlocks = 4;
+    static constexpr uint32_t kMaxPrecedingInstructions = 16;
+
+    // Check for a branch back to a preceding instruction
+    const auto loc = block.Location();
+    const auto entry = block.GetTerminalLocation();
+    const uint32_t opcodeSize = loc.IsThumbMode() ? sizeof(uint16_t) : sizeof(uint32_t);
+    if (block.GetTerminal() != ir::BasicBlock::Terminal::DirectLink || entry.Mode() != loc.Mode() ||
+        entry.IsThumbMode() != loc.IsThumbMode() || entry.PC() >= loc.PC() ||
+        loc.PC() - entry.PC() > kMaxPrecedingInstructions * opcodeSize) {
+        return false;
+    }
+
+    // Translate and analyze the blocks from the loop entry up to this block
+    PollingLoopAnalyzer analyzer{m_context, m_pmrBuffer};
+    auto next = entry;
+    for (uint32_t count = 0; next.PC() != loc.PC(); count++) {
+        if (count == kMaxPrecedingBlocks || next.PC() > loc.PC()) {
+            return false;
+        }
+        ir::BasicBlock precedingBlock{m_alloc, next};
+        m_translator.Translate(precedingBlock);
+        const bool skippable = analyzer.Analyze(precedingBlock, false);
+        next = precedingBlock.NextLocation();
+        precedingBlock.Clear();
+        if (!skippable) {
+            return false;
+        }
+    }
+    if (!analyzer.Analyze(block, true)) {
+        return false;
+    }
+
+    if (analyzer.DependsOnMemoryMap()) {
+        m_dependsOnMemMap = true;
+    }
+
+    ir::Emitter emitter{block};
+    emitter.TerminateIdleLoop(analyzer.Guards());
+    return true;
 }
 
 } // namespace armajitto::ir
@@ -2,8 +2,12 @@
 
 #include "armajitto/core/context.hpp"
 #include "armajitto/core/options.hpp"
+#include "armajitto/core/statistics.hpp"
+
+#include "core/allocator.hpp"
 
 #include "basic_block.hpp"
+#include "translator.hpp"
 
 #include <memory_resource>
 
@@ -11,21 +15,40 @@ namespace armajitto::ir {
 
 class Optimizer {
 public:
-    Optimizer(const Context &context, Options::Optimizer &options, std::pmr::memory_resource &pmrBuffer)
+    // The translator and allocator are used to analyze the blocks preceding loops that span several blocks.
+    Optimizer(Context &context, Options &options, Translator &translator, memory::Allocator &alloc,
+              std::pmr::memory_resource &pmrBuffer)
         : m_context(context)
-        , m_options(options)
+        , m_options(options.optimizer)
+        , m_compilerOptions(options.compiler)
+        , m_translator(translator)
+        , m_alloc(alloc)
         , m_pmrBuffer(pmrBuffer) {}
 
-    bool Optimize(BasicBlock &block);
+    // Optimizes the block. If <stats> is not null, per-pass statistics are accumulated into it.
+    bool Optimize(BasicBlock &block, CompilerStatistics::Optimizer *stats = nullptr);
+
+    // Determines if the last optimized block relies on the current layout of the data memory map.
+    // Such blocks must be discarded when the memory map changes.
+    bool DependsOnMemoryMap() const {
+        return m_dependsOnMemMap;
+    }
 
 private:
-    const Context &m_context;
+    Context &m_context;
     Options::Optimizer &m_options;
+    const Options::Compiler &m_compilerOptions;
+
+    Translator &m_translator;
+    memory::Allocator &m_alloc;
 
     std::pmr::memory_resource &m_pmrBuffer;
 
-    bool DoOptimizations(BasicBlock &block);
+    bool m_dependsOnMemMap = false;
+
+    bool DoOptimizations(BasicBlock &block, CompilerStatistics::Optimizer *stats);
     void DetectIdleLoops(BasicBlock &block);
+    bool DetectPollingLoop(BasicBlock &block);
 };
 
 } // namespace armajitto::ir
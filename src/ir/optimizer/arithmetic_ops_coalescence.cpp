@@ -456,7 +456,10 @@ auto ArithmeticOpsCoalescenceOptimizerPass::DeriveValue(VariableArg var, Variabl
         dstValue.negated = srcValue.negated;
         srcValue.derived = true;
     } else {
+        // Start a new chain; the value may hold stale state from an earlier analysis of the same op
         dstValue.source = src.var;
+        dstValue.runningSum = 0;
+        dstValue.negated = false;
     }
     return &dstValue;
 }
@@ -493,8 +496,17 @@ void ArithmeticOpsCoalescenceOptimizerPass::ConsumeValues(IROp *op, Args &...arg
         ...);
     std::sort(m_sortedVars.begin(), m_sortedVars.end(),
               [](const Variable *lhs, const Variable *rhs) { return lhs->Index() < rhs->Index(); });
+    // The same variable may appear in several arguments; consume it once and give the others the same replacement
+    Variable *prevVar = nullptr;
+    size_t prevIndex = 0;
     for (auto *var : m_sortedVars) {
+        if (prevVar != nullptr && var->Index() == prevIndex) {
+            *var = *prevVar;
+            continue;
+        }
+        prevIndex = var->Index();
         ConsumeValue(op, *var);
+        prevVar = var;
     }
 }
 
@@ -521,6 +533,11 @@ void ArithmeticOpsCoalescenceOptimizerPass::ConsumeValue(IROp *op, Variable &var
         return;
     }
 
+    // An earlier consumer already rewrote the sequence; later ops read the variable or its substitute as is
+    if (value->consumed) {
+        return;
+    }
+
     // Mark this value as consumed
     value->consumed = true;
 
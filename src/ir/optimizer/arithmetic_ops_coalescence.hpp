@@ -86,6 +86,7 @@ private:
     void Process(IRLoadStickyOverflowOp *op) final;
     void Process(IRBranchOp *op) final;
     void Process(IRBranchExchangeOp *op) final;
+    // void Process(IRCheckpointOp *op) final;
     // void Process(IRLoadCopRegisterOp *op) final;
     void Process(IRStoreCopRegisterOp *op) final;
     // void Process(IRConstantOp *op) final;
@@ -493,6 +493,8 @@ void BitwiseOpsCoalescenceOptimizerPass::CopyValue(VariableArg var, VariableArg
     dstValue = srcValue;
     dstValue.prev = src.var;
     dstValue.writerOp = op;
+    dstValue.derivations = 0;
+    ++srcValue.derivations;
 }
 
 auto BitwiseOpsCoalescenceOptimizerPass::DeriveValue(VariableArg var, VariableArg src, IROp *op) -> Value * {
@@ -511,6 +513,10 @@ auto BitwiseOpsCoalescenceOptimizerPass::DeriveValue(VariableArg var, VariableAr
     dstValue.valid = false; // Not yet valid
     dstValue.prev = src.var;
     dstValue.writerOp = op;
+    dstValue.derivations = 0;
+    if (srcIndex < m_values.size()) {
+        ++m_values[srcIndex].derivations;
+    }
     if (srcIndex < m_values.size() && m_values[srcIndex].valid && !m_values[srcIndex].consumed) {
         auto &srcValue = m_values[srcIndex];
         dstValue.source = srcValue.source;
@@ -519,7 +525,12 @@ auto BitwiseOpsCoalescenceOptimizerPass::DeriveValue(VariableArg var, VariableAr
         dstValue.flippedBits = srcValue.flippedBits;
         dstValue.rotateOffset = srcValue.rotateOffset;
     } else {
+        // Start a new chain; the value may hold stale state from an earlier analysis of the same op
         dstValue.source = src.var;
+        dstValue.knownBitsMask = 0;
+        dstValue.knownBitsValue = 0;
+        dstValue.flippedBits = 0;
+        dstValue.rotateOffset = 0;
     }
     return &dstValue;
 }
@@ -565,8 +576,17 @@ void BitwiseOpsCoalescenceOptimizerPass::ConsumeValues(IROp *op, Args &...args)
         ...);
     std::sort(sortedVars.begin(), sortedVars.end(),
               [](const Variable *lhs, const Variable *rhs) { return lhs->Index() < rhs->Index(); });
+    // The same variable may appear in several arguments; consume it once and give the others the same replacement
+    Variable *prevVar = nullptr;
+    size_t prevIndex = 0;
     for (auto *var : sortedVars) {
+        if (prevVar != nullptr && var->Index() == prevIndex) {
+            *var = *prevVar;
+            continue;
+        }
+        prevIndex = var->Index();
         ConsumeValue(op, *var);
+        prevVar = var;
     }
 }
 
@@ -591,8 +611,14 @@ void BitwiseOpsCoalescenceOptimizerPass::ConsumeValue(IROp *op, Variable &var) {
         return;
     }
 
+    // An earlier consumer already rewrote the sequence; later ops read the variable or its substitute as is
+    if (value->consumed) {
+        return;
+    }
+
     // Mark this value as consumed
     value->consumed = true;
+    const auto valueIndex = var.Index();
 
     // Reanalyze the value in a previous value in the chain was consumed
     if (value->prev != value->source) {
@@ -620,6 +646,19 @@ void BitwiseOpsCoalescenceOptimizerPass::ConsumeValue(IROp *op, Variable &var) {
             var = chainValue->prev;
             chainValue = GetValue(chainValue->prev);
         }
+
+        // Reanalysis may grow the value list or fail to derive the value again, in which case its writer must be kept
+        // as is. This happens with ASR when the sign bit was only known from the consumed part of the chain.
+        value = &m_values[valueIndex];
+        if (!value->valid) {
+            return;
+        }
+    }
+
+    // Instructions processed earlier derived other values from this variable, so it must remain defined. Only a
+    // constant definition can replace its writer in that case.
+    if (value->derivations > 0 && value->knownBitsMask != ~0) {
+        return;
     }
 
     bool match = false;
@@ -728,7 +767,7 @@ void BitwiseOpsCoalescenceOptimizerPass::ConsumeValue(IROp *op, Variable &var) {
     if (!match) {
         auto var = value->prev;
         value = GetValue(value->prev);
-        while (value != nullptr && value->valid && !value->consumed && !value->chained &&
+        while (value != nullptr && value->valid && !value->consumed && !value->chained && value->derivations <= 1 &&
                m_varLifetimes.IsExpired(var)) {
             m_emitter.Erase(value->writerOp);
             var = value->prev;
@@ -145,6 +145,7 @@ private:
     void Process(IRLoadStickyOverflowOp *op) final;
     void Process(IRBranchOp *op) final;
     void Process(IRBranchExchangeOp *op) final;
+    // void Process(IRCheckpointOp *op) final;
     // void Process(IRLoadCopRegisterOp *op) final;
     void Process(IRStoreCopRegisterOp *op) final;
     void Process(IRConstantOp *op) final;
@@ -168,6 +169,10 @@ private:
         bool consumed = false; // Indicates if this value was consumed, to prevent overoptimization
         bool chained = false;  // Indicates if this value is part of a consumed chain, to prevent overoptimization
 
+        // Number of instructions that derived or copied other values from this value. Their inputs must remain
+        // defined, so this is preserved across resets.
+        uint32_t derivations = 0;
+
         void Reset() {
             valid = false;
             knownBitsMask = 0;
@@ -0,0 +1,243 @@
+#include "common_subexpression_elimination.hpp"
+
+#include "ir/ops/ir_ops_visitor.hpp"
+
+#include <utility>
+
+namespace armajitto::ir {
+
+CommonSubexpressionEliminationOptimizerPass::CommonSubexpressionEliminationOptimizerPass(
+    Emitter &emitter, std::pmr::memory_resource &alloc)
+    : OptimizerPassBase(emitter)
+    , m_expressions(&alloc)
+    , m_varSubst(emitter.VariableCount(), alloc) {}
+
+void CommonSubexpressionEliminationOptimizerPass::Reset() {
+    m_expressions.clear();
+    m_gprValues.fill({});
+    m_spsrValues.fill({});
+    m_cpsrValue = {};
+    m_baseVectorAddressValue = {};
+    m_varSubst.Reset();
+}
+
+void CommonSubexpressionEliminationOptimizerPass::PreProcess(IROp *op) {
+    MarkDirty(m_varSubst.Substitute(op));
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRGetRegisterOp *op) {
+    ReadRegister(m_gprValues[op->src.Index()], op->dst);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRSetRegisterOp *op) {
+    WriteRegister(m_gprValues[op->dst.Index()], op->src);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRGetCPSROp *op) {
+    ReadRegister(m_cpsrValue, op->dst);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRSetCPSROp *op) {
+    // Mode switches and I flag updates may be applied on top of the written value
+    m_cpsrValue = {};
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRGetSPSROp *op) {
+    ReadRegister(m_spsrValues[arm::NormalizedIndex(op->mode)], op->dst);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRSetSPSROp *op) {
+    WriteRegister(m_spsrValues[arm::NormalizedIndex(op->mode)], op->src);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRLogicalShiftLeftOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->value, op->amount, false), op->setCarry);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRLogicalShiftRightOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->value, op->amount, false), op->setCarry);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRArithmeticShiftRightOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->value, op->amount, false), op->setCarry);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRRotateRightOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->value, op->amount, false), op->setCarry);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRBitwiseAndOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->lhs, op->rhs, true), op->flags != arm::Flags::None);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRBitwiseOrOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->lhs, op->rhs, true), op->flags != arm::Flags::None);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRBitwiseXorOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->lhs, op->rhs, true), op->flags != arm::Flags::None);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRBitClearOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->lhs, op->rhs, false), op->flags != arm::Flags::None);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRCountLeadingZerosOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->value, {}, false), false);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRAddOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->lhs, op->rhs, true), op->flags != arm::Flags::None);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRSubtractOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->lhs, op->rhs, false), op->flags != arm::Flags::None);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRMoveOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->value, {}, false), op->flags != arm::Flags::None);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRMoveNegatedOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->value, {}, false), op->flags != arm::Flags::None);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRSignExtendHalfOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->value, {}, false), false);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRSaturatingAddOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->lhs, op->rhs, true), op->flags != arm::Flags::None);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRSaturatingSubtractOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->lhs, op->rhs, false), op->flags != arm::Flags::None);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRMultiplyOp *op) {
+    Number(op->dst, MakeExpression(op->type, op->lhs, op->rhs, true, op->signedMul),
+           op->flags != arm::Flags::None);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRMultiplyLongOp *op) {
+    const uint8_t params = (op->signedMul ? 1 : 0) | (op->shiftDownHalf ? 2 : 0);
+    const auto expr = MakeExpression(op->type, op->lhs, op->rhs, true, params);
+    auto [it, inserted] = m_expressions.try_emplace(expr, Value{op->dstLo.var, op->dstHi.var});
+    if (inserted) {
+        return;
+    }
+
+    // Every output of this instruction must be available in the existing value
+    auto &value = it->second;
+    const bool loAvailable = !op->dstLo.var.IsPresent() || value.lo.IsPresent();
+    const bool hiAvailable = !op->dstHi.var.IsPresent() || value.hi.IsPresent();
+    if (op->flags != arm::Flags::None || !loAvailable || !hiAvailable) {
+        // Fill in the missing halves for subsequent instructions
+        if (!value.lo.IsPresent()) {
+            value.lo = op->dstLo.var;
+        }
+        if (!value.hi.IsPresent()) {
+            value.hi = op->dstHi.var;
+        }
+        return;
+    }
+
+    m_varSubst.Assign(op->dstLo, value.lo);
+    m_varSubst.Assign(op->dstHi, value.hi);
+    m_emitter.Erase(op);
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRBranchOp *op) {
+    m_gprValues[static_cast<size_t>(arm::GPR::PC)] = {};
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRBranchExchangeOp *op) {
+    m_gprValues[static_cast<size_t>(arm::GPR::PC)] = {};
+    m_cpsrValue = {};
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRStoreCopRegisterOp *op) {
+    // Coprocessor registers may control the location of the exception vectors
+    m_baseVectorAddressValue = {};
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Process(IRGetBaseVectorAddressOp *op) {
+    ReadRegister(m_baseVectorAddressValue, op->dst);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Expression value numbering
+
+size_t CommonSubexpressionEliminationOptimizerPass::ExpressionHash::operator()(const Expression &expr) const {
+    uint64_t hash = static_cast<uint64_t>(expr.type) | (static_cast<uint64_t>(expr.params) << 16);
+    hash = hash * 0x9E3779B97F4A7C15ull ^ expr.lhs;
+    hash = hash * 0x9E3779B97F4A7C15ull ^ expr.rhs;
+    return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+CommonSubexpressionEliminationOptimizerPass::Expression
+CommonSubexpressionEliminationOptimizerPass::MakeExpression(IROpcodeType type, VarOrImmArg lhs, VarOrImmArg rhs,
+                                                            bool commutative, uint8_t params) {
+    // Immediates are tagged above the 32-bit variable index range
+    auto operand = [](const VarOrImmArg &arg) -> uint64_t {
+        if (arg.immediate) {
+            return (1ull << 32) | arg.imm.value;
+        } else {
+            return arg.var.var.Index();
+        }
+    };
+
+    Expression expr{.type = type, .params = params, .lhs = operand(lhs), .rhs = operand(rhs)};
+    if (commutative && expr.lhs > expr.rhs) {
+        std::swap(expr.lhs, expr.rhs);
+    }
+    return expr;
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Number(VariableArg dst, const Expression &expr, bool outputsFlags) {
+    if (!dst.var.IsPresent()) {
+        return;
+    }
+
+    auto [it, inserted] = m_expressions.try_emplace(expr, Value{dst.var, {}});
+    if (inserted) {
+        return;
+    }
+
+    auto &value = it->second;
+    if (!value.lo.IsPresent()) {
+        value.lo = dst.var;
+    } else if (!outputsFlags) {
+        Replace(dst, value.lo);
+    }
+}
+
+void CommonSubexpressionEliminationOptimizerPass::Replace(VariableArg dst, Variable value) {
+    m_varSubst.Assign(dst, value);
+    m_emitter.Erase(m_emitter.GetCurrentOp());
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Register value tracking
+
+void CommonSubexpressionEliminationOptimizerPass::ReadRegister(Variable &value, VariableArg dst) {
+    if (!dst.var.IsPresent()) {
+        return;
+    }
+    if (value.IsPresent()) {
+        Replace(dst, value);
+    } else {
+        value = dst.var;
+    }
+}
+
+void CommonSubexpressionEliminationOptimizerPass::WriteRegister(Variable &value, const VarOrImmArg &src) {
+    if (src.immediate) {
+        // Constant propagation takes care of immediate values
+        value = {};
+    } else {
+        value = src.var.var;
+    }
+}
+
+} // namespace armajitto::ir
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "optimizer_pass_base.hpp"
+
+#include "common/var_subst.hpp"
+
+#include "guest/arm/mode_utils.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <unordered_map>
+
+namespace armajitto::ir {
+
+// Performs local value numbering to eliminate common subexpressions.
+//
+// This pass assigns a value number to the result of every pure ALU operation and register read in the block. When an
+// instruction computes a value that is already available in a variable, the instruction is erased and its output
+// variable is substituted by the existing variable in all subsequent instructions. The example below illustrates the
+// behavior of this optimization pass:
+//
+//      input code               value number               output code
+//   1  ld $v0, r1               r1                         ld $v0, r1
+//   2  add $v1, $v0, #0x4       add $v0, #0x4              add $v1, $v0, #0x4
+//   3  ld.duw $v2, [$v1]        -                          ld.duw $v2, [$v1]
+//   4  ld $v3, r1               r1 = $v0                 * (erased, $v3 -> $v0)
+//   5  add $v4, $v3, #0x4       add $v0, #0x4 = $v1      * (erased, $v4 -> $v1)
+//   6  lsl $v5, $v2, #0x2       lsl $v2, #0x2              lsl $v5, $v2, #0x2
+//   7  st.w $v5, [$v4]          -                          st.w $v5, [$v1]
+//   8  lsl $v6, $v2, #0x2       lsl $v2, #0x2 = $v5      * (erased, $v6 -> $v5)
+//   9  st r2, $v6               -                          st r2, $v5
+//
+// Instructions marked with an asterisk are erased by this pass.
+//
+// Only instructions whose result depends exclusively on their arguments are numbered: shifts and rotations without
+// carry, bitwise and arithmetic operations without carry input, moves, sign extensions, saturating operations and
+// multiplications. The first occurrence of an expression may output flags, but subsequent occurrences are only erased
+// if they don't, since the flags would otherwise be lost. Commutative operations are numbered with their arguments in
+// a canonical order, so that "add $v1, $v0, #0x4" and "add $v1, #0x4, $v0" receive the same value number.
+//
+// Register reads (GPRs, CPSR and SPSRs) are numbered until the register is written to. Memory accesses don't affect
+// registers, so repeated reads of a GPR across loads and stores are also eliminated. Writes with a variable argument
+// assign that variable as the value of the register. Writes to PC through branches, writes to CPSR and coprocessor
+// register stores invalidate the values they might affect.
+class CommonSubexpressionEliminationOptimizerPass final : public OptimizerPassBase {
+public:
+    CommonSubexpressionEliminationOptimizerPass(Emitter &emitter, std::pmr::memory_resource &alloc);
+
+private:
+    void Reset() final;
+
+    void PreProcess(IROp *op) final;
+
+    void Process(IRGetRegisterOp *op) final;
+    void Process(IRSetRegisterOp *op) final;
+    void Process(IRGetCPSROp *op) final;
+    void Process(IRSetCPSROp *op) final;
+    void Process(IRGetSPSROp *op) final;
+    void Process(IRSetSPSROp *op) final;
+    // void Process(IRMemReadOp *op) final;
+    // void Process(IRMemWriteOp *op) final;
+    // void Process(IRPreloadOp *op) final;
+    void Process(IRLogicalShiftLeftOp *op) final;
+    void Process(IRLogicalShiftRightOp *op) final;
+    void Process(IRArithmeticShiftRightOp *op) final;
+    void Process(IRRotateRightOp *op) final;
+    // void Process(IRRotateRightExtendedOp *op) final;
+    void Process(IRBitwiseAndOp *op) final;
+    void Process(IRBitwiseOrOp *op) final;
+    void Process(IRBitwiseXorOp *op) final;
+    void Process(IRBitClearOp *op) final;
+    void Process(IRCountLeadingZerosOp *op) final;
+    void Process(IRAddOp *op) final;
+    // void Process(IRAddCarryOp *op) final;
+    void Process(IRSubtractOp *op) final;
+    // void Process(IRSubtractCarryOp *op) final;
+    void Process(IRMoveOp *op) final;
+    void Process(IRMoveNegatedOp *op) final;
+    void Process(IRSignExtendHalfOp *op) final;
+    void Process(IRSaturatingAddOp *op) final;
+    void Process(IRSaturatingSubtractOp *op) final;
+    void Process(IRMultiplyOp *op) final;
+    void Process(IRMultiplyLongOp *op) final;
+    // void Process(IRAddLongOp *op) final;
+    // void Process(IRStoreFlagsOp *op) final;
+    // void Process(IRLoadFlagsOp *op) final;
+    // void Process(IRLoadStickyOverflowOp *op) final;
+    void Process(IRBranchOp *op) final;
+    void Process(IRBranchExchangeOp *op) final;
+    // void Process(IRCheckpointOp *op) final;
+    // void Process(IRLoadCopRegisterOp *op) final;
+    void Process(IRStoreCopRegisterOp *op) final;
+    // void Process(IRConstantOp *op) final;
+    // void Process(IRCopyVarOp *op) final;
+    void Process(IRGetBaseVectorAddressOp *op) final;
+
+    // -------------------------------------------------------------------------
+    // Expression value numbering
+
+    struct Expression {
+        IROpcodeType type;
+        uint8_t params; // opcode-specific parameters that affect the result
+        uint64_t lhs;
+        uint64_t rhs;
+
+        bool operator==(const Expression &) const = default;
+    };
+
+    struct ExpressionHash {
+        size_t operator()(const Expression &expr) const;
+    };
+
+    // Output variables of a numbered expression. hi is only used by long multiplications.
+    struct Value {
+        Variable lo;
+        Variable hi;
+    };
+
+    std::pmr::unordered_map<Expression, Value, ExpressionHash> m_expressions;
+
+    static Expression MakeExpression(IROpcodeType type, VarOrImmArg lhs, VarOrImmArg rhs, bool commutative,
+                                     uint8_t params = 0);
+
+    // Numbers an expression with a single output variable.
+    // Erases the current instruction if the value is already known and the instruction doesn't output flags.
+    void Number(VariableArg dst, const Expression &expr, bool outputsFlags);
+
+    // Erases the current instruction and substitutes its output variable with the existing value.
+    void Replace(VariableArg dst, Variable value);
+
+    // -------------------------------------------------------------------------
+    // Register value tracking
+
+    alignas(16) std::array<Variable, 16 * arm::kNumBankedModes> m_gprValues;
+    std::array<Variable, arm::kNumBankedModes> m_spsrValues;
+    Variable m_cpsrValue;
+    Variable m_baseVectorAddressValue;
+
+    void ReadRegister(Variable &value, VariableArg dst);
+    void WriteRegister(Variable &value, const VarOrImmArg &src);
+
+    VarSubstitutor m_varSubst;
+};
+
+} // namespace armajitto::ir
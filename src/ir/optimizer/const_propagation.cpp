@@ -104,6 +104,9 @@ void ConstPropagationOptimizerPass::Process(IRLogicalShiftLeftOp *op) {
         } else {
             ClearKnownHostFlags(arm::Flags::C);
         }
+    } else if (op->setCarry) {
+        // Variable shift amounts may or may not update the carry flag
+        ClearKnownHostFlags(arm::Flags::C);
     }
 }
 
@@ -142,6 +145,9 @@ void ConstPropagationOptimizerPass::Process(IRLogicalShiftRightOp *op) {
         } else {
             ClearKnownHostFlags(arm::Flags::C);
         }
+    } else if (op->setCarry) {
+        // Variable shift amounts may or may not update the carry flag
+        ClearKnownHostFlags(arm::Flags::C);
     }
 }
 
@@ -180,6 +186,9 @@ void ConstPropagationOptimizerPass::Process(IRArithmeticShiftRightOp *op) {
         } else {
             ClearKnownHostFlags(arm::Flags::C);
         }
+    } else if (op->setCarry) {
+        // Variable shift amounts may or may not update the carry flag
+        ClearKnownHostFlags(arm::Flags::C);
     }
 }
 
@@ -218,6 +227,9 @@ void ConstPropagationOptimizerPass::Process(IRRotateRightOp *op) {
         } else {
             ClearKnownHostFlags(arm::Flags::C);
         }
+    } else if (op->setCarry) {
+        // Variable shift amounts may or may not update the carry flag
+        ClearKnownHostFlags(arm::Flags::C);
     }
 }
 
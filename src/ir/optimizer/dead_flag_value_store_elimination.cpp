@@ -9,7 +9,8 @@ namespace armajitto::ir {
 DeadFlagValueStoreEliminationOptimizerPass::DeadFlagValueStoreEliminationOptimizerPass(Emitter &emitter,
                                                                                        std::pmr::memory_resource &alloc)
     : DeadStoreEliminationOptimizerPassBase(emitter)
-    , m_flagWritesPerVar(&alloc) {
+    , m_flagWritesPerVar(&alloc)
+    , m_varLifetimes(alloc) {
 
     const uint32_t varCount = emitter.VariableCount();
     m_flagWritesPerVar.resize(varCount);
@@ -17,6 +18,7 @@ DeadFlagValueStoreEliminationOptimizerPass::DeadFlagValueStoreEliminationOptimiz
 
 void DeadFlagValueStoreEliminationOptimizerPass::Reset() {
     std::fill(m_flagWritesPerVar.begin(), m_flagWritesPerVar.end(), FlagWrites{});
+    m_varLifetimes.Analyze(m_emitter.GetBlock());
 }
 
 void DeadFlagValueStoreEliminationOptimizerPass::Process(IRSetRegisterOp *op) {
@@ -230,6 +232,12 @@ void DeadFlagValueStoreEliminationOptimizerPass::RecordFlagWrites(VariableArg ds
     const auto bmFlags = BitmaskEnum(flags);
     auto &srcEntry = m_flagWritesPerVar[srcIndex];
     auto &dstEntry = m_flagWritesPerVar[dstIndex];
+
+    // If the source variable is read by later instructions, the flags it holds are still needed, so the chain is
+    // broken here
+    if (!m_varLifetimes.IsEndOfLife(src.var, writerOp)) {
+        ConsumeFlags(src);
+    }
     dstEntry = srcEntry;
 
     auto updateWrite = [&](arm::Flags flag, IROp *&srcOp, IROp *&dstOp) {
@@ -2,6 +2,8 @@
 
 #include "dead_store_elimination_base.hpp"
 
+#include "ir/var_lifetime.hpp"
+
 #include <array>
 #include <memory_resource>
 #include <vector>
@@ -49,6 +51,10 @@ namespace armajitto::ir {
 //  6  st cpsr, $v4
 //
 // The BIC operation becomes an identity operation, which is removed by a later optimization pass.
+//
+// Flag writes are only erased through variables that are not read by any later instructions. If $v1 in the example
+// above were also stored into a register after instruction 3, the chain would be broken at $v1 and instruction 2 would
+// be left untouched.
 class DeadFlagValueStoreEliminationOptimizerPass final : public DeadStoreEliminationOptimizerPassBase {
 public:
     DeadFlagValueStoreEliminationOptimizerPass(Emitter &emitter, std::pmr::memory_resource &alloc);
@@ -92,6 +98,7 @@ private:
     // void Process(IRLoadStickyOverflowOp *op) final;
     void Process(IRBranchOp *op) final;
     void Process(IRBranchExchangeOp *op) final;
+    // void Process(IRCheckpointOp *op) final;
     // void Process(IRLoadCopRegisterOp *op) final;
     void Process(IRStoreCopRegisterOp *op) final;
     // void Process(IRConstantOp *op) final;
@@ -111,6 +118,7 @@ private:
     };
 
     std::pmr::vector<FlagWrites> m_flagWritesPerVar;
+    VarLifetimeTracker m_varLifetimes;
 
     void ResizeFlagWritesPerVar(size_t index);
     void InitFlagWrites(VariableArg base);
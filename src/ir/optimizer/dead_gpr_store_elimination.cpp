@@ -51,6 +51,11 @@ void DeadGPRStoreEliminationOptimizerPass::Process(IRBranchExchangeOp *op) {
     RecordCPSRWrite(op);
 }
 
+void DeadGPRStoreEliminationOptimizerPass::Process(IRCheckpointOp *op) {
+    // All GPRs and PSRs are observed if the block is left at the checkpoint
+    Reset();
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // GPR and PSR read and write tracking
 
@@ -48,6 +48,7 @@ private:
     void Process(IRSetSPSROp *op) final;
     void Process(IRBranchOp *op) final;
     void Process(IRBranchExchangeOp *op) final;
+    void Process(IRCheckpointOp *op) final;
 
     // -------------------------------------------------------------------------
     // GPR and PSR read and write tracking
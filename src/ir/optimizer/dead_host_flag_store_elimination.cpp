@@ -13,24 +13,37 @@ void DeadHostFlagStoreEliminationOptimizerPass::Reset() {
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRLogicalShiftLeftOp *op) {
     if (op->setCarry) {
         RecordHostFlagsWrite(arm::Flags::C, op);
+        // Shifts by zero leave the carry flag unchanged, which makes shifts by variable amounts conditional writes
+        if (!op->amount.immediate || op->amount.imm.value == 0) {
+            RecordHostFlagsRead(arm::Flags::C, op);
+        }
     }
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRLogicalShiftRightOp *op) {
     if (op->setCarry) {
         RecordHostFlagsWrite(arm::Flags::C, op);
+        if (!op->amount.immediate || op->amount.imm.value == 0) {
+            RecordHostFlagsRead(arm::Flags::C, op);
+        }
     }
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRArithmeticShiftRightOp *op) {
     if (op->setCarry) {
         RecordHostFlagsWrite(arm::Flags::C, op);
+        if (!op->amount.immediate || op->amount.imm.value == 0) {
+            RecordHostFlagsRead(arm::Flags::C, op);
+        }
     }
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRRotateRightOp *op) {
     if (op->setCarry) {
         RecordHostFlagsWrite(arm::Flags::C, op);
+        if (!op->amount.immediate || op->amount.imm.value == 0) {
+            RecordHostFlagsRead(arm::Flags::C, op);
+        }
     }
 }
 
@@ -43,93 +56,93 @@ void DeadHostFlagStoreEliminationOptimizerPass::Process(IRRotateRightExtendedOp
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRBitwiseAndOp *op) {
     if (op->flags != arm::Flags::None) {
-        RecordHostFlagsWrite(op->kAffectedFlags, op);
+        RecordHostFlagsWrite(op->flags, op);
     }
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRBitwiseOrOp *op) {
     if (op->flags != arm::Flags::None) {
-        RecordHostFlagsWrite(op->kAffectedFlags, op);
+        RecordHostFlagsWrite(op->flags, op);
     }
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRBitwiseXorOp *op) {
     if (op->flags != arm::Flags::None) {
-        RecordHostFlagsWrite(op->kAffectedFlags, op);
+        RecordHostFlagsWrite(op->flags, op);
     }
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRBitClearOp *op) {
     if (op->flags != arm::Flags::None) {
-        RecordHostFlagsWrite(op->kAffectedFlags, op);
+        RecordHostFlagsWrite(op->flags, op);
     }
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRAddOp *op) {
     if (op->flags != arm::Flags::None) {
-        RecordHostFlagsWrite(op->kAffectedFlags, op);
+        RecordHostFlagsWrite(op->flags, op);
     }
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRAddCarryOp *op) {
     if (op->flags != arm::Flags::None) {
-        RecordHostFlagsWrite(op->kAffectedFlags, op);
+        RecordHostFlagsWrite(op->flags, op);
     }
     RecordHostFlagsRead(arm::Flags::C, op);
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRSubtractOp *op) {
     if (op->flags != arm::Flags::None) {
-        RecordHostFlagsWrite(op->kAffectedFlags, op);
+        RecordHostFlagsWrite(op->flags, op);
     }
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRSubtractCarryOp *op) {
     if (op->flags != arm::Flags::None) {
-        RecordHostFlagsWrite(op->kAffectedFlags, op);
+        RecordHostFlagsWrite(op->flags, op);
     }
     RecordHostFlagsRead(arm::Flags::C, op);
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRMoveOp *op) {
     if (op->flags != arm::Flags::None) {
-        RecordHostFlagsWrite(op->kAffectedFlags, op);
+        RecordHostFlagsWrite(op->flags, op);
     }
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRMoveNegatedOp *op) {
     if (op->flags != arm::Flags::None) {
-        RecordHostFlagsWrite(op->kAffectedFlags, op);
+        RecordHostFlagsWrite(op->flags, op);
     }
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRSaturatingAddOp *op) {
     if (op->flags != arm::Flags::None) {
-        RecordHostFlagsWrite(op->kAffectedFlags, op);
+        RecordHostFlagsWrite(op->flags, op);
     }
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRSaturatingSubtractOp *op) {
     if (op->flags != arm::Flags::None) {
-        RecordHostFlagsWrite(op->kAffectedFlags, op);
+        RecordHostFlagsWrite(op->flags, op);
     }
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRMultiplyOp *op) {
     if (op->flags != arm::Flags::None) {
-        RecordHostFlagsWrite(op->kAffectedFlags, op);
+        RecordHostFlagsWrite(op->flags, op);
     }
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRMultiplyLongOp *op) {
     if (op->flags != arm::Flags::None) {
-        RecordHostFlagsWrite(op->kAffectedFlags, op);
+        RecordHostFlagsWrite(op->flags, op);
     }
 }
 
 void DeadHostFlagStoreEliminationOptimizerPass::Process(IRAddLongOp *op) {
     if (op->flags != arm::Flags::None) {
-        RecordHostFlagsWrite(op->kAffectedFlags, op);
+        RecordHostFlagsWrite(op->flags, op);
     }
 }
 
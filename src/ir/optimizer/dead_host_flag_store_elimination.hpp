@@ -11,8 +11,9 @@ namespace armajitto::ir {
 // This algorithm scans the code backwards, tracking the host state of each one of the five CPSR flags: NZCVQ.
 // Whenever a host flag write is encountered, it is marked as "final" and any subsequent (previous) writes to those
 // flags are erased. Reads reset the state of the affected flags. For instructions that simultaneously read and write
-// such as ADC and SBC, the writes are processed before the reads. Dead instructions (that is, instructions that write
-// to no variables or flags and have no side effects) are not processed. This can also happen with simultaneous read and
+// such as ADC and SBC, the writes are processed before the reads. Shifts by variable amounts are treated the same way
+// since a zero amount leaves the carry flag unchanged. Dead instructions (that is, instructions that write to no
+// variables or flags and have no side effects) are not processed. This can also happen with simultaneous read and
 // write instructions if the write stage happens to modify the instruction such that it becomes dead -- the read stage
 // is not processed.
 //
@@ -87,6 +88,7 @@ private:
     void Process(IRLoadStickyOverflowOp *op) final;
     // void Process(IRBranchOp *op) final;
     // void Process(IRBranchExchangeOp *op) final;
+    // void Process(IRCheckpointOp *op) final;
     // void Process(IRLoadCopRegisterOp *op) final;
     // void Process(IRStoreCopRegisterOp *op) final;
     // void Process(IRConstantOp *op) final;
@@ -283,6 +283,12 @@ void DeadRegisterStoreEliminationOptimizerPass::Process(IRBranchExchangeOp *op)
     SubstituteVar(op->address);
 }
 
+void DeadRegisterStoreEliminationOptimizerPass::Process(IRCheckpointOp *op) {
+    // All GPRs and PSRs are observed if the block is left at the checkpoint; leave previous writes alone
+    m_gprWrites.fill(nullptr);
+    m_psrWrites.fill(nullptr);
+}
+
 void DeadRegisterStoreEliminationOptimizerPass::Process(IRStoreCopRegisterOp *op) {
     SubstituteVar(op->srcValue);
 }
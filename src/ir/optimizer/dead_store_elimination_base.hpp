@@ -64,6 +64,7 @@ protected:
     bool IsDeadInstruction(IRLoadStickyOverflowOp *op);
     // IRBranchOp has side effects
     // IRBranchExchangeOp has side effects
+    // IRCheckpointOp has side effects
     bool IsDeadInstruction(IRLoadCopRegisterOp *op);
     // IRStoreCopRegisterOp has side effects
     bool IsDeadInstruction(IRConstantOp *op);
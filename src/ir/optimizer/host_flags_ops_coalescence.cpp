@@ -4,10 +4,21 @@
 
 namespace armajitto::ir {
 
-HostFlagsOpsCoalescenceOptimizerPass::HostFlagsOpsCoalescenceOptimizerPass(Emitter &emitter)
-    : OptimizerPassBase(emitter) {}
+HostFlagsOpsCoalescenceOptimizerPass::HostFlagsOpsCoalescenceOptimizerPass(Emitter &emitter,
+                                                                           std::pmr::memory_resource &alloc)
+    : OptimizerPassBase(emitter)
+    , m_varReadCounts(&alloc) {}
 
 void HostFlagsOpsCoalescenceOptimizerPass::Reset() {
+    m_varReadCounts.assign(m_emitter.VariableCount(), 0);
+    for (IROp *op = m_emitter.GetBlock().Head(); op != nullptr; op = op->Next()) {
+        VisitIROpVars(op, [this](const auto *op, Variable var, bool read) -> void {
+            if (read && var.IsPresent() && var.Index() < m_varReadCounts.size()) {
+                ++m_varReadCounts[var.Index()];
+            }
+        });
+    }
+
     m_storeFlagsOp = nullptr;
     m_loadFlagsOpN = nullptr;
     m_loadFlagsOpZ = nullptr;
@@ -129,8 +140,9 @@ void HostFlagsOpsCoalescenceOptimizerPass::Process(IRLoadFlagsOp *op) {
     auto update = [this, &bmFlags, &op](arm::Flags flag, IRLoadFlagsOp *&loadOp) {
         // If another ldflg instruction wrote to this flag, move the flag update to the current instruction
         if (loadOp != nullptr) {
-            // Only if the two instruction are in the same chain of operations
-            if (loadOp->dstCPSR == op->srcCPSR) {
+            // Only if the two instruction are in the same chain of operations and no other instruction reads the
+            // value produced by the previous instruction
+            if (loadOp->dstCPSR == op->srcCPSR && GetReadCount(loadOp->dstCPSR.var) == 1) {
                 op->flags |= flag;
                 loadOp->flags &= ~flag;
 
@@ -138,6 +150,9 @@ void HostFlagsOpsCoalescenceOptimizerPass::Process(IRLoadFlagsOp *op) {
                 // repoint the current instruction's source CPSR to the previous instruction's
                 if (loadOp->flags == arm::Flags::None) {
                     op->srcCPSR = loadOp->srcCPSR;
+                    if (!op->srcCPSR.immediate && op->srcCPSR.var.var.IsPresent()) {
+                        ++m_varReadCounts[op->srcCPSR.var.var.Index()];
+                    }
 
                     auto guard = m_emitter.Overwrite().GoTo(loadOp);
                     if (loadOp->srcCPSR.immediate) {
@@ -187,9 +202,18 @@ void HostFlagsOpsCoalescenceOptimizerPass::UpdateFlags(arm::Flags flags) {
 }
 
 void HostFlagsOpsCoalescenceOptimizerPass::ConsumeFlags(arm::Flags flags) {
-    if (m_storeFlagsOp != nullptr && BitmaskEnum(m_storeFlagsOp->flags).AnyOf(flags)) {
+    // Ends the sequence even if the consumed flags are not among those stored so far, since merging a later store of
+    // these flags into the earlier instruction would move it before this consumer
+    if (BitmaskEnum(flags).Any()) {
         m_storeFlagsOp = nullptr;
     }
 }
 
+uint32_t HostFlagsOpsCoalescenceOptimizerPass::GetReadCount(Variable var) const {
+    if (!var.IsPresent() || var.Index() >= m_varReadCounts.size()) {
+        return 0;
+    }
+    return m_varReadCounts[var.Index()];
+}
+
 } // namespace armajitto::ir
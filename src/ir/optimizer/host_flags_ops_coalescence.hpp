@@ -3,6 +3,7 @@
 #include "optimizer_pass_base.hpp"
 
 #include <bit>
+#include <memory_resource>
 #include <optional>
 #include <vector>
 
@@ -68,8 +69,8 @@ namespace armajitto::ir {
 //  8  stflg.z {z}
 //  9  stflg.cv {c}
 //
-// Observe that it is possible to merge multiple stflg instructions if their flags are not consumed by any other
-// instruction, which is the case with instructions 8 and 9. Whenever a sequence of stflg instructions are encountered,
+// Observe that it is possible to merge multiple stflg instructions if no instruction between them consumes any host
+// flags, which is the case with instructions 8 and 9. Whenever a sequence of stflg instructions are encountered,
 // the flags mask and values are merged into the first stflg instruction that appeared in the sequence. In the example
 // above, instruction 8 would be updated to also set the C flag and clear the V flag -- stflg.zcv {zc}.
 // If multiple stflg instructions update the same flags in that sequence, the last one prevails. For example:
@@ -90,9 +91,11 @@ namespace armajitto::ir {
 // host flag is updated by any other instruction (including stflg), the ldflg pointers for the affected flags are reset.
 // When another ldflg instruction is encountered, all tracked ldflg flags are merged into it and the corresponding flags
 // are removed from the previous instructions, which are then erased if they update no more flags.
+// Flags are only moved out of an ldflg instruction if its output is read exclusively by the instruction it is chained
+// to, since any other reader would observe the missing flags.
 class HostFlagsOpsCoalescenceOptimizerPass final : public OptimizerPassBase {
 public:
-    HostFlagsOpsCoalescenceOptimizerPass(Emitter &emitter);
+    HostFlagsOpsCoalescenceOptimizerPass(Emitter &emitter, std::pmr::memory_resource &alloc);
 
 private:
     void Reset() final;
@@ -133,6 +136,7 @@ private:
     void Process(IRLoadStickyOverflowOp *op) final;
     // void Process(IRBranchOp *op) final;
     // void Process(IRBranchExchangeOp *op) final;
+    // void Process(IRCheckpointOp *op) final;
     // void Process(IRLoadCopRegisterOp *op) final;
     // void Process(IRStoreCopRegisterOp *op) final;
     // void Process(IRConstantOp *op) final;
@@ -153,6 +157,14 @@ private:
 
     void UpdateFlags(arm::Flags flags);
     void ConsumeFlags(arm::Flags flags);
+
+    // -------------------------------------------------------------------------
+    // Variable read tracking
+
+    // Number of instructions that read each variable
+    std::pmr::vector<uint32_t> m_varReadCounts;
+
+    uint32_t GetReadCount(Variable var) const;
 };
 
 } // namespace armajitto::ir
@@ -63,6 +63,10 @@ protected:
     virtual void Process(IRLoadStickyOverflowOp *op) {}
     virtual void Process(IRBranchOp *op) {}
     virtual void Process(IRBranchExchangeOp *op) {}
+    // Checkpoints may leave the block and observe all GPRs, PSRs, memory and coprocessor state at that point.
+    // Passes that erase, merge or reorder writes to guest state must treat them as barriers. Passes that only rewrite
+    // values and flags consumed by those writes are safe to ignore them, since the writes keep their inputs alive.
+    virtual void Process(IRCheckpointOp *op) {}
     virtual void Process(IRLoadCopRegisterOp *op) {}
     virtual void Process(IRStoreCopRegisterOp *op) {}
     virtual void Process(IRConstantOp *op) {}
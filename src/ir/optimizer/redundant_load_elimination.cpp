@@ -0,0 +1,291 @@
+#include "redundant_load_elimination.hpp"
+
+#include "ir/ops/ir_ops_visitor.hpp"
+
+#include "util/bitmask_enum.hpp"
+
+#include <bit>
+#include <cstdlib>
+
+namespace armajitto::ir {
+
+static uint32_t AccessBytes(MemAccessSize size) {
+    switch (size) {
+    case MemAccessSize::Byte: return 1;
+    case MemAccessSize::Half: return 2;
+    case MemAccessSize::Word: return 4;
+    default: return 4;
+    }
+}
+
+RedundantLoadEliminationOptimizerPass::RedundantLoadEliminationOptimizerPass(Emitter &emitter, Context &context,
+                                                                             const Options::Optimizer &options,
+                                                                             std::pmr::memory_resource &alloc)
+    : OptimizerPassBase(emitter)
+    , m_varAddresses(&alloc)
+    , m_accesses(&alloc)
+    , m_memMap(context.GetSystem().GetMemoryMap())
+    , m_arch(context.GetCPUArch())
+    , m_assumeStackInRAM(options.assumeStackInRAM)
+    , m_varSubst(emitter.VariableCount(), alloc) {
+
+    m_varAddresses.resize(emitter.VariableCount());
+}
+
+void RedundantLoadEliminationOptimizerPass::Reset() {
+    std::fill(m_varAddresses.begin(), m_varAddresses.end(), std::nullopt);
+    m_accesses.clear();
+    m_varSubst.Reset();
+}
+
+void RedundantLoadEliminationOptimizerPass::PreProcess(IROp *op) {
+    MarkDirty(m_varSubst.Substitute(op));
+}
+
+void RedundantLoadEliminationOptimizerPass::Process(IRGetRegisterOp *op) {
+    AssignAddress(op->dst, {.base = op->dst.var, .offset = 0, .stack = op->src.gpr == arm::GPR::SP});
+}
+
+void RedundantLoadEliminationOptimizerPass::Process(IRMemReadOp *op) {
+    if (op->bus != MemAccessBus::Data || !op->dst.var.IsPresent()) {
+        return;
+    }
+
+    const auto address = GetAddress(op->address);
+    if (!IsRAM(address, op->size, false)) {
+        return;
+    }
+
+    // Timed accesses add to the cycle count at runtime, so they must be performed even if the value is known
+    if (!op->timing.timed) {
+        for (auto it = m_accesses.rbegin(); it != m_accesses.rend(); ++it) {
+            auto &access = *it;
+            if (access.size != op->size || access.address.offset != address.offset ||
+                !access.address.SameBase(address)) {
+                continue;
+            }
+            if (access.write) {
+                if (ForwardStore(op, address, access.value)) {
+                    return;
+                }
+            } else if (access.mode == op->mode) {
+                Replace(op->dst, access.value);
+                return;
+            }
+        }
+    }
+
+    m_accesses.push_back({.address = address, .size = op->size, .write = false, .mode = op->mode, .value = op->dst});
+}
+
+void RedundantLoadEliminationOptimizerPass::Process(IRMemWriteOp *op) {
+    const auto address = GetAddress(op->address);
+    if (!IsRAM(address, op->size, true)) {
+        // Writes to MMIO may remap memory, start DMA transfers or otherwise modify RAM
+        m_accesses.clear();
+        return;
+    }
+
+    std::erase_if(m_accesses, [&](const Access &access) { return MayOverlap(access, address, op->size); });
+    m_accesses.push_back(
+        {.address = address, .size = op->size, .write = true, .mode = MemAccessMode::Aligned, .value = op->src});
+}
+
+void RedundantLoadEliminationOptimizerPass::Process(IRAddOp *op) {
+    if (op->flags != arm::Flags::None) {
+        return;
+    }
+    if (!op->lhs.immediate && op->rhs.immediate) {
+        DeriveAddress(op->dst, op->lhs, op->rhs.imm.value);
+    } else if (op->lhs.immediate && !op->rhs.immediate) {
+        DeriveAddress(op->dst, op->rhs, op->lhs.imm.value);
+    }
+}
+
+void RedundantLoadEliminationOptimizerPass::Process(IRSubtractOp *op) {
+    if (op->flags != arm::Flags::None) {
+        return;
+    }
+    if (!op->lhs.immediate && op->rhs.immediate) {
+        DeriveAddress(op->dst, op->lhs, 0u - op->rhs.imm.value);
+    }
+}
+
+void RedundantLoadEliminationOptimizerPass::Process(IRMoveOp *op) {
+    if (op->flags != arm::Flags::None) {
+        return;
+    }
+    DeriveAddress(op->dst, op->value, 0);
+}
+
+void RedundantLoadEliminationOptimizerPass::Process(IRStoreCopRegisterOp *op) {
+    // Coprocessor registers may control memory protection and TCM mappings
+    m_accesses.clear();
+}
+
+void RedundantLoadEliminationOptimizerPass::Process(IRConstantOp *op) {
+    AssignAddress(op->dst, {.offset = op->value});
+}
+
+void RedundantLoadEliminationOptimizerPass::Process(IRCopyVarOp *op) {
+    DeriveAddress(op->dst, op->var, 0);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Address tracking
+
+void RedundantLoadEliminationOptimizerPass::AssignAddress(VariableArg var, const Address &address) {
+    if (!var.var.IsPresent()) {
+        return;
+    }
+    const auto index = var.var.Index();
+    if (m_varAddresses.size() <= index) {
+        m_varAddresses.resize(index + 1);
+    }
+    m_varAddresses[index] = address;
+}
+
+void RedundantLoadEliminationOptimizerPass::DeriveAddress(VariableArg var, VarOrImmArg base, uint32_t offset) {
+    auto address = GetAddress(base);
+    address.offset += offset;
+    AssignAddress(var, address);
+}
+
+auto RedundantLoadEliminationOptimizerPass::GetAddress(const VarOrImmArg &arg) const -> Address {
+    if (arg.immediate) {
+        return {.offset = arg.imm.value};
+    }
+    const auto index = arg.var.var.Index();
+    if (index < m_varAddresses.size() && m_varAddresses[index]) {
+        return *m_varAddresses[index];
+    }
+    return {.base = arg.var.var};
+}
+
+bool RedundantLoadEliminationOptimizerPass::IsRAM(const Address &address, MemAccessSize size, bool write) {
+    if (address.base.IsPresent()) {
+        return address.stack && m_assumeStackInRAM;
+    }
+
+    const uint32_t alignedAddress = address.offset & ~(AccessBytes(size) - 1);
+    auto *readPtr = m_memMap.dataRead.GetPointer<uint8_t>(alignedAddress);
+    if (readPtr == nullptr) {
+        return false;
+    }
+    auto readAttrs = BitmaskEnum(m_memMap.dataRead.GetAttributes(alignedAddress));
+    if (readAttrs.NoneOf(MemoryAttributes::Readable) || readAttrs.AnyOf(MemoryAttributes::Volatile)) {
+        return false;
+    }
+    if (write) {
+        // Stored values can only be forwarded if reads observe the memory that was written to
+        auto *writePtr = m_memMap.dataWrite.GetPointer<uint8_t>(alignedAddress);
+        if (writePtr != readPtr) {
+            return false;
+        }
+        auto writeAttrs = BitmaskEnum(m_memMap.dataWrite.GetAttributes(alignedAddress));
+        if (writeAttrs.NoneOf(MemoryAttributes::Writable) || writeAttrs.AnyOf(MemoryAttributes::Volatile)) {
+            return false;
+        }
+    }
+    m_dependsOnMemMap = true;
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Memory contents tracking
+
+bool RedundantLoadEliminationOptimizerPass::MayOverlap(const Access &access, const Address &address,
+                                                       MemAccessSize size) {
+    if (!access.address.SameBase(address)) {
+        return true;
+    }
+
+    const uint32_t bytes1 = AccessBytes(access.size);
+    const uint32_t bytes2 = AccessBytes(size);
+    if (!address.base.IsPresent()) {
+        // Constant addresses are known exactly; accesses are aligned to their size
+        const uint32_t start1 = access.address.offset & ~(bytes1 - 1);
+        const uint32_t start2 = address.offset & ~(bytes2 - 1);
+        return start1 < start2 + bytes2 && start2 < start1 + bytes1;
+    }
+
+    // The alignment of the base is unknown, but two aligned accesses can only overlap if their unaligned addresses
+    // are less than the size of the largest access apart
+    const int64_t distance = static_cast<int32_t>(address.offset - access.address.offset);
+    return std::abs(distance) < std::max(bytes1, bytes2);
+}
+
+bool RedundantLoadEliminationOptimizerPass::ForwardStore(IRMemReadOp *op, const Address &address,
+                                                         const VarOrImmArg &value) {
+    // The alignment of the address is only known for constant addresses
+    const bool constant = !address.base.IsPresent();
+    const auto dst = op->dst;
+    const auto opAddress = op->address;
+
+    switch (op->size) {
+    case MemAccessSize::Byte:
+        if (op->mode == MemAccessMode::Signed) {
+            if (value.immediate) {
+                m_emitter.Overwrite().Constant(dst, static_cast<uint32_t>(static_cast<int8_t>(value.imm.value)));
+            } else {
+                m_emitter.Overwrite();
+                auto shifted = m_emitter.LogicalShiftLeft(value, 24, false);
+                m_emitter.ArithmeticShiftRight(dst, shifted, 24, false);
+            }
+        } else if (value.immediate) {
+            m_emitter.Overwrite().Constant(dst, value.imm.value & 0xFF);
+        } else {
+            m_emitter.Overwrite().BitwiseAnd(dst, value, 0xFF, false);
+        }
+        return true;
+    case MemAccessSize::Half:
+        // ARMv4T rotates unaligned halfword reads and reads a single byte on unaligned signed halfword reads
+        if (op->mode != MemAccessMode::Aligned && m_arch == CPUArch::ARMv4T && (!constant || (address.offset & 1))) {
+            return false;
+        }
+        if (op->mode == MemAccessMode::Signed) {
+            if (value.immediate) {
+                m_emitter.Overwrite().Constant(dst, static_cast<uint32_t>(static_cast<int16_t>(value.imm.value)));
+            } else {
+                m_emitter.Overwrite().SignExtendHalf(dst, value);
+            }
+        } else if (value.immediate) {
+            m_emitter.Overwrite().Constant(dst, value.imm.value & 0xFFFF);
+        } else {
+            m_emitter.Overwrite().BitwiseAnd(dst, value, 0xFFFF, false);
+        }
+        return true;
+    case MemAccessSize::Word:
+        if (op->mode != MemAccessMode::Unaligned) {
+            Replace(dst, value);
+        } else if (constant) {
+            // Unaligned word reads rotate the aligned word
+            const uint32_t rotation = (address.offset & 3) * 8;
+            if (rotation == 0) {
+                Replace(dst, value);
+            } else if (value.immediate) {
+                m_emitter.Overwrite().Constant(dst, std::rotr(value.imm.value, rotation));
+            } else {
+                m_emitter.Overwrite().RotateRight(dst, value, rotation, false);
+            }
+        } else {
+            m_emitter.Overwrite();
+            auto misalignment = m_emitter.BitwiseAnd(opAddress, 3, false);
+            auto rotation = m_emitter.LogicalShiftLeft(misalignment, 3, false);
+            m_emitter.RotateRight(dst, value, rotation, false);
+        }
+        return true;
+    default: return false;
+    }
+}
+
+void RedundantLoadEliminationOptimizerPass::Replace(VariableArg dst, const VarOrImmArg &value) {
+    if (value.immediate) {
+        m_emitter.Overwrite().Constant(dst, value.imm.value);
+    } else {
+        m_varSubst.Assign(dst, value.var);
+        m_emitter.Erase(m_emitter.GetCurrentOp());
+    }
+}
+
+} // namespace armajitto::ir
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "optimizer_pass_base.hpp"
+
+#include "common/var_subst.hpp"
+
+#include "armajitto/core/context.hpp"
+#include "armajitto/core/options.hpp"
+#include "core/memory_map_priv_access.hpp"
+
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+namespace armajitto::ir {
+
+// Eliminates memory reads whose values are already known within the block.
+//
+// This pass tracks the values written to and read from memory through the block and replaces memory reads from
+// locations with known contents by the known values. A read from a location previously written by a store of the same
+// size is replaced by the stored value (store-to-load forwarding), and a read from a location previously read with the
+// same size and mode is replaced by the variable holding the result of the first read (redundant load elimination).
+// The example below illustrates the behavior of this optimization pass:
+//
+//      input code               output code
+//   1  ld $v0, sp               ld $v0, sp
+//   2  add $v1, $v0, #0x4       add $v1, $v0, #0x4
+//   3  st.w $v2, [$v1]          st.w $v2, [$v1]
+//   4  ld.duw $v3, [$v1]      * and $v4, $v1, #0x3
+//                             * lsl $v5, $v4, #0x3
+//                             * ror $v3, $v2, $v5
+//   5  ld.duw $v6, [#0x2000]    ld.duw $v6, [#0x2000]
+//   6  ld.duw $v7, [#0x2000]  * (erased, $v7 -> $v6)
+//
+// Instructions marked with an asterisk are replaced by this pass. Forwarded values are adjusted to match the semantics
+// of the read: unaligned word reads are rotated, halfword and byte reads are truncated or sign-extended.
+//
+// Addresses are tracked as a base variable plus a constant offset, following additions and subtractions of immediate
+// values. Two accesses are known not to overlap if they share the same base and their offsets are far enough apart;
+// accesses with different bases may alias. Memory writes clear all known values they might overlap with.
+//
+// Accesses are only optimized if they are proven to target plain RAM. Accesses to constant addresses are checked
+// against the memory map: the location must be mapped to the same host memory for reads and writes with the Readable
+// and Writable attributes and without the Volatile attribute. Blocks optimized this way are reported through
+// DependsOnMemoryMap() so that they can be discarded when the data memory map changes. Accesses relative to the stack
+// pointer are only optimized if Options::Optimizer::assumeStackInRAM is enabled. Writes that might target anything
+// other than RAM and coprocessor register stores clear all known values, since they may remap memory or change access
+// permissions.
+//
+// Reads that count access cycles at runtime are never eliminated.
+class RedundantLoadEliminationOptimizerPass final : public OptimizerPassBase {
+public:
+    RedundantLoadEliminationOptimizerPass(Emitter &emitter, Context &context, const Options::Optimizer &options,
+                                          std::pmr::memory_resource &alloc);
+
+    // Determines if the pass relied on the current layout of the memory map to optimize accesses to constant
+    // addresses.
+    bool DependsOnMemoryMap() const {
+        return m_dependsOnMemMap;
+    }
+
+private:
+    void Reset() final;
+
+    void PreProcess(IROp *op) final;
+
+    void Process(IRGetRegisterOp *op) final;
+    // void Process(IRSetRegisterOp *op) final;
+    // void Process(IRGetCPSROp *op) final;
+    // void Process(IRSetCPSROp *op) final;
+    // void Process(IRGetSPSROp *op) final;
+    // void Process(IRSetSPSROp *op) final;
+    void Process(IRMemReadOp *op) final;
+    void Process(IRMemWriteOp *op) final;
+    // void Process(IRPreloadOp *op) final;
+    // void Process(IRLogicalShiftLeftOp *op) final;
+    // void Process(IRLogicalShiftRightOp *op) final;
+    // void Process(IRArithmeticShiftRightOp *op) final;
+    // void Process(IRRotateRightOp *op) final;
+    // void Process(IRRotateRightExtendedOp *op) final;
+    // void Process(IRBitwiseAndOp *op) final;
+    // void Process(IRBitwiseOrOp *op) final;
+    // void Process(IRBitwiseXorOp *op) final;
+    // void Process(IRBitClearOp *op) final;
+    // void Process(IRCountLeadingZerosOp *op) final;
+    void Process(IRAddOp *op) final;
+    // void Process(IRAddCarryOp *op) final;
+    void Process(IRSubtractOp *op) final;
+    // void Process(IRSubtractCarryOp *op) final;
+    void Process(IRMoveOp *op) final;
+    // void Process(IRMoveNegatedOp *op) final;
+    // void Process(IRSignExtendHalfOp *op) final;
+    // void Process(IRSaturatingAddOp *op) final;
+    // void Process(IRSaturatingSubtractOp *op) final;
+    // void Process(IRMultiplyOp *op) final;
+    // void Process(IRMultiplyLongOp *op) final;
+    // void Process(IRAddLongOp *op) final;
+    // void Process(IRStoreFlagsOp *op) final;
+    // void Process(IRLoadFlagsOp *op) final;
+    // void Process(IRLoadStickyOverflowOp *op) final;
+    // void Process(IRBranchOp *op) final;
+    // void Process(IRBranchExchangeOp *op) final;
+    // void Process(IRCheckpointOp *op) final;
+    // void Process(IRLoadCopRegisterOp *op) final;
+    void Process(IRStoreCopRegisterOp *op) final;
+    void Process(IRConstantOp *op) final;
+    void Process(IRCopyVarOp *op) final;
+    // void Process(IRGetBaseVectorAddressOp *op) final;
+
+    // -------------------------------------------------------------------------
+    // Address tracking
+
+    struct Address {
+        Variable base;       // absent for constant addresses
+        uint32_t offset = 0; // absolute address for constant addresses
+        bool stack = false;  // base is a read of SP
+
+        bool SameBase(const Address &other) const {
+            return base.IsPresent() == other.base.IsPresent() &&
+                   (!base.IsPresent() || base.Index() == other.base.Index());
+        }
+    };
+
+    std::pmr::vector<std::optional<Address>> m_varAddresses;
+
+    void AssignAddress(VariableArg var, const Address &address);
+    void DeriveAddress(VariableArg var, VarOrImmArg base, uint32_t offset);
+    Address GetAddress(const VarOrImmArg &arg) const;
+
+    // Determines if the access is proven to target plain RAM.
+    bool IsRAM(const Address &address, MemAccessSize size, bool write);
+
+    // -------------------------------------------------------------------------
+    // Memory contents tracking
+
+    struct Access {
+        Address address;
+        MemAccessSize size;
+        bool write;
+        MemAccessMode mode; // reads only
+        VarOrImmArg value;  // value written or read
+    };
+
+    std::pmr::vector<Access> m_accesses;
+
+    static bool MayOverlap(const Access &access, const Address &address, MemAccessSize size);
+
+    // Replaces the read with the value written by a store of the same size to the same address.
+    // Returns false if the read cannot be derived from the stored value.
+    bool ForwardStore(IRMemReadOp *op, const Address &address, const VarOrImmArg &value);
+
+    // Replaces the output of the current instruction with the specified value.
+    void Replace(VariableArg dst, const VarOrImmArg &value);
+
+    // -------------------------------------------------------------------------
+    // Dependencies
+
+    MemoryMapPrivateAccess m_memMap;
+    bool m_dependsOnMemMap = false;
+    const CPUArch m_arch;
+    const bool m_assumeStackInRAM;
+
+    VarSubstitutor m_varSubst;
+};
+
+} // namespace armajitto::ir
@@ -1,18 +1,20 @@
 #include "var_lifetime_opt.hpp"
 
+#include "ir/ops/ir_ops_visitor.hpp"
+
+#include <algorithm>
+
 namespace armajitto::ir {
 
 VarLifetimeOptimizerPass::VarLifetimeOptimizerPass(Emitter &emitter, std::pmr::memory_resource &alloc)
     : OptimizerPassBase(emitter)
     , m_ops(&alloc)
     , m_varAccesses(&alloc)
-    , m_rootNodes(&alloc)
-    , m_leafNodes(&alloc)
     , m_fwdDeps(&alloc)
     , m_revDeps(&alloc)
-    , m_sortedLeafNodes(&alloc)
-    , m_maxDistFromRoot(&alloc)
-    , m_writtenNodes(&alloc) {}
+    , m_pendingDeps(&alloc)
+    , m_readyNodes(&alloc)
+    , m_liveVars(&alloc) {}
 
 void VarLifetimeOptimizerPass::Reset() {
     AccessRecord emptyRecord{};
@@ -22,14 +24,12 @@ void VarLifetimeOptimizerPass::Reset() {
 
     const size_t opCount = m_emitter.IROpCount();
     m_ops.resize(opCount);
-    m_rootNodes.resize((opCount + 63) / 64);
-    m_leafNodes.resize((opCount + 63) / 64);
     m_fwdDeps.resize(opCount);
     m_revDeps.resize(opCount);
-    m_maxDistFromRoot.resize(opCount);
-    m_writtenNodes.resize((opCount + 63) / 64);
+    m_pendingDeps.resize(opCount);
 
     m_memAccessIndex = ~0;
+    m_stateAccesses = emptyRecord;
 
     m_opIndex = 0;
 
@@ -50,10 +50,6 @@ void VarLifetimeOptimizerPass::Reset() {
     m_flagCAccesses = emptyRecord;
     m_flagVAccesses = emptyRecord;
 
-    std::fill(m_rootNodes.begin(), m_rootNodes.end(), ~0ull);
-    std::fill(m_leafNodes.begin(), m_leafNodes.end(), ~0ull);
-    std::fill(m_maxDistFromRoot.begin(), m_maxDistFromRoot.end(), 0);
-    std::fill(m_writtenNodes.begin(), m_writtenNodes.end(), 0);
     for (auto &deps : m_fwdDeps) {
         deps.clear();
     }
@@ -67,57 +63,46 @@ void VarLifetimeOptimizerPass::PostProcess(IROp *op) {
 }
 
 void VarLifetimeOptimizerPass::PostProcess() {
-    const size_t opCount = m_maxDistFromRoot.size();
-
-    // Iterate over all root nodes to compute maximum distances from node to root
-    for (size_t i = 0; i < m_rootNodes.size(); i++) {
-        uint64_t bitmap = m_rootNodes[i];
-        size_t bmindex = std::countr_zero(bitmap);
-        while (bmindex < 64) {
-            const size_t rootIndex = bmindex + i * 64;
-            if (rootIndex >= opCount) {
-                break;
-            }
-
-            // Traverse all children nodes, computing maximum distances from root
-            for (auto node : m_fwdDeps[rootIndex]) {
-                CalcMaxDistanceFromRoot(node);
-            }
-
-            bitmap &= ~(1ull << bmindex);
-            bmindex = std::countr_zero(bitmap);
+    const size_t opCount = m_ops.size();
+
+    // Instructions that no other instruction depends on are ready to be scheduled
+    m_readyNodes.clear();
+    for (size_t i = 0; i < opCount; i++) {
+        m_pendingDeps[i] = m_fwdDeps[i].size();
+        if (m_pendingDeps[i] == 0) {
+            m_readyNodes.push_back(i);
         }
     }
-
-    // Sort leaf nodes from longest to shortest, then highest to lowest index for stability over multiple executions
-    m_sortedLeafNodes.clear();
-    for (size_t i = 0; i < m_leafNodes.size(); i++) {
-        uint64_t bitmap = m_leafNodes[i];
-        size_t bmindex = std::countr_zero(bitmap);
-        while (bmindex < 64) {
-            const size_t leafIndex = bmindex + i * 64;
-            if (leafIndex >= opCount) {
-                break;
+    m_liveVars.assign(m_varAccesses.size(), false);
+
+    // Schedule instructions from the bottom up, moving each one to the head of the block.
+    // Pick the ready instruction that minimizes the number of live variables, preferring instructions that appear later
+    // in the original sequence in case of ties.
+    while (!m_readyNodes.empty()) {
+        size_t bestPos = 0;
+        int bestDelta = LiveVarsDelta(m_ops[m_readyNodes[0]]);
+        for (size_t pos = 1; pos < m_readyNodes.size(); pos++) {
+            const int delta = LiveVarsDelta(m_ops[m_readyNodes[pos]]);
+            if (delta < bestDelta || (delta == bestDelta && m_readyNodes[pos] > m_readyNodes[bestPos])) {
+                bestPos = pos;
+                bestDelta = delta;
             }
-            m_sortedLeafNodes.push_back(leafIndex);
-            bitmap &= ~(1ull << bmindex);
-            bmindex = std::countr_zero(bitmap);
-        }
-    }
-    std::sort(m_sortedLeafNodes.begin(), m_sortedLeafNodes.end(), [&](uint64_t lhs, uint64_t rhs) {
-        if (m_maxDistFromRoot[lhs] > m_maxDistFromRoot[rhs]) {
-            return true;
-        }
-        if (m_maxDistFromRoot[lhs] < m_maxDistFromRoot[rhs]) {
-            return false;
         }
 
-        return lhs > rhs;
-    });
+        const size_t nodeIndex = m_readyNodes[bestPos];
+        m_readyNodes[bestPos] = m_readyNodes.back();
+        m_readyNodes.pop_back();
+
+        IROp *op = m_ops[nodeIndex];
+        VisitIROpVars(op, [this](const auto *, Variable var, bool read) { m_liveVars[var.Index()] = read; });
+        m_emitter.ReinsertAtHead(op);
 
-    // Rewrite instructions
-    for (auto leafIndex : m_sortedLeafNodes) {
-        Rewrite(leafIndex);
+        // Instructions become ready once all of their dependents are scheduled
+        for (auto depIndex : m_revDeps[nodeIndex]) {
+            if (--m_pendingDeps[depIndex] == 0) {
+                m_readyNodes.push_back(depIndex);
+            }
+        }
     }
 
     // Check for changes and mark as dirty if the instruction order changed
@@ -141,6 +126,7 @@ void VarLifetimeOptimizerPass::Process(IRGetRegisterOp *op) {
 void VarLifetimeOptimizerPass::Process(IRSetRegisterOp *op) {
     RecordRead(op->src);
     RecordWrite(op->dst);
+    RecordStateWrite();
 }
 
 void VarLifetimeOptimizerPass::Process(IRGetCPSROp *op) {
@@ -151,6 +137,7 @@ void VarLifetimeOptimizerPass::Process(IRGetCPSROp *op) {
 void VarLifetimeOptimizerPass::Process(IRSetCPSROp *op) {
     RecordRead(op->src);
     RecordCPSRWrite();
+    RecordStateWrite();
 }
 
 void VarLifetimeOptimizerPass::Process(IRGetSPSROp *op) {
@@ -161,6 +148,7 @@ void VarLifetimeOptimizerPass::Process(IRGetSPSROp *op) {
 void VarLifetimeOptimizerPass::Process(IRSetSPSROp *op) {
     RecordRead(op->src);
     RecordSPSRWrite(op->mode);
+    RecordStateWrite();
 }
 
 void VarLifetimeOptimizerPass::Process(IRMemReadOp *op) {
@@ -367,6 +355,7 @@ void VarLifetimeOptimizerPass::Process(IRBranchOp *op) {
     RecordRead(op->address);
     RecordCPSRRead();
     RecordWrite(arm::GPR::PC);
+    RecordStateWrite();
 }
 
 void VarLifetimeOptimizerPass::Process(IRBranchExchangeOp *op) {
@@ -374,14 +363,30 @@ void VarLifetimeOptimizerPass::Process(IRBranchExchangeOp *op) {
     RecordCPSRRead();
     RecordWrite(arm::GPR::PC);
     RecordCPSRWrite();
+    RecordStateWrite();
+}
+
+void VarLifetimeOptimizerPass::Process(IRCheckpointOp *op) {
+    // Checkpoints may leave the block, so they observe every GPR and PSR and act as a barrier for memory accesses and
+    // coprocessor instructions
+    for (auto &record : m_gprAccesses) {
+        AddReadDependencyEdge(record);
+    }
+    for (auto &record : m_psrAccesses) {
+        AddReadDependencyEdge(record);
+    }
+    RecordMemAccess();
+    RecordStateWrite();
 }
 
 void VarLifetimeOptimizerPass::Process(IRLoadCopRegisterOp *op) {
     RecordWrite(op->dstValue);
+    RecordMemAccess();
 }
 
 void VarLifetimeOptimizerPass::Process(IRStoreCopRegisterOp *op) {
     RecordRead(op->srcValue);
+    RecordMemAccess();
 }
 
 void VarLifetimeOptimizerPass::Process(IRConstantOp *op) {
@@ -395,6 +400,7 @@ void VarLifetimeOptimizerPass::Process(IRCopyVarOp *op) {
 
 void VarLifetimeOptimizerPass::Process(IRGetBaseVectorAddressOp *op) {
     RecordWrite(op->dst);
+    RecordMemAccess();
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -421,9 +427,13 @@ void VarLifetimeOptimizerPass::RecordRead(VariableArg arg) {
         return;
     }
 
+    // Variables are only written once, before any reads, so reads don't need to be ordered among themselves
     const auto varIndex = arg.var.Index();
     ResizeVarAccesses(varIndex);
-    AddReadDependencyEdge(m_varAccesses[varIndex]);
+    auto &record = m_varAccesses[varIndex];
+    if (record.writeIndex != ~0) {
+        AddEdge(record.writeIndex, m_opIndex);
+    }
 }
 
 void VarLifetimeOptimizerPass::RecordRead(GPRArg arg) {
@@ -500,18 +510,28 @@ void VarLifetimeOptimizerPass::RecordWrite(arm::Flags flags) {
     update(arm::Flags::V, m_flagVAccesses);
 }
 
+void VarLifetimeOptimizerPass::RecordStateWrite() {
+    AddWriteDependencyEdge(m_stateAccesses);
+}
+
 void VarLifetimeOptimizerPass::RecordMemAccess() {
     if (m_memAccessIndex != ~0) {
         AddEdge(m_memAccessIndex, m_opIndex);
     }
     m_memAccessIndex = m_opIndex;
+
+    // Memory accesses may abort or invoke system callbacks that observe the guest state
+    AddReadDependencyEdge(m_stateAccesses);
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 // Dependency graph
 
 void VarLifetimeOptimizerPass::AddReadDependencyEdge(AccessRecord &record) {
-    if (record.writeIndex != ~0) {
+    // Chain reads together so that the next write is ordered after all of them
+    if (record.readIndex != ~0) {
+        AddEdge(record.readIndex, m_opIndex);
+    } else if (record.writeIndex != ~0) {
         AddEdge(record.writeIndex, m_opIndex);
     }
     record.readIndex = m_opIndex;
@@ -524,6 +544,7 @@ void VarLifetimeOptimizerPass::AddWriteDependencyEdge(AccessRecord &record) {
     if (record.writeIndex != ~0) {
         AddEdge(record.writeIndex, m_opIndex);
     }
+    record.readIndex = ~0;
     record.writeIndex = m_opIndex;
 }
 
@@ -539,92 +560,32 @@ void VarLifetimeOptimizerPass::AddEdge(size_t from, size_t to) {
         return;
     }
 
-    // Add forward edge to graph
     fwdDeps.push_back(to);
-
-    // Add reverse edge to graph
-    auto &revDeps = m_revDeps[to];
-    auto it = std::lower_bound(revDeps.begin(), revDeps.end(), from);
-    revDeps.insert(it, from);
-
-    // Mark "from node as non-leaf
-    ClearLeafNode(from);
-
-    // Mark "to" node as non-root
-    ClearRootNode(to);
-}
-
-void VarLifetimeOptimizerPass::ClearRootNode(size_t index) {
-    const size_t vecIndex = index / 64;
-    const size_t bitIndex = index % 64;
-    m_rootNodes[vecIndex] &= ~(1ull << bitIndex);
+    m_revDeps[to].push_back(from);
 }
 
-void VarLifetimeOptimizerPass::ClearLeafNode(size_t index) {
-    const size_t vecIndex = index / 64;
-    const size_t bitIndex = index % 64;
-    m_leafNodes[vecIndex] &= ~(1ull << bitIndex);
-}
-
-size_t VarLifetimeOptimizerPass::CalcMaxDistanceFromRoot(size_t nodeIndex, size_t dist) {
-    if (m_maxDistFromRoot[nodeIndex] > dist) {
-        return m_maxDistFromRoot[nodeIndex];
-    }
-    m_maxDistFromRoot[nodeIndex] = dist;
-
-    size_t maxDist = dist;
-    for (auto depIndex : m_fwdDeps[nodeIndex]) {
-        maxDist = std::max(maxDist, CalcMaxDistanceFromRoot(depIndex, dist + 1));
-    }
-    return maxDist;
-}
-
-void VarLifetimeOptimizerPass::Rewrite(size_t nodeIndex, size_t dist) {
-    // Define function for writing nodes
-    auto writeNode = [&](size_t nodeIndex) {
-        // Skip already written nodes
-        if (IsWrittenNode(nodeIndex)) {
-            return;
-        }
-
-        // Only write the node if all of its children are already written
-        for (auto depIndex : m_fwdDeps[nodeIndex]) {
-            if (!IsWrittenNode(depIndex)) {
-                return;
+// ---------------------------------------------------------------------------------------------------------------------
+// Scheduling
+
+int VarLifetimeOptimizerPass::LiveVarsDelta(IROp *op) const {
+    // Moving the instruction above the scheduled instructions ends the live ranges of the variables it writes and
+    // starts the live ranges of the variables it reads, if they're not already live
+    int delta = 0;
+    std::array<uint32_t, 4> reads;
+    size_t readCount = 0;
+    VisitIROpVars(op, [&](const auto *, Variable var, bool read) {
+        const auto varIndex = var.Index();
+        if (!read) {
+            if (m_liveVars[varIndex]) {
+                delta--;
             }
+        } else if (!m_liveVars[varIndex] && std::find(reads.begin(), reads.begin() + readCount, varIndex) ==
+                                                 reads.begin() + readCount) {
+            reads[readCount++] = varIndex;
+            delta++;
         }
-
-        m_emitter.ReinsertAtHead(m_ops[nodeIndex]);
-        SetWrittenNode(nodeIndex);
-    };
-
-    // Write the current node
-    writeNode(nodeIndex);
-
-    // Move immediate parents to the head if possible
-    auto &deps = m_revDeps[nodeIndex];
-    for (size_t i = 0; i < deps.size(); i++) {
-        const size_t depIndex = deps[deps.size() - i - 1];
-        writeNode(depIndex);
-    }
-
-    // Visit parents in reverse order
-    for (size_t i = 0; i < deps.size(); i++) {
-        const size_t depIndex = deps[deps.size() - i - 1];
-        Rewrite(depIndex, dist + 1);
-    }
-}
-
-bool VarLifetimeOptimizerPass::IsWrittenNode(size_t index) const {
-    const size_t vecIndex = index / 64;
-    const size_t bitIndex = index % 64;
-    return m_writtenNodes[vecIndex] & (1ull << bitIndex);
-}
-
-void VarLifetimeOptimizerPass::SetWrittenNode(size_t index) {
-    const size_t vecIndex = index / 64;
-    const size_t bitIndex = index % 64;
-    m_writtenNodes[vecIndex] |= 1ull << bitIndex;
+    });
+    return delta;
 }
 
 } // namespace armajitto::ir
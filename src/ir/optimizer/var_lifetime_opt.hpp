@@ -10,9 +10,48 @@ namespace armajitto::ir {
 
 // Optimizes variable lifetimes.
 //
-// (TODO: describe algorithm)
+// The algorithm reorders instructions so that variables are consumed as soon as possible after they are produced,
+// shortening their live ranges and reducing register pressure on the host compiler.
 //
-// (TODO: demonstrate algorithm with an example)
+// The first step builds a dependency graph where each node is an instruction and each edge connects an instruction
+// to another that must be executed after it. Edges are added for:
+// - reads after writes of variables, GPRs, PSRs and host flags
+// - writes after reads or writes of GPRs, PSRs and host flags
+// - every pair of consecutive memory accesses and coprocessor instructions, which may have side effects
+// - memory accesses and writes to GPRs, PSRs or PC, because memory accesses may abort or invoke system callbacks that
+//   observe the guest state
+// - checkpoints and every access to GPRs, PSRs, memory and coprocessors, because checkpoints may leave the block and
+//   must observe the guest state exactly as it is at that point in the original sequence
+//
+// The block is then rewritten from the bottom up with a list scheduler. An instruction is ready to be scheduled once
+// all instructions that depend on it have been scheduled. At each step, the scheduler picks the ready instruction that
+// least increases the number of live variables, and moves it to the head of the block. Scheduling an instruction ends
+// the live ranges of the variables it writes and starts the live ranges of the variables it reads, so instructions
+// that produce values are pulled right above their consumers. Ties are broken in favor of the instruction that comes
+// last in the original sequence, which keeps the original order whenever it doesn't matter and makes the pass stable
+// over multiple executions.
+//
+// For example, the algorithm changes this sequence:
+//     ld $v0, r0
+//     ld $v1, r1
+//     ld $v2, r2
+//     add $v3, $v0, #0x1
+//     add $v4, $v1, #0x2
+//     add $v5, $v2, #0x3
+//     st r0, $v3
+//     st r1, $v4
+//     st r2, $v5
+// into:
+//     ld $v0, r0
+//     add $v3, $v0, #0x1
+//     st r0, $v3
+//     ld $v1, r1
+//     add $v4, $v1, #0x2
+//     st r1, $v4
+//     ld $v2, r2
+//     add $v5, $v2, #0x3
+//     st r2, $v5
+// which reduces the number of simultaneously live variables from three to one.
 class VarLifetimeOptimizerPass final : public OptimizerPassBase {
 public:
     VarLifetimeOptimizerPass(Emitter &emitter, std::pmr::memory_resource &alloc);
@@ -60,6 +99,7 @@ private:
     void Process(IRLoadStickyOverflowOp *op) final;
     void Process(IRBranchOp *op) final;
     void Process(IRBranchExchangeOp *op) final;
+    void Process(IRCheckpointOp *op) final;
     void Process(IRLoadCopRegisterOp *op) final;
     void Process(IRStoreCopRegisterOp *op) final;
     void Process(IRConstantOp *op) final;
@@ -74,6 +114,7 @@ private:
         size_t writeIndex = ~0;
     };
     size_t m_memAccessIndex = ~0;
+    AccessRecord m_stateAccesses; // guest state visible to memory accesses (GPRs, PSRs)
 
     size_t m_opIndex = 0;
 
@@ -104,33 +145,29 @@ private:
     void RecordPSRWrite(size_t index);
     void RecordWrite(arm::Flags flags);
 
+    void RecordStateWrite();
     void RecordMemAccess();
 
     // -------------------------------------------------------------------------
     // Dependency graph
 
-    std::pmr::vector<uint64_t> m_rootNodes;               // bit vector
-    std::pmr::vector<uint64_t> m_leafNodes;               // bit vector
-    std::pmr::vector<std::pmr::vector<size_t>> m_fwdDeps; // deps[from] -> {to, to, ...}; sorted, no dupes
-    std::pmr::vector<std::pmr::vector<size_t>> m_revDeps; // deps[to] -> {from, from, ...}; sorted, no dupes
-    std::pmr::vector<size_t> m_sortedLeafNodes;
-    std::pmr::vector<size_t> m_maxDistFromRoot; // max distance from root
-    std::pmr::vector<uint64_t> m_writtenNodes;  // bit vector indicating which nodes have been written
+    std::pmr::vector<std::pmr::vector<size_t>> m_fwdDeps; // deps[from] -> {to, to, ...}
+    std::pmr::vector<std::pmr::vector<size_t>> m_revDeps; // deps[to] -> {from, from, ...}
 
     void AddReadDependencyEdge(AccessRecord &record);
     void AddWriteDependencyEdge(AccessRecord &record);
 
     void AddEdge(size_t from, size_t to);
 
-    void ClearRootNode(size_t index);
-    void ClearLeafNode(size_t index);
-
-    size_t CalcMaxDistanceFromRoot(size_t nodeIndex, size_t dist = 1);
+    // -------------------------------------------------------------------------
+    // Scheduling
 
-    void Rewrite(size_t nodeIndex, size_t dist = 0);
+    std::pmr::vector<size_t> m_pendingDeps; // number of unscheduled dependents per node
+    std::pmr::vector<size_t> m_readyNodes;  // nodes whose dependents have all been scheduled
+    std::pmr::vector<bool> m_liveVars;      // variables read by scheduled nodes and not yet written
 
-    bool IsWrittenNode(size_t index) const;
-    void SetWrittenNode(size_t index);
+    // Computes the change in live variables caused by scheduling the given instruction
+    int LiveVarsDelta(IROp *op) const;
 };
 
 } // namespace armajitto::ir
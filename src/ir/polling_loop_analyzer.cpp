@@ -0,0 +1,318 @@
+#include "polling_loop_analyzer.hpp"
+
+#include "ops/ir_ops_visitor.hpp"
+
+#include "util/bitmask_enum.hpp"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace armajitto::ir {
+
+PollingLoopAnalyzer::PollingLoopAnalyzer(Context &context, std::pmr::memory_resource &alloc)
+    : m_context(context)
+    , m_memMap(context.GetSystem().GetMemoryMap())
+    , m_varAddresses(&alloc)
+    , m_cpsrVars(&alloc) {
+
+    Reset();
+}
+
+void PollingLoopAnalyzer::Reset() {
+    m_regAddresses.fill(std::nullopt);
+    m_inputRegs = 0;
+    m_writtenRegs = 0;
+    m_maybeWrittenRegs = 0;
+    m_inputFlags = arm::Flags::None;
+    m_writtenFlags = arm::Flags::None;
+    m_maybeWrittenFlags = arm::Flags::None;
+    m_guardCount = 0;
+    m_dependsOnMemMap = false;
+}
+
+bool PollingLoopAnalyzer::Analyze(const BasicBlock &block, bool last) {
+    if (block.Condition() == arm::Condition::NV) {
+        return false;
+    }
+
+    // The condition check reads the flags before any instruction in the block
+    if (block.Condition() != arm::Condition::AL && !ReadFlags(arm::Flags::NZCV)) {
+        return false;
+    }
+
+    // The branch back to the loop entry is always taken while the loop runs, so the instructions of the last block are
+    // always executed. Other conditional blocks may be skipped.
+    m_conditional = !last && block.Condition() != arm::Condition::AL;
+
+    if (!last) {
+        // Conditional branches leave the loop when taken; the loop continues only when they are skipped
+        bool branches = false;
+        for (const IROp *op = block.Head(); op != nullptr; op = op->Next()) {
+            if (op->type == IROpcodeType::Branch || op->type == IROpcodeType::BranchExchange) {
+                branches = true;
+                break;
+            }
+        }
+        if (branches) {
+            return m_conditional;
+        }
+
+        // Otherwise the block must fall through to the next one
+        if (block.GetTerminal() != BasicBlock::Terminal::DirectLink ||
+            block.GetTerminalLocation().ToUint64() != block.NextLocation().ToUint64()) {
+            return false;
+        }
+    }
+
+    m_varAddresses.assign(block.VariableCount(), std::nullopt);
+    m_cpsrVars.assign(block.VariableCount(), false);
+    for (const IROp *op = block.Head(); op != nullptr; op = op->Next()) {
+        if (!AnalyzeOp(op, last)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PollingLoopAnalyzer::AnalyzeOp(const IROp *op, bool last) {
+    return VisitIROp(op, [&](const auto *op) -> bool {
+        using TOp = std::decay_t<std::remove_cvref_t<decltype(*op)>>;
+
+        // CPSR values may only be transferred through flag copies and CPSR writes; anything else observes the flags
+        constexpr bool kTransfersCPSR = std::is_same_v<TOp, IRLoadFlagsOp> ||
+                                        std::is_same_v<TOp, IRLoadStickyOverflowOp> ||
+                                        std::is_same_v<TOp, IRSetCPSROp> || std::is_same_v<TOp, IRCopyVarOp>;
+        if constexpr (!kTransfersCPSR) {
+            bool readsCPSR = false;
+            VisitIROpVars(op, [&](const auto *, Variable var, bool read) {
+                if (read && m_cpsrVars[var.Index()]) {
+                    readsCPSR = true;
+                }
+            });
+            if (readsCPSR && !ReadFlags(arm::Flags::NZCV)) {
+                return false;
+            }
+        }
+
+        // PC is advanced by every instruction and is not carried over to the next iteration.
+        // The preceding blocks are analyzed unoptimized, so they read and write PC around every instruction.
+        if constexpr (std::is_same_v<TOp, IRGetRegisterOp>) {
+            const auto gprIndex = static_cast<size_t>(op->src.gpr);
+            if (op->src.gpr == arm::GPR::PC) {
+                SetAddress(op->dst, std::nullopt);
+            } else if (!ReadRegister(op->src)) {
+                return false;
+            } else if (m_writtenRegs & (1u << gprIndex)) {
+                const auto &regAddress = m_regAddresses[gprIndex];
+                if (regAddress && regAddress->index == op->src.Index()) {
+                    SetAddress(op->dst, regAddress->address);
+                } else {
+                    SetAddress(op->dst, std::nullopt);
+                }
+            } else {
+                SetAddress(op->dst, Address{.base = op->src});
+            }
+        } else if constexpr (std::is_same_v<TOp, IRSetRegisterOp>) {
+            return op->dst.gpr == arm::GPR::PC || WriteRegister(op->dst, op->src);
+        } else if constexpr (std::is_same_v<TOp, IRGetCPSROp>) {
+            if (op->dst.var.IsPresent()) {
+                m_cpsrVars[op->dst.var.Index()] = true;
+            }
+        } else if constexpr (std::is_same_v<TOp, IRSetCPSROp>) {
+            return !op->updateIFlag && IsCPSRVar(op->src);
+        } else if constexpr (std::is_same_v<TOp, IRSetSPSROp>) {
+            return false;
+        } else if constexpr (std::is_same_v<TOp, IRLoadFlagsOp>) {
+            if (!ReadFlags(op->flags)) {
+                return false;
+            }
+            if (op->dstCPSR.var.IsPresent()) {
+                m_cpsrVars[op->dstCPSR.var.Index()] = IsCPSRVar(op->srcCPSR);
+            }
+        } else if constexpr (std::is_same_v<TOp, IRLoadStickyOverflowOp>) {
+            if (op->setQ && !ReadFlags(arm::Flags::V)) {
+                return false;
+            }
+            if (op->dstCPSR.var.IsPresent()) {
+                m_cpsrVars[op->dstCPSR.var.Index()] = IsCPSRVar(op->srcCPSR);
+            }
+        } else if constexpr (std::is_same_v<TOp, IRStoreFlagsOp>) {
+            return WriteFlags(op->flags);
+        } else if constexpr (std::is_same_v<TOp, IRMemReadOp>) {
+            auto address = GetAddress(op->address);
+            if (!address || !CheckRead(*address, op->size)) {
+                return false;
+            }
+        } else if constexpr (std::is_same_v<TOp, IRMemWriteOp>) {
+            return false;
+        } else if constexpr (std::is_same_v<TOp, IRStoreCopRegisterOp>) {
+            const auto &cop = m_context.GetARMState().GetCoprocessor(op->cpnum);
+            if (op->ext ? cop.ExtRegStoreHasSideEffects(op->reg) : cop.RegStoreHasSideEffects(op->reg)) {
+                return false;
+            }
+        } else if constexpr (std::is_same_v<TOp, IRBranchOp>) {
+            return last;
+        } else if constexpr (std::is_same_v<TOp, IRBranchExchangeOp>) {
+            return false;
+        } else if constexpr (std::is_same_v<TOp, IRConstantOp>) {
+            SetAddress(op->dst, Address{.offset = op->value});
+        } else if constexpr (std::is_same_v<TOp, IRCopyVarOp>) {
+            SetAddress(op->dst, GetAddress(op->var));
+            if (op->dst.var.IsPresent()) {
+                m_cpsrVars[op->dst.var.Index()] = IsCPSRVar(op->var);
+            }
+        } else if constexpr (std::is_same_v<TOp, IRMoveOp>) {
+            SetAddress(op->dst, GetAddress(op->value));
+        } else if constexpr (std::is_same_v<TOp, IRAddOp> || std::is_same_v<TOp, IRSubtractOp>) {
+            // Follow constant offsets from addresses
+            constexpr bool kAdd = std::is_same_v<TOp, IRAddOp>;
+            std::optional<Address> address{};
+            if (op->rhs.immediate) {
+                address = GetAddress(op->lhs);
+                if (address) {
+                    address->offset = kAdd ? address->offset + op->rhs.imm.value : address->offset - op->rhs.imm.value;
+                }
+            } else if (kAdd && op->lhs.immediate) {
+                address = GetAddress(op->rhs);
+                if (address) {
+                    address->offset += op->lhs.imm.value;
+                }
+            }
+            SetAddress(op->dst, address);
+        } else if constexpr (std::is_same_v<TOp, IRAddCarryOp> || std::is_same_v<TOp, IRSubtractCarryOp>) {
+            if (!ReadFlags(arm::Flags::C)) {
+                return false;
+            }
+        } else if constexpr (std::is_same_v<TOp, IRLogicalShiftLeftOp> || std::is_same_v<TOp, IRLogicalShiftRightOp> ||
+                             std::is_same_v<TOp, IRArithmeticShiftRightOp> || std::is_same_v<TOp, IRRotateRightOp>) {
+            // Shifts by zero preserve the carry flag
+            if (op->setCarry && (!ReadFlags(arm::Flags::C) || !WriteFlags(arm::Flags::C))) {
+                return false;
+            }
+        } else if constexpr (std::is_same_v<TOp, IRRotateRightExtendedOp>) {
+            if (!ReadFlags(arm::Flags::C) || (op->setCarry && !WriteFlags(arm::Flags::C))) {
+                return false;
+            }
+        }
+
+        // ALU operations that update the host flags
+        if constexpr (!std::is_same_v<TOp, IRLoadFlagsOp> && !std::is_same_v<TOp, IRStoreFlagsOp> &&
+                      requires { op->flags; }) {
+            if (!WriteFlags(op->flags & arm::Flags::NZCV)) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+bool PollingLoopAnalyzer::ReadRegister(const GPRArg &reg) {
+    const uint16_t bit = 1u << static_cast<uint16_t>(reg.gpr);
+    if (m_writtenRegs & bit) {
+        return true;
+    }
+    if (m_maybeWrittenRegs & bit) {
+        // The value may come from this or from a previous iteration
+        return false;
+    }
+    m_inputRegs |= bit;
+    return true;
+}
+
+bool PollingLoopAnalyzer::WriteRegister(const GPRArg &reg, const VarOrImmArg &value) {
+    const uint16_t bit = 1u << static_cast<uint16_t>(reg.gpr);
+    if (m_inputRegs & bit) {
+        return false;
+    }
+    auto &regAddress = m_regAddresses[static_cast<size_t>(reg.gpr)];
+    if (m_conditional) {
+        m_maybeWrittenRegs |= bit;
+        regAddress = std::nullopt;
+    } else {
+        m_writtenRegs |= bit;
+        auto address = GetAddress(value);
+        if (address) {
+            regAddress = RegisterAddress{.index = reg.Index(), .address = *address};
+        } else {
+            regAddress = std::nullopt;
+        }
+    }
+    return true;
+}
+
+bool PollingLoopAnalyzer::ReadFlags(arm::Flags flags) {
+    const auto unwritten = flags & ~m_writtenFlags;
+    if ((unwritten & m_maybeWrittenFlags) != arm::Flags::None) {
+        return false;
+    }
+    m_inputFlags |= unwritten;
+    return true;
+}
+
+bool PollingLoopAnalyzer::WriteFlags(arm::Flags flags) {
+    if ((flags & m_inputFlags) != arm::Flags::None) {
+        return false;
+    }
+    if (m_conditional) {
+        m_maybeWrittenFlags |= flags;
+    } else {
+        m_writtenFlags |= flags;
+    }
+    return true;
+}
+
+auto PollingLoopAnalyzer::GetAddress(const VarOrImmArg &arg) const -> std::optional<Address> {
+    if (arg.immediate) {
+        return Address{.offset = arg.imm.value};
+    }
+    if (!arg.var.var.IsPresent()) {
+        return std::nullopt;
+    }
+    return m_varAddresses[arg.var.var.Index()];
+}
+
+void PollingLoopAnalyzer::SetAddress(const VariableArg &var, std::optional<Address> address) {
+    if (var.var.IsPresent()) {
+        m_varAddresses[var.var.Index()] = address;
+    }
+}
+
+bool PollingLoopAnalyzer::IsCPSRVar(const VarOrImmArg &arg) const {
+    return !arg.immediate && arg.var.var.IsPresent() && m_cpsrVars[arg.var.var.Index()];
+}
+
+bool PollingLoopAnalyzer::CheckRead(const Address &address, MemAccessSize size) {
+    uint32_t resolvedAddress = address.offset;
+    if (address.base) {
+        const auto &base = *address.base;
+        const uint32_t value = m_context.GetARMState().GPR(base.gpr, base.Mode());
+        resolvedAddress += value;
+
+        auto guards = std::span{m_guards.data(), m_guardCount};
+        auto it = std::find_if(guards.begin(), guards.end(),
+                               [&](const auto &guard) { return guard.reg.Index() == base.Index(); });
+        if (it == guards.end()) {
+            if (m_guardCount == m_guards.size()) {
+                return false;
+            }
+            m_guards[m_guardCount++] = {.reg = base, .value = value};
+        }
+    }
+
+    const uint32_t alignedAddress = resolvedAddress & ~((1u << static_cast<uint32_t>(size)) - 1);
+
+    // Reads from plain memory are assumed to be stable, as with idle loops contained in a single block
+    auto *ptr = m_memMap.dataRead.GetPointer<uint8_t>(alignedAddress);
+    if (ptr != nullptr) {
+        auto attrs = BitmaskEnum(m_memMap.dataRead.GetAttributes(alignedAddress));
+        if (attrs.AnyOf(MemoryAttributes::Readable) && attrs.NoneOf(MemoryAttributes::Volatile)) {
+            m_dependsOnMemMap = true;
+            return true;
+        }
+    }
+
+    // Memory-mapped registers may change at any time
+    return m_context.GetSystem().CanSkipPollingLoop(alignedAddress);
+}
+
+} // namespace armajitto::ir
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "armajitto/core/context.hpp"
+#include "core/memory_map_priv_access.hpp"
+
+#include "basic_block.hpp"
+#include "ir_ops.hpp"
+
+#include "guest/arm/flags.hpp"
+
+#include <array>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace armajitto::ir {
+
+// Determines if a loop spanning one or more basic blocks behaves identically on every iteration, allowing the host to
+// skip it until the cycle count deadline is reached.
+//
+// Polling loops usually span several blocks since the loop condition ends the block that reads the polled value:
+//   loop:
+//     ldrh r0, [r1]      ; block A (AL)
+//     cmp r0, #0xA0
+//     bne loop           ; block B (NE), branches back to A
+//
+// The blocks of the loop are analyzed in execution order as a single iteration, ending with the block that branches
+// back to the loop entry. An iteration may be skipped if:
+// - The blocks fall through to each other. Conditional blocks that branch elsewhere leave the loop and are ignored
+//   except for their condition check.
+// - It produces no side-effects: no memory writes, coprocessor register writes with side-effects, SPSR writes or CPSR
+//   writes other than copies of the host flags.
+// - No register or flag is read and later modified, that is, no state is carried over to the next iteration.
+// - Memory reads target constant addresses or registers that are not modified by the loop plus a constant offset.
+//   Reads from unmapped or Volatile regions must be confirmed by ISystem::CanSkipPollingLoop.
+//
+// Register-based addresses are resolved with the register values at the time of the analysis, which are returned as
+// guards to be checked at runtime before skipping the loop.
+class PollingLoopAnalyzer {
+public:
+    PollingLoopAnalyzer(Context &context, std::pmr::memory_resource &alloc);
+
+    // Starts the analysis of a new loop.
+    void Reset();
+
+    // Analyzes the next block of the loop. <last> indicates the block that branches back to the loop entry.
+    // Returns false if the loop cannot be skipped.
+    bool Analyze(const BasicBlock &block, bool last);
+
+    // Register values required for the loop to be skipped.
+    std::span<const BasicBlock::IdleLoopGuard> Guards() const {
+        return {m_guards.data(), m_guardCount};
+    }
+
+    // Determines if the analysis relied on the current layout of the memory map to assume reads to be stable.
+    bool DependsOnMemoryMap() const {
+        return m_dependsOnMemMap;
+    }
+
+private:
+    Context &m_context;
+    MemoryMapPrivateAccess m_memMap;
+    bool m_dependsOnMemMap = false;
+
+    // Value of a loop-invariant register (if present) plus a constant offset
+    struct Address {
+        std::optional<GPRArg> base;
+        uint32_t offset = 0;
+    };
+
+    // Address values assigned to registers within the iteration
+    struct RegisterAddress {
+        size_t index; // GPRArg::Index()
+        Address address;
+    };
+
+    std::pmr::vector<std::optional<Address>> m_varAddresses;
+    std::pmr::vector<bool> m_cpsrVars; // variables holding the CPSR value
+    std::array<std::optional<RegisterAddress>, 16> m_regAddresses;
+
+    // Registers and flags read before being written in the iteration, written by the iteration, and written by
+    // conditional blocks that may be skipped
+    uint16_t m_inputRegs;
+    uint16_t m_writtenRegs;
+    uint16_t m_maybeWrittenRegs;
+    arm::Flags m_inputFlags;
+    arm::Flags m_writtenFlags;
+    arm::Flags m_maybeWrittenFlags;
+
+    // Whether the block being analyzed may be skipped by its condition check
+    bool m_conditional;
+
+    std::array<BasicBlock::IdleLoopGuard, BasicBlock::kMaxIdleLoopGuards> m_guards;
+    size_t m_guardCount;
+
+    bool AnalyzeOp(const IROp *op, bool last);
+
+    bool ReadRegister(const GPRArg &reg);
+    bool WriteRegister(const GPRArg &reg, const VarOrImmArg &value);
+    bool ReadFlags(arm::Flags flags);
+    bool WriteFlags(arm::Flags flags);
+
+    std::optional<Address> GetAddress(const VarOrImmArg &arg) const;
+    void SetAddress(const VariableArg &var, std::optional<Address> address);
+    bool IsCPSRVar(const VarOrImmArg &arg) const;
+
+    // Determines if the memory read may be skipped, adding a guard for the base register if necessary.
+    bool CheckRead(const Address &address, MemAccessSize size);
+};
+
+} // namespace armajitto::ir
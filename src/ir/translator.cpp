@@ -2,6 +2,7 @@
 
 #include "defs/arguments.hpp"
 #include "ir/defs/memory_access.hpp"
+#include "ir/loop_idiom_matcher.hpp"
 
 #include "guest/arm/flags.hpp"
 #include "guest/arm/instructions.hpp"
@@ -12,6 +13,7 @@
 #include "util/bit_ops.hpp"
 #include "util/unreachable.hpp"
 
+#include <algorithm>
 #include <bit>
 
 // Cycle counting notes:
@@ -33,6 +35,7 @@ void Translator::Translate(BasicBlock &block) {
 
     m_flagsUpdated = false;
     m_endBlock = false;
+    m_fetchedOpcodes.clear();
 
     const bool thumb = block.Location().IsThumbMode();
     const uint32_t opcodeSize = thumb ? sizeof(uint16_t) : sizeof(uint32_t);
@@ -40,6 +43,17 @@ void Translator::Translate(BasicBlock &block) {
     const bool fixedCyclesPerInstruction =
         (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::InstructionFixed);
 
+    m_fetchSize = thumb ? MemAccessSize::Half : MemAccessSize::Word;
+    m_codeTimings = nullptr;
+    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionTimingTable) {
+        MemoryMapPrivateAccess memMap{m_context.GetSystem().GetMemoryMap()};
+        m_codeTimings = &memMap.codeReadTimings;
+        emitter.EnableMemAccessTiming();
+    }
+    // Aborted accesses count the cycles of the block so far plus the pipeline refill at the vector, or one instruction
+    // when using fixed cycles per instruction
+    emitter.SetAbortRefillCycles(fixedCyclesPerInstruction ? m_options.cyclesPerInstruction : DataAbortRefillCycles());
+
     auto parseARMCond = [](uint32_t opcode, CPUArch arch) {
         const auto cond = static_cast<Condition>(bit::extract<28, 4>(opcode));
         if (arch == CPUArch::ARMv5TE && cond == Condition::NV) {
@@ -67,25 +81,38 @@ void Translator::Translate(BasicBlock &block) {
         }
     };
 
+    // Allow execution to stop every few instructions
+    const uint32_t checkInterval = m_options.deadlineCheckInterval;
+    auto insertDeadlineCheck = [&](uint32_t i) {
+        if (checkInterval != 0 && i != 0 && i % checkInterval == 0) {
+            emitter.Checkpoint();
+        }
+    };
+
     uint32_t address = block.Location().PC() - opcodeSize * 2;
     for (uint32_t i = 0; i < m_options.maxBlockSize; i++) {
+        m_instrAddress = address;
         if (thumb) {
             const uint16_t opcode = CodeReadHalf(address);
+            m_fetchedOpcodes.push_back(opcode);
             const Condition cond = parseThumbCond(opcode);
             if (i == 0) {
                 emitter.SetCondition(cond);
             } else if (cond != block.Condition()) {
                 break;
             }
+            insertDeadlineCheck(i);
             TranslateThumb(opcode, emitter);
         } else {
             const uint32_t opcode = CodeReadWord(address);
+            m_fetchedOpcodes.push_back(opcode);
             const Condition cond = parseARMCond(opcode, arch);
             if (i == 0) {
                 emitter.SetCondition(cond);
             } else if (cond != block.Condition()) {
                 break;
             }
+            insertDeadlineCheck(i);
             TranslateARM(opcode, emitter);
         }
 
@@ -108,6 +135,117 @@ void Translator::Translate(BasicBlock &block) {
 
     if (!m_endBlock) {
         emitter.TerminateContinueExecution();
+
+        // Copy and fill loops end on a conditional branch, which breaks the block right before it
+        if (m_options.idiomRecognition && m_codeTimings == nullptr) {
+            MatchLoopIdiom(block, emitter);
+        }
+    }
+}
+
+void Translator::MatchLoopIdiom(BasicBlock &block, Emitter &emitter) {
+    const auto loc = block.Location();
+    const bool thumb = loc.IsThumbMode();
+    const uint32_t opcodeSize = thumb ? sizeof(uint16_t) : sizeof(uint32_t);
+    const uint32_t startAddress = loc.PC() - opcodeSize * 2;
+    const uint32_t count = std::min(block.InstructionCount() + 1, LoopIdiomMatcher::kMaxInstructions);
+
+    std::optional<BasicBlock::LoopIdiom> idiom;
+    if (thumb) {
+        std::array<uint16_t, LoopIdiomMatcher::kMaxInstructions> opcodes{};
+        for (uint32_t i = 0; i < count; i++) {
+            opcodes[i] = CodeReadHalf(startAddress + i * opcodeSize);
+        }
+        if (count > m_fetchedOpcodes.size()) {
+            m_fetchedOpcodes.push_back(opcodes[count - 1]);
+        }
+        idiom = LoopIdiomMatcher::MatchThumb({opcodes.data(), count}, startAddress, loc.Mode());
+    } else {
+        std::array<uint32_t, LoopIdiomMatcher::kMaxInstructions> opcodes{};
+        for (uint32_t i = 0; i < count; i++) {
+            opcodes[i] = CodeReadWord(startAddress + i * opcodeSize);
+        }
+        if (count > m_fetchedOpcodes.size()) {
+            m_fetchedOpcodes.push_back(opcodes[count - 1]);
+        }
+        idiom = LoopIdiomMatcher::MatchARM({opcodes.data(), count}, startAddress, loc.Mode());
+    }
+
+    // The block must hold the entire loop body and nothing else
+    if (!idiom || idiom->instrCount != block.InstructionCount() + 1) {
+        return;
+    }
+
+    // An iteration takes the cycles of this block plus those of the taken branch
+    m_instrAddress = startAddress + block.InstructionCount() * opcodeSize;
+    idiom->cyclesPerIteration = block.PassCycles();
+    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::InstructionFixed) {
+        idiom->cyclesPerIteration += m_options.cyclesPerInstruction;
+    } else {
+        idiom->cyclesPerIteration += PipelineRefillCycles(startAddress, m_fetchSize);
+    }
+    if (idiom->cyclesPerIteration == 0) {
+        return;
+    }
+
+    emitter.SetLoopIdiom(*idiom);
+}
+
+bool Translator::IsSubinstructionCycleCounting() const {
+    using Method = Options::Translator::CycleCountingMethod;
+    return m_options.cycleCountingMethod == Method::SubinstructionFixed ||
+           m_options.cycleCountingMethod == Method::SubinstructionTimingTable;
+}
+
+uint64_t Translator::CodeCycles(MemAccessType type) const {
+    if (m_codeTimings != nullptr) {
+        return MemoryMapPrivateAccess::GetAccessCycles(*m_codeTimings, m_instrAddress, m_fetchSize, type);
+    }
+    return m_options.cyclesPerMemoryAccess;
+}
+
+uint64_t Translator::PipelineRefillCycles() const {
+    return CodeCycles(MemAccessType::Nonsequential) + CodeCycles(MemAccessType::Sequential) * 2;
+}
+
+uint64_t Translator::PipelineRefillCycles(uint32_t targetAddress, MemAccessSize fetchSize) {
+    const uint32_t instrAddress = m_instrAddress;
+    const MemAccessSize instrFetchSize = m_fetchSize;
+    m_instrAddress = targetAddress;
+    m_fetchSize = fetchSize;
+    const uint64_t cycles = PipelineRefillCycles();
+    m_instrAddress = instrAddress;
+    m_fetchSize = instrFetchSize;
+    return cycles;
+}
+
+uint64_t Translator::DataAbortRefillCycles() {
+    auto &cp15 = m_context.GetARMState().GetSystemControlCoprocessor();
+    const uint32_t baseVectorAddress = cp15.IsPresent() ? cp15.GetControlRegister().baseVectorAddress : 0;
+
+    // The exception handler runs in ARM mode
+    return PipelineRefillCycles(baseVectorAddress + static_cast<uint32_t>(arm::Exception::DataAbort) * sizeof(uint32_t),
+                                MemAccessSize::Word);
+}
+
+uint64_t Translator::DataCycles(uint32_t count) const {
+    if (m_codeTimings != nullptr) {
+        return 0;
+    }
+    return m_options.cyclesPerMemoryAccess * count;
+}
+
+uint64_t Translator::ParallelCodeCycles(Emitter &emitter, MemAccessType type) const {
+    const uint64_t cycles = CodeCycles(type);
+    emitter.SetLastMemAccessParallelCycles(static_cast<uint8_t>(std::min<uint64_t>(cycles, 0xFF)));
+    return cycles;
+}
+
+uint32_t Translator::FetchOpcode(LocationRef loc, uint32_t index) {
+    if (loc.IsThumbMode()) {
+        return CodeReadHalf(loc.PC() - sizeof(uint16_t) * 2 + index * sizeof(uint16_t));
+    } else {
+        return CodeReadWord(loc.PC() - sizeof(uint32_t) * 2 + index * sizeof(uint32_t));
     }
 }
 
@@ -450,15 +588,20 @@ void Translator::Translate(const BranchOffset &instr, Emitter &emitter) {
 
     m_endBlock = true;
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv4T:
         //   Pass: 1N + 2S to fetch and fill pipeline
         //   Fail: 1S to fetch next instruction
         // ARMv5TE:
         //   Pass: N|I, S|I, S|I to fetch and fill pipeline
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        // The target is known, so the pipeline is refilled from its memory region
+        const bool thumb = m_fetchSize == MemAccessSize::Half;
+        const bool targetThumb = thumb != instr.IsExchange();
+        const uint32_t pcValue = m_instrAddress + (thumb ? sizeof(uint16_t) : sizeof(uint32_t)) * 2;
+        const uint32_t target = (pcValue + instr.offset) & (targetThumb ? ~1u : ~3u);
+        emitter.AddPassCycles(PipelineRefillCycles(target, targetThumb ? MemAccessSize::Half : MemAccessSize::Word));
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -471,15 +614,15 @@ void Translator::Translate(const BranchExchangeRegister &instr, Emitter &emitter
 
     m_endBlock = true;
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv4T:
         //   Pass: 1N + 2S to fetch and fill pipeline
         //   Fail: 1S to fetch next instruction
         // ARMv5TE:
         //   Pass: N|I, S|I, S|I to fetch and fill pipeline
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(PipelineRefillCycles());
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -498,15 +641,15 @@ void Translator::Translate(const ThumbLongBranchSuffix &instr, Emitter &emitter)
 
     m_endBlock = true;
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv4T:
         //   Pass: 1N + 2S to fetch and fill pipeline
         //   Fail: 1S to fetch next instruction
         // ARMv5TE:
         //   Pass: N|I, S|I, S|I to fetch and fill pipeline
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(PipelineRefillCycles());
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -528,7 +671,7 @@ void Translator::Translate(const DataProcessing &instr, Emitter &emitter) {
 
     // ARMv4T: 1I if using register specified shift
     // ARMv5TE: I|I if using register specified shift
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         if (!instr.rhs.shift.immediate) {
             emitter.AddPassCycles(1);
         }
@@ -618,15 +761,15 @@ void Translator::Translate(const DataProcessing &instr, Emitter &emitter) {
 
         m_endBlock = true;
 
-        if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+        if (IsSubinstructionCycleCounting()) {
             // ARMv4T:
             //   Pass: 1N + 2S to fetch and fill pipeline
             //   Fail: 1S to fetch next instruction
             // ARMv5TE:
             //   Pass: N|I, S|I, S|I to fetch and fill pipeline
             //   Fail: S|I to fetch next instruction
-            emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
-            emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+            emitter.AddPassCycles(PipelineRefillCycles());
+            emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
         }
     } else {
         m_flagsUpdated = updateFlags;
@@ -636,15 +779,15 @@ void Translator::Translate(const DataProcessing &instr, Emitter &emitter) {
             emitter.FetchInstruction();
         }
 
-        if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+        if (IsSubinstructionCycleCounting()) {
             // ARMv4T:
             //   Pass: 1S to fetch next instruction
             //   Fail: 1S to fetch next instruction
             // ARMv5TE:
             //   Pass: S|I to fetch next instruction
             //   Fail: S|I to fetch next instruction
-            emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
-            emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+            emitter.AddPassCycles(CodeCycles(MemAccessType::Sequential));
+            emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
         }
     }
 }
@@ -656,15 +799,15 @@ void Translator::Translate(const CountLeadingZeros &instr, Emitter &emitter) {
 
     emitter.FetchInstruction();
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv4T:
         //   Pass: 1S to fetch next instruction
         //   Fail: 1S to fetch next instruction
         // ARMv5TE:
         //   Pass: S|I to fetch next instruction
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(CodeCycles(MemAccessType::Sequential));
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -687,15 +830,15 @@ void Translator::Translate(const SaturatingAddSub &instr, Emitter &emitter) {
 
     emitter.FetchInstruction();
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv4T:
         //   Pass: 1S to fetch next instruction
         //   Fail: 1S to fetch next instruction
         // ARMv5TE:
         //   Pass: S|I to fetch next instruction
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(CodeCycles(MemAccessType::Sequential));
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -706,7 +849,7 @@ void Translator::Translate(const MultiplyAccumulate &instr, Emitter &emitter) {
     auto result = emitter.Multiply(lhs, rhs, false, instr.setFlags);
     if (instr.accumulate) {
         auto acc = emitter.GetRegister(instr.accReg);
-        result = emitter.Add(result, acc, instr.setFlags);
+        result = instr.setFlags ? emitter.AddNZ(result, acc) : emitter.Add(result, acc, false);
     }
     emitter.SetRegisterExceptPC(instr.dstReg, result);
 
@@ -717,7 +860,7 @@ void Translator::Translate(const MultiplyAccumulate &instr, Emitter &emitter) {
 
     emitter.FetchInstruction();
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         switch (m_context.GetCPUArch()) {
         case CPUArch::ARMv4T:
             // TODO: variable I cycles based on multiplier
@@ -743,8 +886,8 @@ void Translator::Translate(const MultiplyAccumulate &instr, Emitter &emitter) {
         // ARMv5TE:
         //   Pass: S|I to fetch next instruction
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(CodeCycles(MemAccessType::Sequential));
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -768,7 +911,7 @@ void Translator::Translate(const MultiplyAccumulateLong &instr, Emitter &emitter
 
     emitter.FetchInstruction();
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         switch (m_context.GetCPUArch()) {
         case CPUArch::ARMv4T:
             // TODO: variable I cycles based on multiplier
@@ -794,8 +937,8 @@ void Translator::Translate(const MultiplyAccumulateLong &instr, Emitter &emitter
         // ARMv5TE:
         //   Pass: S|I to fetch next instruction
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(CodeCycles(MemAccessType::Sequential));
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -822,12 +965,12 @@ void Translator::Translate(const SignedMultiplyAccumulate &instr, Emitter &emitt
 
     emitter.FetchInstruction();
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // Note: not available on ARMv4T
         // Pass: S|I to fetch next instruction
         // Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(CodeCycles(MemAccessType::Sequential));
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -855,12 +998,12 @@ void Translator::Translate(const SignedMultiplyAccumulateWord &instr, Emitter &e
 
     emitter.FetchInstruction();
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // Note: not available on ARMv4T
         // Pass: S|I to fetch next instruction
         // Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(CodeCycles(MemAccessType::Sequential));
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -886,7 +1029,7 @@ void Translator::Translate(const SignedMultiplyAccumulateLong &instr, Emitter &e
 
     emitter.FetchInstruction();
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // Note: not available on ARMv4T
 
         // I|I to perform operation
@@ -894,8 +1037,8 @@ void Translator::Translate(const SignedMultiplyAccumulateLong &instr, Emitter &e
 
         // Pass: S|I to fetch next instruction
         // Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(CodeCycles(MemAccessType::Sequential));
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -910,7 +1053,7 @@ void Translator::Translate(const PSRRead &instr, Emitter &emitter) {
 
     emitter.FetchInstruction();
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv5TE: I|I to update PSR
         if (m_context.GetCPUArch() == CPUArch::ARMv5TE) {
             emitter.AddPassCycles(1);
@@ -922,8 +1065,8 @@ void Translator::Translate(const PSRRead &instr, Emitter &emitter) {
         // ARMv5TE:
         //   Pass: S|I to fetch next instruction
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(CodeCycles(MemAccessType::Sequential));
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -986,7 +1129,7 @@ void Translator::Translate(const PSRWrite &instr, Emitter &emitter) {
         m_endBlock = true;
     }
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv5TE: I|I, I|I to load anything but flags
         if (m_context.GetCPUArch() == CPUArch::ARMv5TE) {
             if (instr.s || instr.x || instr.c) {
@@ -1000,8 +1143,8 @@ void Translator::Translate(const PSRWrite &instr, Emitter &emitter) {
         // ARMv5TE:
         //   Pass: S|I to fetch next instruction
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(CodeCycles(MemAccessType::Sequential));
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -1015,7 +1158,7 @@ void Translator::Translate(const SingleDataTransfer &instr, Emitter &emitter) {
 
     // ARMv4T: 1I if using register specified shift
     // ARMv5TE: I|I if using register specified shift
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         if (!instr.address.shift.immediate) {
             emitter.AddPassCycles(1);
         }
@@ -1085,7 +1228,7 @@ void Translator::Translate(const SingleDataTransfer &instr, Emitter &emitter) {
 
         m_endBlock = true;
 
-        if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+        if (IsSubinstructionCycleCounting()) {
             switch (m_context.GetCPUArch()) {
             case CPUArch::ARMv4T:
                 // 1I for loads
@@ -1094,25 +1237,25 @@ void Translator::Translate(const SingleDataTransfer &instr, Emitter &emitter) {
                 }
 
                 // 1N to transfer data
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+                emitter.AddPassCycles(DataCycles(1));
 
                 // 1N + 2S to fetch and fill pipeline
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
+                emitter.AddPassCycles(PipelineRefillCycles());
                 break;
             case CPUArch::ARMv5TE:
                 // I|I for PC load operation
                 emitter.AddPassCycles(1);
 
                 // I|N to transfer data
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+                emitter.AddPassCycles(DataCycles(1));
 
                 // N|I, S|I, S|I to fetch and fill pipeline
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
+                emitter.AddPassCycles(PipelineRefillCycles());
                 break;
             }
         }
     } else {
-        if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+        if (IsSubinstructionCycleCounting()) {
             switch (m_context.GetCPUArch()) {
             case CPUArch::ARMv4T:
                 // 1I for loads
@@ -1121,25 +1264,25 @@ void Translator::Translate(const SingleDataTransfer &instr, Emitter &emitter) {
                 }
 
                 // 1N to transfer data
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+                emitter.AddPassCycles(DataCycles(1));
 
                 // 1N to fetch next instruction
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+                emitter.AddPassCycles(CodeCycles(MemAccessType::Nonsequential));
                 break;
             case CPUArch::ARMv5TE:
                 // S|N to fetch next instruction and transfer data
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+                emitter.AddPassCycles(ParallelCodeCycles(emitter, MemAccessType::Sequential));
                 break;
             }
         }
     }
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv4T:
         //   Fail: 1S to fetch next instruction
         // ARMv5TE:
         //   Fail: S|I to fetch next instruction
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -1256,7 +1399,7 @@ void Translator::Translate(const HalfwordAndSignedTransfer &instr, Emitter &emit
         }
         m_endBlock = true;
 
-        if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+        if (IsSubinstructionCycleCounting()) {
             switch (m_context.GetCPUArch()) {
             case CPUArch::ARMv4T:
                 // 1I for loads
@@ -1265,25 +1408,25 @@ void Translator::Translate(const HalfwordAndSignedTransfer &instr, Emitter &emit
                 }
 
                 // 1N to transfer data
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+                emitter.AddPassCycles(DataCycles(1));
 
                 // 1N + 2S to fetch and fill pipeline
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
+                emitter.AddPassCycles(PipelineRefillCycles());
                 break;
             case CPUArch::ARMv5TE:
                 // I|I for PC load operation
                 emitter.AddPassCycles(1);
 
                 // I|N to transfer data
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+                emitter.AddPassCycles(DataCycles(1));
 
                 // N|I, S|I, S|I to fetch and fill pipeline
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
+                emitter.AddPassCycles(PipelineRefillCycles());
                 break;
             }
         }
     } else {
-        if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+        if (IsSubinstructionCycleCounting()) {
             switch (m_context.GetCPUArch()) {
             case CPUArch::ARMv4T:
                 // 1I for loads
@@ -1292,31 +1435,31 @@ void Translator::Translate(const HalfwordAndSignedTransfer &instr, Emitter &emit
                 }
 
                 // 1N to transfer data
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+                emitter.AddPassCycles(DataCycles(1));
 
                 // 1N to fetch next instruction
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+                emitter.AddPassCycles(CodeCycles(MemAccessType::Nonsequential));
                 break;
             case CPUArch::ARMv5TE:
                 // Handle LDRD and STRD
                 if (!instr.load && instr.sign) {
                     // N|I to transfer first portion of data
-                    emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+                    emitter.AddPassCycles(DataCycles(1));
                 }
 
                 // S|N to fetch next instruction and transfer data
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+                emitter.AddPassCycles(ParallelCodeCycles(emitter, MemAccessType::Sequential));
                 break;
             }
         }
     }
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv4T:
         //   Fail: 1S to fetch next instruction
         // ARMv5TE:
         //   Fail: S|I to fetch next instruction
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -1448,7 +1591,7 @@ void Translator::Translate(const BlockTransfer &instr, Emitter &emitter) {
 
         m_endBlock = true;
 
-        if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+        if (IsSubinstructionCycleCounting()) {
             switch (m_context.GetCPUArch()) {
             case CPUArch::ARMv4T:
                 // 1I for loads
@@ -1457,10 +1600,10 @@ void Translator::Translate(const BlockTransfer &instr, Emitter &emitter) {
                 }
 
                 // 1N + nS to transfer data
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * std::popcount(instr.regList));
+                emitter.AddPassCycles(DataCycles(std::popcount(instr.regList)));
 
                 // 1N + 2S to fetch and fill pipeline
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
+                emitter.AddPassCycles(PipelineRefillCycles());
                 break;
             case CPUArch::ARMv5TE: {
                 // I|I for PC load operation
@@ -1468,16 +1611,16 @@ void Translator::Translate(const BlockTransfer &instr, Emitter &emitter) {
 
                 // I|N, I|S, ... to transfer data
                 const uint32_t numTransfers = std::popcount(instr.regList);
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * numTransfers);
+                emitter.AddPassCycles(DataCycles(numTransfers));
 
                 // N|I, S|I, S|I to fetch and fill pipeline
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
+                emitter.AddPassCycles(PipelineRefillCycles());
                 break;
             }
             }
         }
     } else {
-        if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+        if (IsSubinstructionCycleCounting()) {
             switch (m_context.GetCPUArch()) {
             case CPUArch::ARMv4T:
                 // 1I for loads
@@ -1486,10 +1629,10 @@ void Translator::Translate(const BlockTransfer &instr, Emitter &emitter) {
                 }
 
                 // 1N + nS to transfer data
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * std::popcount(instr.regList));
+                emitter.AddPassCycles(DataCycles(std::popcount(instr.regList)));
 
                 // 1N to fetch next instruction
-                emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+                emitter.AddPassCycles(CodeCycles(MemAccessType::Nonsequential));
                 break;
             case CPUArch::ARMv5TE: {
                 // I|I for PC load operation
@@ -1498,18 +1641,18 @@ void Translator::Translate(const BlockTransfer &instr, Emitter &emitter) {
                 const uint32_t numTransfers = std::popcount(instr.regList);
                 if (numTransfers > 1) {
                     // I|N, I|S, ... to transfer data (except the last transfer)
-                    emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * (numTransfers - 1));
+                    emitter.AddPassCycles(DataCycles(numTransfers - 1));
 
                     // S|S to perform the last transfer and fetch next instruction
-                    emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+                    emitter.AddPassCycles(ParallelCodeCycles(emitter, MemAccessType::Sequential));
                 } else {
                     if (numTransfers == 1) {
                         // I|N to transfer data
-                        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+                        emitter.AddPassCycles(DataCycles(1));
                     }
 
                     // S|I to fetch next instruction
-                    emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+                    emitter.AddPassCycles(CodeCycles(MemAccessType::Sequential));
                 }
                 break;
             }
@@ -1517,12 +1660,12 @@ void Translator::Translate(const BlockTransfer &instr, Emitter &emitter) {
         }
     }
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv4T:
         //   Fail: 1S to fetch next instruction
         // ARMv5TE:
         //   Fail: S|I to fetch next instruction
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -1539,28 +1682,29 @@ void Translator::Translate(const SingleDataSwap &instr, Emitter &emitter) {
         value = emitter.MemRead(MemAccessBus::Data, MemAccessMode::Unaligned, MemAccessSize::Word, address);
         emitter.MemWrite(MemAccessSize::Word, src, address);
     }
+    emitter.SetLastMemAccessType(MemAccessType::Nonsequential); // the write is also a nonsequential access
     emitter.SetRegisterExceptPC(instr.dstReg, value);
 
     emitter.FetchInstruction();
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         switch (m_context.GetCPUArch()) {
         case CPUArch::ARMv4T:
             // 1I base
             emitter.AddPassCycles(1);
 
             // 1N for the read + 1N for the write
-            emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 2);
+            emitter.AddPassCycles(DataCycles(2));
 
             // 1S to fetch next instruction
-            emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+            emitter.AddPassCycles(CodeCycles(MemAccessType::Sequential));
             break;
         case CPUArch::ARMv5TE:
             // I|N to read data
-            emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+            emitter.AddPassCycles(DataCycles(1));
 
             // S|N to write data and fetch next instruction
-            emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
+            emitter.AddPassCycles(ParallelCodeCycles(emitter, MemAccessType::Sequential));
             break;
         }
 
@@ -1568,7 +1712,7 @@ void Translator::Translate(const SingleDataSwap &instr, Emitter &emitter) {
         //   Fail: 1S to fetch next instruction
         // ARMv5TE:
         //   Fail: S|I to fetch next instruction
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -1576,15 +1720,15 @@ void Translator::Translate(const SoftwareInterrupt &instr, Emitter &emitter) {
     emitter.EnterException(arm::Exception::SoftwareInterrupt);
     m_endBlock = true;
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv4T:
         //   Pass: 1N + 2S to fetch and fill pipeline
         //   Fail: 1S to fetch next instruction
         // ARMv5TE:
         //   Pass: N|I, S|I, S|I to fetch and fill pipeline
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(PipelineRefillCycles());
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -1592,15 +1736,15 @@ void Translator::Translate(const SoftwareBreakpoint &instr, Emitter &emitter) {
     emitter.EnterException(arm::Exception::PrefetchAbort);
     m_endBlock = true;
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv4T:
         //   Pass: 1N + 2S to fetch and fill pipeline
         //   Fail: 1S to fetch next instruction
         // ARMv5TE:
         //   Pass: N|I, S|I, S|I to fetch and fill pipeline
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(PipelineRefillCycles());
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -1610,15 +1754,15 @@ void Translator::Translate(const Preload &instr, Emitter &emitter) {
 
     emitter.FetchInstruction();
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv4T:
         //   Pass: 1S to fetch next instruction
         //   Fail: 1S to fetch next instruction
         // ARMv5TE:
         //   Pass: S|I to fetch next instruction
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(CodeCycles(MemAccessType::Sequential));
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -1627,15 +1771,15 @@ void Translator::Translate(const CopDataOperations &instr, Emitter &emitter) {
     emitter.EnterException(arm::Exception::UndefinedInstruction);
     m_endBlock = true;
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv4T:
         //   Pass: 1N + 2S to fetch and fill pipeline
         //   Fail: 1S to fetch next instruction
         // ARMv5TE:
         //   Pass: N|I, S|I, S|I to fetch and fill pipeline
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(PipelineRefillCycles());
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -1644,15 +1788,15 @@ void Translator::Translate(const CopDataTransfer &instr, Emitter &emitter) {
     emitter.EnterException(arm::Exception::UndefinedInstruction);
     m_endBlock = true;
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv4T:
         //   Pass: 1N + 2S to fetch and fill pipeline
         //   Fail: 1S to fetch next instruction
         // ARMv5TE:
         //   Pass: N|I, S|I, S|I to fetch and fill pipeline
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(PipelineRefillCycles());
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -1662,15 +1806,15 @@ void Translator::Translate(const CopRegTransfer &instr, Emitter &emitter) {
         emitter.EnterException(arm::Exception::UndefinedInstruction);
         m_endBlock = true;
 
-        if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+        if (IsSubinstructionCycleCounting()) {
             // ARMv4T:
             //   Pass: 1N + 2S to fetch and fill pipeline
             //   Fail: 1S to fetch next instruction
             // ARMv5TE:
             //   Pass: N|I, S|I, S|I to fetch and fill pipeline
             //   Fail: S|I to fetch next instruction
-            emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
-            emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+            emitter.AddPassCycles(PipelineRefillCycles());
+            emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
         }
         return;
     }
@@ -1678,15 +1822,15 @@ void Translator::Translate(const CopRegTransfer &instr, Emitter &emitter) {
         emitter.EnterException(arm::Exception::UndefinedInstruction);
         m_endBlock = true;
 
-        if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+        if (IsSubinstructionCycleCounting()) {
             // ARMv4T:
             //   Pass: 1N + 2S to fetch and fill pipeline
             //   Fail: 1S to fetch next instruction
             // ARMv5TE:
             //   Pass: N|I, S|I, S|I to fetch and fill pipeline
             //   Fail: S|I to fetch next instruction
-            emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
-            emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+            emitter.AddPassCycles(PipelineRefillCycles());
+            emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
         }
         return;
     }
@@ -1717,7 +1861,7 @@ void Translator::Translate(const CopRegTransfer &instr, Emitter &emitter) {
 
     emitter.FetchInstruction();
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // TODO: coprocessor timings
 
         // ARMv4T:
@@ -1726,8 +1870,8 @@ void Translator::Translate(const CopRegTransfer &instr, Emitter &emitter) {
         // ARMv5TE:
         //   Pass: S|I to fetch next instruction
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(CodeCycles(MemAccessType::Sequential));
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -1736,15 +1880,15 @@ void Translator::Translate(const CopDualRegTransfer &instr, Emitter &emitter) {
     emitter.EnterException(arm::Exception::UndefinedInstruction);
     m_endBlock = true;
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv4T:
         //   Pass: 1N + 2S to fetch and fill pipeline
         //   Fail: 1S to fetch next instruction
         // ARMv5TE:
         //   Pass: N|I, S|I, S|I to fetch and fill pipeline
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(PipelineRefillCycles());
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -1752,15 +1896,15 @@ void Translator::Translate(const Undefined &instr, Emitter &emitter) {
     emitter.EnterException(arm::Exception::UndefinedInstruction);
     m_endBlock = true;
 
-    if (m_options.cycleCountingMethod == Options::Translator::CycleCountingMethod::SubinstructionFixed) {
+    if (IsSubinstructionCycleCounting()) {
         // ARMv4T:
         //   Pass: 1N + 2S to fetch and fill pipeline
         //   Fail: 1S to fetch next instruction
         // ARMv5TE:
         //   Pass: N|I, S|I, S|I to fetch and fill pipeline
         //   Fail: S|I to fetch next instruction
-        emitter.AddPassCycles(m_options.cyclesPerMemoryAccess * 3);
-        emitter.AddFailCycles(m_options.cyclesPerMemoryAccess);
+        emitter.AddPassCycles(PipelineRefillCycles());
+        emitter.AddFailCycles(CodeCycles(MemAccessType::Sequential));
     }
 }
 
@@ -3,10 +3,14 @@
 #include "armajitto/core/context.hpp"
 #include "armajitto/core/options.hpp"
 
+#include "core/memory_map_priv_access.hpp"
 #include "guest/arm/instructions.hpp"
 
 #include "emitter.hpp"
 
+#include <span>
+#include <vector>
+
 namespace armajitto::ir {
 
 // Decodes and translates ARM or Thumb instructions to armajitto's intermediate representation into a basic block.
@@ -20,6 +24,17 @@ public:
 
     void Translate(BasicBlock &block);
 
+    // Reads the opcode <index> instructions past the first instruction of the block at the specified location, as seen
+    // by the translator.
+    uint32_t FetchOpcode(LocationRef loc, uint32_t index);
+
+    // Retrieves the opcodes read by the last call to Translate(), starting from the first instruction of the block.
+    // The translation of the block depends only on these opcodes, the CPU model and the translator options, unless the
+    // SubinstructionTimingTable cycle counting method is used.
+    std::span<const uint32_t> FetchedOpcodes() const {
+        return m_fetchedOpcodes;
+    }
+
 private:
     Context &m_context;
     Options::Translator &m_options;
@@ -31,6 +46,46 @@ private:
     // Marks the end of a basic block.
     bool m_endBlock = false;
 
+    // Address and size of the instruction being translated, used to look up code fetch timings.
+    uint32_t m_instrAddress = 0;
+    MemAccessSize m_fetchSize = MemAccessSize::Word;
+
+    // Opcodes read while translating the current block
+    std::vector<uint32_t> m_fetchedOpcodes;
+
+    // Code fetch timings when using the SubinstructionTimingTable cycle counting method, nullptr otherwise.
+    const MemoryMapPrivateAccess::TimingTable *m_codeTimings = nullptr;
+
+    // Determines if S/N/I cycles are being computed.
+    bool IsSubinstructionCycleCounting() const;
+
+    // Returns the number of cycles taken by a code fetch from the current instruction's memory region.
+    uint64_t CodeCycles(MemAccessType type) const;
+
+    // Returns the number of cycles taken by the 1N + 2S code fetches that refill the pipeline after a branch.
+    // Used for branches to variable targets, which are assumed to be in the same memory region as the current
+    // instruction.
+    uint64_t PipelineRefillCycles() const;
+
+    // Returns the number of cycles taken by the 1N + 2S code fetches of the given size that refill the pipeline at the
+    // given branch target.
+    uint64_t PipelineRefillCycles(uint32_t targetAddress, MemAccessSize fetchSize);
+
+    // Returns the number of cycles taken by the 1N + 2S code fetches that refill the pipeline at the data abort vector.
+    uint64_t DataAbortRefillCycles();
+
+    // Returns the number of cycles taken by the specified number of data transfers.
+    // With timing tables, transfers are counted by the host at each memory access, so this returns zero.
+    uint64_t DataCycles(uint32_t count) const;
+
+    // Returns the number of cycles taken by a code fetch performed in parallel with the last data transfer of the
+    // current instruction (ARMv5TE). With timing tables, the host only counts the data transfer cycles that exceed
+    // the code fetch.
+    uint64_t ParallelCodeCycles(Emitter &emitter, MemAccessType type) const;
+
+    // Recognizes memory copy and fill loops whose body is contained in the block.
+    void MatchLoopIdiom(BasicBlock &block, Emitter &emitter);
+
     uint16_t CodeReadHalf(uint32_t address);
     uint32_t CodeReadWord(uint32_t address);
 
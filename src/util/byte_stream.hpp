@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace util {
+
+// Appends raw values to a byte buffer in host byte order.
+class ByteWriter {
+public:
+    ByteWriter(std::vector<uint8_t> &buffer)
+        : m_buffer(buffer) {}
+
+    template <typename T>
+    void Write(const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>, "value must be trivially copyable");
+        WriteBytes(&value, sizeof(T));
+    }
+
+    void WriteBytes(const void *data, size_t size) {
+        const size_t pos = m_buffer.size();
+        m_buffer.resize(pos + size);
+        if (size > 0) {
+            std::memcpy(&m_buffer[pos], data, size);
+        }
+    }
+
+private:
+    std::vector<uint8_t> &m_buffer;
+};
+
+// Reads raw values written by ByteWriter from a byte buffer.
+// Reading past the end of the buffer fails without consuming any bytes.
+class ByteReader {
+public:
+    ByteReader(std::span<const uint8_t> buffer)
+        : m_buffer(buffer) {}
+
+    template <typename T>
+    bool Read(T &value) {
+        static_assert(std::is_trivially_copyable_v<T>, "value must be trivially copyable");
+        return ReadBytes(&value, sizeof(T));
+    }
+
+    bool ReadBytes(void *data, size_t size) {
+        if (m_buffer.size() < size) {
+            return false;
+        }
+        if (size > 0) {
+            std::memcpy(data, m_buffer.data(), size);
+        }
+        m_buffer = m_buffer.subspan(size);
+        return true;
+    }
+
+    // Returns a view of the next <size> bytes and consumes them, or an empty span if there are not enough bytes.
+    std::span<const uint8_t> ReadSpan(size_t size) {
+        if (m_buffer.size() < size) {
+            return {};
+        }
+        auto result = m_buffer.first(size);
+        m_buffer = m_buffer.subspan(size);
+        return result;
+    }
+
+    size_t Remaining() const {
+        return m_buffer.size();
+    }
+
+private:
+    std::span<const uint8_t> m_buffer;
+};
+
+} // namespace util
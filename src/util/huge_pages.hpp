@@ -0,0 +1,99 @@
+#pragma once
+
+#include "armajitto/core/memory_params.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#ifdef __linux__
+    #include <sys/mman.h>
+#endif
+
+namespace util {
+
+inline constexpr size_t kHugePageSize = static_cast<size_t>(2) * 1024 * 1024;
+
+// Rounds the size up to the granularity used by AllocatePages for the given mode.
+inline size_t RoundUpToPageGranularity(size_t size, armajitto::HugePageMode mode) {
+#ifdef __linux__
+    if (mode != armajitto::HugePageMode::None) {
+        return (size + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    }
+#endif
+    return size;
+}
+
+// Allocates a zero-filled block of memory, optionally backed by huge pages.
+// Huge page allocations are aligned to kHugePageSize. If huge pages or the aligned mapping are unavailable, the block
+// falls back to normal pages, which are still released correctly by FreePages.
+// Memory allocated with this function must be released with FreePages using the same size and mode.
+// Returns nullptr if the allocation failed.
+inline void *AllocatePages(size_t size, armajitto::HugePageMode mode) {
+#ifdef __linux__
+    if (mode != armajitto::HugePageMode::None) {
+        size = RoundUpToPageGranularity(size, mode);
+
+    #ifdef MAP_HUGETLB
+        if (mode == armajitto::HugePageMode::Explicit) {
+            void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (ptr != MAP_FAILED) {
+                return ptr;
+            }
+        }
+    #endif
+
+        // Over-allocate by one huge page then trim the unaligned head and tail so that the kernel can back the whole
+        // region with huge pages
+        const size_t mapSize = size + kHugePageSize;
+        void *base = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            // Fall back to an unaligned mapping of normal pages
+            base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            return (base != MAP_FAILED) ? base : nullptr;
+        }
+        const uintptr_t baseAddr = reinterpret_cast<uintptr_t>(base);
+        const uintptr_t alignedAddr = (baseAddr + kHugePageSize - 1) & ~(kHugePageSize - 1);
+        const size_t headSize = alignedAddr - baseAddr;
+        const size_t tailSize = mapSize - headSize - size;
+        if (headSize > 0) {
+            munmap(base, headSize);
+        }
+        if (tailSize > 0) {
+            munmap(reinterpret_cast<void *>(alignedAddr + size), tailSize);
+        }
+        void *ptr = reinterpret_cast<void *>(alignedAddr);
+    #ifdef MADV_HUGEPAGE
+        madvise(ptr, size, MADV_HUGEPAGE); // best effort; THP may be disabled system-wide
+    #endif
+        return ptr;
+    }
+#endif
+    return std::calloc(1, size);
+}
+
+// Allocates memory like AllocatePages, but throws std::bad_alloc if the allocation failed.
+inline void *AllocatePagesOrThrow(size_t size, armajitto::HugePageMode mode) {
+    void *ptr = AllocatePages(size, mode);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+// Releases memory allocated with AllocatePages.
+inline void FreePages(void *ptr, size_t size, armajitto::HugePageMode mode) {
+    if (ptr == nullptr) {
+        return;
+    }
+#ifdef __linux__
+    if (mode != armajitto::HugePageMode::None) {
+        munmap(ptr, RoundUpToPageGranularity(size, mode));
+        return;
+    }
+#endif
+    std::free(ptr);
+}
+
+} // namespace util
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "bit_ops.hpp"
+#include "huge_pages.hpp"
 #include "noitree.hpp"
 #include "pointer_cast.hpp"
 
@@ -9,6 +10,7 @@
 #include <cassert>
 #include <cstdint>
 #include <map>
+#include <vector>
 
 namespace util {
 
@@ -19,10 +21,21 @@ namespace util {
 //
 // This allows simple and efficient memory pointer queries, and easy management of multiple layers of memory maps such
 // as those used in complex systems with caches overlaid on top of the base system memory view.
-template <size_t numLayers, typename TAttrs>
+//
+// When backed by huge pages, all level 2 tables are carved out of a single contiguous pool so that the lookup tables
+// span as few TLB entries as possible. The pool is reserved up front but only committed as it is touched.
+//
+// The map can also maintain a number of filtered views of the effective page map. Each view has its own level 1 table
+// whose entries either share the effective level 2 table (when every page in the block passes the filter), are null
+// (when no page passes) or point to a private copy with the rejected pages removed. Views without a filter mirror the
+// effective page map. Lookups through a view cost exactly the same as lookups through the effective page map.
+template <size_t numLayers, typename TAttrs, size_t numViews = 0>
 class LayeredMemoryMap {
 public:
-    LayeredMemoryMap(uint32_t pageSize)
+    // Determines if the page range starting at address is visible through a view.
+    using ViewFilter = bool (*)(void *ctx, uint32_t address, uint32_t size);
+
+    LayeredMemoryMap(uint32_t pageSize, armajitto::HugePageMode hugePages = armajitto::HugePageMode::None)
         : m_pageSize(bit::bitceil(pageSize))
         , m_pageMask(m_pageSize - 1)
         , m_pageShift(std::countr_zero(m_pageSize))
@@ -34,15 +47,28 @@ public:
         , m_l2Bits(m_lutBits - m_l1Bits)
         , m_l2Size(1u << m_l2Bits)
         , m_l2Mask(m_l2Size - 1)
-        , m_l2Shift(32 - m_lutBits) {
+        , m_l2Shift(32 - m_lutBits)
+        , m_hugePages(hugePages) {
 
-        m_map = new Page[m_l1Size];
+        m_map = static_cast<Page *>(AllocatePagesOrThrow(sizeof(Page) * m_l1Size, m_hugePages));
         std::fill_n(m_map, m_l1Size, nullptr);
+        if (m_hugePages != armajitto::HugePageMode::None) {
+            m_l2Pool = static_cast<Entry *>(AllocatePagesOrThrow(L2PoolSize(), m_hugePages));
+        }
+        for (auto &view : m_views) {
+            view.map = static_cast<Page *>(AllocatePagesOrThrow(sizeof(Page) * m_l1Size, m_hugePages));
+            std::fill_n(view.map, m_l1Size, nullptr);
+            view.privatePages.resize(m_l1Size, nullptr);
+        }
     }
 
     ~LayeredMemoryMap() {
         Clear();
-        delete[] m_map;
+        for (auto &view : m_views) {
+            FreePages(view.map, sizeof(Page) * m_l1Size, m_hugePages);
+        }
+        FreePages(m_l2Pool, L2PoolSize(), m_hugePages);
+        FreePages(m_map, sizeof(Page) * m_l1Size, m_hugePages);
     }
 
     void Map(uint8_t layer, uint32_t baseAddress, uint64_t size, TAttrs attrs, uint8_t *ptr,
@@ -92,10 +118,8 @@ public:
 
     void Clear() {
         for (size_t i = 0; i < m_l1Size; i++) {
-            if (m_map[i] != nullptr) {
-                delete[] m_map[i];
-            }
-            m_map[i] = nullptr;
+            FreeL2Table(i);
+            RefreshViews(i);
         }
         for (auto &layer : m_layers) {
             layer.Clear();
@@ -113,11 +137,11 @@ public:
                     }
                 }
                 if (allEmpty) {
-                    delete[] m_map[i];
-                    m_map[i] = nullptr;
+                    FreeL2Table(i);
                 }
             }
             m_map[i] = nullptr;
+            RefreshViews(i);
         }
     }
 
@@ -125,6 +149,33 @@ public:
         return CastUintPtr(m_map);
     }
 
+    // Installs a filter on a view and rebuilds it. A null filter makes the view mirror the effective page map.
+    void SetViewFilter(size_t view, ViewFilter filter, void *ctx) {
+        assert(view < numViews);
+        m_views[view].filter = filter;
+        m_views[view].filterCtx = ctx;
+        RefreshView(view, 0, 0x1'0000'0000);
+    }
+
+    // Re-evaluates the filter of a view over the specified range.
+    // Must be called whenever the conditions checked by the filter change.
+    void RefreshView(size_t view, uint32_t baseAddress, uint64_t size) {
+        assert(view < numViews);
+        if (size == 0) {
+            return;
+        }
+        const uint32_t firstIndex = baseAddress >> m_l1Shift;
+        const uint32_t lastIndex = ((uint64_t)baseAddress + size - 1) >> m_l1Shift;
+        for (uint32_t i = firstIndex; i <= lastIndex && i < m_l1Size; i++) {
+            RefreshView(view, i);
+        }
+    }
+
+    uintptr_t GetViewL1MapAddress(size_t view) const {
+        assert(view < numViews);
+        return CastUintPtr(m_views[view].map);
+    }
+
     uint32_t GetL1Shift() const {
         return m_l1Shift;
     }
@@ -211,6 +262,76 @@ private:
     using Page = Entry *;  // array of Entry
     Page *m_map = nullptr; // array of Page
 
+    const armajitto::HugePageMode m_hugePages;
+    Entry *m_l2Pool = nullptr; // m_l1Size arrays of m_l2Size Entries; only used with huge pages
+
+    size_t L2PoolSize() const {
+        return sizeof(Entry) * m_l1Size * m_l2Size;
+    }
+
+    void AllocateL2Table(uint32_t l1Index) {
+        if (m_l2Pool != nullptr) {
+            m_map[l1Index] = &m_l2Pool[static_cast<size_t>(l1Index) * m_l2Size];
+        } else {
+            m_map[l1Index] = new Entry[m_l2Size];
+        }
+        std::fill_n(m_map[l1Index], m_l2Size, nullptr);
+    }
+
+    void FreeL2Table(size_t l1Index) {
+        if (m_l2Pool == nullptr) {
+            delete[] m_map[l1Index];
+        }
+        m_map[l1Index] = nullptr;
+    }
+
+    // Rebuilds the level 1 entry of a view from the effective page map.
+    void RefreshView(size_t viewIndex, uint32_t l1Index) {
+        auto &view = m_views[viewIndex];
+        const Page basePage = m_map[l1Index];
+        delete[] view.privatePages[l1Index];
+        view.privatePages[l1Index] = nullptr;
+        if (basePage == nullptr || view.filter == nullptr) {
+            view.map[l1Index] = basePage;
+            return;
+        }
+
+        // Check if the filter accepts all or none of the pages in this block
+        const uint32_t blockAddress = l1Index << m_l1Shift;
+        bool anyAllowed = false;
+        bool anyDenied = false;
+        for (uint32_t i = 0; i < m_l2Size && !(anyAllowed && anyDenied); i++) {
+            if (view.filter(view.filterCtx, blockAddress + (i << m_l2Shift), m_pageSize)) {
+                anyAllowed = true;
+            } else {
+                anyDenied = true;
+            }
+        }
+        if (!anyDenied) {
+            view.map[l1Index] = basePage;
+            return;
+        }
+        if (!anyAllowed) {
+            view.map[l1Index] = nullptr;
+            return;
+        }
+
+        // Mixed block; build a private copy with only the accepted pages
+        const Page page = new Entry[m_l2Size];
+        for (uint32_t i = 0; i < m_l2Size; i++) {
+            const bool allowed = view.filter(view.filterCtx, blockAddress + (i << m_l2Shift), m_pageSize);
+            page[i] = allowed ? basePage[i] : nullptr;
+        }
+        view.map[l1Index] = page;
+        view.privatePages[l1Index] = page;
+    }
+
+    void RefreshViews(uint32_t l1Index) {
+        for (size_t view = 0; view < numViews; view++) {
+            RefreshView(view, l1Index);
+        }
+    }
+
     void DoMap(uint8_t layer, uint32_t baseAddress, uint64_t size, uint32_t mask, TAttrs attrs, uint8_t *ptr) {
         const uint32_t finalAddress = baseAddress + size - 1;
         m_layers[layer].Insert(baseAddress, finalAddress, {ptr, mask, attrs});
@@ -253,8 +374,7 @@ private:
             const uint32_t pageIndex = (page >> m_l2Bits) & m_l1Mask;
             const uint32_t entryIndex = page & m_l2Mask;
             if (m_map[pageIndex] == nullptr) {
-                m_map[pageIndex] = new Entry[m_l2Size];
-                std::fill_n(m_map[pageIndex], m_l2Size, nullptr);
+                AllocateL2Table(pageIndex);
             }
             if (ptr != nullptr) {
                 const uint32_t offset = (page - startPage) << m_pageShift;
@@ -263,6 +383,16 @@ private:
                 m_map[pageIndex][entryIndex] = nullptr;
             }
         }
+
+        if constexpr (numViews > 0) {
+            if (numPages > 0) {
+                const uint32_t firstIndex = startPage >> m_l2Bits;
+                const uint32_t lastIndex = (endPage - 1) >> m_l2Bits;
+                for (uint32_t i = firstIndex; i <= lastIndex; i++) {
+                    RefreshViews(i & m_l1Mask);
+                }
+            }
+        }
     }
 
     void UnmapSubrange(uint8_t layer, uint32_t baseAddress, uint64_t size) {
@@ -331,6 +461,15 @@ private:
     using Layer = util::NonOverlappingIntervalTree<uint32_t, LayerEntry>;
     std::array<Layer, numLayers> m_layers;
 
+    struct View {
+        Page *map = nullptr; // array of Page
+        std::vector<Page> privatePages; // filtered copies of level 2 tables owned by the view
+        ViewFilter filter = nullptr;
+        void *filterCtx = nullptr;
+    };
+
+    std::array<View, numViews> m_views;
+
     static uint64_t MakeKey(uint8_t layer, uint32_t baseAddress) {
         return ((uint64_t)baseAddress << 8ull) | ~layer;
     }
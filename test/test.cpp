@@ -351,6 +351,7 @@ void testGBA() {
     // jit.GetOptions().translator.maxBlockSize = 1;
     // jit.GetOptions().optimizer.passes.SetAll(false);
     // jit.GetOptions().compiler.enableBlockLinking = true;
+    // jit.GetOptions().compiler.lazyFlagsMaterialization = true;
 
     auto &armState = jit.GetARMState();
 
@@ -365,6 +366,8 @@ void testGBA() {
 
     // auto &optParams = jit.GetOptimizationParameters();
     // optParams.passes.constantPropagation = false;
+    // optParams.passes.commonSubexpressionElimination = false;
+    // optParams.passes.redundantLoadElimination = false;
     // optParams.passes.deadRegisterStoreElimination = false;
     // optParams.passes.deadGPRStoreElimination = false;
     // optParams.passes.deadHostFlagStoreElimination = false;
@@ -0,0 +1,77 @@
+#include "../test_framework.hpp"
+#include "../test_system.hpp"
+
+using namespace armajitto;
+using namespace armajitto::test;
+
+namespace {
+
+bool IsPageCacheable(const std::vector<uint32_t> &pages, uint32_t address) {
+    const uint32_t page = address >> arm::cp15::Cache::kCacheablePageShift;
+    return (pages[page >> 5] >> (page & 31)) & 1;
+}
+
+// Installs 8 KiB caches and TCMs and sets up two protection regions:
+//   0: 00000000..FFFFFFFF, cacheable by the instruction cache only
+//   1: 02000000..023FFFFF, cacheable by both caches, with the DTCM at 02100000..02103FFF
+void SetupCacheableRegions(arm::SystemControlCoprocessor &cp15) {
+    using namespace arm::cp15;
+    cp15.ConfigureTCM({.itcmSize = 0x8000, .dtcmSize = 0x4000});
+    cp15.ConfigureCache({
+        .type = cache::Type::WriteBackReg7CleanLockdownB,
+        .separateCodeDataCaches = true,
+        .code = {.size = 0x2000, .lineLength = cache::LineLength::_32B, .associativity = cache::Associativity::_4Way},
+        .data = {.size = 0x2000, .lineLength = cache::LineLength::_32B, .associativity = cache::Associativity::_4Way},
+    });
+
+    cp15.StoreRegister(0x0600, 0x0000003F); // Region 0: base 0, 4 GiB
+    cp15.StoreRegister(0x0610, 0x0200002B); // Region 1: base 0x02000000, 4 MiB
+    cp15.StoreRegister(0x0200, 0b10);       // Data cachability bits
+    cp15.StoreRegister(0x0201, 0b11);       // Instruction cachability bits
+    cp15.StoreRegister(0x0910, 0x0210000A); // DTCM: base 0x02100000, 16 KiB
+    cp15.StoreRegister(0x0100, 0x00011005); // PU, data cache, instruction cache and DTCM enabled
+}
+
+} // namespace
+
+TEST_CASE(CP15Cache_CacheabilityMapsFollowConfiguration) {
+    TestSystem system;
+    Context context{CPUModel::ARM946ES, system};
+    auto &cp15 = context.GetARMState().GetSystemControlCoprocessor();
+    SetupCacheableRegions(cp15);
+
+    auto &cache = cp15.GetCache();
+    CHECK(IsPageCacheable(cache.dataCacheablePages, 0x02000000));
+    CHECK(IsPageCacheable(cache.dataCacheablePages, 0x02104000));
+    CHECK(!IsPageCacheable(cache.dataCacheablePages, 0x01FFF000));
+    CHECK(!IsPageCacheable(cache.dataCacheablePages, 0x02100000));
+    CHECK(!IsPageCacheable(cache.dataCacheablePages, 0x02103000));
+    CHECK(IsPageCacheable(cache.codeCacheablePages, 0x00000000));
+    CHECK(IsPageCacheable(cache.codeCacheablePages, 0x02100000));
+
+    // Disabling the data cache clears the data map only
+    cp15.StoreRegister(0x0100, 0x00011001);
+    CHECK(!IsPageCacheable(cache.dataCacheablePages, 0x02000000));
+    CHECK(IsPageCacheable(cache.codeCacheablePages, 0x02000000));
+
+    // Disabling the protection unit clears both maps
+    cp15.StoreRegister(0x0100, 0x00011004);
+    CHECK(!IsPageCacheable(cache.dataCacheablePages, 0x02000000));
+    CHECK(!IsPageCacheable(cache.codeCacheablePages, 0x02000000));
+}
+
+TEST_CASE(CP15Cache_MissesFillCacheableLinesOnly) {
+    TestSystem system;
+    Context context{CPUModel::ARM946ES, system};
+    auto &cp15 = context.GetARMState().GetSystemControlCoprocessor();
+    SetupCacheableRegions(cp15);
+
+    CHECK(cp15.DataCacheMiss(0x02000000));
+    CHECK(!cp15.DataCacheMiss(0x0200001C)); // same line
+    CHECK(!cp15.DataCacheMiss(0x01000000)); // uncacheable region
+    CHECK(!cp15.DataCacheMiss(0x02100000)); // DTCM
+
+    // Clean and invalidate drops the line
+    cp15.StoreRegister(0x07E1, 0x02000000);
+    CHECK(cp15.DataCacheMiss(0x02000000));
+}
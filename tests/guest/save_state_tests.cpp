@@ -0,0 +1,96 @@
+#include "../test_framework.hpp"
+#include "../test_system.hpp"
+
+#include <vector>
+
+using namespace armajitto;
+using namespace armajitto::test;
+
+namespace {
+
+// Finds the offset of the single byte that differs between two snapshots of the same size, or -1 if there is none.
+int FindChangedByte(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b) {
+    int offset = -1;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i] != b[i]) {
+            if (offset != -1) {
+                return -1;
+            }
+            offset = static_cast<int>(i);
+        }
+    }
+    return offset;
+}
+
+} // namespace
+
+TEST_CASE(SaveState_RoundTrip) {
+    TestSystem system;
+    Context context{CPUModel::ARM946ES, system};
+    auto &state = context.GetARMState();
+
+    state.GPR(arm::GPR::R3) = 0x12345678;
+    state.GPR(arm::GPR::SP, arm::Mode::IRQ) = 0x0300FF00;
+    state.IRQLine() = true;
+    state.ExecutionState() = arm::ExecState::Halted;
+
+    std::vector<uint8_t> snapshot;
+    state.SaveState(snapshot);
+    state.Reset();
+
+    CHECK(state.LoadState(snapshot));
+    CHECK(state.GPR(arm::GPR::R3) == 0x12345678);
+    CHECK(state.GPR(arm::GPR::SP, arm::Mode::IRQ) == 0x0300FF00);
+    CHECK(state.IRQLine());
+    CHECK(!state.FIQLine());
+    CHECK(state.ExecutionState() == arm::ExecState::Halted);
+}
+
+TEST_CASE(SaveState_RejectsInvalidValues) {
+    TestSystem system;
+    Context context{CPUModel::ARM946ES, system};
+    auto &state = context.GetARMState();
+
+    std::vector<uint8_t> base;
+    state.SaveState(base);
+
+    // Locate the interrupt line and execution state bytes by changing one value at a time
+    std::vector<uint8_t> changed;
+    state.IRQLine() = true;
+    state.SaveState(changed);
+    const int irqLineOffset = FindChangedByte(base, changed);
+    state.IRQLine() = false;
+
+    state.ExecutionState() = arm::ExecState::Stopped;
+    state.SaveState(changed);
+    const int execStateOffset = FindChangedByte(base, changed);
+    state.ExecutionState() = arm::ExecState::Running;
+
+    CHECK(irqLineOffset >= 0);
+    CHECK(execStateOffset >= 0);
+    if (irqLineOffset < 0 || execStateOffset < 0) {
+        return;
+    }
+
+    state.GPR(arm::GPR::R0) = 0xDEADBEEF;
+
+    auto corrupted = base;
+    corrupted[irqLineOffset] = 2;
+    CHECK(!state.LoadState(corrupted));
+
+    corrupted = base;
+    corrupted[execStateOffset] = 0xFF;
+    CHECK(!state.LoadState(corrupted));
+
+    // Truncated and oversized snapshots fail the size check in the header
+    corrupted = base;
+    corrupted.pop_back();
+    CHECK(!state.LoadState(corrupted));
+
+    corrupted = base;
+    corrupted.push_back(0);
+    CHECK(!state.LoadState(corrupted));
+
+    // Nothing was applied
+    CHECK(state.GPR(arm::GPR::R0) == 0xDEADBEEF);
+}
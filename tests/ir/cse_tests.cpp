@@ -0,0 +1,181 @@
+#include "../test_framework.hpp"
+#include "ir_test_fixture.hpp"
+
+#include "ir/ir_ops.hpp"
+#include "ir/optimizer/common_subexpression_elimination.hpp"
+
+#include <array>
+
+using namespace armajitto;
+using namespace armajitto::test;
+
+namespace {
+
+using Type = ir::IROpcodeType;
+
+void RunCSE(IRTestFixture &fx, ir::BasicBlock &block) {
+    ir::Emitter emitter{block};
+    ir::CommonSubexpressionEliminationOptimizerPass pass{emitter, fx.pmrBuffer};
+    pass.Optimize();
+}
+
+// Returns the variable written to the given GPR by the last st op that writes a variable to it
+ir::Variable StoredVar(const ir::BasicBlock &block, arm::GPR gpr) {
+    ir::Variable var{};
+    for (const ir::IROp *op = block.Head(); op != nullptr; op = op->Next()) {
+        if (op->type == Type::SetRegister) {
+            auto *setOp = static_cast<const ir::IRSetRegisterOp *>(op);
+            if (setOp->dst.gpr == gpr && !setOp->src.immediate) {
+                var = setOp->src.var.var;
+            }
+        }
+    }
+    return var;
+}
+
+} // namespace
+
+TEST_CASE(CSE_RepeatedALUOpIsEliminated) {
+    IRTestFixture fx;
+    auto &block = fx.NewBlock(TestSystem::kRAMBase);
+    {
+        ir::Emitter emitter{block};
+        auto base = emitter.GetRegister(arm::GPR::R1);
+        auto sum1 = emitter.Add(base, 4, false);
+        auto sum2 = emitter.Add(4, base, false); // commutative, same value
+        emitter.SetRegister(arm::GPR::R2, sum1);
+        emitter.SetRegister(arm::GPR::R3, sum2);
+    }
+
+    RunCSE(fx, block);
+
+    CHECK(fx.Count(block, Type::Add) == 1);
+    CHECK(StoredVar(block, arm::GPR::R2) == StoredVar(block, arm::GPR::R3));
+}
+
+TEST_CASE(CSE_ValueDoesNotSurviveRegisterWrite) {
+    IRTestFixture fx;
+    auto &block = fx.NewBlock(TestSystem::kRAMBase);
+    ir::Variable first;
+    ir::Variable written;
+    {
+        ir::Emitter emitter{block};
+        first = emitter.GetRegister(arm::GPR::R1);
+        emitter.SetRegister(arm::GPR::R2, first);
+        written = emitter.Add(first, 1, false);
+        emitter.SetRegister(arm::GPR::R1, written);
+        auto second = emitter.GetRegister(arm::GPR::R1);
+        emitter.SetRegister(arm::GPR::R3, second);
+
+        // An immediate write clears the known value; the next read must remain
+        emitter.SetRegister(arm::GPR::R1, 0x1234u);
+        auto third = emitter.GetRegister(arm::GPR::R1);
+        emitter.SetRegister(arm::GPR::R4, third);
+    }
+
+    RunCSE(fx, block);
+
+    // The read after the write yields the written value, never the stale one
+    CHECK(StoredVar(block, arm::GPR::R3) == written);
+    CHECK(StoredVar(block, arm::GPR::R3) != first);
+    CHECK(fx.Count(block, Type::GetRegister) == 2);
+    CHECK(StoredVar(block, arm::GPR::R4) != first);
+    CHECK(StoredVar(block, arm::GPR::R4) != written);
+}
+
+TEST_CASE(CSE_RepeatedRegisterReadIsEliminated) {
+    IRTestFixture fx;
+    auto &block = fx.NewBlock(TestSystem::kRAMBase);
+    {
+        ir::Emitter emitter{block};
+        auto first = emitter.GetRegister(arm::GPR::R1);
+        auto addr = emitter.GetRegister(arm::GPR::R0);
+        emitter.MemWrite(ir::MemAccessSize::Word, first, addr);
+        auto second = emitter.GetRegister(arm::GPR::R1);
+        emitter.SetRegister(arm::GPR::R2, first);
+        emitter.SetRegister(arm::GPR::R3, second);
+    }
+
+    RunCSE(fx, block);
+
+    CHECK(fx.Count(block, Type::GetRegister) == 2);
+    CHECK(StoredVar(block, arm::GPR::R2) == StoredVar(block, arm::GPR::R3));
+}
+
+TEST_CASE(CSE_CPSRDoesNotSurviveModeChange) {
+    IRTestFixture fx;
+    auto &block = fx.NewBlock(TestSystem::kRAMBase, arm::Mode::Supervisor);
+    {
+        ir::Emitter emitter{block};
+        auto cpsr1 = emitter.GetCPSR();
+        emitter.SetRegister(arm::GPR::R1, cpsr1);
+        auto newMode = emitter.BitClear(cpsr1, 0x1F, false);
+        newMode = emitter.BitwiseOr(newMode, static_cast<uint32_t>(arm::Mode::IRQ), false);
+        emitter.SetCPSR(newMode, false);
+        auto cpsr2 = emitter.GetCPSR();
+        emitter.SetRegister(arm::GPR::R2, cpsr2);
+    }
+
+    RunCSE(fx, block);
+
+    CHECK(fx.Count(block, Type::GetCPSR) == 2);
+    CHECK(StoredVar(block, arm::GPR::R1) != StoredVar(block, arm::GPR::R2));
+}
+
+TEST_CASE(CSE_BankedRegistersAreTrackedPerMode) {
+    IRTestFixture fx;
+    auto &block = fx.NewBlock(TestSystem::kRAMBase, arm::Mode::Supervisor);
+    {
+        ir::Emitter emitter{block};
+        auto svcSP = emitter.GetRegister({arm::GPR::SP, arm::Mode::Supervisor});
+        emitter.SetRegister(arm::GPR::R1, svcSP);
+        auto irqSP = emitter.GetRegister({arm::GPR::SP, arm::Mode::IRQ});
+        emitter.SetRegister(arm::GPR::R2, irqSP);
+    }
+
+    RunCSE(fx, block);
+
+    CHECK(fx.Count(block, Type::GetRegister) == 2);
+    CHECK(StoredVar(block, arm::GPR::R1) != StoredVar(block, arm::GPR::R2));
+}
+
+TEST_CASE(CSE_MatchesUnoptimizedExecution) {
+    // Reads SP before and after switching to IRQ mode, recomputing the same expression on both sides
+    const std::initializer_list<uint32_t> code = {
+        0xE28D1004, // add r1, sp, #4
+        0xE321F0D2, // msr cpsr_c, #0xD2
+        0xE28D2004, // add r2, sp, #4
+        0xE28D3004, // add r3, sp, #4
+        0xEAFFFFFE, // b $
+    };
+
+    auto run = [&](bool optimize) {
+        IRTestFixture fx;
+        fx.options.translator.maxBlockSize = 1;
+        fx.options.optimizer.passes.SetAll(false);
+        fx.options.optimizer.passes.commonSubexpressionElimination = true;
+        fx.system.WriteCode(TestSystem::kRAMBase, code);
+        auto &state = fx.ARMState();
+        state.SetMode(arm::Mode::Supervisor);
+        state.GPR(arm::GPR::SP, arm::Mode::Supervisor) = 0x1000;
+        state.GPR(arm::GPR::SP, arm::Mode::IRQ) = 0x2000;
+
+        // Run one instruction per block, following PC
+        uint32_t address = TestSystem::kRAMBase;
+        for (int i = 0; i < 4; i++) {
+            auto &block = fx.Translate(address, state.CPSR().mode);
+            if (optimize) {
+                fx.optimizer.Optimize(block);
+            }
+            fx.Run(block, 1);
+            address = state.GPR(arm::GPR::PC) - 8;
+        }
+        return std::array{state.GPR(arm::GPR::R1), state.GPR(arm::GPR::R2), state.GPR(arm::GPR::R3)};
+    };
+
+    const auto expected = run(false);
+    const auto actual = run(true);
+    CHECK(expected[0] == 0x1004);
+    CHECK(expected[1] == 0x2004);
+    CHECK(actual == expected);
+}
@@ -0,0 +1,226 @@
+#include "../test_framework.hpp"
+#include "ir_test_fixture.hpp"
+
+#include "ir/flags_materialization.hpp"
+
+using namespace armajitto;
+using namespace armajitto::test;
+
+namespace {
+
+using Type = ir::IROpcodeType;
+
+constexpr uint32_t kLinkTarget = TestSystem::kRAMBase + 0x100;
+
+ir::FlagsMaterializationAnalyzer Analyze(IRTestFixture &fx, const ir::BasicBlock &block, bool memAccessesMayAbort) {
+    ir::FlagsMaterializationAnalyzer analyzer{fx.pmrBuffer};
+    analyzer.Analyze(block, memAccessesMayAbort);
+    return analyzer;
+}
+
+} // namespace
+
+TEST_CASE(FlagsMaterialization_TrailingFlagCopyIsDeferred) {
+    IRTestFixture fx;
+    auto &block = fx.NewBlock(TestSystem::kRAMBase);
+    {
+        ir::Emitter emitter{block};
+        auto sum = emitter.Add(emitter.GetRegister(arm::GPR::R0), 1, true);
+        emitter.SetRegister(arm::GPR::R0, sum);
+        emitter.LoadFlags(arm::Flags::NZCV);
+        emitter.TerminateDirectLink(kLinkTarget, arm::Mode::System, false);
+    }
+
+    auto analyzer = Analyze(fx, block, true);
+    CHECK(analyzer.ResyncedFlags() == arm::Flags::NZCV);
+    CHECK(analyzer.DeferredFlags() == arm::Flags::NZCV);
+
+    auto ops = fx.Ops(block);
+    CHECK(analyzer.IsDeferred(ops[fx.Find(block, Type::GetCPSR)]));
+    CHECK(analyzer.IsDeferred(ops[fx.Find(block, Type::LoadFlags)]));
+    CHECK(analyzer.IsDeferred(ops[fx.Find(block, Type::SetCPSR)]));
+    CHECK(!analyzer.IsDeferred(ops[fx.Find(block, Type::Add)]));
+}
+
+TEST_CASE(FlagsMaterialization_NothingIsDeferredWithoutDirectLink) {
+    IRTestFixture fx;
+    auto &block = fx.NewBlock(TestSystem::kRAMBase);
+    {
+        ir::Emitter emitter{block};
+        emitter.LoadFlags(arm::Flags::NZCV);
+        emitter.TerminateIndirectLink();
+    }
+
+    auto analyzer = Analyze(fx, block, true);
+    CHECK(analyzer.ResyncedFlags() == arm::Flags::NZCV);
+    CHECK(analyzer.DeferredFlags() == arm::Flags::None);
+}
+
+TEST_CASE(FlagsMaterialization_PartialFlagCopiesMerge) {
+    // A single partial copy leaves the other flags stale
+    {
+        IRTestFixture fx;
+        auto &block = fx.NewBlock(TestSystem::kRAMBase);
+        {
+            ir::Emitter emitter{block};
+            emitter.LoadFlags(arm::Flags::NZ);
+            emitter.TerminateDirectLink(kLinkTarget, arm::Mode::System, false);
+        }
+
+        auto analyzer = Analyze(fx, block, true);
+        CHECK(analyzer.ResyncedFlags() == arm::Flags::NZ);
+        CHECK(analyzer.DeferredFlags() == arm::Flags::NZ);
+    }
+
+    // Consecutive partial copies add up; only the last one is deferred
+    {
+        IRTestFixture fx;
+        auto &block = fx.NewBlock(TestSystem::kRAMBase);
+        {
+            ir::Emitter emitter{block};
+            emitter.LoadFlags(arm::Flags::NZ);
+            emitter.LoadFlags(arm::Flags::C | arm::Flags::V);
+            emitter.TerminateDirectLink(kLinkTarget, arm::Mode::System, false);
+        }
+
+        auto analyzer = Analyze(fx, block, true);
+        CHECK(analyzer.ResyncedFlags() == arm::Flags::NZCV);
+        CHECK(analyzer.DeferredFlags() == (arm::Flags::C | arm::Flags::V));
+    }
+}
+
+TEST_CASE(FlagsMaterialization_CPSRReadsObserveStaleFlags) {
+    // Reading the whole CPSR observes every stale flag
+    {
+        IRTestFixture fx;
+        auto &block = fx.NewBlock(TestSystem::kRAMBase);
+        {
+            ir::Emitter emitter{block};
+            emitter.SetRegister(arm::GPR::R0, emitter.GetCPSR());
+            emitter.LoadFlags(arm::Flags::NZCV);
+            emitter.TerminateDirectLink(kLinkTarget, arm::Mode::System, false);
+        }
+
+        auto analyzer = Analyze(fx, block, true);
+        CHECK(analyzer.ResyncedFlags() == arm::Flags::None);
+        CHECK(analyzer.DeferredFlags() == arm::Flags::NZCV);
+    }
+
+    // Masking out the flag bits with an immediate keeps them unobserved
+    {
+        IRTestFixture fx;
+        auto &block = fx.NewBlock(TestSystem::kRAMBase);
+        {
+            ir::Emitter emitter{block};
+            emitter.SetRegister(arm::GPR::R0, emitter.BitwiseAnd(emitter.GetCPSR(), 0x1F, false));
+            emitter.LoadFlags(arm::Flags::NZCV);
+            emitter.TerminateDirectLink(kLinkTarget, arm::Mode::System, false);
+        }
+
+        auto analyzer = Analyze(fx, block, true);
+        CHECK(analyzer.ResyncedFlags() == arm::Flags::NZCV);
+    }
+
+    // Reading CPSR after the trailing copy prevents the deferral
+    {
+        IRTestFixture fx;
+        auto &block = fx.NewBlock(TestSystem::kRAMBase);
+        {
+            ir::Emitter emitter{block};
+            emitter.LoadFlags(arm::Flags::NZCV);
+            emitter.SetRegister(arm::GPR::R0, emitter.GetCPSR());
+            emitter.TerminateDirectLink(kLinkTarget, arm::Mode::System, false);
+        }
+
+        auto analyzer = Analyze(fx, block, true);
+        CHECK(analyzer.ResyncedFlags() == arm::Flags::NZCV);
+        CHECK(analyzer.DeferredFlags() == arm::Flags::None);
+    }
+}
+
+TEST_CASE(FlagsMaterialization_CheckpointsObserveStaleFlags) {
+    // A checkpoint between partial copies observes the flags that were still stale
+    {
+        IRTestFixture fx;
+        auto &block = fx.NewBlock(TestSystem::kRAMBase);
+        {
+            ir::Emitter emitter{block};
+            emitter.LoadFlags(arm::Flags::NZ);
+            emitter.Checkpoint();
+            emitter.LoadFlags(arm::Flags::NZCV);
+            emitter.TerminateDirectLink(kLinkTarget, arm::Mode::System, false);
+        }
+
+        auto analyzer = Analyze(fx, block, true);
+        CHECK(analyzer.ResyncedFlags() == arm::Flags::NZ);
+        CHECK(analyzer.DeferredFlags() == arm::Flags::NZCV);
+    }
+
+    // A checkpoint after the trailing copy prevents the deferral
+    {
+        IRTestFixture fx;
+        auto &block = fx.NewBlock(TestSystem::kRAMBase);
+        {
+            ir::Emitter emitter{block};
+            emitter.LoadFlags(arm::Flags::NZCV);
+            emitter.Checkpoint();
+            emitter.TerminateDirectLink(kLinkTarget, arm::Mode::System, false);
+        }
+
+        auto analyzer = Analyze(fx, block, true);
+        CHECK(analyzer.ResyncedFlags() == arm::Flags::NZCV);
+        CHECK(analyzer.DeferredFlags() == arm::Flags::None);
+    }
+}
+
+TEST_CASE(FlagsMaterialization_AbortingMemoryAccessesObserveStaleFlags) {
+    // Memory accesses before the copy only observe the stale flags when they may abort
+    for (bool mayAbort : {false, true}) {
+        IRTestFixture fx;
+        auto &block = fx.NewBlock(TestSystem::kRAMBase);
+        {
+            ir::Emitter emitter{block};
+            auto value = emitter.MemRead(ir::MemAccessBus::Data, ir::MemAccessMode::Aligned, ir::MemAccessSize::Word,
+                                         emitter.GetRegister(arm::GPR::R1));
+            emitter.SetRegister(arm::GPR::R0, value);
+            emitter.LoadFlags(arm::Flags::NZCV);
+            emitter.TerminateDirectLink(kLinkTarget, arm::Mode::System, false);
+        }
+
+        auto analyzer = Analyze(fx, block, mayAbort);
+        CHECK(analyzer.ResyncedFlags() == (mayAbort ? arm::Flags::None : arm::Flags::NZCV));
+        CHECK(analyzer.DeferredFlags() == arm::Flags::NZCV);
+    }
+
+    // Memory accesses after the trailing copy prevent the deferral only when they may abort
+    for (bool mayAbort : {false, true}) {
+        IRTestFixture fx;
+        auto &block = fx.NewBlock(TestSystem::kRAMBase);
+        {
+            ir::Emitter emitter{block};
+            emitter.LoadFlags(arm::Flags::NZCV);
+            emitter.MemWrite(ir::MemAccessSize::Word, emitter.GetRegister(arm::GPR::R0),
+                             emitter.GetRegister(arm::GPR::R1));
+            emitter.TerminateDirectLink(kLinkTarget, arm::Mode::System, false);
+        }
+
+        auto analyzer = Analyze(fx, block, mayAbort);
+        CHECK(analyzer.ResyncedFlags() == arm::Flags::NZCV);
+        CHECK(analyzer.DeferredFlags() == (mayAbort ? arm::Flags::None : arm::Flags::NZCV));
+    }
+}
+
+TEST_CASE(FlagsMaterialization_ConditionalBlocksResyncNothing) {
+    IRTestFixture fx;
+    auto &block = fx.NewBlock(TestSystem::kRAMBase);
+    {
+        ir::Emitter emitter{block};
+        emitter.SetCondition(arm::Condition::EQ);
+        emitter.LoadFlags(arm::Flags::NZCV);
+        emitter.TerminateDirectLink(kLinkTarget, arm::Mode::System, false);
+    }
+
+    // The condition fail path skips the copy
+    auto analyzer = Analyze(fx, block, true);
+    CHECK(analyzer.ResyncedFlags() == arm::Flags::None);
+}
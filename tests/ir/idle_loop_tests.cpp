@@ -0,0 +1,80 @@
+#include "../test_framework.hpp"
+#include "ir_test_fixture.hpp"
+
+using namespace armajitto;
+using namespace armajitto::test;
+
+namespace {
+
+constexpr uint32_t kDataAddress = TestSystem::kRAMBase + 0x100;
+
+// Writes the loop to the start of RAM, then translates and optimizes the block at the given offset from the start of
+// the loop, with PC pointing to that block as it would when the recompiler compiles it. R2 points to plain RAM.
+bool IsIdleLoop(std::initializer_list<uint32_t> code, uint32_t lastBlockOffset = 0) {
+    IRTestFixture fx;
+    fx.system.WriteCode(TestSystem::kRAMBase, code);
+    fx.ARMState().GPR(arm::GPR::R2) = kDataAddress;
+    fx.ARMState().GPR(arm::GPR::PC) = TestSystem::kRAMBase + lastBlockOffset + 8;
+    auto &block = fx.Translate(TestSystem::kRAMBase + lastBlockOffset);
+    fx.optimizer.Optimize(block);
+    return block.GetTerminal() == ir::BasicBlock::Terminal::IdleLoop;
+}
+
+} // namespace
+
+TEST_CASE(IdleLoop_LoopReadingPCIsDetected) {
+    CHECK(IsIdleLoop({
+        0xE1A0000F, // loop: mov r0, pc
+        0xE59F1000, //       ldr r1, [pc, #0]
+        0xEAFFFFFC, //       b loop
+    }));
+}
+
+TEST_CASE(IdleLoop_LoopReadingPCWithSideEffectsIsRejected) {
+    // Accumulates values derived from PC into a register carried over to the next iteration
+    CHECK(!IsIdleLoop({
+        0xE081100F, // loop: add r1, r1, pc
+        0xEAFFFFFD, //       b loop
+    }));
+
+    // Writes to memory through a PC-relative address
+    CHECK(!IsIdleLoop({
+        0xE58F0008, // loop: str r0, [pc, #8]
+        0xEAFFFFFD, //       b loop
+    }));
+}
+
+TEST_CASE(IdleLoop_PollingLoopReadingPCIsDetected) {
+    // The conditional branch starts a new block; the first block is analyzed without being optimized
+    CHECK(IsIdleLoop(
+        {
+            0xE1A0100F, // loop: mov r1, pc
+            0xE5920000, //       ldr r0, [r2]
+            0xE3500000, //       cmp r0, #0
+            0x0AFFFFFB, //       beq loop
+        },
+        12));
+}
+
+TEST_CASE(IdleLoop_PollingLoopReadingPCWithSideEffectsIsRejected) {
+    CHECK(!IsIdleLoop(
+        {
+            0xE081100F, // loop: add r1, r1, pc
+            0xE5920000, //       ldr r0, [r2]
+            0xE3500000, //       cmp r0, #0
+            0x0AFFFFFB, //       beq loop
+        },
+        12));
+}
+
+TEST_CASE(IdleLoop_PollingLoopWithPCRelativeMMIOLoadIsKept) {
+    // The load reads MMIO just below RAM. PC holds a different value at every instruction, so it cannot be used as a
+    // loop-invariant base register; doing so would resolve the address with the PC of the last block and land in RAM.
+    CHECK(!IsIdleLoop(
+        {
+            0xE51F000C, // loop: ldr r0, [pc, #-12]
+            0xE3500000, //       cmp r0, #0
+            0x0AFFFFFC, //       beq loop
+        },
+        8));
+}
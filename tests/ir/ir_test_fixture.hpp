@@ -0,0 +1,104 @@
+#pragma once
+
+#include "../test_system.hpp"
+
+#include "core/allocator.hpp"
+#include "host/interp/interp_host.hpp"
+#include "ir/basic_block.hpp"
+#include "ir/emitter.hpp"
+#include "ir/optimizer.hpp"
+#include "ir/translator.hpp"
+
+#include <cstdio>
+#include <memory_resource>
+#include <vector>
+
+namespace armajitto::test {
+
+// Builds, translates, optimizes and runs IR blocks in isolation.
+// Blocks are executed with the IR interpreter host, so the tests don't depend on the host architecture.
+struct IRTestFixture {
+    IRTestFixture()
+        : context(CPUModel::ARM946ES, system)
+        , translator(context, options.translator)
+        , optimizer(context, options, translator, allocator, pmrBuffer)
+        , host(context, options.compiler, pmrBuffer) {}
+
+    TestSystem system;
+    Options options;
+    Context context;
+    memory::Allocator allocator;
+    std::pmr::unsynchronized_pool_resource pmrBuffer{std::pmr::get_default_resource()};
+    ir::Translator translator;
+    ir::Optimizer optimizer;
+    interp::InterpreterHost host;
+
+    arm::State &ARMState() {
+        return context.GetARMState();
+    }
+
+    // Creates an empty, unconditional ARM block for the instruction at the given address.
+    ir::BasicBlock &NewBlock(uint32_t address, arm::Mode mode = arm::Mode::System) {
+        auto &block = *allocator.Allocate<ir::BasicBlock>(allocator, LocationRef{address + 8, mode, false});
+        ir::Emitter{block}.SetCondition(arm::Condition::AL);
+        return block;
+    }
+
+    // Translates the ARM code at the given address into a new block.
+    ir::BasicBlock &Translate(uint32_t address, arm::Mode mode = arm::Mode::System) {
+        auto &block = NewBlock(address, mode);
+        translator.Translate(block);
+        return block;
+    }
+
+    // Compiles the block with the interpreter host and runs it with the given cycle budget, starting from the block's
+    // location. Returns the number of cycles executed.
+    uint64_t Run(ir::BasicBlock &block, uint64_t cycles) {
+        auto &state = ARMState();
+        state.SetMode(block.Location().Mode());
+        state.CPSR().t = block.Location().IsThumbMode();
+        state.GPR(arm::GPR::PC) = block.Location().PC();
+        auto code = host.Compile(block);
+        return cycles - host.Call(code, cycles);
+    }
+
+    // Lists the ops in the block in order.
+    static std::vector<const ir::IROp *> Ops(const ir::BasicBlock &block) {
+        std::vector<const ir::IROp *> ops;
+        for (const ir::IROp *op = block.Head(); op != nullptr; op = op->Next()) {
+            ops.push_back(op);
+        }
+        return ops;
+    }
+
+    // Returns the position of the first op of the given type at or after <start>, or -1 if there is none.
+    static int Find(const ir::BasicBlock &block, ir::IROpcodeType type, int start = 0) {
+        auto ops = Ops(block);
+        for (int i = start; i < static_cast<int>(ops.size()); i++) {
+            if (ops[i]->type == type) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // Counts the ops of the given type in the block.
+    static int Count(const ir::BasicBlock &block, ir::IROpcodeType type) {
+        int count = 0;
+        for (const ir::IROp *op = block.Head(); op != nullptr; op = op->Next()) {
+            if (op->type == type) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    // Prints the block for diagnostics.
+    static void Print(const ir::BasicBlock &block) {
+        for (const ir::IROp *op = block.Head(); op != nullptr; op = op->Next()) {
+            printf("      %s\n", op->ToString().c_str());
+        }
+    }
+};
+
+} // namespace armajitto::test
@@ -0,0 +1,89 @@
+#include "../test_framework.hpp"
+#include "ir_test_fixture.hpp"
+
+#include <array>
+
+using namespace armajitto;
+using namespace armajitto::test;
+
+namespace {
+
+constexpr uint32_t kCodeAddress = TestSystem::kRAMBase;
+constexpr uint32_t kDataAddress = TestSystem::kRAMBase + 0x100;
+
+// Guest state observed after running a block
+struct Snapshot {
+    std::array<uint32_t, 16> gprs;
+    uint32_t cpsr;
+    std::array<uint32_t, 3> data;
+    uint64_t cycles;
+
+    bool operator==(const Snapshot &) const = default;
+};
+
+// Translates the code at kCodeAddress with a checkpoint after every instruction, optionally optimizes it with every
+// pass enabled, then runs it with the given cycle budget.
+Snapshot RunWithCheckpoints(std::initializer_list<uint32_t> code, uint64_t budget, bool optimize) {
+    IRTestFixture fx;
+    fx.options.translator.cyclesPerInstruction = 1;
+    fx.options.translator.deadlineCheckInterval = 1;
+    fx.options.optimizer.passes.SetAll(true);
+    fx.system.WriteCode(kCodeAddress, code);
+
+    auto &state = fx.ARMState();
+    state.GPR(arm::GPR::R2) = kDataAddress;
+
+    auto &block = fx.Translate(kCodeAddress);
+    if (optimize) {
+        fx.optimizer.Optimize(block);
+    }
+
+    Snapshot snapshot{};
+    snapshot.cycles = fx.Run(block, budget);
+    for (int i = 0; i < 16; i++) {
+        snapshot.gprs[i] = state.GPR(static_cast<arm::GPR>(i));
+    }
+    snapshot.cpsr = state.CPSR().u32;
+    for (uint32_t i = 0; i < snapshot.data.size(); i++) {
+        snapshot.data[i] = fx.system.RAMWord(kDataAddress + i * sizeof(uint32_t));
+    }
+    return snapshot;
+}
+
+// Overwrites registers and flags without reading them in between, which makes the earlier writes dead unless the
+// checkpoints between them are respected
+const std::initializer_list<uint32_t> kCheckpointTestCode = {
+    0xE3A00001, // mov r0, #1
+    0xE3A00002, // mov r0, #2
+    0xE0901000, // adds r1, r0, r0
+    0xE5820000, // str r0, [r2]
+    0xE3B03000, // movs r3, #0
+    0xE3A00003, // mov r0, #3
+    0xE5821004, // str r1, [r2, #4]
+    0xE5820008, // str r0, [r2, #8]
+    0xEAFFFFFE, // b $
+};
+
+} // namespace
+
+TEST_CASE(OptimizerPipeline_CheckpointExitsMidBlock) {
+    // Stop at the checkpoint after the first instruction
+    auto snapshot = RunWithCheckpoints(kCheckpointTestCode, 1, true);
+    CHECK(snapshot.cycles == 1);
+    CHECK(snapshot.gprs[0] == 1);
+    CHECK(snapshot.gprs[15] == kCodeAddress + sizeof(uint32_t) + 8);
+    CHECK(snapshot.data[0] == 0);
+}
+
+TEST_CASE(OptimizerPipeline_CheckpointsObserveUnoptimizedState) {
+    // Every budget stops at a different checkpoint; the optimized block must leave the same state as the unoptimized
+    // one at each of them
+    for (uint64_t budget = 1; budget <= 10; budget++) {
+        auto expected = RunWithCheckpoints(kCheckpointTestCode, budget, false);
+        auto actual = RunWithCheckpoints(kCheckpointTestCode, budget, true);
+        CHECK(actual == expected);
+        if (actual != expected) {
+            printf("      mismatch with a budget of %llu cycles\n", static_cast<unsigned long long>(budget));
+        }
+    }
+}
@@ -0,0 +1,252 @@
+#include "../test_framework.hpp"
+#include "ir_test_fixture.hpp"
+
+#include "ir/ops/ir_ops_visitor.hpp"
+
+#include <array>
+#include <initializer_list>
+#include <utility>
+
+using namespace armajitto;
+using namespace armajitto::test;
+
+// Minimized reproducers of discrepancies found by `armajitto-fuzzer passes`, which compares blocks compiled with
+// every optimizer pass enabled against the same blocks compiled without optimizations.
+
+namespace {
+
+constexpr uint32_t kCodeAddress = TestSystem::kRAMBase;
+constexpr uint32_t kDataAddress = TestSystem::kRAMBase + 0x100;
+
+// Guest state observed after running a block
+struct Snapshot {
+    std::array<uint32_t, 16> gprs;
+    uint32_t cpsr;
+    std::array<uint32_t, 32> data; // words at kDataAddress
+    uint64_t cycles;
+
+    bool operator==(const Snapshot &) const = default;
+};
+
+Options::Optimizer::Passes AllPasses() {
+    Options::Optimizer::Passes passes{};
+    passes.SetAll(true);
+    return passes;
+}
+
+// Translates the code at kCodeAddress, optionally optimizes it with the given passes, then runs it once with the given
+// registers and CPSR flags (NZCV in bits 31..28).
+Snapshot Run(std::initializer_list<uint32_t> code, std::initializer_list<std::pair<arm::GPR, uint32_t>> regs,
+             uint32_t flags, bool optimize, const Options::Optimizer::Passes &passes = AllPasses()) {
+    IRTestFixture fx;
+    fx.options.translator.cyclesPerInstruction = 1;
+    fx.options.optimizer.passes = passes;
+    fx.system.WriteCode(kCodeAddress, code);
+
+    auto &state = fx.ARMState();
+    for (auto [gpr, value] : regs) {
+        state.GPR(gpr, arm::Mode::System) = value;
+    }
+    state.CPSR().u32 = (state.CPSR().u32 & 0x0FFFFFFF) | flags;
+
+    auto &block = fx.Translate(kCodeAddress);
+    if (optimize) {
+        fx.optimizer.Optimize(block);
+    }
+
+    Snapshot snapshot{};
+    snapshot.cycles = fx.Run(block, 64);
+    for (int i = 0; i < 16; i++) {
+        snapshot.gprs[i] = state.GPR(static_cast<arm::GPR>(i));
+    }
+    snapshot.cpsr = state.CPSR().u32;
+    for (uint32_t i = 0; i < snapshot.data.size(); i++) {
+        snapshot.data[i] = fx.system.RAMWord(kDataAddress + i * sizeof(uint32_t));
+    }
+    return snapshot;
+}
+
+bool MatchesUnoptimized(std::initializer_list<uint32_t> code, std::initializer_list<std::pair<arm::GPR, uint32_t>> regs,
+                        uint32_t flags, const Options::Optimizer::Passes &passes = AllPasses()) {
+    return Run(code, regs, flags, false) == Run(code, regs, flags, true, passes);
+}
+
+// Checks that every variable read in the block is written by an earlier op. The interpreter host reads undefined
+// variables as whatever the last block left in their slots, so this catches what comparing results may miss.
+bool ReadsOnlyDefinedVariables(const ir::BasicBlock &block) {
+    std::vector<bool> defined(block.VariableCount());
+    bool valid = true;
+    for (const ir::IROp *op = block.Head(); op != nullptr; op = op->Next()) {
+        ir::VisitIROpVars<false>(op, [&](const auto * /*op*/, ir::Variable var, bool read) {
+            if (read) {
+                valid &= var.Index() < defined.size() && defined[var.Index()];
+            } else if (var.Index() < defined.size()) {
+                defined[var.Index()] = true;
+            }
+        });
+    }
+    return valid;
+}
+
+} // namespace
+
+// Seed 1, iteration 468: the carry from an immediate MOVS survived a flag-setting shift by a register amount
+TEST_CASE(OptimizerRegression_VariableShiftAmountClobbersKnownCarry) {
+    const auto code = {
+        0xE3B083A0, // movs r8, #0x80000002   (C = 1)
+        0xE1F0691C, // mvns r6, r12, lsl r9   (r9 = 0xF6: C = 0)
+        0xEAFFFFFE, // b $
+    };
+    const auto regs = {std::pair{arm::GPR::R9, 0xF6u}, std::pair{arm::GPR::R12, 0x1234u}};
+    auto snapshot = Run(code, regs, 0x50000000, true);
+    CHECK((snapshot.cpsr & (1u << 29)) == 0);
+    CHECK(MatchesUnoptimized(code, regs, 0x50000000));
+}
+
+// Seed 1, iteration 1390: a shift by a register amount of zero must preserve the carry from an earlier MOVS
+TEST_CASE(OptimizerRegression_ZeroShiftByRegisterPreservesCarry) {
+    const auto code = {
+        0xE3B06591, // movs r6, #0x24400000   (C = 0)
+        0xE1B05B3D, // movs r5, r13, lsr r11  (r11 = 0: C unchanged)
+        0xEAFFFFFE, // b $
+    };
+    const auto regs = {std::pair{arm::GPR::R11, 0u}, std::pair{arm::GPR::R13, 0x10DF2u}};
+    auto snapshot = Run(code, regs, 0x20000000, true);
+    CHECK((snapshot.cpsr & (1u << 29)) == 0);
+    CHECK(MatchesUnoptimized(code, regs, 0x20000000));
+}
+
+// Seed 2, iteration 1058: MLAS clobbered the host carry flag, which a later SBC consumed
+TEST_CASE(OptimizerRegression_MultiplyAccumulatePreservesCarry) {
+    const auto code = {
+        0xE036859B, // mlas r6, r11, r5, r8
+        0xE0DB3154, // sbcs r3, r11, r4, asr r1
+        0xEAFFFFFE, // b $
+    };
+    const auto regs = {std::pair{arm::GPR::R1, 0x1FEu}, std::pair{arm::GPR::R4, 0x4FBu},
+                       std::pair{arm::GPR::R5, 0x5FAu}, std::pair{arm::GPR::R8, 0x8F7u},
+                       std::pair{arm::GPR::R11, 0xBF4u}};
+    auto snapshot = Run(code, regs, 0xB0000000, false);
+    CHECK(snapshot.gprs[3] == 0xBF4);
+    CHECK(MatchesUnoptimized(code, regs, 0xB0000000));
+}
+
+// Seed 4, iteration 510: a partial host flag write (the V flag of SMLAxy) erased the carry stored by an earlier
+// constant-folded shift, which a later ADC consumed
+TEST_CASE(OptimizerRegression_PartialHostFlagWriteKeepsEarlierCarry) {
+    const auto code = {
+        0xE3A01101, // mov r1, #0x40000000
+        0xE0320081, // eors r0, r2, r1, lsl #1   (C = 0)
+        0xE1082DE7, // smlatt r8, r7, r13, r2
+        0xE0A32004, // adc r2, r3, r4
+        0xEAFFFFFE, // b $
+    };
+    const auto regs = {std::pair{arm::GPR::R3, 0x10u}, std::pair{arm::GPR::R4, 0x20u}};
+    auto snapshot = Run(code, regs, 0x20000000, true);
+    CHECK(snapshot.gprs[2] == 0x30);
+    CHECK(MatchesUnoptimized(code, regs, 0x20000000));
+}
+
+// Seed 1, iteration 2493 with var-lifetime disabled: after an LSR result was consumed, reanalyzing an ASR derived from
+// it lost the known sign bit and the ASR was erased as a no-op
+TEST_CASE(OptimizerRegression_ASRKeptWhenChainIsReanalyzed) {
+    Options::Optimizer::Passes passes{};
+    passes.bitwiseOpsCoalescence = true;
+    passes.deadRegisterStoreElimination = true;
+    passes.deadGPRStoreElimination = true;
+    passes.deadVariableStoreElimination = true;
+
+    const auto code = {
+        0xE1A051A5, // mov r5, r5, lsr #3
+        0xE1A022C5, // mov r2, r5, asr #5
+        0xE2455FE2, // sub r5, r5, #0x388
+        0xE28220EF, // add r2, r2, #0xEF
+        0xEAFFFFFE, // b $
+    };
+    const auto regs = {std::pair{arm::GPR::R5, 0x5FAu}};
+    auto snapshot = Run(code, regs, 0, true, passes);
+    CHECK(snapshot.gprs[2] == 0xF4);
+    CHECK(MatchesUnoptimized(code, regs, 0, passes));
+}
+
+// Seed 4, iteration 1037 with var-lifetime disabled: reanalyzing an ADD after the chain was cut by a consumed value
+// reused the running sum from the earlier analysis and computed the wrong store address
+TEST_CASE(OptimizerRegression_ReanalyzedAddStartsNewChain) {
+    auto passes = AllPasses();
+    passes.varLifetimeOptimization = false;
+
+    const auto code = {
+        0xE28D50B0, // add r5, sp, #0xB0
+        0xE2753000, // rsbs r3, r5, #0
+        0xE583504C, // str r5, [r3, #0x4C]
+        0xE2555032, // subs r5, r5, #0x32
+        0xE28F3F71, // add r3, pc, #0x1C4   (discards the negated value)
+        0xEAFFFFFE, // b $
+    };
+    // Places the store at kDataAddress + 0x4C
+    const auto regs = {std::pair{arm::GPR::SP, -kDataAddress - 0xB0}};
+    auto snapshot = Run(code, regs, 0, true, passes);
+    CHECK(snapshot.data[0x4C / sizeof(uint32_t)] == -kDataAddress);
+    CHECK(MatchesUnoptimized(code, regs, 0, passes));
+}
+
+// Seed 5, iteration 568 with var-lifetime disabled: QDSUB doubles its operand with QADD of the same variable, which
+// the bitwise pass consumed twice and rewrote into an undefined variable
+TEST_CASE(OptimizerRegression_SameVariableInBothOperands) {
+    auto passes = AllPasses();
+    passes.varLifetimeOptimization = false;
+
+    const auto code = {
+        0xE3D583FA, // bics r8, r5, #0xE8000003
+        0xE1B0A0C5, // movs r10, r5, asr #1
+        0xE168E057, // qdsub lr, r7, r8
+        0xE05B88A3, // subs r8, r11, r3, lsr #17
+        0xEAFFFFFE, // b $
+    };
+    const auto regs = {std::pair{arm::GPR::R3, 0x3FCu}, std::pair{arm::GPR::R5, 0x5FAu},
+                       std::pair{arm::GPR::R7, 0x7F8u}, std::pair{arm::GPR::R11, 0x10BF4u}};
+    auto snapshot = Run(code, regs, 0x10000000, true, passes);
+    CHECK(snapshot.gprs[14] == 0xFFFFFC08);
+    CHECK(MatchesUnoptimized(code, regs, 0x10000000, passes));
+}
+
+// Seed 11, iteration 1149 with var-lifetime disabled: a value stored to two registers was reanalyzed on the second
+// store after the first one had already replaced it with a constant, leaving the second store reading an undefined
+// variable
+TEST_CASE(OptimizerRegression_ValueConsumedTwiceIsRewrittenOnce) {
+    IRTestFixture fx;
+    fx.options.optimizer.passes = AllPasses();
+    fx.options.optimizer.passes.varLifetimeOptimization = false;
+    fx.system.WriteCode(kCodeAddress, {
+                                          0xE1B01F04, // movs r1, r4, lsl #30
+                                          0xE1B065A1, // movs r6, r1, lsr #11
+                                          0xE1B05D86, // movs r5, r6, lsl #27   (always zero)
+                                          0xE5D1400E, // ldrb r4, [r1, #0xE]
+                                          0xE1A0C005, // mov r12, r5
+                                          0xE1F01003, // mvns r1, r3
+                                          0xE2776000, // rsbs r6, r7, #0
+                                          0xEAFFFFFE, // b $
+                                      });
+
+    auto &block = fx.Translate(kCodeAddress);
+    fx.optimizer.Optimize(block);
+    CHECK(ReadsOnlyDefinedVariables(block));
+}
+
+// Seed 14, iteration 790 with dead-hflags disabled: the carry cleared by the operand of CMP was merged into the NZ flags
+// stored by MVNS, ahead of the ADC that consumes the original carry
+TEST_CASE(OptimizerRegression_StoredFlagsNotMergedAcrossConsumer) {
+    auto passes = AllPasses();
+    passes.deadHostFlagStoreElimination = false;
+
+    const auto code = {
+        0xE3F030B5, // mvns r3, #0xB5
+        0xE2AB07EB, // adc r0, r11, #0x3AC00000
+        0xE3550887, // cmp r5, #0x870000
+        0xEAFFFFFE, // b $
+    };
+    const auto regs = {std::pair{arm::GPR::R5, 0x5FAu}, std::pair{arm::GPR::R11, 0x10BF4u}};
+    auto snapshot = Run(code, regs, 0xB0000000, true, passes);
+    CHECK(snapshot.gprs[0] == 0x03AD0BF5);
+    CHECK(MatchesUnoptimized(code, regs, 0xB0000000, passes));
+}
@@ -0,0 +1,94 @@
+#include "../test_framework.hpp"
+#include "ir_test_fixture.hpp"
+
+#include "core/memory_map_priv_access.hpp"
+#include "ir/optimizer/redundant_load_elimination.hpp"
+
+using namespace armajitto;
+using namespace armajitto::test;
+
+namespace {
+
+using Type = ir::IROpcodeType;
+
+constexpr uint32_t kDataAddress = TestSystem::kRAMBase + 0x100;
+
+// Loads the same constant address twice and stores the results into R1 and R2
+void EmitDoubleLoad(ir::BasicBlock &block, uint32_t address) {
+    ir::Emitter emitter{block};
+    auto first = emitter.MemRead(ir::MemAccessBus::Data, ir::MemAccessMode::Aligned, ir::MemAccessSize::Word, address);
+    auto second = emitter.MemRead(ir::MemAccessBus::Data, ir::MemAccessMode::Aligned, ir::MemAccessSize::Word, address);
+    emitter.SetRegister(arm::GPR::R1, first);
+    emitter.SetRegister(arm::GPR::R2, second);
+}
+
+// Runs only the redundant load elimination pass over the block. Returns true if the pass relied on the memory map.
+bool RunRLE(IRTestFixture &fx, ir::BasicBlock &block) {
+    ir::Emitter emitter{block};
+    ir::RedundantLoadEliminationOptimizerPass pass{emitter, fx.context, fx.options.optimizer, fx.pmrBuffer};
+    pass.Optimize();
+    return pass.DependsOnMemoryMap();
+}
+
+} // namespace
+
+TEST_CASE(RLE_StoreIsForwardedToLoad) {
+    IRTestFixture fx;
+    auto &block = fx.NewBlock(TestSystem::kRAMBase);
+    {
+        ir::Emitter emitter{block};
+        auto value = emitter.GetRegister(arm::GPR::R0);
+        emitter.MemWrite(ir::MemAccessSize::Word, value, kDataAddress);
+        auto loaded =
+            emitter.MemRead(ir::MemAccessBus::Data, ir::MemAccessMode::Aligned, ir::MemAccessSize::Word, kDataAddress);
+        emitter.SetRegister(arm::GPR::R1, loaded);
+    }
+
+    CHECK(RunRLE(fx, block));
+    CHECK(fx.Count(block, Type::MemRead) == 0);
+    CHECK(fx.Count(block, Type::MemWrite) == 1);
+
+    fx.ARMState().GPR(arm::GPR::R0) = 0xCAFEF00D;
+    fx.Run(block, 1);
+    CHECK(fx.ARMState().GPR(arm::GPR::R1) == 0xCAFEF00D);
+    CHECK(fx.system.RAMWord(kDataAddress) == 0xCAFEF00D);
+}
+
+TEST_CASE(RLE_MMIOLoadIsNeverEliminated) {
+    IRTestFixture fx;
+    auto &block = fx.NewBlock(TestSystem::kRAMBase);
+    EmitDoubleLoad(block, TestSystem::kMMIOBase);
+
+    CHECK(!RunRLE(fx, block));
+    CHECK(fx.Count(block, Type::MemRead) == 2);
+
+    fx.Run(block, 1);
+    CHECK(fx.system.mmioReads == 2);
+    CHECK(fx.ARMState().GPR(arm::GPR::R1) == 0);
+    CHECK(fx.ARMState().GPR(arm::GPR::R2) == 1);
+}
+
+TEST_CASE(RLE_RemappedRegionIsNotTreatedAsRAM) {
+    IRTestFixture fx;
+    fx.options.optimizer.passes.SetAll(false);
+    fx.options.optimizer.passes.redundantLoadElimination = true;
+
+    auto &ramBlock = fx.NewBlock(TestSystem::kRAMBase);
+    EmitDoubleLoad(ramBlock, kDataAddress);
+    fx.optimizer.Optimize(ramBlock);
+    CHECK(fx.Count(ramBlock, Type::MemRead) == 1);
+    CHECK(fx.optimizer.DependsOnMemoryMap());
+
+    // Remapping the data areas bumps the generation that the recompiler uses to discard dependent blocks
+    auto &memMap = fx.system.GetMemoryMap();
+    const uint64_t generation = MemoryMapPrivateAccess{memMap}.dataGeneration;
+    memMap.Unmap(MemoryArea::All, 0, TestSystem::kRAMBase, TestSystem::kRAMSize);
+    CHECK(MemoryMapPrivateAccess{memMap}.dataGeneration != generation);
+
+    // The same code compiled against the new layout keeps both reads
+    auto &mmioBlock = fx.NewBlock(TestSystem::kRAMBase);
+    EmitDoubleLoad(mmioBlock, kDataAddress);
+    fx.optimizer.Optimize(mmioBlock);
+    CHECK(fx.Count(mmioBlock, Type::MemRead) == 2);
+    CHECK(!fx.optimizer.DependsOnMemoryMap());
+}
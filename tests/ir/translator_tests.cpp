@@ -0,0 +1,84 @@
+#include "../test_framework.hpp"
+#include "ir_test_fixture.hpp"
+
+using namespace armajitto;
+using namespace armajitto::test;
+
+namespace {
+
+// Two ALU instructions followed by a load and a store
+const std::initializer_list<uint32_t> kAccessAfterALUCode = {
+    0xE3A00001, // mov r0, #1
+    0xE2800001, // add r0, r0, #1
+    0xE5921000, // ldr r1, [r2]
+    0xE5820004, // str r0, [r2, #4]
+    0xEAFFFFFE, // b $
+};
+
+const ir::IRMemReadOp *FirstLoad(const ir::BasicBlock &block) {
+    const int index = IRTestFixture::Find(block, ir::IROpcodeType::MemRead);
+    return (index >= 0) ? static_cast<const ir::IRMemReadOp *>(IRTestFixture::Ops(block)[index]) : nullptr;
+}
+
+const ir::IRMemWriteOp *FirstStore(const ir::BasicBlock &block) {
+    const int index = IRTestFixture::Find(block, ir::IROpcodeType::MemWrite);
+    return (index >= 0) ? static_cast<const ir::IRMemWriteOp *>(IRTestFixture::Ops(block)[index]) : nullptr;
+}
+
+} // namespace
+
+TEST_CASE(Translator_AbortCyclesWithFixedCyclesPerInstruction) {
+    IRTestFixture fx;
+    fx.options.translator.cyclesPerInstruction = 3;
+    fx.system.WriteCode(TestSystem::kRAMBase, kAccessAfterALUCode);
+    auto &block = fx.Translate(TestSystem::kRAMBase);
+
+    // The preceding instructions plus the aborted one
+    auto *load = FirstLoad(block);
+    auto *store = FirstStore(block);
+    CHECK(load != nullptr && load->abortCycles == 3 * 3);
+    CHECK(store != nullptr && store->abortCycles == 4 * 3);
+}
+
+TEST_CASE(Translator_AbortCyclesWithSubinstructionCycles) {
+    using Method = Options::Translator::CycleCountingMethod;
+    auto translate = [](uint32_t address, uint32_t maxBlockSize, auto &&fn) {
+        IRTestFixture fx;
+        fx.options.translator.cycleCountingMethod = Method::SubinstructionFixed;
+        fx.options.translator.cyclesPerMemoryAccess = 2;
+        fx.options.translator.maxBlockSize = maxBlockSize;
+        fx.system.WriteCode(TestSystem::kRAMBase, kAccessAfterALUCode);
+        return fn(fx.Translate(address));
+    };
+
+    const uint64_t aluCycles = translate(TestSystem::kRAMBase, 2, [](auto &block) { return block.PassCycles(); });
+    auto abortCycles = [](auto &block) {
+        auto *load = FirstLoad(block);
+        return (load != nullptr) ? load->abortCycles : 0;
+    };
+    const uint64_t loadFirst = translate(TestSystem::kRAMBase + 8, 1, abortCycles);
+    const uint64_t loadAfterALU = translate(TestSystem::kRAMBase, 3, abortCycles);
+
+    // The refill at the vector takes 1N + 2S; the preceding instructions are counted on top of it
+    CHECK(loadFirst >= 3 * 2);
+    CHECK(loadAfterALU == loadFirst + aluCycles);
+}
+
+TEST_CASE(Translator_BranchRefillCyclesUseTargetRegion) {
+    using Method = Options::Translator::CycleCountingMethod;
+    constexpr uint32_t kTargetAddress = TestSystem::kRAMBase + MemoryMap::kTimingBlockSize;
+    auto passCycles = [](uint32_t instr) {
+        IRTestFixture fx;
+        fx.options.translator.cycleCountingMethod = Method::SubinstructionTimingTable;
+        fx.system.GetMemoryMap().SetTimings(MemoryArea::All, TestSystem::kRAMBase, MemoryMap::kTimingBlockSize,
+                                            {.nonsequential = {1, 1, 1}, .sequential = {1, 1, 1}});
+        fx.system.GetMemoryMap().SetTimings(MemoryArea::All, kTargetAddress, MemoryMap::kTimingBlockSize,
+                                            {.nonsequential = {1, 6, 7}, .sequential = {1, 2, 3}});
+        fx.system.WriteCode(TestSystem::kRAMBase, {instr});
+        return fx.Translate(TestSystem::kRAMBase).PassCycles();
+    };
+
+    // The pipeline is refilled with 1N + 2S fetches from the target, in the target's instruction set
+    CHECK(passCycles(0xEA03FFFE) == 7 + 3 * 2); // b  kTargetAddress
+    CHECK(passCycles(0xFA03FFFE) == 6 + 2 * 2); // blx kTargetAddress
+}
@@ -0,0 +1,47 @@
+#include "../test_framework.hpp"
+#include "ir_test_fixture.hpp"
+
+#include "ir/optimizer/var_lifetime_opt.hpp"
+
+using namespace armajitto;
+using namespace armajitto::test;
+
+TEST_CASE(VarLifetimeOpt_CheckpointStaysBetweenStores) {
+    IRTestFixture fx;
+    auto &block = fx.NewBlock(TestSystem::kRAMBase);
+    {
+        ir::Emitter emitter{block};
+
+        // str r1, [r0]; mov r2, r1
+        auto addr1 = emitter.GetRegister(arm::GPR::R0);
+        auto value1 = emitter.GetRegister(arm::GPR::R1);
+        emitter.MemWrite(ir::MemAccessSize::Word, value1, addr1);
+        emitter.SetRegister(arm::GPR::R2, value1);
+        emitter.NextInstruction();
+
+        emitter.Checkpoint();
+
+        // str r4, [r3]; mov r5, r4
+        auto addr2 = emitter.GetRegister(arm::GPR::R3);
+        auto value2 = emitter.GetRegister(arm::GPR::R4);
+        emitter.MemWrite(ir::MemAccessSize::Word, value2, addr2);
+        emitter.SetRegister(arm::GPR::R5, value2);
+        emitter.NextInstruction();
+    }
+
+    ir::Emitter emitter{block};
+    ir::VarLifetimeOptimizerPass pass{emitter, fx.pmrBuffer};
+    pass.Optimize();
+
+    using Type = ir::IROpcodeType;
+    const int firstStore = fx.Find(block, Type::MemWrite);
+    const int firstSetReg = fx.Find(block, Type::SetRegister);
+    const int checkpoint = fx.Find(block, Type::Checkpoint);
+    const int secondStore = fx.Find(block, Type::MemWrite, firstStore + 1);
+    const int secondSetReg = fx.Find(block, Type::SetRegister, firstSetReg + 1);
+    CHECK(checkpoint >= 0);
+    CHECK(firstStore < checkpoint);
+    CHECK(firstSetReg < checkpoint);
+    CHECK(checkpoint < secondStore);
+    CHECK(checkpoint < secondSetReg);
+}
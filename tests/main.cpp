@@ -0,0 +1,30 @@
+#include "test_framework.hpp"
+
+#include <cstdio>
+#include <string_view>
+
+// armajitto-tests [filter]
+// Runs all tests whose names contain the filter string, or all tests if no filter is given.
+int main(int argc, char *argv[]) {
+    using namespace armajitto::test;
+
+    const std::string_view filter = (argc >= 2) ? argv[1] : "";
+
+    int failedTests = 0;
+    int ranTests = 0;
+    for (auto &test : Registry()) {
+        if (std::string_view{test.name}.find(filter) == std::string_view::npos) {
+            continue;
+        }
+        const int failuresBefore = FailureCount();
+        printf("%s\n", test.name);
+        test.fn();
+        ++ranTests;
+        if (FailureCount() != failuresBefore) {
+            ++failedTests;
+        }
+    }
+
+    printf("%d of %d tests failed\n", failedTests, ranTests);
+    return (failedTests == 0) ? 0 : 1;
+}
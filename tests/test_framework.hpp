@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+// Minimal self-registering test framework.
+// Tests are defined with TEST_CASE(name) and verify their results with CHECK(expr). A failed check reports the
+// expression and location and marks the test as failed, but lets the test run to completion.
+
+namespace armajitto::test {
+
+struct TestCase {
+    const char *name;
+    void (*fn)();
+};
+
+inline std::vector<TestCase> &Registry() {
+    static std::vector<TestCase> registry;
+    return registry;
+}
+
+inline int &FailureCount() {
+    static int failures = 0;
+    return failures;
+}
+
+struct TestRegistrar {
+    TestRegistrar(const char *name, void (*fn)()) {
+        Registry().push_back({name, fn});
+    }
+};
+
+inline void ReportFailure(const char *file, int line, const char *expr) {
+    printf("    %s:%d: check failed: %s\n", file, line, expr);
+    ++FailureCount();
+}
+
+} // namespace armajitto::test
+
+#define TEST_CASE(name)                                                         \
+    static void name();                                                         \
+    static ::armajitto::test::TestRegistrar name##_registrar{#name, &name};     \
+    static void name()
+
+#define CHECK(expr)                                                             \
+    do {                                                                        \
+        if (!(expr)) {                                                          \
+            ::armajitto::test::ReportFailure(__FILE__, __LINE__, #expr);        \
+        }                                                                       \
+    } while (false)
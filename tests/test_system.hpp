@@ -0,0 +1,81 @@
+#pragma once
+
+#include <armajitto/armajitto.hpp>
+
+#include <array>
+#include <cstring>
+#include <initializer_list>
+
+namespace armajitto::test {
+
+// Guest system with 64 KiB of RAM mapped at kRAMBase and MMIO registers at kMMIOBase.
+// RAM is mapped in the memory map; MMIO accesses go through the system callbacks, which count reads.
+struct TestSystem : public ISystem {
+    static constexpr uint32_t kRAMBase = 0x02000000;
+    static constexpr uint32_t kRAMSize = 0x10000;
+    static constexpr uint32_t kMMIOBase = 0x04000000;
+
+    alignas(16) std::array<uint8_t, kRAMSize> ram{};
+
+    uint32_t mmioReads = 0;
+    uint32_t mmioValue = 0; // incremented on every MMIO read
+
+    TestSystem() {
+        m_memMap.Map(MemoryArea::All, 0, kRAMBase, kRAMSize, MemoryAttributes::RWX, ram.data(), kRAMSize);
+    }
+
+    uint8_t MemReadByte(uint32_t address) final {
+        return Read<uint8_t>(address);
+    }
+    uint16_t MemReadHalf(uint32_t address) final {
+        return Read<uint16_t>(address);
+    }
+    uint32_t MemReadWord(uint32_t address) final {
+        return Read<uint32_t>(address);
+    }
+
+    void MemWriteByte(uint32_t address, uint8_t value) final {
+        Write<uint8_t>(address, value);
+    }
+    void MemWriteHalf(uint32_t address, uint16_t value) final {
+        Write<uint16_t>(address, value);
+    }
+    void MemWriteWord(uint32_t address, uint32_t value) final {
+        Write<uint32_t>(address, value);
+    }
+
+    uint32_t RAMWord(uint32_t address) const {
+        uint32_t value;
+        std::memcpy(&value, &ram[(address - kRAMBase) & (kRAMSize - 4)], sizeof(value));
+        return value;
+    }
+
+    // Writes ARM instructions to RAM starting at the given address
+    void WriteCode(uint32_t address, std::initializer_list<uint32_t> instrs) {
+        for (uint32_t instr : instrs) {
+            std::memcpy(&ram[(address - kRAMBase) & (kRAMSize - 4)], &instr, sizeof(instr));
+            address += sizeof(instr);
+        }
+    }
+
+private:
+    template <typename T>
+    T Read(uint32_t address) {
+        if (address - kRAMBase < kRAMSize) {
+            T value;
+            std::memcpy(&value, &ram[(address - kRAMBase) & (kRAMSize - sizeof(T))], sizeof(T));
+            return value;
+        }
+        ++mmioReads;
+        return static_cast<T>(mmioValue++);
+    }
+
+    template <typename T>
+    void Write(uint32_t address, T value) {
+        if (address - kRAMBase < kRAMSize) {
+            std::memcpy(&ram[(address - kRAMBase) & (kRAMSize - sizeof(T))], &value, sizeof(T));
+        }
+    }
+};
+
+} // namespace armajitto::test
@@ -0,0 +1,23 @@
+#include "../test_framework.hpp"
+
+#include "util/huge_pages.hpp"
+
+using namespace armajitto;
+
+TEST_CASE(HugePages_AllocationsAreZeroFilledInEveryMode) {
+    for (auto mode : {HugePageMode::None, HugePageMode::Transparent, HugePageMode::Explicit}) {
+        // Explicit huge pages fall back to other pages if the hugetlbfs pool is empty
+        constexpr size_t kSize = 0x1234;
+        auto *ptr = static_cast<uint8_t *>(util::AllocatePagesOrThrow(kSize, mode));
+        CHECK(ptr != nullptr);
+        if (ptr == nullptr) {
+            continue;
+        }
+        bool zeroed = true;
+        for (size_t i = 0; i < kSize; i++) {
+            zeroed &= ptr[i] == 0;
+        }
+        CHECK(zeroed);
+        util::FreePages(ptr, kSize, mode);
+    }
+}